@@ -32,6 +32,7 @@ BuildXlaOpsPassFlags* build_ops_flags;
 MarkForCompilationPassFlags* mark_for_compilation_flags;
 XlaDeviceFlags* device_flags;
 XlaOpsCommonFlags* ops_flags;
+XlaCompilationCacheFlags* compilation_cache_flags;
 IntroduceFloatingPointJitterPassFlags* jitter_flags;
 MlirCommonFlags* mlir_flags;
 
@@ -164,6 +165,10 @@ void AllocateAndParseFlags() {
   ops_flags = new XlaOpsCommonFlags;
   ops_flags->tf_xla_always_defer_compilation = false;
 
+  compilation_cache_flags = new XlaCompilationCacheFlags;
+  compilation_cache_flags->tf_xla_persistent_cache_directory = "";
+  compilation_cache_flags->tf_xla_persistent_cache_max_size_mb = 4096;
+
   jitter_flags = new IntroduceFloatingPointJitterPassFlags;
   jitter_flags->jitter_amount = 1e-5;
 
@@ -216,6 +221,15 @@ void AllocateAndParseFlags() {
        Flag("tf_xla_always_defer_compilation",
             &ops_flags->tf_xla_always_defer_compilation, ""),
 
+       Flag("tf_xla_persistent_cache_directory",
+            &compilation_cache_flags->tf_xla_persistent_cache_directory,
+            "If non-empty, persist compiled XLA clusters to this directory "
+            "and reload them from it instead of recompiling."),
+       Flag("tf_xla_persistent_cache_max_size_mb",
+            &compilation_cache_flags->tf_xla_persistent_cache_max_size_mb,
+            "Maximum size of the persistent XLA compilation cache directory "
+            "in megabytes; the oldest entries are evicted beyond this size."),
+
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
             "The Tensors to add the jitter to.  The tensors are named in the "
@@ -272,6 +286,11 @@ const XlaOpsCommonFlags& GetXlaOpsCommonFlags() {
   return *ops_flags;
 }
 
+const XlaCompilationCacheFlags& GetXlaCompilationCacheFlags() {
+  absl::call_once(flags_init, &AllocateAndParseFlags);
+  return *compilation_cache_flags;
+}
+
 const IntroduceFloatingPointJitterPassFlags&
 GetIntroduceFloatingPointJitterPassFlags() {
   absl::call_once(flags_init, &AllocateAndParseFlags);
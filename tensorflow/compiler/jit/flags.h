@@ -100,6 +100,17 @@ struct XlaOpsCommonFlags {
   bool tf_xla_always_defer_compilation;
 };
 
+// Flags for the persistent on-disk cache of the XLA compilation cache.
+struct XlaCompilationCacheFlags {
+  // If non-empty, compiled XLA clusters are persisted to this directory and
+  // reloaded from it by later processes instead of being recompiled.
+  string tf_xla_persistent_cache_directory;
+
+  // Upper bound on the total size of the persistent cache directory, in
+  // megabytes.  The oldest entries are evicted once the bound is exceeded.
+  int64 tf_xla_persistent_cache_max_size_mb;
+};
+
 // Flags for the build_xla_ops pass.
 struct BuildXlaOpsPassFlags {
   // Enables lazy compilation for TF/XLA (only when auto-clustering) if true.
@@ -150,6 +161,7 @@ MarkForCompilationPassFlags* GetMarkForCompilationPassFlags();
 BuildXlaOpsPassFlags* GetBuildXlaOpsPassFlags();
 XlaDeviceFlags* GetXlaDeviceFlags();
 const XlaOpsCommonFlags& GetXlaOpsCommonFlags();
+const XlaCompilationCacheFlags& GetXlaCompilationCacheFlags();
 
 const IntroduceFloatingPointJitterPassFlags&
 GetIntroduceFloatingPointJitterPassFlags();
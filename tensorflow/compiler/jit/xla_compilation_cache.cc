@@ -18,6 +18,7 @@ limitations under the License.
 #include <numeric>
 
 #include "absl/base/call_once.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/compiler/jit/flags.h"
@@ -28,6 +29,8 @@ limitations under the License.
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/debug_options_flags.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -40,12 +43,15 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/protobuf/graph_debug_info.pb.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/stream_executor/host/host_platform_id.h"
 
 #if !defined(LIBTPU_ON_GCE)
 #include "tensorflow/compiler/mlir/tensorflow/utils/compile_mlir_util.h"
@@ -58,7 +64,15 @@ constexpr int64 XlaCompilationCache::kDefaultCompilationThreshold;
 
 XlaCompilationCache::XlaCompilationCache(xla::LocalClient* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : XlaCompilationCache(client, std::move(device_type),
+                          XlaPersistentCompilationCache::Global()) {}
+
+XlaCompilationCache::XlaCompilationCache(
+    xla::LocalClient* client, DeviceType device_type,
+    XlaPersistentCompilationCache* persistent_cache)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      persistent_cache_(persistent_cache) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
@@ -156,20 +170,12 @@ XlaCompilationCache::BuildSignature(
   return std::move(signature);
 }
 
-Status XlaCompilationCache::BuildExecutable(
+xla::ExecutableBuildOptions XlaCompilationCache::GetExecutableBuildOptions(
     const XlaCompiler::Options& options,
     const XlaCompiler::CompilationResult& result,
     const std::vector<int32>& argument_input_indices,
     const std::vector<int32>& resource_input_indices,
-    const std::vector<bool>& resource_input_initialized,
-    std::unique_ptr<xla::LocalExecutable>* executable) {
-  VLOG(2) << "Compiling to local executable";
-
-  std::vector<const xla::Shape*> argument_layouts(
-      result.xla_input_shapes.size());
-  for (int i = 0, end = result.xla_input_shapes.size(); i < end; ++i) {
-    argument_layouts[i] = &result.xla_input_shapes[i];
-  }
+    const std::vector<bool>& resource_input_initialized) {
   xla::ExecutableBuildOptions build_options;
   build_options.set_device_ordinal(options.device_ordinal != -1
                                        ? options.device_ordinal
@@ -187,6 +193,26 @@ Status XlaCompilationCache::BuildExecutable(
   build_options.set_resource_update_to_input_index(
       resource_update_to_input_index);
   build_options.set_alias_passthrough_params(options.alias_passthrough_params);
+  return build_options;
+}
+
+Status XlaCompilationCache::BuildExecutable(
+    const XlaCompiler::Options& options,
+    const XlaCompiler::CompilationResult& result,
+    const std::vector<int32>& argument_input_indices,
+    const std::vector<int32>& resource_input_indices,
+    const std::vector<bool>& resource_input_initialized,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  VLOG(2) << "Compiling to local executable";
+
+  std::vector<const xla::Shape*> argument_layouts(
+      result.xla_input_shapes.size());
+  for (int i = 0, end = result.xla_input_shapes.size(); i < end; ++i) {
+    argument_layouts[i] = &result.xla_input_shapes[i];
+  }
+  xla::ExecutableBuildOptions build_options = GetExecutableBuildOptions(
+      options, result, argument_input_indices, resource_input_indices,
+      resource_input_initialized);
 
   TF_ASSIGN_OR_RETURN(
       auto executables,
@@ -196,6 +222,205 @@ Status XlaCompilationCache::BuildExecutable(
   return Status::OK();
 }
 
+Status XlaCompilationCache::BuildExecutableFromOptimizedHlo(
+    const xla::ExecutableBuildOptions& build_options,
+    const xla::HloModuleProto& optimized_hlo,
+    const string& serialized_executable,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  VLOG(2) << "Compiling optimized HLO to local executable";
+
+  xla::Backend* backend = client_->mutable_backend();
+  TF_ASSIGN_OR_RETURN(xla::HloModuleConfig config,
+                      xla::HloModule::CreateModuleConfigFromProto(
+                          optimized_hlo, xla::GetDebugOptionsFromFlags()));
+  if (backend->eigen_intra_op_thread_pool() != nullptr) {
+    config.set_intra_op_parallelism_threads(
+        backend->eigen_intra_op_thread_pool()->NumThreads());
+  }
+  config.set_alias_passthrough_params(build_options.alias_passthrough_params());
+  TF_ASSIGN_OR_RETURN(se::StreamExecutor * executor,
+                      backend->stream_executor(build_options.device_ordinal()));
+
+  std::unique_ptr<xla::Executable> xla_executable;
+  if (!serialized_executable.empty()) {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloModule> module,
+                        xla::HloModule::CreateFromProto(optimized_hlo, config));
+    xla::StatusOr<std::unique_ptr<xla::Executable>> loaded =
+        backend->compiler()->LoadExecutable(std::move(module),
+                                            serialized_executable, executor);
+    if (loaded.ok()) {
+      xla_executable = std::move(loaded).ValueOrDie();
+    } else {
+      VLOG(1) << "Failed to load the serialized executable, running the code "
+                 "generator: "
+              << loaded.status();
+    }
+  }
+  if (xla_executable == nullptr) {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<xla::HloModule> module,
+                        xla::HloModule::CreateFromProto(optimized_hlo, config));
+    TF_ASSIGN_OR_RETURN(xla_executable, backend->compiler()->RunBackend(
+                                            std::move(module), executor,
+                                            build_options.device_allocator()));
+  }
+  *executable = absl::make_unique<xla::LocalExecutable>(
+      std::move(xla_executable), backend, build_options);
+  return Status::OK();
+}
+
+xla::StatusOr<string> XlaCompilationCache::BuildPersistentCacheKey(
+    const XlaCompiler::Options& options,
+    const XlaCompiler::CompileOptions& compile_options,
+    const string& function_name, const Signature& signature) {
+  string key_material;
+  auto append_proto = [&](const protobuf::MessageLite& proto) -> Status {
+    string serialized;
+    if (!SerializeToStringDeterministic(proto, &serialized)) {
+      return errors::Internal("Failed to serialize XLA cache key material");
+    }
+    absl::StrAppend(&key_material, serialized.size(), ":", serialized, ";");
+    return Status::OK();
+  };
+
+  // The compiler: any change in TensorFlow, the target or the XLA flags
+  // invalidates all entries.
+  absl::StrAppend(&key_material, tf_git_version(), ";", tf_compiler_version(),
+                  ";", TF_GRAPH_DEF_VERSION, ";", client_->platform()->Name(),
+                  ";", device_type_.type_string(), ";",
+                  options.device_type.type_string(), ";");
+  TF_RETURN_IF_ERROR(append_proto(xla::GetDebugOptionsFromFlags()));
+
+  // The compilation options.
+  absl::StrAppend(
+      &key_material, options.graph_def_version, ";",
+      options.allow_cpu_custom_calls, options.custom_fake_quant_op_calls,
+      options.alias_passthrough_params, compile_options.use_tuple_arg,
+      compile_options.return_updated_values_for_all_resources,
+      compile_options.always_return_tuple,
+      compile_options.is_entry_computation,
+      compile_options.add_token_input_output,
+      compile_options.alias_resource_update, ";");
+
+  // The signature.
+  absl::StrAppend(&key_material, signature.name.size(), ":", signature.name,
+                  ";");
+  for (const auto& arg : signature.arg_shapes) {
+    absl::StrAppend(&key_material, DataTypeString(arg.first), "[",
+                    absl::StrJoin(arg.second, ","), "];");
+  }
+  for (const Tensor& value : signature.arg_values) {
+    absl::StrAppend(&key_material, DataTypeString(value.dtype()),
+                    value.shape().DebugString(), value.tensor_data().size(),
+                    ":", value.tensor_data(), ";");
+  }
+
+  // The functions being compiled. Cluster names are not unique across
+  // programs, so the definitions themselves must be part of the key.
+  if (options.flib_def != nullptr) {
+    const FunctionDef* fdef = options.flib_def->Find(function_name);
+    if (fdef != nullptr) {
+      TF_RETURN_IF_ERROR(append_proto(*fdef));
+      TF_RETURN_IF_ERROR(
+          append_proto(options.flib_def->ReachableDefinitions(*fdef).ToProto()));
+    }
+  }
+
+  const Fprint128 fingerprint = Fingerprint128(key_material);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+bool XlaCompilationCache::LoadFromPersistentCache(
+    const string& key, const XlaCompiler::Options& options,
+    const std::vector<int32>& argument_input_indices,
+    const std::vector<int32>& resource_input_indices,
+    const std::vector<bool>& resource_input_initialized,
+    XlaCompiler::CompilationResult* compilation_result,
+    std::unique_ptr<xla::LocalExecutable>* executable) {
+  XlaPersistentCacheEntry entry;
+  Status s = persistent_cache_->Lookup(key, &entry);
+  if (!s.ok()) {
+    if (!errors::IsNotFound(s)) {
+      LOG(WARNING) << "Ignoring persistent XLA cache entry: " << s;
+    }
+    return false;
+  }
+
+  XlaCompiler::CompilationResult result;
+  s = DeserializeCompilationResult(entry.compilation_result(), &result);
+  if (!s.ok()) {
+    LOG(WARNING) << "Ignoring persistent XLA cache entry " << key << ": " << s;
+    return false;
+  }
+
+  // Only the CPU backend is known to accept an already optimized module in
+  // RunBackend; other backends rerun the HLO pipeline on the unoptimized
+  // computation, which still skips the TF-to-XLA bridge.
+  std::unique_ptr<xla::LocalExecutable> result_executable;
+  if (entry.has_optimized_hlo() &&
+      client_->platform()->id() == se::host::kHostPlatformId) {
+    xla::ExecutableBuildOptions build_options = GetExecutableBuildOptions(
+        options, result, argument_input_indices, resource_input_indices,
+        resource_input_initialized);
+    s = BuildExecutableFromOptimizedHlo(build_options, entry.optimized_hlo(),
+                                        entry.executable(), &result_executable);
+    if (!s.ok()) {
+      VLOG(1) << "Failed to rebuild executable from optimized HLO for " << key
+              << ", recompiling the unoptimized HLO: " << s;
+      result_executable.reset();
+    }
+  }
+  if (result_executable == nullptr) {
+    s = BuildExecutable(options, result, argument_input_indices,
+                        resource_input_indices, resource_input_initialized,
+                        &result_executable);
+    if (!s.ok()) {
+      LOG(WARNING) << "Ignoring persistent XLA cache entry " << key << ": "
+                   << s;
+      return false;
+    }
+  }
+
+  VLOG(1) << "Loaded " << entry.signature()
+          << " from the persistent XLA compilation cache";
+  *compilation_result = std::move(result);
+  *executable = std::move(result_executable);
+  return true;
+}
+
+void XlaCompilationCache::StoreInPersistentCache(
+    const string& key, const Signature& signature,
+    const XlaCompiler::CompilationResult& compilation_result,
+    const xla::LocalExecutable* executable) {
+  XlaPersistentCacheEntry entry;
+  entry.set_signature(signature.HumanString());
+  Status s = SerializeCompilationResult(compilation_result,
+                                        entry.mutable_compilation_result());
+  if (s.ok() && executable != nullptr &&
+      executable->executable()->has_module()) {
+    *entry.mutable_optimized_hlo() =
+        executable->executable()->module().ToProto();
+    // Backends that cannot serialize their machine code are rebuilt from the
+    // optimized HLO alone.
+    xla::StatusOr<string> serialized_executable =
+        client_->backend().compiler()->SerializeExecutable(
+            *executable->executable());
+    if (serialized_executable.ok()) {
+      entry.set_executable(std::move(serialized_executable).ValueOrDie());
+    } else {
+      VLOG(2) << "Not persisting the machine code of " << signature.name
+              << ": " << serialized_executable.status();
+    }
+  }
+  if (s.ok()) {
+    s = persistent_cache_->Insert(key, entry);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write persistent XLA cache entry for "
+                 << signature.name << ": " << s;
+  }
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
@@ -211,7 +436,7 @@ Status XlaCompilationCache::Compile(
                         XlaCompiler::CompilationResult* result) {
     return compiler->CompileFunction(compile_options, function, args, result);
   };
-  return CompileImpl(options, function, args, compile_fn,
+  return CompileImpl(options, function, args, compile_options, compile_fn,
                      /*compile_threshold=*/compile_threshold,
                      out_compilation_result, out_executable);
 }
@@ -331,7 +556,7 @@ Status XlaCompilationCache::CompileSingleOp(
         *options.flib_def, debug_info, options.shape_representation_fn, result);
 #endif
   };
-  return CompileImpl(options, name, args, compile_op,
+  return CompileImpl(options, name, args, compile_options, compile_op,
                      /*compile_threshold=*/absl::nullopt,
                      out_compilation_result, out_executable);
 }
@@ -353,6 +578,7 @@ void LogOnceXlaCompiledFirstCluster() {
 Status XlaCompilationCache::CompileImpl(
     const XlaCompiler::Options& options, const NameAttrList& function,
     absl::Span<const XlaCompiler::Argument> args,
+    const XlaCompiler::CompileOptions& compile_options,
     const std::function<Status(XlaCompiler* compiler,
                                XlaCompiler::CompilationResult*)>& compile_fn,
     absl::optional<int64> compile_threshold,
@@ -502,13 +728,41 @@ Status XlaCompilationCache::CompileImpl(
       }
     }
 
-    entry->compilation_status =
-        compile_fn(&compiler, &entry->compilation_result);
-    TF_RETURN_IF_ERROR(entry->compilation_status);
-    CHECK_EQ(entry->executable.get(), nullptr);
-    entry->compilation_status = BuildExecutable(
-        options, entry->compilation_result, argument_input_indices,
-        resource_input_indices, resource_input_initialized, &entry->executable);
+    string persistent_cache_key;
+    bool loaded_from_persistent_cache = false;
+    if (persistent_cache_ != nullptr) {
+      xla::StatusOr<string> key =
+          BuildPersistentCacheKey(options, compile_options, function.name(),
+                                  signature);
+      if (key.ok()) {
+        persistent_cache_key = std::move(key).ValueOrDie();
+        loaded_from_persistent_cache = LoadFromPersistentCache(
+            persistent_cache_key, options, argument_input_indices,
+            resource_input_indices, resource_input_initialized,
+            &entry->compilation_result, &entry->executable);
+      } else {
+        LOG(WARNING) << "Not using the persistent XLA compilation cache for "
+                     << function.name() << ": " << key.status();
+      }
+    }
+
+    if (loaded_from_persistent_cache) {
+      entry->compilation_status = Status::OK();
+    } else {
+      entry->compilation_status =
+          compile_fn(&compiler, &entry->compilation_result);
+      TF_RETURN_IF_ERROR(entry->compilation_status);
+      CHECK_EQ(entry->executable.get(), nullptr);
+      entry->compilation_status = BuildExecutable(
+          options, entry->compilation_result, argument_input_indices,
+          resource_input_indices, resource_input_initialized,
+          &entry->executable);
+      if (entry->compilation_status.ok() && !persistent_cache_key.empty()) {
+        StoreInPersistentCache(persistent_cache_key, signature,
+                               entry->compilation_result,
+                               entry->executable.get());
+      }
+    }
 
     const uint64 compile_end_us = env->NowMicros();
     const uint64 compile_time_us = compile_end_us - compile_start_us;
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/container/inlined_vector.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
 #include "tensorflow/compiler/tf2xla/xla_compiler.h"
 #include "tensorflow/compiler/tf2xla/xla_context.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
@@ -42,9 +43,17 @@ namespace tensorflow {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// If a persistent cache is configured (see
+// XlaPersistentCompilationCache::Global()), compilation results are also
+// written to disk and later processes reload them instead of recompiling.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::LocalClient* client, DeviceType device_type);
+  // As above, but backs the in-memory cache with `persistent_cache`, which may
+  // be null and must outlive this object.
+  XlaCompilationCache(xla::LocalClient* client, DeviceType device_type,
+                      XlaPersistentCompilationCache* persistent_cache);
   ~XlaCompilationCache() override;
 
   enum class CompileMode {
@@ -127,6 +136,7 @@ class XlaCompilationCache : public ResourceBase {
   Status CompileImpl(
       const XlaCompiler::Options& options, const NameAttrList& function,
       absl::Span<const XlaCompiler::Argument> args,
+      const XlaCompiler::CompileOptions& compile_options,
       const std::function<Status(XlaCompiler* compiler,
                                  XlaCompiler::CompilationResult*)>& compile_fn,
       absl::optional<int64> compile_threshold,
@@ -142,8 +152,54 @@ class XlaCompilationCache : public ResourceBase {
                          const std::vector<bool>& resource_input_initialized,
                          std::unique_ptr<xla::LocalExecutable>* executable);
 
+  // Returns the options used to build the executable for `result`.
+  xla::ExecutableBuildOptions GetExecutableBuildOptions(
+      const XlaCompiler::Options& options,
+      const XlaCompiler::CompilationResult& result,
+      const std::vector<int32>& argument_input_indices,
+      const std::vector<int32>& resource_input_indices,
+      const std::vector<bool>& resource_input_initialized);
+
+  // Generates an XLA LocalExecutable for `optimized_hlo`, a module that has
+  // already been through the backend's HLO optimization pipeline. Loads the
+  // machine code in `serialized_executable` if it is not empty and the backend
+  // can load it, and runs only the backend code generator otherwise.
+  Status BuildExecutableFromOptimizedHlo(
+      const xla::ExecutableBuildOptions& build_options,
+      const xla::HloModuleProto& optimized_hlo,
+      const string& serialized_executable,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
+  // Computes the key under which the compilation of `signature` is stored in
+  // the persistent cache. The key covers the signature, the definitions of
+  // `function_name` and the functions it calls, the compilation options and a
+  // fingerprint of the compiler itself.
+  xla::StatusOr<string> BuildPersistentCacheKey(
+      const XlaCompiler::Options& options,
+      const XlaCompiler::CompileOptions& compile_options,
+      const string& function_name, const Signature& signature);
+
+  // Tries to load the compilation result and executable stored under `key` in
+  // the persistent cache. Returns false if they could not be loaded, in which
+  // case the outputs are left untouched.
+  bool LoadFromPersistentCache(
+      const string& key, const XlaCompiler::Options& options,
+      const std::vector<int32>& argument_input_indices,
+      const std::vector<int32>& resource_input_indices,
+      const std::vector<bool>& resource_input_initialized,
+      XlaCompiler::CompilationResult* compilation_result,
+      std::unique_ptr<xla::LocalExecutable>* executable);
+
+  // Writes a compilation result and its executable to the persistent cache.
+  // Failures are logged and otherwise ignored.
+  void StoreInPersistentCache(
+      const string& key, const Signature& signature,
+      const XlaCompiler::CompilationResult& compilation_result,
+      const xla::LocalExecutable* executable);
+
   xla::LocalClient* const client_;
   const DeviceType device_type_;
+  XlaPersistentCompilationCache* const persistent_cache_;
 
   // The value associated with a cache entry.
   struct Entry {
@@ -0,0 +1,292 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_statistics.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+
+namespace tensorflow {
+namespace {
+
+// Bump whenever the on-disk format or the meaning of a cache key changes.
+constexpr int32 kRecordVersion = 1;
+
+constexpr char kEntrySuffix[] = ".xla_cache";
+
+Status ShapeFromProto(const TensorShapeProto& proto, TensorShape* shape) {
+  TF_RETURN_IF_ERROR(TensorShape::IsValidShape(proto));
+  *shape = TensorShape(proto);
+  return Status::OK();
+}
+
+}  // namespace
+
+XlaPersistentCompilationCache::XlaPersistentCompilationCache(
+    Env* env, string directory, int64 max_size_bytes)
+    : env_(env),
+      directory_(std::move(directory)),
+      max_size_bytes_(max_size_bytes) {}
+
+/* static */ XlaPersistentCompilationCache*
+XlaPersistentCompilationCache::Global() {
+  static XlaPersistentCompilationCache* cache = []() {
+    const XlaCompilationCacheFlags& flags = GetXlaCompilationCacheFlags();
+    if (flags.tf_xla_persistent_cache_directory.empty()) {
+      return static_cast<XlaPersistentCompilationCache*>(nullptr);
+    }
+    Env* env = Env::Default();
+    Status s =
+        env->RecursivelyCreateDir(flags.tf_xla_persistent_cache_directory);
+    if (!s.ok() && s.code() != error::ALREADY_EXISTS) {
+      LOG(WARNING) << "Disabling the persistent XLA compilation cache: could "
+                      "not create "
+                   << flags.tf_xla_persistent_cache_directory << ": " << s;
+      return static_cast<XlaPersistentCompilationCache*>(nullptr);
+    }
+    VLOG(1) << "Using persistent XLA compilation cache in "
+            << flags.tf_xla_persistent_cache_directory;
+    return new XlaPersistentCompilationCache(
+        env, flags.tf_xla_persistent_cache_directory,
+        flags.tf_xla_persistent_cache_max_size_mb * 1024 * 1024);
+  }();
+  return cache;
+}
+
+string XlaPersistentCompilationCache::FilePath(const string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, kEntrySuffix));
+}
+
+Status XlaPersistentCompilationCache::Lookup(const string& key,
+                                             XlaPersistentCacheEntry* entry) {
+  const string path = FilePath(key);
+  string contents;
+  Status s = ReadFileToString(env_, path, &contents);
+  if (!s.ok()) {
+    mutex_lock lock(mu_);
+    ++stats_.misses;
+    metrics::RecordXlaPersistentCacheLookup("miss");
+    return errors::NotFound("No persistent XLA cache entry for ", key);
+  }
+
+  XlaPersistentCacheRecord record;
+  string error;
+  if (!record.ParseFromString(contents)) {
+    error = "unparseable record";
+  } else if (record.version() != kRecordVersion) {
+    error = absl::StrCat("unsupported record version ", record.version());
+  } else if (record.key() != key) {
+    error = absl::StrCat("record was written for key ", record.key());
+  } else if (crc32c::Unmask(record.entry_crc32c()) !=
+             crc32c::Value(record.entry().data(), record.entry().size())) {
+    error = "checksum mismatch";
+  } else if (!entry->ParseFromString(record.entry())) {
+    error = "unparseable entry";
+  }
+
+  mutex_lock lock(mu_);
+  if (!error.empty()) {
+    ++stats_.corrupt_entries;
+    metrics::RecordXlaPersistentCacheLookup("corrupt");
+    // Remove the entry so that it is rewritten by the next compilation.
+    env_->DeleteFile(path).IgnoreError();
+    return errors::DataLoss("Corrupt persistent XLA cache entry ", path, ": ",
+                            error);
+  }
+  ++stats_.hits;
+  metrics::RecordXlaPersistentCacheLookup("hit");
+  return Status::OK();
+}
+
+Status XlaPersistentCompilationCache::Insert(
+    const string& key, const XlaPersistentCacheEntry& entry) {
+  XlaPersistentCacheRecord record;
+  record.set_version(kRecordVersion);
+  record.set_key(key);
+  if (!entry.SerializeToString(record.mutable_entry())) {
+    return errors::Internal("Failed to serialize XLA cache entry for ", key);
+  }
+  record.set_entry_crc32c(crc32c::Mask(
+      crc32c::Value(record.entry().data(), record.entry().size())));
+
+  const string path = FilePath(key);
+  const string tmp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(random::New64()));
+  Status s = WriteStringToFile(env_, tmp_path, record.SerializeAsString());
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+
+  {
+    mutex_lock lock(mu_);
+    ++stats_.insertions;
+  }
+  return MaybeEvict();
+}
+
+Status XlaPersistentCompilationCache::MaybeEvict() {
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(env_->GetChildren(directory_, &children));
+
+  struct FileInfo {
+    string path;
+    int64 size;
+    int64 mtime_nsec;
+  };
+  std::vector<FileInfo> files;
+  int64 total_size = 0;
+  for (const string& child : children) {
+    if (!absl::EndsWith(child, kEntrySuffix)) continue;
+    FileInfo info;
+    info.path = io::JoinPath(directory_, child);
+    FileStatistics stat;
+    // Another process may have evicted the file in the meantime.
+    if (!env_->Stat(info.path, &stat).ok()) continue;
+    info.size = stat.length;
+    info.mtime_nsec = stat.mtime_nsec;
+    total_size += info.size;
+    files.push_back(std::move(info));
+  }
+  if (total_size <= max_size_bytes_) return Status::OK();
+
+  std::sort(files.begin(), files.end(),
+            [](const FileInfo& a, const FileInfo& b) {
+              if (a.mtime_nsec != b.mtime_nsec) {
+                return a.mtime_nsec < b.mtime_nsec;
+              }
+              return a.path < b.path;
+            });
+  int64 num_evicted = 0;
+  for (const FileInfo& info : files) {
+    if (total_size <= max_size_bytes_) break;
+    if (env_->DeleteFile(info.path).ok()) {
+      VLOG(2) << "Evicted persistent XLA cache entry " << info.path;
+      ++num_evicted;
+    }
+    total_size -= info.size;
+  }
+
+  mutex_lock lock(mu_);
+  stats_.evictions += num_evicted;
+  return Status::OK();
+}
+
+XlaPersistentCompilationCache::Stats XlaPersistentCompilationCache::stats()
+    const {
+  mutex_lock lock(mu_);
+  return stats_;
+}
+
+Status SerializeCompilationResult(const XlaCompilationResult& result,
+                                  XlaCompilationResultProto* proto) {
+  proto->Clear();
+  for (int index : result.input_mapping) {
+    proto->add_input_mapping(index);
+  }
+  for (const xla::Shape& shape : result.xla_input_shapes) {
+    *proto->add_xla_input_shapes() = shape.ToProto();
+  }
+  *proto->mutable_xla_output_shape() = result.xla_output_shape.ToProto();
+  for (const XlaOutputDescription& output : result.outputs) {
+    XlaOutputDescriptionProto* output_proto = proto->add_outputs();
+    output_proto->set_type(output.type);
+    output.shape.AsProto(output_proto->mutable_shape());
+    output_proto->set_is_constant(output.is_constant);
+    if (output.is_constant) {
+      output.constant_value.AsProtoTensorContent(
+          output_proto->mutable_constant_value());
+    }
+    output_proto->set_input_index(output.input_index);
+    output_proto->set_is_tensor_list(output.is_tensor_list);
+  }
+  *proto->mutable_host_compute_metadata() = result.host_compute_metadata;
+  for (const XlaResourceUpdate& update : result.resource_updates) {
+    XlaResourceUpdateProto* update_proto = proto->add_resource_updates();
+    update_proto->set_input_index(update.input_index);
+    update_proto->set_type(update.type);
+    update.shape.AsProto(update_proto->mutable_shape());
+    update_proto->set_modified(update.modified);
+    for (const string& gradient : update.tensor_array_gradients_accessed) {
+      update_proto->add_tensor_array_gradients_accessed(gradient);
+    }
+  }
+  if (result.computation == nullptr) {
+    return errors::InvalidArgument(
+        "Cannot serialize a compilation result without a computation");
+  }
+  *proto->mutable_computation() = result.computation->proto();
+  return Status::OK();
+}
+
+Status DeserializeCompilationResult(const XlaCompilationResultProto& proto,
+                                    XlaCompilationResult* result) {
+  result->input_mapping.assign(proto.input_mapping().begin(),
+                               proto.input_mapping().end());
+  result->xla_input_shapes.clear();
+  for (const xla::ShapeProto& shape : proto.xla_input_shapes()) {
+    result->xla_input_shapes.emplace_back(shape);
+  }
+  result->xla_output_shape = xla::Shape(proto.xla_output_shape());
+  result->outputs.clear();
+  for (const XlaOutputDescriptionProto& output_proto : proto.outputs()) {
+    XlaOutputDescription output;
+    output.type = output_proto.type();
+    TF_RETURN_IF_ERROR(ShapeFromProto(output_proto.shape(), &output.shape));
+    output.is_constant = output_proto.is_constant();
+    if (output.is_constant &&
+        !output.constant_value.FromProto(output_proto.constant_value())) {
+      return errors::DataLoss("Invalid constant output in XLA cache entry");
+    }
+    output.input_index = output_proto.input_index();
+    output.is_tensor_list = output_proto.is_tensor_list();
+    result->outputs.push_back(std::move(output));
+  }
+  result->host_compute_metadata = proto.host_compute_metadata();
+  result->resource_updates.clear();
+  for (const XlaResourceUpdateProto& update_proto : proto.resource_updates()) {
+    XlaResourceUpdate update;
+    update.input_index = update_proto.input_index();
+    update.type = update_proto.type();
+    TF_RETURN_IF_ERROR(ShapeFromProto(update_proto.shape(), &update.shape));
+    update.modified = update_proto.modified();
+    update.tensor_array_gradients_accessed.insert(
+        update_proto.tensor_array_gradients_accessed().begin(),
+        update_proto.tensor_array_gradients_accessed().end());
+    result->resource_updates.push_back(std::move(update));
+  }
+  result->computation =
+      std::make_shared<xla::XlaComputation>(proto.computation());
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,95 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+#define TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
+
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
+#include "tensorflow/compiler/tf2xla/xla_helpers.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A content-addressed, on-disk cache of XLA compilation results.
+//
+// Entries are stored one per file in a flat directory, named after the cache
+// key.  Each file holds a checksummed XlaPersistentCacheRecord; files that fail
+// to parse or whose checksum does not match are treated as misses and deleted.
+// Writes go through a temporary file followed by a rename, so concurrent
+// processes sharing the directory never observe partially written entries.
+//
+// The total size of the directory is bounded; once the bound is exceeded the
+// least recently written entries are evicted.
+//
+// This class is thread-safe.
+class XlaPersistentCompilationCache {
+ public:
+  struct Stats {
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 corrupt_entries = 0;
+    int64 insertions = 0;
+    int64 evictions = 0;
+  };
+
+  XlaPersistentCompilationCache(Env* env, string directory,
+                                int64 max_size_bytes);
+
+  // Returns the process-wide cache configured through
+  // --tf_xla_persistent_cache_directory, or nullptr if persistent caching is
+  // disabled or the directory could not be created.
+  static XlaPersistentCompilationCache* Global();
+
+  // Reads the entry stored under `key` into `*entry`.  Returns NotFound if
+  // there is no such entry and DataLoss if the entry was corrupt.
+  Status Lookup(const string& key, XlaPersistentCacheEntry* entry);
+
+  // Stores `entry` under `key`, replacing any existing entry, and evicts old
+  // entries if the cache has grown beyond its size bound.
+  Status Insert(const string& key, const XlaPersistentCacheEntry& entry);
+
+  Stats stats() const;
+
+  const string& directory() const { return directory_; }
+
+ private:
+  string FilePath(const string& key) const;
+
+  // Deletes the oldest entries until the directory fits in `max_size_bytes_`.
+  Status MaybeEvict();
+
+  Env* const env_;
+  const string directory_;
+  const int64 max_size_bytes_;
+
+  mutable mutex mu_;
+  Stats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(XlaPersistentCompilationCache);
+};
+
+// Converts between XlaCompilationResult and its serialized form.
+Status SerializeCompilationResult(const XlaCompilationResult& result,
+                                  XlaCompilationResultProto* proto);
+Status DeserializeCompilationResult(const XlaCompilationResultProto& proto,
+                                    XlaCompilationResult* result);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_XLA_PERSISTENT_COMPILATION_CACHE_H_
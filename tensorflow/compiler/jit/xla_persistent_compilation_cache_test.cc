@@ -0,0 +1,243 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/xla_persistent_compilation_cache.h"
+
+#include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/tf2xla/xla_op_registry.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TestDirectory(const string& name) {
+  string dir = io::JoinPath(testing::TmpDir(), name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(dir));
+  return dir;
+}
+
+XlaPersistentCacheEntry MakeEntry(const string& signature, int payload_size) {
+  XlaPersistentCacheEntry entry;
+  entry.set_signature(signature);
+  entry.mutable_optimized_hlo()->set_name(string(payload_size, 'x'));
+  return entry;
+}
+
+TEST(XlaPersistentCompilationCacheTest, InsertAndLookup) {
+  XlaPersistentCompilationCache cache(
+      Env::Default(), TestDirectory("insert_and_lookup"), 1 << 20);
+
+  XlaPersistentCacheEntry entry;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup("key", &entry)));
+
+  TF_ASSERT_OK(cache.Insert("key", MakeEntry("signature", 16)));
+  TF_ASSERT_OK(cache.Lookup("key", &entry));
+  EXPECT_EQ(entry.signature(), "signature");
+
+  XlaPersistentCompilationCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.insertions, 1);
+  EXPECT_EQ(stats.corrupt_entries, 0);
+}
+
+TEST(XlaPersistentCompilationCacheTest, SharedAcrossInstances) {
+  const string dir = TestDirectory("shared_across_instances");
+  {
+    XlaPersistentCompilationCache writer(Env::Default(), dir, 1 << 20);
+    TF_ASSERT_OK(writer.Insert("key", MakeEntry("signature", 16)));
+  }
+  XlaPersistentCompilationCache reader(Env::Default(), dir, 1 << 20);
+  XlaPersistentCacheEntry entry;
+  TF_ASSERT_OK(reader.Lookup("key", &entry));
+  EXPECT_EQ(entry.signature(), "signature");
+}
+
+TEST(XlaPersistentCompilationCacheTest, CorruptEntryIsDetectedAndRemoved) {
+  const string dir = TestDirectory("corrupt_entry");
+  XlaPersistentCompilationCache cache(Env::Default(), dir, 1 << 20);
+  TF_ASSERT_OK(cache.Insert("key", MakeEntry("signature", 64)));
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(dir, &children));
+  ASSERT_EQ(children.size(), 1);
+  const string path = io::JoinPath(dir, children[0]);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  // Flip a byte in the middle of the payload.
+  contents[contents.size() / 2] ^= 0xff;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, contents));
+
+  XlaPersistentCacheEntry entry;
+  EXPECT_TRUE(errors::IsDataLoss(cache.Lookup("key", &entry)));
+  EXPECT_EQ(cache.stats().corrupt_entries, 1);
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(path)));
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup("key", &entry)));
+}
+
+TEST(XlaPersistentCompilationCacheTest, MisplacedEntryIsRejected) {
+  const string dir = TestDirectory("misplaced_entry");
+  XlaPersistentCompilationCache cache(Env::Default(), dir, 1 << 20);
+  TF_ASSERT_OK(cache.Insert("key1", MakeEntry("signature", 16)));
+  TF_ASSERT_OK(Env::Default()->RenameFile(
+      io::JoinPath(dir, "key1.xla_cache"), io::JoinPath(dir, "key2.xla_cache")));
+
+  XlaPersistentCacheEntry entry;
+  EXPECT_TRUE(errors::IsDataLoss(cache.Lookup("key2", &entry)));
+}
+
+TEST(XlaPersistentCompilationCacheTest, EvictsOldestEntries) {
+  const string dir = TestDirectory("evicts_oldest_entries");
+  // Each entry is a little over 1KB, so only two of them fit.
+  XlaPersistentCompilationCache cache(Env::Default(), dir, 2500);
+  TF_ASSERT_OK(cache.Insert("key1", MakeEntry("signature1", 1024)));
+  Env::Default()->SleepForMicroseconds(10000);
+  TF_ASSERT_OK(cache.Insert("key2", MakeEntry("signature2", 1024)));
+  Env::Default()->SleepForMicroseconds(10000);
+  TF_ASSERT_OK(cache.Insert("key3", MakeEntry("signature3", 1024)));
+
+  EXPECT_EQ(cache.stats().evictions, 1);
+  XlaPersistentCacheEntry entry;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup("key1", &entry)));
+  TF_EXPECT_OK(cache.Lookup("key2", &entry));
+  TF_EXPECT_OK(cache.Lookup("key3", &entry));
+}
+
+TEST(XlaPersistentCompilationCacheTest, CompilationResultRoundTrip) {
+  xla::XlaBuilder builder("computation");
+  xla::Parameter(&builder, 0, xla::ShapeUtil::MakeShape(xla::F32, {2}), "p");
+  TF_ASSERT_OK_AND_ASSIGN(xla::XlaComputation computation, builder.Build());
+
+  XlaCompilationResult result;
+  result.input_mapping = {0, 2};
+  result.xla_input_shapes = {xla::ShapeUtil::MakeShape(xla::F32, {2})};
+  result.xla_output_shape = xla::ShapeUtil::MakeTupleShape(
+      {xla::ShapeUtil::MakeShape(xla::F32, {2})});
+  XlaOutputDescription output;
+  output.type = DT_INT32;
+  output.shape = TensorShape({2});
+  output.is_constant = true;
+  output.constant_value = test::AsTensor<int32>({3, 4});
+  output.input_index = 1;
+  result.outputs.push_back(output);
+  XlaResourceUpdate update;
+  update.input_index = 2;
+  update.type = DT_FLOAT;
+  update.shape = TensorShape({2});
+  update.modified = true;
+  update.tensor_array_gradients_accessed = {"grad"};
+  result.resource_updates.push_back(update);
+  result.computation =
+      std::make_shared<xla::XlaComputation>(std::move(computation));
+
+  XlaCompilationResultProto proto;
+  TF_ASSERT_OK(SerializeCompilationResult(result, &proto));
+  XlaCompilationResult restored;
+  TF_ASSERT_OK(DeserializeCompilationResult(proto, &restored));
+
+  EXPECT_EQ(restored.input_mapping, result.input_mapping);
+  ASSERT_EQ(restored.xla_input_shapes.size(), 1);
+  EXPECT_TRUE(xla::ShapeUtil::Equal(restored.xla_input_shapes[0],
+                                    result.xla_input_shapes[0]));
+  EXPECT_TRUE(xla::ShapeUtil::Equal(restored.xla_output_shape,
+                                    result.xla_output_shape));
+  ASSERT_EQ(restored.outputs.size(), 1);
+  EXPECT_EQ(restored.outputs[0].type, DT_INT32);
+  EXPECT_EQ(restored.outputs[0].shape, TensorShape({2}));
+  EXPECT_TRUE(restored.outputs[0].is_constant);
+  test::ExpectTensorEqual<int32>(restored.outputs[0].constant_value,
+                                 output.constant_value);
+  EXPECT_EQ(restored.outputs[0].input_index, 1);
+  ASSERT_EQ(restored.resource_updates.size(), 1);
+  EXPECT_EQ(restored.resource_updates[0].input_index, 2);
+  EXPECT_TRUE(restored.resource_updates[0].modified);
+  EXPECT_EQ(restored.resource_updates[0].tensor_array_gradients_accessed,
+            update.tensor_array_gradients_accessed);
+  EXPECT_EQ(restored.computation->proto().SerializeAsString(),
+            result.computation->proto().SerializeAsString());
+}
+
+TEST(XlaPersistentCompilationCacheTest, ReusedByXlaCompilationCache) {
+  XlaOpRegistry::RegisterCompilationKernels();
+  XlaPersistentCompilationCache persistent_cache(
+      Env::Default(), TestDirectory("reused_by_compilation_cache"), 1 << 30);
+
+  FunctionDefLibrary flib;
+  *flib.add_function() = test::function::XTimesTwo();
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), flib);
+
+  xla::LocalClient* client = xla::ClientLibrary::LocalClientOrDie();
+  XlaCompiler::Options options;
+  options.device_type = DeviceType(DEVICE_CPU_XLA_JIT);
+  options.client = client;
+  options.flib_def = &flib_def;
+
+  NameAttrList fn;
+  fn.set_name("XTimesTwo");
+  (*fn.mutable_attr())["T"].set_type(DT_FLOAT);
+  std::vector<XlaCompiler::Argument> args(1);
+  args[0].kind = XlaCompiler::Argument::kParameter;
+  args[0].type = DT_FLOAT;
+  args[0].shape = TensorShape({2});
+
+  auto compile = [&](XlaCompilationCache* cache) {
+    const XlaCompiler::CompilationResult* compilation_result;
+    xla::LocalExecutable* executable;
+    TF_ASSERT_OK(cache->Compile(options, fn, args,
+                                XlaCompiler::CompileOptions{},
+                                XlaCompilationCache::CompileMode::kStrict,
+                                &compilation_result, &executable));
+    ASSERT_NE(compilation_result, nullptr);
+    ASSERT_NE(executable, nullptr);
+    EXPECT_EQ(compilation_result->outputs.size(), 1);
+  };
+
+  // The first cache compiles from scratch and populates the persistent cache.
+  auto* cache1 = new XlaCompilationCache(client, DeviceType(DEVICE_CPU_XLA_JIT),
+                                         &persistent_cache);
+  core::ScopedUnref cache1_ref(cache1);
+  compile(cache1);
+  EXPECT_EQ(persistent_cache.stats().misses, 1);
+  EXPECT_EQ(persistent_cache.stats().insertions, 1);
+
+  // A fresh cache, as in a restarted process, loads the entry from disk.
+  auto* cache2 = new XlaCompilationCache(client, DeviceType(DEVICE_CPU_XLA_JIT),
+                                         &persistent_cache);
+  core::ScopedUnref cache2_ref(cache2);
+  compile(cache2);
+  EXPECT_EQ(persistent_cache.stats().hits, 1);
+  EXPECT_EQ(persistent_cache.stats().insertions, 1);
+
+  // A different argument shape is a different entry.
+  args[0].shape = TensorShape({3});
+  compile(cache2);
+  EXPECT_EQ(persistent_cache.stats().misses, 2);
+  EXPECT_EQ(persistent_cache.stats().insertions, 2);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -207,6 +207,24 @@ class Compiler {
       std::unique_ptr<HloModule> module, se::StreamExecutor* executor,
       se::DeviceMemoryAllocator* device_allocator) = 0;
 
+  // Serializes the machine code of `executable`, an executable returned by
+  // RunBackend, so that LoadExecutable can rebuild it without running the
+  // code generator again.
+  virtual StatusOr<std::string> SerializeExecutable(
+      const Executable& executable) const {
+    return Unimplemented("This compiler does not support this method");
+  }
+
+  // Rebuilds an executable from the output of SerializeExecutable. `module`
+  // must be the module of the serialized executable. Returns a
+  // FailedPrecondition error if the machine code cannot be run on the device
+  // given by the executor, or no longer matches the module.
+  virtual StatusOr<std::unique_ptr<Executable>> LoadExecutable(
+      std::unique_ptr<HloModule> module, const std::string& serialized,
+      se::StreamExecutor* executor) {
+    return Unimplemented("This compiler does not support this method");
+  }
+
   // Compiles a set of HLO modules that can run in parallel, potentially
   // communicating data between the modules, and returns a corresponding
   // sequence of executable objects.
@@ -40,6 +40,7 @@ limitations under the License.
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
@@ -71,6 +72,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/conv_canonicalization.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_executable.pb.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_layout_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
@@ -127,7 +129,9 @@ limitations under the License.
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/platform/dynamic_annotations.h"
+#include "tensorflow/core/platform/fingerprint.h"
 
 namespace {
 
@@ -624,6 +628,16 @@ struct OrcJITPostCompilationHook {
   const HloModule* module;
 };
 
+// Fingerprints `assignment`. The buffer table indices of the generated code
+// depend on the buffer assignment, so object code is only reloaded against a
+// buffer assignment with the same fingerprint.
+uint64 BufferAssignmentFingerprint(const BufferAssignment& assignment) {
+  string serialized;
+  tensorflow::SerializeToStringDeterministic(assignment.ToProto(),
+                                             &serialized);
+  return tensorflow::Fingerprint64(serialized);
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
@@ -651,6 +665,9 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   auto llvm_module =
       absl::make_unique<llvm::Module>("__compute_module", *llvm_context);
 
+  // The object files are kept in the executable, so that SerializeExecutable
+  // can save the machine code.
+  auto obj_files = std::make_shared<std::vector<string>>();
   auto jit = SimpleOrcJIT::Create(
       CompilerTargetOptions(module->config()),
       CodeGenOptLevel(module->config()),
@@ -658,7 +675,12 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
       module->config().debug_options().xla_llvm_disable_expensive_passes(),
       llvm_ir::GetCpuFastMathFlags(module->config()), pre_optimization_ir_hook,
       post_optimization_ir_hook,
-      OrcJITPostCompilationHook::Create(module.get()));
+      [dump_hook = OrcJITPostCompilationHook::Create(module.get()),
+       obj_files](const llvm::object::ObjectFile& obj_file) {
+        dump_hook(obj_file);
+        obj_files->emplace_back(obj_file.getData().data(),
+                                obj_file.getData().size());
+      });
   if (!jit) {
     return InternalError("Creating JIT failed: %s",
                          llvm::toString(jit.takeError()));
@@ -763,6 +785,10 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   cpu_executable.reset(new CpuExecutable(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
       std::move(hlo_profile_printer_data), std::move(hlo_profile_index_map)));
+  // The constructor looked up the entry function, which ran the code
+  // generator on the module.
+  static_cast<CpuExecutable&>(*cpu_executable)
+      .set_obj_files(std::move(*obj_files));
 
   if (embed_ir_in_executable) {
     static_cast<CpuExecutable&>(*cpu_executable)
@@ -773,6 +799,123 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
   return std::move(cpu_executable);
 }
 
+StatusOr<std::string> CpuCompiler::SerializeExecutable(
+    const Executable& executable) const {
+  const auto& cpu_executable = static_cast<const CpuExecutable&>(executable);
+  if (cpu_executable.obj_files().empty()) {
+    return FailedPrecondition("No object code was kept for %s",
+                              executable.module().name());
+  }
+  CpuExecutableProto proto;
+  const llvm::TargetMachine* target_machine =
+      cpu_executable.jit().target_machine();
+  proto.set_target_triple(target_machine->getTargetTriple().str());
+  proto.set_target_cpu(target_machine->getTargetCPU().str());
+  proto.set_target_features(target_machine->getTargetFeatureString().str());
+  proto.set_buffer_assignment_fingerprint(
+      BufferAssignmentFingerprint(cpu_executable.buffer_assignment()));
+  proto.set_entry_function_name(cpu_executable.entry_function_name());
+  for (const string& obj_file : cpu_executable.obj_files()) {
+    proto.add_obj_files(obj_file);
+  }
+  return proto.SerializeAsString();
+}
+
+StatusOr<std::unique_ptr<Executable>> CpuCompiler::LoadExecutable(
+    std::unique_ptr<HloModule> module, const std::string& serialized,
+    se::StreamExecutor* stream_exec) {
+  VLOG(1) << "Loading: " << module->name();
+  XLA_SCOPED_LOGGING_TIMER(
+      absl::StrFormat("Loading [%s] for CPU from object code", module->name()));
+
+  TF_RET_CHECK(stream_exec != nullptr);
+  CpuExecutableProto proto;
+  if (!proto.ParseFromString(serialized)) {
+    return InvalidArgument("Failed to parse the object code of %s",
+                           module->name());
+  }
+  absl::call_once(llvm_command_line_options_initialized,
+                  &llvm_ir::InitializeLLVMCommandLineOptions, module->config());
+
+  // No module is added to this JIT, so the compiler hooks are never run.
+  auto jit = SimpleOrcJIT::Create(
+      CompilerTargetOptions(module->config()),
+      CodeGenOptLevel(module->config()),
+      options::OptimizeForSizeRequested(module->config()),
+      module->config().debug_options().xla_llvm_disable_expensive_passes(),
+      llvm_ir::GetCpuFastMathFlags(module->config()),
+      /*pre_optimization_hook=*/nullptr, /*post_optimization_hook=*/nullptr,
+      /*post_codegen_hook=*/nullptr);
+  if (!jit) {
+    return InternalError("Creating JIT failed: %s",
+                         llvm::toString(jit.takeError()));
+  }
+  const llvm::TargetMachine* target_machine = (*jit)->target_machine();
+  if (proto.target_triple() != target_machine->getTargetTriple().str() ||
+      proto.target_cpu() != target_machine->getTargetCPU().str() ||
+      proto.target_features() !=
+          target_machine->getTargetFeatureString().str()) {
+    return FailedPrecondition(
+        "The object code of %s was generated for %s (%s), not for this host",
+        module->name(), proto.target_triple(), proto.target_cpu());
+  }
+
+  std::unordered_map<const HloInstruction*, int64> instruction_to_profile_idx;
+  std::unordered_map<const HloComputation*, int64> computation_to_profile_idx;
+  std::unique_ptr<HloProfileIndexMap> hlo_profile_index_map;
+  std::unique_ptr<HloProfilePrinterData> hlo_profile_printer_data;
+  if (module->config().hlo_profiling_enabled()) {
+    TF_RETURN_IF_ERROR(CreateHloProfilingArtifacts(
+        *module, &instruction_to_profile_idx, &computation_to_profile_idx,
+        &hlo_profile_index_map, &hlo_profile_printer_data));
+  }
+
+  // Recompute the schedule and buffer assignment of RunBackend; both are
+  // deterministic, and the fingerprint check catches any divergence.
+  TF_ASSIGN_OR_RETURN(HloSchedule schedule,
+                      ScheduleModule(module.get(), BufferSizeBytesFunction(),
+                                     ComputationSchedulerToModuleScheduler(
+                                         DFSMemoryScheduler)));
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<BufferAssignment> assignment,
+      BufferAssigner::Run(module.get(),
+                          absl::make_unique<SequentialHloOrdering>(schedule),
+                          BufferSizeBytesFunction(), memory_alignment,
+                          /*allocate_buffers_for_constants=*/true));
+  if (BufferAssignmentFingerprint(*assignment) !=
+      proto.buffer_assignment_fingerprint()) {
+    return FailedPrecondition(
+        "The buffer assignment of %s does not match its object code",
+        module->name());
+  }
+
+  for (const string& obj_file : proto.obj_files()) {
+    llvm::Error error = (*jit)->AddObjectFile(
+        llvm::MemoryBuffer::getMemBufferCopy(obj_file, module->name()));
+    if (error) {
+      return InternalError("Failed to load the object code of %s: %s",
+                           module->name(), llvm::toString(std::move(error)));
+    }
+  }
+  // CpuExecutable requires the entry function to exist.
+  auto entry_function =
+      (*jit)->FindCompiledSymbol(proto.entry_function_name());
+  if (!entry_function) {
+    return InternalError("Entry function %s of %s not found: %s",
+                         proto.entry_function_name(), module->name(),
+                         llvm::toString(entry_function.takeError()));
+  }
+
+  auto cpu_executable = absl::make_unique<CpuExecutable>(
+      std::move(*jit), std::move(assignment), std::move(module),
+      proto.entry_function_name(), std::move(hlo_profile_printer_data),
+      std::move(hlo_profile_index_map));
+  cpu_executable->set_obj_files(
+      std::vector<string>(proto.obj_files().begin(), proto.obj_files().end()));
+  VLOG(1) << "Loading finished";
+  return std::unique_ptr<Executable>(std::move(cpu_executable));
+}
+
 StatusOr<std::vector<std::unique_ptr<AotCompilationResult>>>
 CpuCompiler::CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
                                 const AotCompilationOptions& aot_options) {
@@ -147,6 +147,15 @@ class CpuCompiler : public LLVMCompiler {
       std::unique_ptr<HloModule> module, se::StreamExecutor* stream_exec,
       se::DeviceMemoryAllocator* device_allocator) override;
 
+  // The serialized executable holds the object files generated by RunBackend
+  // and is only loaded on a host with the same target CPU and features.
+  StatusOr<std::string> SerializeExecutable(
+      const Executable& executable) const override;
+
+  StatusOr<std::unique_ptr<Executable>> LoadExecutable(
+      std::unique_ptr<HloModule> module, const std::string& serialized,
+      se::StreamExecutor* stream_exec) override;
+
   StatusOr<std::vector<std::unique_ptr<AotCompilationResult>>>
   CompileAheadOfTime(std::unique_ptr<HloModuleGroup> module_group,
                      const AotCompilationOptions& options) override;
@@ -81,6 +81,20 @@ class CpuExecutable : public Executable {
 
   const BufferAssignment& buffer_assignment() const { return *assignment_; }
 
+  const SimpleOrcJIT& jit() const { return *jit_; }
+
+  const string& entry_function_name() const { return entry_function_name_; }
+
+  // The object files that the JIT generated for this executable. They are
+  // kept so that CpuCompiler::SerializeExecutable can persist the machine
+  // code; empty if the executable was not built by CpuCompiler::RunBackend or
+  // CpuCompiler::LoadExecutable.
+  const std::vector<string>& obj_files() const { return obj_files_; }
+
+  void set_obj_files(std::vector<string> obj_files) {
+    obj_files_ = std::move(obj_files);
+  }
+
   int64 SizeOfGeneratedCodeInBytes() const override;
 
  private:
@@ -142,6 +156,8 @@ class CpuExecutable : public Executable {
   // Entry function name for the computation.
   const string entry_function_name_;
 
+  std::vector<string> obj_files_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CpuExecutable);
 };
 
@@ -214,6 +214,11 @@ llvm::Error SimpleOrcJIT::AddModule(llvm::orc::ThreadSafeModule module) {
   return compile_layer_.add(*main_jit_dylib_, std::move(module));
 }
 
+llvm::Error SimpleOrcJIT::AddObjectFile(
+    std::unique_ptr<llvm::MemoryBuffer> object) {
+  return object_layer_.add(*main_jit_dylib_, std::move(object));
+}
+
 llvm::Expected<llvm::JITEvaluatedSymbol> SimpleOrcJIT::FindCompiledSymbol(
     const std::string& name) {
   return execution_session_->lookup({main_jit_dylib_}, name);
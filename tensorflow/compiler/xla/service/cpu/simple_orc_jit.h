@@ -28,6 +28,7 @@ limitations under the License.
 #include "llvm/ExecutionEngine/Orc/SymbolStringPool.h"
 #include "llvm/ExecutionEngine/Orc/TargetProcessControl.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/types.h"
@@ -79,6 +80,11 @@ class SimpleOrcJIT : public llvm::JITEventListener {
 
   llvm::Error AddModule(llvm::orc::ThreadSafeModule module);
 
+  // Adds an object file that was previously generated for this target, e.g.
+  // by the post_codegen_hook of another JIT. The code is linked as is, without
+  // running the compiler.
+  llvm::Error AddObjectFile(std::unique_ptr<llvm::MemoryBuffer> object);
+
   // Get the runtime address of the compiled symbol whose name is given. Returns
   // nullptr if the symbol cannot be found.
   llvm::Expected<llvm::JITEvaluatedSymbol> FindCompiledSymbol(
@@ -0,0 +1,125 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/compiler.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_executable.pb.h"
+#include "tensorflow/compiler/xla/service/executable.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+const char* const kHloText = R"(
+HloModule AddConstantAndExp
+
+ENTRY main {
+  p = f32[4] parameter(0)
+  c = f32[4] constant({1, 2, 3, 4})
+  add = f32[4] add(p, c)
+  ROOT exp = f32[4] exponential(add)
+}
+)";
+
+class CpuSerializeExecutableTest : public HloTestBase {
+ protected:
+  // Compiles kHloText and serializes the executable.
+  void CompileAndSerialize(std::unique_ptr<Executable>* executable,
+                           string* serialized) {
+    TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                            ParseAndReturnVerifiedModule(kHloText));
+    TF_ASSERT_OK_AND_ASSIGN(
+        *executable, test_runner_.CreateExecutable(std::move(module),
+                                                   /*run_hlo_passes=*/true));
+    TF_ASSERT_OK_AND_ASSIGN(
+        *serialized, backend().compiler()->SerializeExecutable(**executable));
+  }
+
+  // Loads `serialized` for a copy of the module of `executable` that went
+  // through its proto, as in the persistent compilation cache.
+  StatusOr<std::unique_ptr<Executable>> Load(const Executable& executable,
+                                             const string& serialized) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<HloModule> module,
+        HloModule::CreateFromProto(executable.module().ToProto(),
+                                   executable.module().config()));
+    return backend().compiler()->LoadExecutable(
+        std::move(module), serialized, backend().default_stream_executor());
+  }
+};
+
+TEST_F(CpuSerializeExecutableTest, LoadedExecutableComputesTheSameResult) {
+  std::unique_ptr<Executable> executable;
+  string serialized;
+  CompileAndSerialize(&executable, &serialized);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Executable> loaded,
+                          Load(*executable, serialized));
+
+  std::vector<Literal> args;
+  args.push_back(LiteralUtil::CreateR1<float>({0, -1, 0.5, -4}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal expected,
+                          test_runner_.Execute(std::move(executable), args));
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual,
+                          test_runner_.Execute(std::move(loaded), args));
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, actual));
+}
+
+TEST_F(CpuSerializeExecutableTest, LoadedExecutableCanBeSerializedAgain) {
+  std::unique_ptr<Executable> executable;
+  string serialized;
+  CompileAndSerialize(&executable, &serialized);
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Executable> loaded,
+                          Load(*executable, serialized));
+  TF_ASSERT_OK_AND_ASSIGN(string reserialized,
+                          backend().compiler()->SerializeExecutable(*loaded));
+  EXPECT_EQ(reserialized, serialized);
+}
+
+TEST_F(CpuSerializeExecutableTest, RejectsCodeForAnotherCpu) {
+  std::unique_ptr<Executable> executable;
+  string serialized;
+  CompileAndSerialize(&executable, &serialized);
+  CpuExecutableProto proto;
+  ASSERT_TRUE(proto.ParseFromString(serialized));
+  proto.set_target_cpu("not-a-cpu");
+  EXPECT_EQ(Load(*executable, proto.SerializeAsString()).status().code(),
+            tensorflow::error::FAILED_PRECONDITION);
+}
+
+TEST_F(CpuSerializeExecutableTest, RejectsCodeForAnotherBufferAssignment) {
+  std::unique_ptr<Executable> executable;
+  string serialized;
+  CompileAndSerialize(&executable, &serialized);
+  CpuExecutableProto proto;
+  ASSERT_TRUE(proto.ParseFromString(serialized));
+  proto.set_buffer_assignment_fingerprint(
+      proto.buffer_assignment_fingerprint() + 1);
+  EXPECT_EQ(Load(*executable, proto.SerializeAsString()).status().code(),
+            tensorflow::error::FAILED_PRECONDITION);
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -37,15 +38,28 @@ limitations under the License.
 namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
+constexpr size_t BFCAllocator::kMaxSmallAllocationCacheSize;
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                            bool allow_growth, const string& name,
-                           bool garbage_collection)
+                           bool garbage_collection, bool small_allocation_cache)
     : garbage_collection_(garbage_collection),
       sub_allocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      small_allocation_cache_(small_allocation_cache) {
+  static_assert(kMinAllocationSize << (kNumSmallAllocationClasses - 1) ==
+                    kMaxSmallAllocationCacheSize,
+                "Size classes must cover all small allocations");
+  if (small_allocation_cache_) {
+    small_allocation_shards_.reset(
+        new SmallAllocationShard[kNumSmallAllocationShards]);
+  }
+  for (auto& num_cached : num_cached_small_blocks_) {
+    num_cached = 0;
+  }
+
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -210,6 +224,10 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
   }
   void* r =
       AllocateRawInternal(unused_alignment, num_bytes, false, freed_by_count);
+  if (r == nullptr && FlushSmallAllocationCache()) {
+    r = AllocateRawInternal(unused_alignment, num_bytes, false,
+                            freed_by_count);
+  }
   if (r != nullptr) {
     return r;
   } else {
@@ -230,6 +248,26 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(1) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (small_allocation_cache_ && num_bytes > 0 &&
+      num_bytes <= kMaxSmallAllocationCacheSize &&
+      allocation_attr.freed_by_func == nullptr && timing_counter_ == nullptr) {
+    const int size_class = SmallAllocationClass(num_bytes);
+    void* ptr = AllocateFromSmallAllocationCache(size_class);
+    if (ptr != nullptr) return ptr;
+    // Allocate a block of the full class size, so that it can be reused for
+    // any allocation of the same class once it is freed.
+    ptr = AllocateRawUncached(unused_alignment,
+                              SmallAllocationClassSize(size_class),
+                              allocation_attr);
+    if (ptr != nullptr) AddToSmallAllocationCache(ptr, size_class);
+    return ptr;
+  }
+  return AllocateRawUncached(unused_alignment, num_bytes, allocation_attr);
+}
+
+void* BFCAllocator::AllocateRawUncached(
+    size_t unused_alignment, size_t num_bytes,
+    const AllocationAttributes& allocation_attr) {
   if (!allocation_attr.retry_on_failure) {
     // Return immediately upon the first failure if this is for allocating an
     // optional scratch space.
@@ -240,6 +278,10 @@ void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
     }
     void* result = AllocateRawInternal(unused_alignment, num_bytes,
                                        dump_log_on_failure, freed_by_count);
+    if (result == nullptr && FlushSmallAllocationCache()) {
+      result = AllocateRawInternal(unused_alignment, num_bytes,
+                                   dump_log_on_failure, freed_by_count);
+    }
     if (result == nullptr) {
       static std::atomic<int32> log_counter{0};
       int32 counter_value = log_counter.load(std::memory_order_relaxed);
@@ -617,10 +659,123 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  // Only look the pointer up in the cache while it tracks small blocks, so
+  // that deallocations do not take a shard lock when the cache is unused.
+  if (small_allocation_cache_ && ptr != nullptr &&
+      num_small_allocation_blocks_.load(std::memory_order_relaxed) > 0 &&
+      DeallocateToSmallAllocationCache(ptr)) {
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
 
+// static
+int BFCAllocator::SmallAllocationClass(size_t num_bytes) {
+  DCHECK_LE(num_bytes, kMaxSmallAllocationCacheSize);
+  int size_class = 0;
+  while (SmallAllocationClassSize(size_class) < num_bytes) ++size_class;
+  return size_class;
+}
+
+BFCAllocator::SmallAllocationShard& BFCAllocator::SmallAllocationShardFor(
+    const void* ptr) {
+  // Blocks are at least kMinAllocationSize aligned, so skip the low bits.
+  const uint64 address = reinterpret_cast<uintptr_t>(ptr) >> kMinAllocationBits;
+  return small_allocation_shards_[Hash64Combine(address, 0) %
+                                  kNumSmallAllocationShards];
+}
+
+void* BFCAllocator::AllocateFromSmallAllocationCache(int size_class) {
+  if (num_cached_small_blocks_[size_class].load(std::memory_order_relaxed) <=
+      0) {
+    return nullptr;
+  }
+  // Threads start their search at different shards to spread the contention.
+  static std::atomic<int> next_thread_shard{0};
+  thread_local const int thread_shard =
+      next_thread_shard.fetch_add(1, std::memory_order_relaxed);
+  for (int i = 0; i < kNumSmallAllocationShards; ++i) {
+    SmallAllocationShard& shard =
+        small_allocation_shards_[(thread_shard + i) %
+                                 kNumSmallAllocationShards];
+    mutex_lock l(shard.mu);
+    std::vector<void*>& free_blocks = shard.free_blocks[size_class];
+    if (free_blocks.empty()) continue;
+    void* ptr = free_blocks.back();
+    free_blocks.pop_back();
+    num_cached_small_blocks_[size_class].fetch_sub(1,
+                                                   std::memory_order_relaxed);
+    small_allocation_cache_bytes_.fetch_sub(
+        SmallAllocationClassSize(size_class), std::memory_order_relaxed);
+    small_allocation_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+  }
+  return nullptr;
+}
+
+void BFCAllocator::AddToSmallAllocationCache(void* ptr, int size_class) {
+  SmallAllocationShard& shard = SmallAllocationShardFor(ptr);
+  mutex_lock l(shard.mu);
+  if (shard.size_classes.insert_or_assign(ptr, size_class).second) {
+    num_small_allocation_blocks_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool BFCAllocator::DeallocateToSmallAllocationCache(void* ptr) {
+  SmallAllocationShard& shard = SmallAllocationShardFor(ptr);
+  mutex_lock l(shard.mu);
+  auto it = shard.size_classes.find(ptr);
+  if (it == shard.size_classes.end()) return false;
+  const int size_class = it->second;
+  const size_t class_size = SmallAllocationClassSize(size_class);
+  std::vector<void*>& free_blocks = shard.free_blocks[size_class];
+  if ((free_blocks.size() + 1) * class_size >
+      kMaxSmallAllocationFreeListBytes) {
+    shard.size_classes.erase(it);
+    num_small_allocation_blocks_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+  free_blocks.push_back(ptr);
+  num_cached_small_blocks_[size_class].fetch_add(1, std::memory_order_relaxed);
+  small_allocation_cache_bytes_.fetch_add(class_size,
+                                          std::memory_order_relaxed);
+  return true;
+}
+
+bool BFCAllocator::FlushSmallAllocationCache() {
+  if (!small_allocation_cache_) return false;
+  std::vector<void*> blocks;
+  for (int i = 0; i < kNumSmallAllocationShards; ++i) {
+    SmallAllocationShard& shard = small_allocation_shards_[i];
+    mutex_lock l(shard.mu);
+    for (int size_class = 0; size_class < kNumSmallAllocationClasses;
+         ++size_class) {
+      std::vector<void*>& free_blocks = shard.free_blocks[size_class];
+      for (void* ptr : free_blocks) {
+        shard.size_classes.erase(ptr);
+        blocks.push_back(ptr);
+      }
+      num_cached_small_blocks_[size_class].fetch_sub(
+          free_blocks.size(), std::memory_order_relaxed);
+      small_allocation_cache_bytes_.fetch_sub(
+          free_blocks.size() * SmallAllocationClassSize(size_class),
+          std::memory_order_relaxed);
+      free_blocks.clear();
+    }
+  }
+  if (blocks.empty()) return false;
+  num_small_allocation_blocks_.fetch_sub(blocks.size(),
+                                         std::memory_order_relaxed);
+  VLOG(1) << "Returning " << blocks.size()
+          << " cached small allocations to the bins of " << Name();
+  for (void* ptr : blocks) {
+    DeallocateRawInternal(ptr);
+  }
+  retry_helper_.NotifyDealloc();
+  return true;
+}
+
 void BFCAllocator::DeallocateRawInternal(void* ptr) {
   if (ptr == nullptr) {
     VLOG(2) << "tried to deallocate nullptr";
@@ -1141,11 +1296,22 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  if (small_allocation_cache_) {
+    // Cached blocks are in use as far as the bins are concerned.
+    stats.bytes_in_cache =
+        small_allocation_cache_bytes_.load(std::memory_order_relaxed);
+    stats.num_cache_hits =
+        small_allocation_cache_hits_.load(std::memory_order_relaxed);
+    stats.bytes_in_use -= stats.bytes_in_cache;
+    stats.num_allocs += stats.num_cache_hits;
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
+  small_allocation_cache_hits_.store(0, std::memory_order_relaxed);
   stats_.num_allocs = 0;
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
@@ -17,12 +17,14 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -49,9 +51,16 @@ class MemoryDump;
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
+  //
+  // If `small_allocation_cache` is true, freed allocations of up to
+  // kMaxSmallAllocationCacheSize bytes are kept in per-size-class caches and
+  // handed out again without taking the allocator lock. Such allocations are
+  // rounded up to a power of two, and RequestedSize() reports the rounded
+  // size. The cache is bypassed when a timing counter is set.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
                bool allow_growth, const string& name,
-               bool garbage_collection = false);
+               bool garbage_collection = false,
+               bool small_allocation_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -85,6 +94,9 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // The largest allocation served by the small allocation cache.
+  static constexpr size_t kMaxSmallAllocationCacheSize = 4096;
+
  private:
   struct Bin;
 
@@ -96,6 +108,10 @@ class BFCAllocator : public Allocator {
       size_t alignment, size_t num_bytes,
       const AllocationAttributes& allocation_attr);
 
+  // AllocateRaw without the small allocation cache.
+  void* AllocateRawUncached(size_t alignment, size_t num_bytes,
+                            const AllocationAttributes& allocation_attr);
+
   void DeallocateRawInternal(void* ptr);
 
   // Chunks whose freed_at_count is later than the safe frontier value are kept
@@ -549,6 +565,50 @@ class BFCAllocator : public Allocator {
 
   // Stats.
   AllocatorStats stats_ TF_GUARDED_BY(lock_);
+
+  // The small allocation cache. Blocks in the cache are still allocated
+  // chunks as far as the bins are concerned; they are only returned to the
+  // bins when the cache of their size class is full, or when an allocation
+  // would otherwise fail.
+  //
+  // Blocks are assigned to a shard by address, and each shard keeps one free
+  // list per power-of-two size class between kMinAllocationSize and
+  // kMaxSmallAllocationCacheSize.
+  static constexpr int kNumSmallAllocationClasses = 5;
+  static constexpr int kNumSmallAllocationShards = 16;
+  // The maximum number of bytes in a single free list.
+  static constexpr size_t kMaxSmallAllocationFreeListBytes = 64 << 10;
+  struct SmallAllocationShard {
+    mutex mu;
+    // The size class of every block of this shard, cached or in use.
+    absl::flat_hash_map<void*, int> size_classes TF_GUARDED_BY(mu);
+    std::vector<void*> free_blocks[kNumSmallAllocationClasses] TF_GUARDED_BY(
+        mu);
+  };
+
+  static int SmallAllocationClass(size_t num_bytes);
+  static size_t SmallAllocationClassSize(int size_class) {
+    return kMinAllocationSize << size_class;
+  }
+  SmallAllocationShard& SmallAllocationShardFor(const void* ptr);
+
+  // Returns a cached block of class `size_class`, or nullptr if there is none.
+  void* AllocateFromSmallAllocationCache(int size_class);
+  // Records that `ptr` was allocated for class `size_class`.
+  void AddToSmallAllocationCache(void* ptr, int size_class);
+  // Returns true if `ptr` was taken by the cache, and false if it must be
+  // returned to the bins.
+  bool DeallocateToSmallAllocationCache(void* ptr);
+  // Returns all cached blocks to the bins. Returns true if there were any.
+  bool FlushSmallAllocationCache() TF_LOCKS_EXCLUDED(lock_);
+
+  const bool small_allocation_cache_;
+  std::unique_ptr<SmallAllocationShard[]> small_allocation_shards_;
+  std::atomic<int64> num_cached_small_blocks_[kNumSmallAllocationClasses];
+  // The number of blocks of all shards, cached or in use.
+  std::atomic<int64> num_small_allocation_blocks_{0};
+  std::atomic<int64> small_allocation_cache_bytes_{0};
+  std::atomic<int64> small_allocation_cache_hits_{0};
 #ifdef TENSORFLOW_MEM_DEBUG
   int64 action_counter_ TF_GUARDED_BY(lock_);
 #define MEM_DEBUG_SIZE_HISTORY_SIZE 4096
@@ -0,0 +1,157 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+SubAllocator* NewCPUSubAllocator() {
+  return new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+}
+
+TEST(CPUBFCAllocatorTest, SmallAllocationCache) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 20, false /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*small_allocation_cache*/);
+
+  // Small allocations are rounded up to their size class.
+  void* p1 = a.AllocateRaw(1, 300);
+  EXPECT_EQ(512, a.RequestedSize(p1));
+  a.DeallocateRaw(p1);
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(512, stats->bytes_in_cache);
+  EXPECT_EQ(0, stats->num_cache_hits);
+
+  // Any allocation of the same class reuses the cached block.
+  void* p2 = a.AllocateRaw(1, 400);
+  EXPECT_EQ(p1, p2);
+  stats = a.GetStats();
+  EXPECT_EQ(512, stats->bytes_in_use);
+  EXPECT_EQ(0, stats->bytes_in_cache);
+  EXPECT_EQ(1, stats->num_cache_hits);
+  EXPECT_EQ(2, stats->num_allocs);
+
+  // Allocations of other classes do not.
+  void* p3 = a.AllocateRaw(1, 200);
+  EXPECT_NE(p2, p3);
+  EXPECT_EQ(256, a.RequestedSize(p3));
+
+  // Large allocations bypass the cache.
+  void* p4 = a.AllocateRaw(1, BFCAllocator::kMaxSmallAllocationCacheSize + 1);
+  EXPECT_EQ(BFCAllocator::kMaxSmallAllocationCacheSize + 1,
+            a.RequestedSize(p4));
+  a.DeallocateRaw(p4);
+  stats = a.GetStats();
+  EXPECT_EQ(768, stats->bytes_in_use);
+  EXPECT_EQ(0, stats->bytes_in_cache);
+
+  a.DeallocateRaw(p2);
+  a.DeallocateRaw(p3);
+}
+
+TEST(CPUBFCAllocatorTest, SmallAllocationCacheDisabled) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 20, false /*allow_growth*/,
+                 "cpu_bfc");
+
+  void* p1 = a.AllocateRaw(1, 300);
+  EXPECT_EQ(300, a.RequestedSize(p1));
+  a.DeallocateRaw(p1);
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(0, stats->bytes_in_use);
+  EXPECT_EQ(0, stats->bytes_in_cache);
+  EXPECT_EQ(0, stats->num_cache_hits);
+}
+
+TEST(CPUBFCAllocatorTest, SmallAllocationCacheFlushedOnExhaustion) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 20, false /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 true /*small_allocation_cache*/);
+
+  // Fill the cache with as many small blocks as it will take.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 1024));
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(64 << 10, stats->bytes_in_cache);
+
+  // An allocation of the whole region only succeeds once the cached blocks
+  // have been returned to the bins.
+  void* large = a.AllocateRaw(1, 1 << 20);
+  ASSERT_NE(nullptr, large);
+  stats = a.GetStats();
+  EXPECT_EQ(0, stats->bytes_in_cache);
+  EXPECT_EQ(1 << 20, stats->bytes_in_use);
+  a.DeallocateRaw(large);
+}
+
+// Small allocations freed by other threads, as done by the CPU allocator of
+// an input pipeline.
+static void BM_SmallAllocationThreaded(int iters, int num_threads,
+                                       int small_allocation_cache) {
+  BFCAllocator a(NewCPUSubAllocator(), 1 << 30, true /*allow_growth*/,
+                 "cpu_bfc", false /*garbage_collection*/,
+                 small_allocation_cache);
+  testing::UseRealTime();
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  BlockingCounter counter(num_threads);
+  const int iters_per_thread = std::max(1, iters / num_threads);
+
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &counter, iters_per_thread]() {
+      std::vector<int> sizes = {64, 256, 1024, 4096, 128, 512, 2048};
+      std::vector<void*> ptrs(16, nullptr);
+      for (int i = 0; i < iters_per_thread; i++) {
+        void*& p = ptrs[i % ptrs.size()];
+        if (p != nullptr) a.DeallocateRaw(p);
+        p = a.AllocateRaw(1, sizes[i % sizes.size()]);
+      }
+      for (void* p : ptrs) {
+        if (p != nullptr) a.DeallocateRaw(p);
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+}
+BENCHMARK(BM_SmallAllocationThreaded)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(16, 0)
+    ->ArgPair(16, 1);
+
+}  // namespace
+}  // namespace tensorflow
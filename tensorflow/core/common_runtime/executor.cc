@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/executor.h"
 
 #include <atomic>
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -133,9 +135,24 @@ struct KernelTimer {
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Identifies the work-stealing worker, if any, that is running on the current
+// thread. See `ExecutorState::WorkerLoop()`.
+struct CurrentWorker {
+  const void* executor_state = nullptr;
+  int deque = -1;
+};
+thread_local CurrentWorker current_worker;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  // If `use_work_stealing` is true, ready nodes are distributed through
+  // per-worker deques instead of one closure per node.  See
+  // `ExecutorState::ScheduleReadyWorkStealing()`.
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        bool use_work_stealing = false)
+      : immutable_state_(p),
+        num_work_stealing_workers_(use_work_stealing ? port::MaxParallelism()
+                                                     : 0) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
@@ -215,6 +232,10 @@ class ExecutorImpl : public Executor {
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
 
+  // The maximum number of concurrent work-stealing workers per step, or 0 if
+  // work stealing is disabled.
+  const int num_work_stealing_workers_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -272,7 +293,8 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                int num_work_stealing_workers);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -317,12 +339,35 @@ class ExecutorState {
                 TaggedNodeReadyQueue* inline_ready);
 
   // Schedule all the expensive nodes in '*ready', and put all the inexpensive
-  // nodes in 'ready' into 'inline_ready'.
+  // nodes in 'ready' into 'inline_ready'. Returns true if execution has
+  // completed, which can only happen in work-stealing mode.
   //
   // This method will clear `*ready` before returning.
   //
   // REQUIRES: `!ready->empty()`.
-  void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
+  bool ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
+
+  // Work-stealing variant of `ScheduleReady()`.
+  //
+  // Inexpensive nodes are run inline as usual. Instead of dispatching a
+  // closure per expensive node, the remaining nodes are pushed onto the deque
+  // of the current worker, and new workers are only started while there are
+  // fewer active workers than queued nodes. Workers pop their own deque in
+  // LIFO order, which keeps producers and consumers on the same thread, and
+  // steal from the other deques in FIFO order once their own is empty.
+  bool ScheduleReadyWorkStealing(TaggedNodeSeq* ready,
+                                 TaggedNodeReadyQueue* inline_ready);
+  void PushReady(int deque, const TaggedNode& tagged_node,
+                 int64 scheduled_nsec);
+  // Pops a node from `deque`, or steals one from another deque, and processes
+  // it. Returns false if all deques were empty.
+  bool ProcessNextReady(int deque);
+  void MaybeStartWorkers();
+
+  // Processes nodes from the deques until all of them are empty. Each active
+  // worker counts as an outstanding op, so the step cannot finish while a
+  // worker is running.
+  void WorkerLoop(int deque);
 
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
@@ -377,6 +422,18 @@ class ExecutorState {
 
   std::atomic_int_fast32_t num_outstanding_ops_;
 
+  // Work-stealing state. `num_ready_deques_` is 0 if work stealing is
+  // disabled.
+  struct ReadyDeque {
+    mutex mu;
+    std::deque<std::pair<TaggedNode, int64>> nodes TF_GUARDED_BY(mu);
+  };
+  const int num_ready_deques_;
+  std::unique_ptr<ReadyDeque[]> ready_deques_;
+  std::atomic<int> next_ready_deque_{0};
+  std::atomic<int> num_active_workers_{0};
+  std::atomic<int64> num_queued_nodes_{0};
+
   // Available via OpKernelContext to every OpKernel invocation.
   mutex num_deferred_ops_mu_;
   int64 num_deferred_ops_ TF_GUARDED_BY(num_deferred_ops_mu_) = 0;
@@ -390,7 +447,7 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, int num_work_stealing_workers)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -414,7 +471,12 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       sync_on_finish_(args.sync_on_finish),
       run_all_kernels_inline_(args.run_all_kernels_inline),
       propagator_(immutable_state, step_id_, vlog_),
-      num_outstanding_ops_(0) {
+      num_outstanding_ops_(0),
+      num_ready_deques_(run_all_kernels_inline_ ? 0
+                                                : num_work_stealing_workers) {
+  if (num_ready_deques_ > 0) {
+    ready_deques_.reset(new ReadyDeque[num_ready_deques_]);
+  }
   if (args.user_intra_op_threadpool != nullptr) {
     Device* device = immutable_state_.params().device;
     user_device_ = RenamedDevice::NewRenamedDevice(
@@ -478,7 +540,7 @@ void ExecutorState<PropagatorStateType>::RunAsync(Executor::DoneCallback done) {
   } else {
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(&ready, nullptr);
+    if (ScheduleReady(&ready, nullptr)) ScheduleFinish();
   }
 }
 
@@ -1077,9 +1139,7 @@ bool ExecutorState<PropagatorStateType>::NodeDone(
       }
 
       // Schedule the ready nodes in 'ready'.
-      ScheduleReady(ready, inline_ready);
-
-      return false;
+      return ScheduleReady(ready, inline_ready);
     }
   } else {
     bool abort_run = false;
@@ -1134,10 +1194,14 @@ bool ExecutorState<PropagatorStateType>::NodeDone(
 }
 
 template <class PropagatorStateType>
-void ExecutorState<PropagatorStateType>::ScheduleReady(
+bool ExecutorState<PropagatorStateType>::ScheduleReady(
     TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
   DCHECK(!ready->empty());
 
+  if (num_ready_deques_ > 0) {
+    return ScheduleReadyWorkStealing(ready, inline_ready);
+  }
+
   int64 scheduled_nsec = 0;
   if (stats_collector_) {
     scheduled_nsec = nodestats::NowInNsec();
@@ -1195,6 +1259,144 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     }
   }
   ready->clear();
+  return false;
+}
+
+template <class PropagatorStateType>
+bool ExecutorState<PropagatorStateType>::ScheduleReadyWorkStealing(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready) {
+  int64 scheduled_nsec = 0;
+  if (stats_collector_) {
+    scheduled_nsec = nodestats::NowInNsec();
+  }
+
+  // A worker of this step holds an outstanding op for as long as it runs.
+  // Other threads (the caller of `RunAsync()` and the completion callbacks of
+  // asynchronous kernels) take one here, because the nodes they push may be
+  // run to completion by a worker before this method returns.
+  const bool on_worker = current_worker.executor_state == this;
+  int deque;
+  if (on_worker) {
+    deque = current_worker.deque;
+  } else {
+    num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+    deque = next_ready_deque_.fetch_add(1, std::memory_order_relaxed) %
+            num_ready_deques_;
+  }
+
+  const TaggedNode* curr_expensive_node = nullptr;
+  bool pushed = false;
+  for (auto& tagged_node : *ready) {
+    if (inline_ready != nullptr &&
+        (tagged_node.get_is_dead() ||
+         !kernel_stats_->IsExpensive(tagged_node.get_node_item()))) {
+      // Inline this inexpensive node.
+      inline_ready->push_back(tagged_node);
+    } else {
+      if (curr_expensive_node) {
+        PushReady(deque, *curr_expensive_node, scheduled_nsec);
+        pushed = true;
+      }
+      curr_expensive_node = &tagged_node;
+    }
+  }
+  if (curr_expensive_node) {
+    if (inline_ready != nullptr && inline_ready->empty()) {
+      inline_ready->push_back(*curr_expensive_node);
+    } else {
+      PushReady(deque, *curr_expensive_node, scheduled_nsec);
+      pushed = true;
+    }
+  }
+  ready->clear();
+  if (pushed) {
+    MaybeStartWorkers();
+  }
+
+  if (on_worker) return false;
+  return num_outstanding_ops_.fetch_sub(1) == 1;
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::PushReady(
+    int deque, const TaggedNode& tagged_node, int64 scheduled_nsec) {
+  ReadyDeque& ready_deque = ready_deques_[deque];
+  {
+    mutex_lock l(ready_deque.mu);
+    ready_deque.nodes.emplace_back(tagged_node, scheduled_nsec);
+  }
+  num_queued_nodes_.fetch_add(1);
+}
+
+template <class PropagatorStateType>
+bool ExecutorState<PropagatorStateType>::ProcessNextReady(int deque) {
+  for (int i = 0; i < num_ready_deques_; ++i) {
+    ReadyDeque& ready_deque = ready_deques_[(deque + i) % num_ready_deques_];
+    ready_deque.mu.lock();
+    if (ready_deque.nodes.empty()) {
+      ready_deque.mu.unlock();
+      continue;
+    }
+    // Own deque in LIFO order, other deques in FIFO order.
+    std::pair<TaggedNode, int64> next =
+        i == 0 ? ready_deque.nodes.back() : ready_deque.nodes.front();
+    if (i == 0) {
+      ready_deque.nodes.pop_back();
+    } else {
+      ready_deque.nodes.pop_front();
+    }
+    ready_deque.mu.unlock();
+    num_queued_nodes_.fetch_sub(1);
+    Process(next.first, next.second);
+    return true;
+  }
+  return false;
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::MaybeStartWorkers() {
+  int active = num_active_workers_.load();
+  while (true) {
+    const int64 queued = num_queued_nodes_.load();
+    if (active >= std::min<int64>(queued, num_ready_deques_)) return;
+    if (!num_active_workers_.compare_exchange_weak(active, active + 1)) {
+      continue;
+    }
+    // The caller holds an outstanding op, so this cannot race with `Finish()`.
+    num_outstanding_ops_.fetch_add(1, std::memory_order_relaxed);
+    const int deque =
+        next_ready_deque_.fetch_add(1, std::memory_order_relaxed) %
+        num_ready_deques_;
+    RunTask([this, deque]() { WorkerLoop(deque); });
+    active = num_active_workers_.load();
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::WorkerLoop(int deque) {
+  // Workers may nest if `runner_` runs closures inline.
+  const CurrentWorker saved_worker = current_worker;
+  current_worker.executor_state = this;
+  current_worker.deque = deque;
+
+  while (true) {
+    if (ProcessNextReady(deque)) continue;
+    // A node may have been pushed after the deques were found empty, by a
+    // thread that saw this worker as active and so did not start a new one.
+    // Resume in that case, unless another worker is available to take it.
+    int active = num_active_workers_.fetch_sub(1) - 1;
+    bool resume = false;
+    while (num_queued_nodes_.load() > 0 && active < num_ready_deques_) {
+      if (num_active_workers_.compare_exchange_weak(active, active + 1)) {
+        resume = true;
+        break;
+      }
+    }
+    if (!resume) break;
+  }
+
+  current_worker = saved_worker;
+  if (num_outstanding_ops_.fetch_sub(1) == 1) ScheduleFinish();
 }
 
 template <class PropagatorStateType>
@@ -1334,11 +1536,13 @@ void ExecutorState<PropagatorStateType>::Finish() {
 
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        num_work_stealing_workers_))
         ->RunAsync(std::move(done));
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_,
+                                              num_work_stealing_workers_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1357,6 +1561,18 @@ Status NewLocalExecutor(const LocalExecutorParams& params, const Graph& graph,
   return s;
 }
 
+Status NewWorkStealingLocalExecutor(const LocalExecutorParams& params,
+                                    const Graph& graph, Executor** executor) {
+  ExecutorImpl* impl = new ExecutorImpl(params, /*use_work_stealing=*/true);
+  const Status s = impl->Initialize(graph);
+  if (s.ok()) {
+    *executor = impl;
+  } else {
+    delete impl;
+  }
+  return s;
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const std::shared_ptr<const NodeProperties>& props,
                              int graph_def_version, OpKernel** kernel) {
@@ -1377,6 +1593,7 @@ class DefaultExecutorRegistrar {
     Factory* factory = new Factory;
     ExecutorFactory::Register("", factory);
     ExecutorFactory::Register("DEFAULT", factory);
+    ExecutorFactory::Register("WORK_STEALING", new WorkStealingFactory);
   }
 
  private:
@@ -1389,6 +1606,16 @@ class DefaultExecutorRegistrar {
       return Status::OK();
     }
   };
+
+  class WorkStealingFactory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewWorkStealingLocalExecutor(params, graph, &ret));
+      out_executor->reset(ret);
+      return Status::OK();
+    }
+  };
 };
 static DefaultExecutorRegistrar registrar;
 
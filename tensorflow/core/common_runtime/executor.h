@@ -134,6 +134,14 @@ class Executor {
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph& graph, Executor** executor);
 
+// Like NewLocalExecutor, but the returned executor hands ready nodes to a
+// bounded number of workers through per-worker work-stealing deques, instead
+// of scheduling one closure per node. This reduces the scheduling overhead of
+// graphs with many small ops. Also available as the "WORK_STEALING" executor
+// type.
+::tensorflow::Status NewWorkStealingLocalExecutor(
+    const LocalExecutorParams& params, const Graph& graph, Executor** executor);
+
 // A class to help run multiple executors in parallel and wait until
 // all of them are complete.
 //
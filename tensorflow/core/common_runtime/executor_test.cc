@@ -67,7 +67,8 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              bool use_work_stealing = false) {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -82,7 +83,11 @@ class ExecutorTest : public ::testing::Test {
     };
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (use_work_stealing) {
+      TF_CHECK_OK(NewWorkStealingLocalExecutor(params, *graph, &exec_));
+    } else {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -255,6 +260,38 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, WorkStealingRandomTree) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g), /*use_work_stealing=*/true);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, WorkStealingInlineRunner) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(256, g.get());
+  Create(std::move(g), /*use_work_stealing=*/true);
+  // Workers started from a worker run nested on the same thread.
+  runner_ = [](std::function<void()> fn) { fn(); };
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(256.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -290,6 +327,23 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, WorkStealingConcurrentAddAssign) {
+  auto g = absl::make_unique<Graph>(OpRegistry::Global());
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g), /*use_work_stealing=*/true);
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -433,7 +487,8 @@ TEST_F(ExecutorTest, NoInputTensors) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void BM_ExecutorHelper(int iters, int width, int depth,
+                              const char* executor_type) {
   testing::StopTiming();
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
@@ -472,7 +527,13 @@ static void BM_executor(int iters, int width, int depth) {
 #endif  // PLATFORM_GOOGLE
   FixupSourceAndSinkEdges(g);
   testing::StartTiming();
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, /*options=*/nullptr, /*init=*/nullptr,
+                  /*rendez=*/nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  BM_ExecutorHelper(iters, width, depth, /*executor_type=*/"");
 }
 
 // Tall skinny graphs
@@ -486,6 +547,18 @@ BENCHMARK(BM_executor)->ArgPair(8192, 32);
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
 
+// The same graphs with the work-stealing executor. All nodes are no-ops, so the
+// difference to BM_executor is the per-node scheduling overhead.
+static void BM_WorkStealingExecutor(int iters, int width, int depth) {
+  BM_ExecutorHelper(iters, width, depth, /*executor_type=*/"WORK_STEALING");
+}
+
+BENCHMARK(BM_WorkStealingExecutor)->ArgPair(16, 1024);
+BENCHMARK(BM_WorkStealingExecutor)->ArgPair(32, 8192);
+BENCHMARK(BM_WorkStealingExecutor)->ArgPair(1024, 16);
+BENCHMARK(BM_WorkStealingExecutor)->ArgPair(8192, 32);
+BENCHMARK(BM_WorkStealingExecutor)->ArgPair(1024, 1024);
+
 static void BM_const_identity(int iters, int width, int outputs_per_const) {
 #ifdef PLATFORM_GOOGL
   BenchmarkUseRealTime();
@@ -118,21 +118,30 @@ class GPUCompatibleCPUDeviceFactory : public DeviceFactory {
 
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
+    const bool use_numa_affinity =
+        options.config.experimental().use_numa_affinity();
+    int num_numa_nodes = use_numa_affinity ? port::NUMANumNodes() : 1;
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
+    } else if (use_numa_affinity) {
+      n = num_numa_nodes;
+    }
+    if (use_numa_affinity) {
+      ProcessState::singleton()->EnableNUMA();
     }
-    int num_numa_nodes = options.config.experimental().use_numa_affinity()
-                             ? port::NUMANumNodes()
-                             : 1;
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
       int numa_node = i % num_numa_nodes;
       DeviceLocality locality;
-      locality.set_numa_node(numa_node);
+      if (use_numa_affinity) {
+        locality.set_numa_node(numa_node);
+      } else {
+        numa_node = port::kNUMANoAffinity;
+      }
       devices->push_back(absl::make_unique<GPUCompatibleCPUDevice>(
-          options, name, Bytes(256 << 20), DeviceLocality(),
+          options, name, Bytes(256 << 20), locality,
           ProcessState::singleton()->GetCPUAllocator(numa_node)));
     }
 
@@ -62,15 +62,22 @@ ProcessState::MemDesc ProcessState::PtrType(const void* ptr) {
 }
 
 Allocator* ProcessState::GetCPUAllocator(int numa_node) {
-  if (!numa_enabled_ || numa_node == port::kNUMANoAffinity) numa_node = 0;
+  if (!numa_enabled_.load(std::memory_order_acquire)) {
+    numa_node = port::kNUMANoAffinity;
+  }
+  const int index = numa_node == port::kNUMANoAffinity ? 0 : numa_node + 1;
 
   // Check if allocator for the numa node is in lock-free cache.
-  if (numa_node < cpu_allocators_cached_.load(std::memory_order_acquire)) {
-    return cpu_allocators_cache_[numa_node];
+  if (index < cpu_allocators_cached_.load(std::memory_order_acquire)) {
+    return cpu_allocators_cache_[index];
   }
 
   mutex_lock lock(mu_);
-  while (cpu_allocators_.size() <= static_cast<size_t>(numa_node)) {
+  while (cpu_allocators_.size() <= static_cast<size_t>(index)) {
+    // Allocators for every index up to `index` are created in order; the
+    // first one is not specific to any NUMA node.
+    const int node = static_cast<int>(cpu_allocators_.size()) - 1;
+    const bool numa_specific = node != port::kNUMANoAffinity;
     // If visitors have been defined we need an Allocator built from
     // a SubAllocator.  Prefer BFCAllocator, but fall back to PoolAllocator
     // depending on env var setting.
@@ -84,10 +91,9 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
     }
     Allocator* allocator = nullptr;
     SubAllocator* sub_allocator =
-        (numa_enabled_ || alloc_visitors_defined || use_bfc_allocator)
-            ? new BasicCPUAllocator(
-                  numa_enabled_ ? numa_node : port::kNUMANoAffinity,
-                  cpu_alloc_visitors_, cpu_free_visitors_)
+        (numa_specific || alloc_visitors_defined || use_bfc_allocator)
+            ? new BasicCPUAllocator(node, cpu_alloc_visitors_,
+                                    cpu_free_visitors_)
             : nullptr;
     if (use_bfc_allocator) {
       // TODO(reedwm): evaluate whether 64GB by default is the best choice.
@@ -99,10 +105,18 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      bool small_allocation_cache = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_SMALL_ALLOCATION_CACHE", false,
+                                  &small_allocation_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       DCHECK(sub_allocator);
       allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
-                           "bfc_cpu_allocator_for_gpu" /*name*/);
+                           "bfc_cpu_allocator_for_gpu" /*name*/,
+                           false /*garbage_collection*/,
+                           small_allocation_cache);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else if (sub_allocator) {
@@ -111,8 +125,7 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
           new PoolAllocator(100 /*pool_size_limit*/, true /*auto_resize*/,
                             sub_allocator, new NoopRounder, "cpu_pool");
       VLOG(2) << "Using PoolAllocator for ProcessState CPU allocator "
-              << "numa_enabled_=" << numa_enabled_
-              << " numa_node=" << numa_node;
+              << "numa_node=" << node;
     } else {
       DCHECK(!sub_allocator);
       allocator = cpu_allocator_base();
@@ -131,7 +144,7 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
       DCHECK(cpu_alloc_visitors_.empty() && cpu_free_visitors_.empty());
     }
   }
-  return cpu_allocators_[numa_node];
+  return cpu_allocators_[index];
 }
 
 void ProcessState::AddCPUAllocVisitor(SubAllocator::Visitor visitor) {
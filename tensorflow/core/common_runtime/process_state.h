@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_STATE_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_STATE_H_
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <unordered_map>
@@ -55,16 +56,17 @@ class ProcessState : public ProcessStateInterface {
     string DebugString();
   };
 
-  // If NUMA Allocators are desired, call this before calling any
-  // Allocator accessor.
-  void EnableNUMA() { numa_enabled_ = true; }
+  // If NUMA Allocators are desired, call this before calling
+  // GetCPUAllocator for a specific NUMA node. Allocators for
+  // kNUMANoAffinity are unaffected and may be created before.
+  void EnableNUMA() { numa_enabled_.store(true, std::memory_order_release); }
 
   // Returns what we know about the memory at ptr.
   // If we know nothing, it's called CPU 0 with no other attributes.
   MemDesc PtrType(const void* ptr);
 
-  // Returns the one CPUAllocator used for the given numa_node.
-  // Treats numa_node == kNUMANoAffinity as numa_node == 0.
+  // Returns the one CPUAllocator used for the given numa_node. If NUMA is
+  // not enabled, all nodes share the allocator used for kNUMANoAffinity.
   Allocator* GetCPUAllocator(int numa_node) override;
 
   // Registers alloc visitor for the CPU allocator(s).
@@ -92,20 +94,20 @@ class ProcessState : public ProcessStateInterface {
   void TestOnlyReset();
 
   static ProcessState* instance_;
-  bool numa_enabled_;
+  std::atomic<bool> numa_enabled_;
 
   mutex mu_;
 
-  // Indexed by numa_node.  If we want numa-specific allocators AND a
-  // non-specific allocator, maybe should index by numa_node+1.
+  // Indexed by numa_node + 1, with the non-specific allocator used for
+  // kNUMANoAffinity at index 0.
   std::vector<Allocator*> cpu_allocators_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_alloc_visitors_ TF_GUARDED_BY(mu_);
   std::vector<SubAllocator::Visitor> cpu_free_visitors_ TF_GUARDED_BY(mu_);
 
-  // A cache of cpu allocators indexed by a numa node. Used as a fast path to
-  // get CPU allocator by numa node id without locking the mutex. We can't use
-  // `cpu_allocators_` storage in the lock-free path because concurrent
-  // operation can deallocate the vector storage.
+  // A cache of cpu allocators indexed like `cpu_allocators_`. Used as a fast
+  // path to get CPU allocator by numa node id without locking the mutex. We
+  // can't use `cpu_allocators_` storage in the lock-free path because
+  // concurrent operation can deallocate the vector storage.
   std::atomic<int> cpu_allocators_cached_;
   std::array<Allocator*, 8> cpu_allocators_cache_;
 
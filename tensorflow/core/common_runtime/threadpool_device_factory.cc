@@ -37,16 +37,25 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
 
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
+    const bool use_numa_affinity =
+        options.config.experimental().use_numa_affinity();
     int num_numa_nodes = port::NUMANumNodes();
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
       n = iter->second;
+    } else if (use_numa_affinity) {
+      // One device per NUMA node, so that placement can keep work local.
+      n = num_numa_nodes;
+    }
+    if (use_numa_affinity) {
+      // Serve the allocations of each device from its node-local memory.
+      ProcessState::singleton()->EnableNUMA();
     }
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
       std::unique_ptr<ThreadPoolDevice> tpd;
-      if (options.config.experimental().use_numa_affinity()) {
+      if (use_numa_affinity) {
         int numa_node = i % num_numa_nodes;
         if (numa_node != i) {
           LOG(INFO) << "Only " << num_numa_nodes
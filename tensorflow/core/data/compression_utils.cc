@@ -14,67 +14,276 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <limits>
+
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 namespace data {
+namespace {
 
-Status CompressElement(const std::vector<Tensor>& element,
-                       CompressedElement* out) {
-  // Step 1: Determine the total uncompressed size. This requires serializing
-  // non-memcopyable tensors, which we save to use again later.
-  std::vector<TensorProto> non_memcpy_components;
-  int64 total_size = 0;
-  for (auto& component : element) {
-    if (DataTypeCanUseMemcpy(component.dtype())) {
-      // Some datatypes can be memcopied, allowing us to save two copies
-      // (AsProtoTensorContent and SerializeToArray).
-      total_size += DMAHelper::buffer(&component)->size();
-    } else {
-      non_memcpy_components.emplace_back();
-      component.AsProtoTensorContent(&non_memcpy_components.back());
-      total_size += non_memcpy_components.back().ByteSizeLong();
+// zlib counts bytes with `uInt`s, so larger buffers are passed in chunks.
+constexpr size_t kMaxZlibChunkBytes = std::numeric_limits<uInt>::max();
+
+// Compresses the concatenation of the component buffers in `iov`, which hold
+// `total_size` bytes, into `output`, and uncompresses `input` back into the
+// component buffers. Codecs never stage the element in a contiguous buffer.
+class Codec {
+ public:
+  virtual ~Codec() = default;
+  virtual Status Compress(const std::vector<struct iovec>& iov,
+                          size_t total_size, std::string* output) const = 0;
+  virtual Status Uncompress(const std::string& input,
+                            const std::vector<struct iovec>& iov,
+                            size_t total_size) const = 0;
+};
+
+class UncompressedCodec : public Codec {
+ public:
+  Status Compress(const std::vector<struct iovec>& iov, size_t total_size,
+                  std::string* output) const override {
+    output->resize(total_size);
+    char* position = &(*output)[0];
+    for (const struct iovec& buffer : iov) {
+      if (buffer.iov_len == 0) continue;
+      memcpy(position, buffer.iov_base, buffer.iov_len);
+      position += buffer.iov_len;
     }
+    return Status::OK();
   }
 
-  // Step 2: Write the tensor data to a buffer, and compress that buffer.
-  // We use tstring for access to resize_uninitialized.
-  tstring uncompressed;
-  uncompressed.resize_uninitialized(total_size);
-  // Position in `uncompressed` to write the next component.
-  char* position = uncompressed.mdata();
-  int non_memcpy_component_index = 0;
-  for (auto& component : element) {
+  Status Uncompress(const std::string& input,
+                    const std::vector<struct iovec>& iov,
+                    size_t total_size) const override {
+    if (input.size() != total_size) {
+      return errors::Internal("Uncompressed size mismatch. The element has ",
+                              input.size(),
+                              " bytes whereas the tensor metadata suggests ",
+                              total_size);
+    }
+    const char* position = input.data();
+    for (const struct iovec& buffer : iov) {
+      if (buffer.iov_len == 0) continue;
+      memcpy(buffer.iov_base, position, buffer.iov_len);
+      position += buffer.iov_len;
+    }
+    return Status::OK();
+  }
+};
+
+class SnappyCodec : public Codec {
+ public:
+  Status Compress(const std::vector<struct iovec>& iov, size_t total_size,
+                  std::string* output) const override {
+    if (!port::Snappy_CompressFromIOVec(iov.data(), total_size, output)) {
+      return errors::Internal("Failed to compress using snappy.");
+    }
+    return Status::OK();
+  }
+
+  Status Uncompress(const std::string& input,
+                    const std::vector<struct iovec>& iov,
+                    size_t total_size) const override {
+    size_t uncompressed_size;
+    if (!port::Snappy_GetUncompressedLength(input.data(), input.size(),
+                                            &uncompressed_size)) {
+      return errors::Internal(
+          "Could not get snappy uncompressed length. Compressed data size: ",
+          input.size());
+    }
+    if (uncompressed_size != total_size) {
+      return errors::Internal(
+          "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
+          " whereas the tensor metadata suggests ", total_size);
+    }
+    if (!port::Snappy_UncompressToIOVec(input.data(), input.size(), iov.data(),
+                                        iov.size())) {
+      return errors::Internal("Failed to perform snappy decompression.");
+    }
+    return Status::OK();
+  }
+};
+
+// zlib at its fastest level, for data which compresses poorly with snappy.
+class ZlibCodec : public Codec {
+ public:
+  Status Compress(const std::vector<struct iovec>& iov, size_t total_size,
+                  std::string* output) const override {
+    z_stream stream = {};
+    if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK) {
+      return errors::Internal("Failed to initialize zlib compression.");
+    }
+    output->resize(deflateBound(&stream, total_size));
+    stream.next_out = reinterpret_cast<Bytef*>(&(*output)[0]);
+    stream.avail_out = output->size();
+    int ret = Z_OK;
+    for (const struct iovec& buffer : iov) {
+      Bytef* position = static_cast<Bytef*>(buffer.iov_base);
+      size_t remaining = buffer.iov_len;
+      while (remaining > 0 && ret == Z_OK) {
+        const uInt chunk = std::min<size_t>(remaining, kMaxZlibChunkBytes);
+        stream.next_in = position;
+        stream.avail_in = chunk;
+        ret = deflate(&stream, Z_NO_FLUSH);
+        const size_t consumed = chunk - stream.avail_in;
+        position += consumed;
+        remaining -= consumed;
+      }
+    }
+    if (ret == Z_OK) {
+      ret = deflate(&stream, Z_FINISH);
+    }
+    output->resize(stream.total_out);
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+      return errors::Internal("Failed to compress using zlib: ", ret);
+    }
+    return Status::OK();
+  }
+
+  Status Uncompress(const std::string& input,
+                    const std::vector<struct iovec>& iov,
+                    size_t total_size) const override {
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+      return errors::Internal("Failed to initialize zlib decompression.");
+    }
+    stream.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = input.size();
+    int ret = Z_OK;
+    for (const struct iovec& buffer : iov) {
+      Bytef* position = static_cast<Bytef*>(buffer.iov_base);
+      size_t remaining = buffer.iov_len;
+      while (remaining > 0 && ret == Z_OK) {
+        const uInt chunk = std::min<size_t>(remaining, kMaxZlibChunkBytes);
+        stream.next_out = position;
+        stream.avail_out = chunk;
+        ret = inflate(&stream, Z_NO_FLUSH);
+        const size_t produced = chunk - stream.avail_out;
+        position += produced;
+        remaining -= produced;
+      }
+      if (remaining > 0) break;
+    }
+    // The stream must end exactly where the components do.
+    Bytef extra;
+    if (ret == Z_OK) {
+      stream.next_out = &extra;
+      stream.avail_out = 1;
+      ret = inflate(&stream, Z_FINISH);
+    }
+    const size_t uncompressed_size = stream.total_out;
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END || uncompressed_size != total_size) {
+      return errors::Internal(
+          "Failed to perform zlib decompression: status ", ret, ", ",
+          uncompressed_size, " bytes uncompressed whereas the tensor metadata "
+          "suggests ", total_size);
+    }
+    return Status::OK();
+  }
+};
+
+const Codec* GetCodec(CompressedElement::Codec codec) {
+  static const UncompressedCodec* uncompressed = new UncompressedCodec();
+  static const SnappyCodec* snappy = new SnappyCodec();
+  static const ZlibCodec* zlib = new ZlibCodec();
+  switch (codec) {
+    case CompressedElement::UNCOMPRESSED:
+      return uncompressed;
+    case CompressedElement::SNAPPY:
+      return snappy;
+    case CompressedElement::ZLIB:
+      return zlib;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+Status CompressElement(const std::vector<Tensor>& element,
+                       const std::string& codec, CompressedElement* out) {
+  CompressedElement::Codec element_codec;
+  if (codec == kCompressionCodecNone) {
+    element_codec = CompressedElement::UNCOMPRESSED;
+  } else if (codec == kCompressionCodecSnappy ||
+             codec == kCompressionCodecAuto) {
+    element_codec = CompressedElement::SNAPPY;
+  } else if (codec == kCompressionCodecZlib) {
+    element_codec = CompressedElement::ZLIB;
+  } else {
+    return errors::InvalidArgument("Unknown compression codec: ", codec);
+  }
+
+  // Step 1: Collect the buffers to compress. Memcopyable tensors are
+  // compressed straight from their buffers, which saves two copies
+  // (AsProtoTensorContent and SerializeToArray) plus the copy into a staging
+  // buffer. Other tensors are serialized to strings first.
+  std::vector<struct iovec> iov(element.size());
+  // `element.size()` is a conservative estimate. It is important to reserve
+  // vector space so that the vector doesn't resize itself, which could
+  // invalidate pointers to its strings' data.
+  std::vector<std::string> serialized_components;
+  serialized_components.reserve(element.size());
+  size_t total_size = 0;
+  for (int i = 0; i < element.size(); ++i) {
+    const Tensor& component = element[i];
     CompressedComponentMetadata* metadata =
         out->mutable_component_metadata()->Add();
     metadata->set_dtype(component.dtype());
     component.shape().AsProto(metadata->mutable_tensor_shape());
     if (DataTypeCanUseMemcpy(component.dtype())) {
       const TensorBuffer* buffer = DMAHelper::buffer(&component);
-      memcpy(position, buffer->data(), buffer->size());
-      metadata->set_tensor_size_bytes(buffer->size());
+      iov[i].iov_base = buffer ? buffer->data() : nullptr;
+      iov[i].iov_len = buffer ? buffer->size() : 0;
     } else {
-      TensorProto& proto = non_memcpy_components[non_memcpy_component_index++];
-      proto.SerializeToArray(position, proto.ByteSizeLong());
-      metadata->set_tensor_size_bytes(proto.ByteSizeLong());
+      TensorProto proto;
+      component.AsProtoTensorContent(&proto);
+      serialized_components.push_back(proto.SerializeAsString());
+      std::string& serialized = serialized_components.back();
+      iov[i].iov_base = &serialized[0];
+      iov[i].iov_len = serialized.size();
     }
-    position += metadata->tensor_size_bytes();
+    metadata->set_tensor_size_bytes(iov[i].iov_len);
+    total_size += iov[i].iov_len;
   }
-  DCHECK_EQ(position, uncompressed.mdata() + total_size);
 
-  if (!port::Snappy_Compress(uncompressed.mdata(), total_size,
-                             out->mutable_data())) {
-    return errors::Internal("Failed to compress using snappy.");
+  // Step 2: Compress the buffers.
+  TF_RETURN_IF_ERROR(
+      GetCodec(element_codec)->Compress(iov, total_size, out->mutable_data()));
+  if (codec == kCompressionCodecAuto &&
+      out->data().size() > total_size - total_size / 8) {
+    element_codec = CompressedElement::UNCOMPRESSED;
+    TF_RETURN_IF_ERROR(GetCodec(element_codec)
+                           ->Compress(iov, total_size, out->mutable_data()));
   }
+  out->set_codec(element_codec);
   VLOG(3) << "Compressed element from " << total_size << " bytes to "
-          << out->data().size() << " bytes";
+          << out->data().size() << " bytes with codec "
+          << CompressedElement::Codec_Name(element_codec);
   return Status::OK();
 }
 
+Status CompressElement(const std::vector<Tensor>& element,
+                       CompressedElement* out) {
+  return CompressElement(element, kCompressionCodecSnappy, out);
+}
+
 Status UncompressElement(const CompressedElement& compressed,
+                         const ComponentAllocator& allocator,
                          std::vector<Tensor>* out) {
+  const Codec* codec = GetCodec(compressed.codec());
+  if (codec == nullptr) {
+    return errors::Internal("Unknown compression codec ", compressed.codec());
+  }
   int num_components = compressed.component_metadata_size();
   out->clear();
   out->reserve(num_components);
@@ -87,15 +296,18 @@ Status UncompressElement(const CompressedElement& compressed,
   // vector space so that the vector doesn't resize itself, which could
   // invalidate pointers to its strings' data.
   tensor_proto_strs.reserve(num_components);
-  int64 total_size = 0;
+  size_t total_size = 0;
   for (int i = 0; i < num_components; ++i) {
     const CompressedComponentMetadata& metadata =
         compressed.component_metadata(i);
     if (DataTypeCanUseMemcpy(metadata.dtype())) {
-      out->emplace_back(metadata.dtype(), metadata.tensor_shape());
+      out->emplace_back();
+      TF_RETURN_IF_ERROR(allocator(i, metadata.dtype(),
+                                   TensorShape(metadata.tensor_shape()),
+                                   &out->back()));
       TensorBuffer* buffer = DMAHelper::buffer(&out->back());
-      iov[i].iov_base = buffer->data();
-      iov[i].iov_len = buffer->size();
+      iov[i].iov_base = buffer ? buffer->data() : nullptr;
+      iov[i].iov_len = buffer ? buffer->size() : 0;
     } else {
       // Allocate an empty Tensor. We will fill it out later after
       // uncompressing into the tensor_proto_str.
@@ -110,24 +322,7 @@ Status UncompressElement(const CompressedElement& compressed,
   }
 
   // Step 2: Uncompress into the iovec.
-  const std::string& compressed_data = compressed.data();
-  size_t uncompressed_size;
-  if (!port::Snappy_GetUncompressedLength(
-          compressed_data.data(), compressed_data.size(), &uncompressed_size)) {
-    return errors::Internal(
-        "Could not get snappy uncompressed length. Compressed data size: ",
-        compressed_data.size());
-  }
-  if (uncompressed_size != static_cast<size_t>(total_size)) {
-    return errors::Internal(
-        "Uncompressed size mismatch. Snappy expects ", uncompressed_size,
-        " whereas the tensor metadata suggests ", total_size);
-  }
-  if (!port::Snappy_UncompressToIOVec(compressed_data.data(),
-                                      compressed_data.size(), iov.data(),
-                                      num_components)) {
-    return errors::Internal("Failed to perform snappy decompression.");
-  }
+  TF_RETURN_IF_ERROR(codec->Uncompress(compressed.data(), iov, total_size));
 
   // Step 3: Deserialize tensor proto strings to tensors.
   int tensor_proto_strs_index = 0;
@@ -146,5 +341,16 @@ Status UncompressElement(const CompressedElement& compressed,
   return Status::OK();
 }
 
+Status UncompressElement(const CompressedElement& compressed,
+                         std::vector<Tensor>* out) {
+  return UncompressElement(
+      compressed,
+      [](int index, DataType dtype, const TensorShape& shape, Tensor* tensor) {
+        *tensor = Tensor(dtype, shape);
+        return Status::OK();
+      },
+      out);
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_COMPRESSION_UTILS_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_COMPRESSION_UTILS_H_
 
+#include <functional>
+
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/platform/status.h"
@@ -22,14 +24,40 @@ limitations under the License.
 namespace tensorflow {
 namespace data {
 
-// Compresses the components of `element` into the `CompressedElement` proto.
+// Names of the codecs accepted by `CompressElement`.
+constexpr char kCompressionCodecNone[] = "none";
+constexpr char kCompressionCodecSnappy[] = "snappy";
+constexpr char kCompressionCodecZlib[] = "zlib";
+// Compresses with snappy, but stores elements uncompressed when snappy saves
+// less than an eighth of their size, as is typical for already-encoded images.
+constexpr char kCompressionCodecAuto[] = "auto";
+
+// Compresses the components of `element` into the `CompressedElement` proto,
+// using the codec named `codec`.
 //
 // In addition to writing the actual compressed bytes, `Compress` fills
-// out the per-component metadata for the `CompressedElement`.
+// out the per-component metadata for the `CompressedElement`. Memcopyable
+// components are compressed straight from their tensor buffers.
+Status CompressElement(const std::vector<Tensor>& element,
+                       const std::string& codec, CompressedElement* out);
+
+// Compresses the components of `element` with snappy.
 Status CompressElement(const std::vector<Tensor>& element,
                        CompressedElement* out);
 
+// Allocates the tensor for component `index` of an element being uncompressed.
+using ComponentAllocator = std::function<Status(
+    int index, DataType dtype, const TensorShape& shape, Tensor* tensor)>;
+
 // Uncompresses a `CompressedElement` into a vector of tensor components.
+// Memcopyable components are uncompressed directly into tensors allocated by
+// `allocator`.
+Status UncompressElement(const CompressedElement& compressed,
+                         const ComponentAllocator& allocator,
+                         std::vector<Tensor>* out);
+
+// Uncompresses a `CompressedElement` into a vector of tensor components
+// allocated with the default CPU allocator.
 Status UncompressElement(const CompressedElement& compressed,
                          std::vector<Tensor>* out);
 
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/compression_utils.h"
 
+#include <tuple>
+
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/platform/test.h"
@@ -49,5 +51,100 @@ std::vector<std::vector<Tensor>> TestCases() {
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedCompressionUtilsTest,
                          ::testing::ValuesIn(TestCases()));
 
+class CodecCompressionUtilsTest
+    : public DatasetOpsTestBase,
+      public ::testing::WithParamInterface<
+          std::tuple<std::string, std::vector<Tensor>>> {};
+
+TEST_P(CodecCompressionUtilsTest, RoundTrip) {
+  const std::string& codec = std::get<0>(GetParam());
+  const std::vector<Tensor>& element = std::get<1>(GetParam());
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, codec, &compressed));
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  TF_EXPECT_OK(
+      ExpectEqual(element, round_trip_element, /*compare_order=*/true));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Instantiation, CodecCompressionUtilsTest,
+    ::testing::Combine(::testing::Values(kCompressionCodecNone,
+                                         kCompressionCodecSnappy,
+                                         kCompressionCodecZlib,
+                                         kCompressionCodecAuto),
+                       ::testing::ValuesIn(TestCases())));
+
+// Returns a uint8 tensor of `size` bytes, which is incompressible if `random`
+// and highly compressible otherwise.
+Tensor ByteTensor(int64 size, bool random) {
+  Tensor tensor(DT_UINT8, TensorShape({size}));
+  auto flat = tensor.flat<uint8>();
+  uint32 state = 1;
+  for (int64 i = 0; i < size; ++i) {
+    state = state * 1664525 + 1013904223;
+    flat(i) = random ? static_cast<uint8>(state >> 24) : i % 4;
+  }
+  return tensor;
+}
+
+TEST(CompressionUtilsTest, AutoStoresIncompressibleElementsUncompressed) {
+  std::vector<Tensor> element = {ByteTensor(1 << 16, /*random=*/true)};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, kCompressionCodecAuto, &compressed));
+  EXPECT_EQ(compressed.codec(), CompressedElement::UNCOMPRESSED);
+  EXPECT_EQ(compressed.data().size(), 1 << 16);
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(compressed, &round_trip_element));
+  test::ExpectTensorEqual<uint8>(element[0], round_trip_element[0]);
+}
+
+TEST(CompressionUtilsTest, AutoCompressesCompressibleElements) {
+  std::vector<Tensor> element = {ByteTensor(1 << 16, /*random=*/false)};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, kCompressionCodecAuto, &compressed));
+  EXPECT_EQ(compressed.codec(), CompressedElement::SNAPPY);
+  EXPECT_LT(compressed.data().size(), 1 << 15);
+}
+
+TEST(CompressionUtilsTest, UnknownCodec) {
+  CompressedElement compressed;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CompressElement({ByteTensor(16, /*random=*/false)}, "lzma", &compressed)));
+}
+
+TEST(CompressionUtilsTest, UncompressIntoAllocatedTensors) {
+  std::vector<Tensor> element = {ByteTensor(1 << 10, /*random=*/true),
+                                 ByteTensor(1 << 10, /*random=*/false)};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, kCompressionCodecZlib, &compressed));
+  std::vector<Tensor> allocated;
+  std::vector<Tensor> round_trip_element;
+  TF_ASSERT_OK(UncompressElement(
+      compressed,
+      [&allocated](int index, DataType dtype, const TensorShape& shape,
+                   Tensor* tensor) {
+        allocated.emplace_back(dtype, shape);
+        *tensor = allocated.back();
+        return Status::OK();
+      },
+      &round_trip_element));
+  ASSERT_EQ(allocated.size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(allocated[i].tensor_data().data(),
+              round_trip_element[i].tensor_data().data());
+    test::ExpectTensorEqual<uint8>(element[i], allocated[i]);
+  }
+}
+
+TEST(CompressionUtilsTest, TruncatedZlibData) {
+  std::vector<Tensor> element = {ByteTensor(1 << 10, /*random=*/true)};
+  CompressedElement compressed;
+  TF_ASSERT_OK(CompressElement(element, kCompressionCodecZlib, &compressed));
+  compressed.mutable_data()->resize(compressed.data().size() / 2);
+  std::vector<Tensor> round_trip_element;
+  EXPECT_FALSE(UncompressElement(compressed, &round_trip_element).ok());
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -0,0 +1,104 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_job_cache.h"
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace data {
+
+CrossJobCache::CrossJobCache(ElementProducer producer, int64 max_size_bytes)
+    : producer_(std::move(producer)), max_size_bytes_(max_size_bytes) {}
+
+void CrossJobCache::RegisterConsumer(int64 consumer_id) {
+  mutex_lock l(mu_);
+  cursors_.insert({consumer_id, first_index_});
+}
+
+void CrossJobCache::UnregisterConsumer(int64 consumer_id) {
+  mutex_lock l(mu_);
+  cursors_.erase(consumer_id);
+}
+
+Status CrossJobCache::GetNext(int64 consumer_id, CompressedElement& element,
+                              bool& end_of_sequence) {
+  mutex_lock l(mu_);
+  auto it = cursors_.find(consumer_id);
+  if (it == cursors_.end()) {
+    return errors::NotFound("Consumer ", consumer_id,
+                            " is not registered with the cache");
+  }
+  int64& cursor = it->second;
+  if (cursor < first_index_) {
+    stats_.skipped += first_index_ - cursor;
+    cursor = first_index_;
+  }
+  if (cursor < first_index_ + static_cast<int64>(window_.size())) {
+    element = window_[cursor - first_index_];
+    ++cursor;
+    ++stats_.hits;
+    end_of_sequence = false;
+    return Status::OK();
+  }
+  if (end_of_sequence_) {
+    end_of_sequence = true;
+    return Status::OK();
+  }
+  CompressedElement produced;
+  TF_RETURN_IF_ERROR(producer_(produced, end_of_sequence_));
+  end_of_sequence = end_of_sequence_;
+  if (end_of_sequence_) {
+    return Status::OK();
+  }
+  ++stats_.misses;
+  element = produced;
+  size_bytes_ += produced.ByteSizeLong();
+  window_.push_back(std::move(produced));
+  ++cursor;
+  MaybeEvict();
+  return Status::OK();
+}
+
+void CrossJobCache::MaybeEvict() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  while (size_bytes_ > max_size_bytes_ && window_.size() > 1) {
+    size_bytes_ -= window_.front().ByteSizeLong();
+    window_.pop_front();
+    ++first_index_;
+    ++stats_.evictions;
+  }
+}
+
+bool CrossJobCache::end_of_sequence() const {
+  mutex_lock l(mu_);
+  return end_of_sequence_;
+}
+
+int64 CrossJobCache::num_consumers() const {
+  mutex_lock l(mu_);
+  return cursors_.size();
+}
+
+int64 CrossJobCache::size_bytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+CrossJobCache::Stats CrossJobCache::stats() const {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+}  // namespace data
+}  // namespace tensorflow
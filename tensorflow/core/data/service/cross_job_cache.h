@@ -0,0 +1,106 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
+
+#include <deque>
+#include <functional>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+
+// Shares the elements of one dataset between several consumers, so that
+// concurrent jobs reading the same dataset only produce each element once.
+//
+// Elements are produced on demand by a single producer and appended to a
+// sliding window. Each consumer reads the window through its own cursor. Once
+// the window holds more than `max_size_bytes`, the oldest elements are evicted,
+// and consumers whose cursor points at an evicted element skip ahead to the
+// oldest element still cached. Consumers which register after production has
+// started begin at the oldest cached element. Consumers may therefore observe
+// a suffix of the dataset, possibly with gaps, rather than the full dataset.
+//
+// This class is thread-safe.
+class CrossJobCache {
+ public:
+  // Produces the next element of the shared dataset.
+  using ElementProducer =
+      std::function<Status(CompressedElement& element, bool& end_of_sequence)>;
+
+  struct Stats {
+    // Number of elements served from the window.
+    int64 hits = 0;
+    // Number of elements which had to be produced.
+    int64 misses = 0;
+    // Number of elements evicted from the window.
+    int64 evictions = 0;
+    // Number of elements that consumers skipped because they fell behind.
+    int64 skipped = 0;
+  };
+
+  CrossJobCache(ElementProducer producer, int64 max_size_bytes);
+
+  // Registers a consumer reading from the cache. Registering an already
+  // registered consumer is a no-op.
+  void RegisterConsumer(int64 consumer_id);
+  // Unregisters a consumer. Unregistering an unknown consumer is a no-op.
+  void UnregisterConsumer(int64 consumer_id);
+
+  // Gets the next element for `consumer_id`, producing it if no consumer has
+  // needed it yet. Returns NotFound if the consumer is not registered.
+  Status GetNext(int64 consumer_id, CompressedElement& element,
+                 bool& end_of_sequence);
+
+  // Whether the producer has reached the end of the dataset.
+  bool end_of_sequence() const;
+  int64 num_consumers() const;
+  // Size of the elements currently held in the window.
+  int64 size_bytes() const;
+  Stats stats() const;
+
+ private:
+  // Evicts the oldest elements until the window fits in `max_size_bytes_`. The
+  // newest element is always kept, so that consumers that are caught up can
+  // still read it.
+  void MaybeEvict() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const ElementProducer producer_;
+  const int64 max_size_bytes_;
+
+  mutable mutex mu_;
+  // The cached elements. `window_[i]` is element number `first_index_ + i` of
+  // the dataset.
+  std::deque<CompressedElement> window_ TF_GUARDED_BY(mu_);
+  int64 first_index_ TF_GUARDED_BY(mu_) = 0;
+  int64 size_bytes_ TF_GUARDED_BY(mu_) = 0;
+  bool end_of_sequence_ TF_GUARDED_BY(mu_) = false;
+  // The index of the next element to return to each consumer.
+  absl::flat_hash_map<int64, int64> cursors_ TF_GUARDED_BY(mu_);
+  Stats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CrossJobCache);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_CROSS_JOB_CACHE_H_
@@ -0,0 +1,178 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_job_cache.h"
+
+#include <string>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+// Size of the payload of each element produced by `RangeProducer`.
+constexpr int64 kElementPayloadBytes = 100;
+
+// Returns a producer of `num_elements` elements whose payload encodes their
+// index, counting the number of elements produced in `num_produced`.
+CrossJobCache::ElementProducer RangeProducer(int64 num_elements,
+                                             int64* num_produced) {
+  *num_produced = 0;
+  return [num_elements, num_produced](CompressedElement& element,
+                                      bool& end_of_sequence) {
+    if (*num_produced == num_elements) {
+      end_of_sequence = true;
+      return Status::OK();
+    }
+    std::string payload = std::to_string(*num_produced);
+    payload.resize(kElementPayloadBytes, ' ');
+    element.set_data(payload);
+    ++*num_produced;
+    end_of_sequence = false;
+    return Status::OK();
+  };
+}
+
+int64 ElementIndex(const CompressedElement& element) {
+  return std::stoll(element.data());
+}
+
+// Reads the remaining elements of `consumer_id`.
+std::vector<int64> ReadAll(CrossJobCache& cache, int64 consumer_id) {
+  std::vector<int64> indices;
+  while (true) {
+    CompressedElement element;
+    bool end_of_sequence;
+    TF_CHECK_OK(cache.GetNext(consumer_id, element, end_of_sequence));
+    if (end_of_sequence) return indices;
+    indices.push_back(ElementIndex(element));
+  }
+}
+}  // namespace
+
+TEST(CrossJobCacheTest, SingleConsumer) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(5, &num_produced), 1 << 20);
+  cache.RegisterConsumer(0);
+  EXPECT_EQ(ReadAll(cache, 0), std::vector<int64>({0, 1, 2, 3, 4}));
+  EXPECT_TRUE(cache.end_of_sequence());
+  EXPECT_EQ(num_produced, 5);
+  EXPECT_EQ(cache.stats().hits, 0);
+}
+
+TEST(CrossJobCacheTest, ConsumersShareProducer) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(5, &num_produced), 1 << 20);
+  cache.RegisterConsumer(0);
+  cache.RegisterConsumer(1);
+  EXPECT_EQ(ReadAll(cache, 0), std::vector<int64>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(ReadAll(cache, 1), std::vector<int64>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(num_produced, 5);
+  CrossJobCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 5);
+  EXPECT_EQ(stats.misses, 5);
+}
+
+TEST(CrossJobCacheTest, InterleavedConsumers) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(3, &num_produced), 1 << 20);
+  cache.RegisterConsumer(0);
+  cache.RegisterConsumer(1);
+  for (int64 i = 0; i < 3; ++i) {
+    for (int64 consumer : {0, 1}) {
+      CompressedElement element;
+      bool end_of_sequence;
+      TF_ASSERT_OK(cache.GetNext(consumer, element, end_of_sequence));
+      ASSERT_FALSE(end_of_sequence);
+      EXPECT_EQ(ElementIndex(element), i);
+    }
+  }
+  EXPECT_EQ(num_produced, 3);
+}
+
+TEST(CrossJobCacheTest, SlowConsumerSkipsEvictedElements) {
+  int64 num_produced;
+  // Room for two elements.
+  CrossJobCache cache(RangeProducer(10, &num_produced),
+                      2 * kElementPayloadBytes + 10);
+  cache.RegisterConsumer(0);
+  cache.RegisterConsumer(1);
+  EXPECT_EQ(ReadAll(cache, 0).size(), 10);
+  EXPECT_LE(cache.size_bytes(), 2 * kElementPayloadBytes + 10);
+  EXPECT_EQ(ReadAll(cache, 1), std::vector<int64>({8, 9}));
+  CrossJobCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.evictions, 8);
+  EXPECT_EQ(stats.skipped, 8);
+}
+
+TEST(CrossJobCacheTest, LateConsumerStartsAtOldestElement) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(10, &num_produced),
+                      2 * kElementPayloadBytes + 10);
+  cache.RegisterConsumer(0);
+  CompressedElement element;
+  bool end_of_sequence;
+  for (int i = 0; i < 5; ++i) {
+    TF_ASSERT_OK(cache.GetNext(0, element, end_of_sequence));
+  }
+  cache.RegisterConsumer(1);
+  TF_ASSERT_OK(cache.GetNext(1, element, end_of_sequence));
+  EXPECT_EQ(ElementIndex(element), 3);
+  EXPECT_EQ(cache.stats().skipped, 0);
+}
+
+TEST(CrossJobCacheTest, KeepsNewestElementOverBudget) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(3, &num_produced), 1);
+  cache.RegisterConsumer(0);
+  cache.RegisterConsumer(1);
+  CompressedElement element;
+  bool end_of_sequence;
+  TF_ASSERT_OK(cache.GetNext(0, element, end_of_sequence));
+  TF_ASSERT_OK(cache.GetNext(1, element, end_of_sequence));
+  EXPECT_EQ(ElementIndex(element), 0);
+  EXPECT_EQ(cache.stats().hits, 1);
+}
+
+TEST(CrossJobCacheTest, UnregisteredConsumer) {
+  int64 num_produced;
+  CrossJobCache cache(RangeProducer(3, &num_produced), 1 << 20);
+  cache.RegisterConsumer(0);
+  EXPECT_EQ(cache.num_consumers(), 1);
+  cache.UnregisterConsumer(0);
+  EXPECT_EQ(cache.num_consumers(), 0);
+  CompressedElement element;
+  bool end_of_sequence;
+  EXPECT_TRUE(
+      errors::IsNotFound(cache.GetNext(0, element, end_of_sequence)));
+}
+
+TEST(CrossJobCacheTest, ProducerError) {
+  CrossJobCache cache(
+      [](CompressedElement& element, bool& end_of_sequence) {
+        return errors::Internal("producer failed");
+      },
+      1 << 20);
+  cache.RegisterConsumer(0);
+  CompressedElement element;
+  bool end_of_sequence;
+  EXPECT_TRUE(errors::IsInternal(cache.GetNext(0, element, end_of_sequence)));
+  EXPECT_FALSE(cache.end_of_sequence());
+}
+
+}  // namespace data
+}  // namespace tensorflow
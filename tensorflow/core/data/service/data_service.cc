@@ -56,13 +56,18 @@ std::string ProcessingModeToString(ProcessingMode mode) {
 
 Status DataServiceDispatcherClient::WorkerHeartbeat(
     const std::string& worker_address, const std::vector<int64>& current_tasks,
-    std::vector<TaskDef>& new_tasks, std::vector<int64>& tasks_to_delete) {
+    int64 cross_job_cache_hits, int64 cross_job_cache_misses,
+    const WorkerLoad& load, std::vector<TaskDef>& new_tasks,
+    std::vector<int64>& tasks_to_delete) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   WorkerHeartbeatRequest req;
   req.set_worker_address(worker_address);
   for (int64 task : current_tasks) {
     req.add_current_tasks(task);
   }
+  req.set_cross_job_cache_hits(cross_job_cache_hits);
+  req.set_cross_job_cache_misses(cross_job_cache_misses);
+  *req.mutable_load() = load;
   WorkerHeartbeatResponse resp;
   grpc::ClientContext client_ctx;
   grpc::Status status = stub_->WorkerHeartbeat(&client_ctx, req, &resp);
@@ -78,9 +78,13 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // registered with the dispatcher, this will register the worker. The
   // dispatcher will report which new tasks the worker should run, and which
   // tasks it should delete. This is stored into `new_tasks` and
-  // `tasks_to_delete`.
+  // `tasks_to_delete`. `cross_job_cache_hits` and `cross_job_cache_misses` are
+  // the worker's cross-job cache lookups since its previous heartbeat, and
+  // `load` its load over the same interval.
   Status WorkerHeartbeat(const std::string& worker_address,
                          const std::vector<int64>& current_tasks,
+                         int64 cross_job_cache_hits,
+                         int64 cross_job_cache_misses, const WorkerLoad& load,
                          std::vector<TaskDef>& new_tasks,
                          std::vector<int64>& tasks_to_delete);
 
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -37,7 +38,59 @@ namespace data {
 
 namespace {
 constexpr const char kProtocol[] = "grpc+local";
+constexpr const char kCrossJobCacheElements[] =
+    "/tensorflow/data/service/worker/cross_job_cache_elements";
+
+// Returns the value of the worker counter of cross-job cache elements with
+// the given label ("hit" or "miss").
+int64 CrossJobCacheElements(const std::string& label) {
+  std::unique_ptr<monitoring::CollectedMetrics> metrics =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  auto it = metrics->point_set_map.find(kCrossJobCacheElements);
+  if (it == metrics->point_set_map.end()) {
+    return 0;
+  }
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == label) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
+// Returns the only task of the job with the given job client id.
+Status GetTask(DataServiceDispatcherClient& dispatcher, int64 job_client_id,
+               TaskInfo& task) {
+  std::vector<TaskInfo> tasks;
+  bool job_finished;
+  TF_RETURN_IF_ERROR(dispatcher.GetTasks(job_client_id, tasks, job_finished));
+  if (tasks.size() != 1) {
+    return errors::Internal("Expected 1 task, got ", tasks.size());
+  }
+  task = tasks[0];
+  return Status::OK();
+}
+
+// Reads up to `max_elements` elements of `task`, stopping early at the end of
+// the sequence.
+Status ReadElements(const TaskInfo& task, int max_elements,
+                    std::vector<std::vector<Tensor>>& elements,
+                    bool& end_of_sequence) {
+  DataServiceWorkerClient worker(task.worker_address(), kProtocol);
+  end_of_sequence = false;
+  for (int i = 0; i < max_elements; ++i) {
+    CompressedElement compressed;
+    TF_RETURN_IF_ERROR(
+        worker.GetElement(task.task_id(), compressed, end_of_sequence));
+    if (end_of_sequence) {
+      return Status::OK();
+    }
+    elements.emplace_back();
+    TF_RETURN_IF_ERROR(UncompressElement(compressed, &elements.back()));
+  }
+  return Status::OK();
 }
+}  // namespace
 
 TEST(DataService, ParseParallelEpochsProcessingMode) {
   ProcessingMode mode;
@@ -74,5 +127,68 @@ TEST(DataService, GetWorkers) {
   EXPECT_EQ(1, workers.size());
 }
 
+TEST(DataService, WorkersWithCrossJobCache) {
+  experimental::WorkerConfig worker_config;
+  worker_config.set_cross_job_cache_max_bytes(1 << 20);
+  TestCluster cluster(2, worker_config);
+  TF_ASSERT_OK(cluster.Initialize());
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  std::vector<WorkerInfo> workers;
+  TF_EXPECT_OK(dispatcher.GetWorkers(workers));
+  EXPECT_EQ(2, workers.size());
+}
+
+TEST(DataService, SecondJobReadsFromCrossJobCache) {
+  experimental::WorkerConfig worker_config;
+  worker_config.set_cross_job_cache_max_bytes(1 << 20);
+  TestCluster cluster(1, worker_config);
+  TF_ASSERT_OK(cluster.Initialize());
+  test_util::GraphDefTestCase test_case;
+  TF_ASSERT_OK(test_util::map_test_case(&test_case));
+  const int num_elements = test_case.output.size();
+  DataServiceDispatcherClient dispatcher(cluster.DispatcherAddress(),
+                                         kProtocol);
+  int64 dataset_id;
+  TF_ASSERT_OK(dispatcher.RegisterDataset(test_case.graph_def, dataset_id));
+  int64 job_client_id1, job_client_id2;
+  TF_ASSERT_OK(dispatcher.CreateJob(dataset_id, ProcessingMode::PARALLEL_EPOCHS,
+                                    job_client_id1));
+  TF_ASSERT_OK(dispatcher.CreateJob(dataset_id, ProcessingMode::PARALLEL_EPOCHS,
+                                    job_client_id2));
+  TaskInfo task1, task2;
+  TF_ASSERT_OK(GetTask(dispatcher, job_client_id1, task1));
+  TF_ASSERT_OK(GetTask(dispatcher, job_client_id2, task2));
+  ASSERT_NE(task1.job_id(), task2.job_id());
+  const int64 hits = CrossJobCacheElements("hit");
+  const int64 misses = CrossJobCacheElements("miss");
+
+  // The first job produces every element, and stops before the end of the
+  // sequence so that the shared iterator is still live for the second job.
+  std::vector<std::vector<Tensor>> elements1;
+  bool end_of_sequence;
+  TF_ASSERT_OK(ReadElements(task1, num_elements, elements1, end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  EXPECT_EQ(CrossJobCacheElements("hit"), hits);
+  EXPECT_EQ(CrossJobCacheElements("miss"), misses + num_elements);
+
+  // The second job reads them all from the cache.
+  std::vector<std::vector<Tensor>> elements2;
+  TF_ASSERT_OK(
+      ReadElements(task2, num_elements + 1, elements2, end_of_sequence));
+  EXPECT_TRUE(end_of_sequence);
+  EXPECT_EQ(CrossJobCacheElements("hit"), hits + num_elements);
+  EXPECT_EQ(CrossJobCacheElements("miss"), misses + num_elements);
+
+  ASSERT_EQ(elements1.size(), num_elements);
+  ASSERT_EQ(elements2.size(), num_elements);
+  for (int i = 0; i < num_elements; ++i) {
+    TF_EXPECT_OK(DatasetOpsTestBase::ExpectEqual(
+        elements1[i], test_case.output[i], /*compare_order=*/true));
+    TF_EXPECT_OK(DatasetOpsTestBase::ExpectEqual(
+        elements2[i], test_case.output[i], /*compare_order=*/true));
+  }
+}
+
 }  // namespace data
 }  // namespace tensorflow
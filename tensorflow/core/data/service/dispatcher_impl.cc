@@ -35,11 +35,13 @@ limitations under the License.
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/journal.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
 #include "tensorflow/core/kernels/data/hash_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/protobuf/data/experimental/service_config.pb.h"
@@ -53,6 +55,10 @@ namespace {
 constexpr char kJournalDir[] = "tf_data_dispatcher_journal";
 // The name of the datasets directory inside the dispatcher's working directory.
 constexpr char kDatasetsDir[] = "datasets";
+// How long the load reported by a worker is kept if
+// `DispatcherConfig.worker_load_timeout_ms` is not set: four heartbeats at the
+// default worker heartbeat interval.
+constexpr int64 kDefaultWorkerLoadTimeoutMs = 2 * 60 * 1000;
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -71,6 +77,12 @@ using NamedJobKey = DispatcherState::NamedJobKey;
 using Job = DispatcherState::Job;
 using Task = DispatcherState::Task;
 
+auto* cross_job_cache_elements = monitoring::Counter<1>::New(
+    "/tensorflow/data/service/dispatcher/cross_job_cache_elements",
+    "The number of elements served by workers of this dispatcher through "
+    "their cross-job caches, by whether they were already cached.",
+    "result");
+
 std::string JournalDir(const std::string& work_dir) {
   return io::JoinPath(work_dir, kJournalDir);
 }
@@ -200,8 +212,17 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
   TF_RETURN_IF_ERROR(CheckStarted());
   VLOG(3) << "Received worker heartbeat request from worker "
           << request->worker_address();
+  cross_job_cache_elements->GetCell("hit")->IncrementBy(
+      request->cross_job_cache_hits());
+  cross_job_cache_elements->GetCell("miss")->IncrementBy(
+      request->cross_job_cache_misses());
   mutex_lock l(mu_);
   const std::string& worker_address = request->worker_address();
+  if (request->has_load()) {
+    worker_loads_[worker_address] = {request->load(), env_->NowMicros()};
+  } else {
+    worker_loads_.erase(worker_address);
+  }
   std::vector<std::shared_ptr<const Task>> correct_tasks;
   Status s = state_.TasksForWorker(worker_address, correct_tasks);
   if (!s.ok()) {
@@ -546,6 +567,22 @@ Status DataServiceDispatcherImpl::CreateTasksForJob(
     std::vector<std::shared_ptr<const Task>>& tasks)
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   std::vector<std::shared_ptr<const Worker>> workers = state_.ListWorkers();
+  if (config_.load_aware_task_assignment()) {
+    GcWorkerLoads();
+    std::vector<std::shared_ptr<const Worker>> available_workers;
+    for (const auto& worker : workers) {
+      auto it = worker_loads_.find(worker->address);
+      if (it == worker_loads_.end() || !IsOverloaded(it->second.load)) {
+        available_workers.push_back(worker);
+      } else {
+        VLOG(1) << "Not creating a task for job " << job->job_id
+                << " on overloaded worker " << worker->address;
+      }
+    }
+    if (!available_workers.empty()) {
+      workers = std::move(available_workers);
+    }
+  }
   tasks.clear();
   tasks.reserve(workers.size());
   for (const auto& worker : workers) {
@@ -728,6 +765,7 @@ void DataServiceDispatcherImpl::JobGcThread() {
     if (!s.ok()) {
       LOG(WARNING) << "Error garbage collecting old jobs: " << s;
     }
+    GcWorkerLoads();
     next_check_micros =
         env_->NowMicros() + (config_.job_gc_check_interval_ms() * 1000);
   }
@@ -758,6 +796,22 @@ Status DataServiceDispatcherImpl::GcOldJobs() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   return Status::OK();
 }
 
+void DataServiceDispatcherImpl::GcWorkerLoads() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64 timeout_ms = config_.worker_load_timeout_ms() > 0
+                               ? config_.worker_load_timeout_ms()
+                               : kDefaultWorkerLoadTimeoutMs;
+  const int64 now = env_->NowMicros();
+  for (auto it = worker_loads_.begin(); it != worker_loads_.end();) {
+    if (now < it->second.received_micros + timeout_ms * 1000) {
+      ++it;
+      continue;
+    }
+    VLOG(1) << "Forgetting the load of worker " << it->first
+            << ", which has not heartbeated for " << timeout_ms << "ms";
+    worker_loads_.erase(it++);
+  }
+}
+
 Status DataServiceDispatcherImpl::GetDatasetDef(
     int64 dataset_id, std::shared_ptr<const DatasetDef>& dataset_def)
     EXCLUSIVE_LOCKS_REQUIRED(mu_) {
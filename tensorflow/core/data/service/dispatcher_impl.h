@@ -163,6 +163,9 @@ class DataServiceDispatcherImpl {
   void JobGcThread();
   // Scans for old jobs and marks them as finished.
   Status GcOldJobs() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Removes the loads of workers which have not heartbeated within
+  // `worker_load_timeout_ms`.
+  void GcWorkerLoads() EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Gets a `DatasetDef` from `dataset_store_` for the given dataset id, and
   // stores it in `dataset_def`.
   Status GetDatasetDef(int64 dataset_id,
@@ -181,6 +184,16 @@ class DataServiceDispatcherImpl {
   bool started_ TF_GUARDED_BY(mu_) = false;
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
 
+  struct ReportedLoad {
+    WorkerLoad load;
+    // When the heartbeat carrying `load` was received.
+    int64 received_micros;
+  };
+  // The load most recently reported by each worker, keyed by worker address.
+  // This is not journaled; it is rebuilt from heartbeats after a restart.
+  // Entries expire when the worker stops heartbeating.
+  absl::flat_hash_map<std::string, ReportedLoad> worker_loads_
+      TF_GUARDED_BY(mu_);
   // Cached worker stubs for communicating with workers.
   absl::flat_hash_map<std::string, std::unique_ptr<WorkerService::Stub>>
       worker_stubs_ TF_GUARDED_BY(mu_);
@@ -28,10 +28,13 @@ limitations under the License.
 #include "tensorflow/core/data/service/grpc_util.h"
 #include "tensorflow/core/data/service/split_provider.h"
 #include "tensorflow/core/data/service/utils.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/refcount.h"
@@ -48,11 +51,51 @@ auto* tf_data_service_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/data/service/created",
                                     "Whether a tf.data service server "
                                     "has been created.");
+
+auto* cross_job_cache_elements = monitoring::Counter<1>::New(
+    "/tensorflow/data/service/worker/cross_job_cache_elements",
+    "The number of elements served through the cross-job cache, by whether "
+    "they were already cached.",
+    "result");
+
+// Moves the compressed element produced by a tf.data service dataset out of
+// `outputs`.
+Status MoveCompressedElement(std::vector<Tensor>& outputs,
+                             CompressedElement& element) {
+  if (outputs.size() != 1) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but the "
+        "dataset produced ",
+        outputs.size(), " outputs");
+  }
+  if (outputs[0].dtype() != DT_VARIANT) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with type ",
+        DataTypeString(outputs[0].dtype()));
+  }
+  if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a single scalar variant tensor, but "
+        "the dataset produced a tensor with shape ",
+        outputs[0].shape());
+  }
+  Variant& variant = outputs[0].scalar<Variant>()();
+  CompressedElement* compressed = variant.get<CompressedElement>();
+  if (compressed == nullptr) {
+    return errors::FailedPrecondition(
+        "Expected dataset to produce a CompressedElement variant tensor, but "
+        "it produced ",
+        variant.TypeName());
+  }
+  compressed->Swap(&element);
+  return Status::OK();
+}
 }  // namespace
 
 DataServiceWorkerImpl::DataServiceWorkerImpl(
     const experimental::WorkerConfig& config)
-    : config_(config) {
+    : config_(config), load_tracker_(Env::Default()->NowMicros()) {
   tf_data_service_created->GetCell()->Set(true);
 }
 
@@ -116,36 +159,78 @@ Status DataServiceWorkerImpl::ProcessTaskInternal(const TaskDef& task_def)
   return Status::OK();
 }
 
-Status DataServiceWorkerImpl::EnsureTaskInitialized(
-    DataServiceWorkerImpl::Task& task) {
-  mutex_lock l(task.mu);
-  if (task.initialized) {
-    return Status::OK();
-  }
+Status DataServiceWorkerImpl::MakeDataset(
+    const TaskDef& task_def, std::unique_ptr<standalone::Dataset>& dataset) {
   standalone::Dataset::Params params;
-
-  switch (task.task_def.dataset_case()) {
+  switch (task_def.dataset_case()) {
     case TaskDef::kDatasetDef:
-      TF_RETURN_IF_ERROR(standalone::Dataset::FromGraph(
-          params, task.task_def.dataset_def().graph(), &task.dataset));
-      break;
+      return standalone::Dataset::FromGraph(
+          params, task_def.dataset_def().graph(), &dataset);
     case TaskDef::kPath: {
       DatasetDef def;
-      Status s = ReadDatasetDef(task.task_def.path(), def);
+      Status s = ReadDatasetDef(task_def.path(), def);
       if (!s.ok()) {
-        LOG(INFO) << "Failed to read dataset from " << task.task_def.path()
-                  << ": " << s << ". Falling back to reading from dispatcher.";
+        LOG(INFO) << "Failed to read dataset from " << task_def.path() << ": "
+                  << s << ". Falling back to reading from dispatcher.";
         TF_RETURN_IF_ERROR(
-            dispatcher_->GetDatasetDef(task.task_def.dataset_id(), def));
+            dispatcher_->GetDatasetDef(task_def.dataset_id(), def));
       }
-      TF_RETURN_IF_ERROR(
-          standalone::Dataset::FromGraph(params, def.graph(), &task.dataset));
-      break;
+      return standalone::Dataset::FromGraph(params, def.graph(), &dataset);
     }
     case TaskDef::DATASET_NOT_SET:
-      return errors::Internal("Unrecognized dataset case: ",
-                              task.task_def.dataset_case());
+      break;
+  }
+  return errors::Internal("Unrecognized dataset case: ",
+                          task_def.dataset_case());
+}
+
+Status DataServiceWorkerImpl::GetOrCreateSharedDataset(
+    const TaskDef& task_def, std::shared_ptr<SharedDataset>& shared)
+    EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::weak_ptr<SharedDataset>& entry = shared_datasets_[task_def.dataset_id()];
+  shared = entry.lock();
+  // Jobs starting after the shared iterator is exhausted get a new iterator,
+  // so that they still see a full epoch.
+  if (shared && !shared->cache->end_of_sequence()) {
+    return Status::OK();
+  }
+  auto new_shared = std::make_shared<SharedDataset>();
+  TF_RETURN_IF_ERROR(MakeDataset(task_def, new_shared->dataset));
+  TF_RETURN_IF_ERROR(new_shared->dataset->MakeIterator(&new_shared->iterator));
+  standalone::Iterator* iterator = new_shared->iterator.get();
+  new_shared->cache = absl::make_unique<CrossJobCache>(
+      [iterator](CompressedElement& element, bool& end_of_sequence) {
+        std::vector<Tensor> outputs;
+        TF_RETURN_IF_ERROR(iterator->GetNext(&outputs, &end_of_sequence));
+        if (end_of_sequence) {
+          return Status::OK();
+        }
+        return MoveCompressedElement(outputs, element);
+      },
+      config_.cross_job_cache_max_bytes());
+  shared = std::move(new_shared);
+  entry = shared;
+  VLOG(3) << "Created shared iterator for dataset " << task_def.dataset_id();
+  return Status::OK();
+}
+
+Status DataServiceWorkerImpl::EnsureTaskInitialized(
+    DataServiceWorkerImpl::Task& task) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  mutex_lock l(task.mu);
+  if (task.initialized) {
+    return Status::OK();
   }
+  if (task.task_def.processing_mode() == PARALLEL_EPOCHS &&
+      config_.cross_job_cache_max_bytes() > 0) {
+    TF_RETURN_IF_ERROR(
+        GetOrCreateSharedDataset(task.task_def, task.shared_dataset));
+    task.shared_dataset->cache->RegisterConsumer(task.task_def.task_id());
+    task.initialized = true;
+    VLOG(3) << "Task " << task.task_def.task_id()
+            << " reads through the cross-job cache";
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(MakeDataset(task.task_def, task.dataset));
   switch (task.task_def.processing_mode()) {
     case DISTRIBUTED_EPOCH: {
       auto split_provider = absl::make_unique<DataServiceSplitProvider>(
@@ -171,7 +256,14 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
                                          GetElementResponse* response) {
   VLOG(3) << "Received GetElement request for task " << request->task_id();
   bool end_of_sequence = false;
+  bool from_cache = false;
   std::vector<tensorflow::Tensor> outputs;
+  bool produced = false;
+  int64 processing_micros = 0;
+  load_tracker_.RequestStarted();
+  auto record_load = gtl::MakeCleanup([&]() {
+    load_tracker_.RequestFinished(produced, processing_micros);
+  });
   {
     mutex_lock l(mu_);
     if (!registered_) {
@@ -188,7 +280,29 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
     }
     auto& task = it->second;
     TF_RETURN_IF_ERROR(EnsureTaskInitialized(*task));
-    TF_RETURN_IF_ERROR(task->iterator->GetNext(&outputs, &end_of_sequence));
+    const int64 start_micros = Env::Default()->NowMicros();
+    auto record_processing_time = gtl::MakeCleanup([&]() {
+      processing_micros = Env::Default()->NowMicros() - start_micros;
+    });
+    if (task->shared_dataset) {
+      CrossJobCache& cache = *task->shared_dataset->cache;
+      const int64 hits = cache.stats().hits;
+      TF_RETURN_IF_ERROR(cache.GetNext(request->task_id(),
+                                       *response->mutable_compressed_element(),
+                                       end_of_sequence));
+      if (!end_of_sequence) {
+        // Tasks only read from the cache under `mu_`, so the stats can't have
+        // been changed by another task.
+        const bool hit = cache.stats().hits > hits;
+        ++(hit ? cross_job_cache_hits_ : cross_job_cache_misses_);
+        cross_job_cache_elements->GetCell(hit ? "hit" : "miss")
+            ->IncrementBy(1);
+        from_cache = true;
+      }
+    } else {
+      TF_RETURN_IF_ERROR(task->iterator->GetNext(&outputs, &end_of_sequence));
+    }
+    produced = !end_of_sequence;
     if (end_of_sequence) {
       VLOG(3) << "Reached end_of_sequence for task " << request->task_id();
       task->finished = true;
@@ -197,35 +311,10 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
     }
   }
 
-  if (!end_of_sequence) {
+  if (!end_of_sequence && !from_cache) {
     VLOG(3) << "Producing an element for task " << request->task_id();
-    if (outputs.size() != 1) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but the "
-          "dataset produced ",
-          outputs.size(), " outputs");
-    }
-    if (outputs[0].dtype() != DT_VARIANT) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with type ",
-          DataTypeString(outputs[0].dtype()));
-    }
-    if (!TensorShapeUtils::IsScalar(outputs[0].shape())) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a single scalar variant tensor, but "
-          "the dataset produced a tensor with shape ",
-          outputs[0].shape());
-    }
-    Variant& variant = outputs[0].scalar<Variant>()();
-    CompressedElement* compressed = variant.get<CompressedElement>();
-    if (compressed == nullptr) {
-      return errors::FailedPrecondition(
-          "Expected dataset to produce a CompressedElement variant tensor, but "
-          "it produced ",
-          variant.TypeName());
-    }
-    compressed->Swap(response->mutable_compressed_element());
+    TF_RETURN_IF_ERROR(
+        MoveCompressedElement(outputs, *response->mutable_compressed_element()));
   }
   response->set_end_of_sequence(end_of_sequence);
 
@@ -323,17 +412,31 @@ void DataServiceWorkerImpl::HeartbeatThread() LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
   std::vector<int64> current_tasks;
+  int64 cross_job_cache_hits;
+  int64 cross_job_cache_misses;
+  int64 new_cross_job_cache_hits;
+  int64 new_cross_job_cache_misses;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
     }
+    cross_job_cache_hits = cross_job_cache_hits_;
+    cross_job_cache_misses = cross_job_cache_misses_;
+    new_cross_job_cache_hits =
+        cross_job_cache_hits - reported_cross_job_cache_hits_;
+    new_cross_job_cache_misses =
+        cross_job_cache_misses - reported_cross_job_cache_misses_;
   }
   std::vector<TaskDef> new_tasks;
   std::vector<int64> tasks_to_delete;
+  const WorkerLoad load = load_tracker_.Report(Env::Default()->NowMicros());
   TF_RETURN_IF_ERROR(dispatcher_->WorkerHeartbeat(
-      worker_address_, current_tasks, new_tasks, tasks_to_delete));
+      worker_address_, current_tasks, new_cross_job_cache_hits,
+      new_cross_job_cache_misses, load, new_tasks, tasks_to_delete));
   mutex_lock l(mu_);
+  reported_cross_job_cache_hits_ = cross_job_cache_hits;
+  reported_cross_job_cache_misses_ = cross_job_cache_misses;
   for (const auto& task : new_tasks) {
     Status s = ProcessTaskInternal(task);
     if (!s.ok() && !errors::IsAlreadyExists(s)) {
@@ -346,6 +449,13 @@ Status DataServiceWorkerImpl::Heartbeat() LOCKS_EXCLUDED(mu_) {
             << " at the request of the dispatcher";
     tasks_.erase(task_id);
   }
+  for (auto it = shared_datasets_.begin(); it != shared_datasets_.end();) {
+    if (it->second.expired()) {
+      shared_datasets_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
   return Status::OK();
 }
 
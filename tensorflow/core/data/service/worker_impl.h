@@ -17,9 +17,11 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/data/service/cross_job_cache.h"
 #include "tensorflow/core/data/service/data_service.h"
 #include "tensorflow/core/data/service/dispatcher.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/data/experimental/service_config.pb.h"
@@ -54,8 +56,21 @@ class DataServiceWorkerImpl {
                         GetWorkerTasksResponse* response);
 
  private:
+  // A dataset whose iterator is shared, through a cross-job cache, by the
+  // parallel-epochs tasks of all jobs reading the dataset.
+  struct SharedDataset {
+    std::unique_ptr<standalone::Dataset> dataset;
+    std::unique_ptr<standalone::Iterator> iterator;
+    std::unique_ptr<CrossJobCache> cache;
+  };
+
   struct Task {
     explicit Task(TaskDef task_def) : task_def(std::move(task_def)) {}
+    ~Task() {
+      if (shared_dataset) {
+        shared_dataset->cache->UnregisterConsumer(task_def.task_id());
+      }
+    }
 
     TaskDef task_def;
     mutex mu;
@@ -65,13 +80,24 @@ class DataServiceWorkerImpl {
     // standalone::Dataset so that we don't need to store the dataset here.
     std::unique_ptr<standalone::Dataset> dataset;
     std::unique_ptr<standalone::Iterator> iterator;
+    // Set instead of `dataset` and `iterator` when the task reads through the
+    // cross-job cache.
+    std::shared_ptr<SharedDataset> shared_dataset;
   };
 
   // Sends task status to the dispatcher and checks for dispatcher commands.
   Status SendTaskUpdates() LOCKS_EXCLUDED(mu_);
   // Creates an iterator to process a task.
   Status ProcessTaskInternal(const TaskDef& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
-  Status EnsureTaskInitialized(Task& task);
+  Status EnsureTaskInitialized(Task& task) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Creates the dataset for `task_def`.
+  Status MakeDataset(const TaskDef& task_def,
+                     std::unique_ptr<standalone::Dataset>& dataset);
+  // Gets the shared dataset for the dataset of `task_def`, creating it if no
+  // task is reading it or if its iterator has been exhausted.
+  Status GetOrCreateSharedDataset(const TaskDef& task_def,
+                                  std::shared_ptr<SharedDataset>& shared)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // A thread for notifying the dispatcher when tasks complete.
   void TaskCompletionThread() LOCKS_EXCLUDED(mu_);
   // A thread for doing periodic heartbeats to the dispatcher.
@@ -83,6 +109,8 @@ class DataServiceWorkerImpl {
   // The worker's own address.
   std::string worker_address_;
   std::unique_ptr<DataServiceDispatcherClient> dispatcher_;
+  // Load reported to the dispatcher in heartbeats.
+  WorkerLoadTracker load_tracker_;
 
   mutex mu_;
   // Information about tasks, keyed by task ids.
@@ -92,6 +120,17 @@ class DataServiceWorkerImpl {
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
+  // Datasets shared through the cross-job cache, keyed by dataset id. The
+  // dispatcher gives identical datasets the same id. Entries are owned by the
+  // tasks reading them.
+  absl::flat_hash_map<int64, std::weak_ptr<SharedDataset>> shared_datasets_
+      TF_GUARDED_BY(mu_);
+  // Cross-job cache lookups, and how many of them were reported to the
+  // dispatcher.
+  int64 cross_job_cache_hits_ TF_GUARDED_BY(mu_) = 0;
+  int64 cross_job_cache_misses_ TF_GUARDED_BY(mu_) = 0;
+  int64 reported_cross_job_cache_hits_ TF_GUARDED_BY(mu_) = 0;
+  int64 reported_cross_job_cache_misses_ TF_GUARDED_BY(mu_) = 0;
   // A thread for notifying the dispatcher when tasks complete.
   std::unique_ptr<Thread> task_completion_thread_;
   condition_variable task_completion_cv_ TF_GUARDED_BY(mu_);
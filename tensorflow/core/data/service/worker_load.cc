@@ -0,0 +1,96 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_load.h"
+
+#include <algorithm>
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+// Weight of a new measurement in latency estimates.
+constexpr double kLatencyDecay = 0.2;
+}  // namespace
+
+bool IsOverloaded(const WorkerLoad& load) {
+  return load.utilization() >= kOverloadedWorkerUtilization;
+}
+
+WorkerLoadTracker::WorkerLoadTracker(int64 now_micros)
+    : interval_start_micros_(now_micros) {}
+
+void WorkerLoadTracker::RequestStarted() {
+  mutex_lock l(mu_);
+  ++active_requests_;
+}
+
+void WorkerLoadTracker::RequestFinished(bool produced,
+                                        int64 processing_micros) {
+  mutex_lock l(mu_);
+  --active_requests_;
+  processing_micros_ += processing_micros;
+  if (produced) {
+    ++elements_;
+  }
+}
+
+WorkerLoad WorkerLoadTracker::Report(int64 now_micros) {
+  mutex_lock l(mu_);
+  WorkerLoad load;
+  const int64 interval_micros =
+      std::max<int64>(now_micros - interval_start_micros_, 1);
+  load.set_elements_per_second(elements_ * 1e6 / interval_micros);
+  load.set_utilization(
+      std::min(1.0, static_cast<double>(processing_micros_) / interval_micros));
+  load.set_active_requests(active_requests_);
+  interval_start_micros_ = now_micros;
+  elements_ = 0;
+  processing_micros_ = 0;
+  return load;
+}
+
+void UpdateLatencyEstimate(int64 sample_micros, double* estimate_micros) {
+  // Clamp samples so that unmeasurably fast requests still get a finite
+  // weight in `ChooseLowLatencyTask`.
+  const double sample = std::max<int64>(sample_micros, 1);
+  if (*estimate_micros <= 0) {
+    *estimate_micros = sample;
+    return;
+  }
+  *estimate_micros += kLatencyDecay * (sample - *estimate_micros);
+}
+
+int ChooseLowLatencyTask(const std::vector<double>& latency_estimates_micros,
+                         double uniform) {
+  double total_weight = 0;
+  for (int i = 0; i < latency_estimates_micros.size(); ++i) {
+    if (latency_estimates_micros[i] <= 0) {
+      return i;
+    }
+    total_weight += 1.0 / latency_estimates_micros[i];
+  }
+  double target = uniform * total_weight;
+  for (int i = 0; i < latency_estimates_micros.size(); ++i) {
+    target -= 1.0 / latency_estimates_micros[i];
+    if (target < 0) {
+      return i;
+    }
+  }
+  // Only reachable through rounding.
+  return latency_estimates_micros.size() - 1;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,74 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
+
+#include <vector>
+
+#include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+// Utilities for load-aware scheduling in the tf.data service.
+namespace tensorflow {
+namespace data {
+
+// Utilization above which a worker is considered overloaded.
+constexpr double kOverloadedWorkerUtilization = 0.9;
+
+// Returns whether a worker reporting `load` should not be given more work.
+bool IsOverloaded(const WorkerLoad& load);
+
+// Measures the load of a worker between successive reports.
+//
+// This class is thread-safe.
+class WorkerLoadTracker {
+ public:
+  explicit WorkerLoadTracker(int64 now_micros);
+
+  // Records that a request for an element started.
+  void RequestStarted();
+  // Records that a request finished after spending `processing_micros`
+  // producing an element, or reaching the end of its task if `!produced`.
+  void RequestFinished(bool produced, int64 processing_micros);
+
+  // Returns the load since the previous report, and starts a new interval.
+  WorkerLoad Report(int64 now_micros);
+
+ private:
+  mutex mu_;
+  int64 interval_start_micros_ TF_GUARDED_BY(mu_);
+  int64 elements_ TF_GUARDED_BY(mu_) = 0;
+  int64 processing_micros_ TF_GUARDED_BY(mu_) = 0;
+  int64 active_requests_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Folds a new latency measurement into the moving average `*estimate_micros`.
+// An estimate of 0 means that nothing has been measured yet.
+void UpdateLatencyEstimate(int64 sample_micros, double* estimate_micros);
+
+// Picks one of several candidate tasks to read from, with probability
+// inversely proportional to their estimated latencies, so that clients favor
+// fast workers without starving slow ones. Candidates without an estimate are
+// picked first, so that every worker is measured. `uniform` is a random number
+// in [0, 1).
+int ChooseLowLatencyTask(const std::vector<double>& latency_estimates_micros,
+                         double uniform);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_WORKER_LOAD_H_
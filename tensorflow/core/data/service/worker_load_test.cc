@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_load.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+
+namespace {
+// Simulates a client reading `num_elements` elements, one request at a time,
+// from workers which take `worker_latencies_micros` to produce each element.
+// Returns the simulated time taken to read all elements.
+int64 SimulateReads(const std::vector<int64>& worker_latencies_micros,
+                    int64 num_elements, bool load_aware) {
+  random::PhiloxRandom parent_generator(/*seed=*/42);
+  random::SimplePhilox generator(&parent_generator);
+  std::vector<double> latency_estimates(worker_latencies_micros.size(), 0);
+  int64 now_micros = 0;
+  int next_worker = 0;
+  for (int64 i = 0; i < num_elements; ++i) {
+    int worker;
+    if (load_aware) {
+      worker = ChooseLowLatencyTask(latency_estimates, generator.RandDouble());
+    } else {
+      worker = next_worker;
+      next_worker = (next_worker + 1) % worker_latencies_micros.size();
+    }
+    now_micros += worker_latencies_micros[worker];
+    UpdateLatencyEstimate(worker_latencies_micros[worker],
+                          &latency_estimates[worker]);
+  }
+  return now_micros;
+}
+}  // namespace
+
+TEST(WorkerLoadTest, IsOverloaded) {
+  WorkerLoad load;
+  load.set_utilization(0.5);
+  EXPECT_FALSE(IsOverloaded(load));
+  load.set_utilization(kOverloadedWorkerUtilization);
+  EXPECT_TRUE(IsOverloaded(load));
+}
+
+TEST(WorkerLoadTest, TrackerReport) {
+  WorkerLoadTracker tracker(/*now_micros=*/0);
+  tracker.RequestStarted();
+  tracker.RequestStarted();
+  tracker.RequestFinished(/*produced=*/true, /*processing_micros=*/200000);
+  tracker.RequestFinished(/*produced=*/false, /*processing_micros=*/50000);
+  tracker.RequestStarted();
+  WorkerLoad load = tracker.Report(/*now_micros=*/1000000);
+  EXPECT_DOUBLE_EQ(load.elements_per_second(), 1.0);
+  EXPECT_DOUBLE_EQ(load.utilization(), 0.25);
+  EXPECT_EQ(load.active_requests(), 1);
+
+  // Each report only covers the interval since the previous one.
+  tracker.RequestFinished(/*produced=*/true, /*processing_micros=*/500000);
+  load = tracker.Report(/*now_micros=*/1500000);
+  EXPECT_DOUBLE_EQ(load.elements_per_second(), 2.0);
+  EXPECT_DOUBLE_EQ(load.utilization(), 1.0);
+  EXPECT_EQ(load.active_requests(), 0);
+}
+
+TEST(WorkerLoadTest, UpdateLatencyEstimate) {
+  double estimate = 0;
+  UpdateLatencyEstimate(100, &estimate);
+  EXPECT_DOUBLE_EQ(estimate, 100);
+  UpdateLatencyEstimate(200, &estimate);
+  EXPECT_DOUBLE_EQ(estimate, 120);
+  UpdateLatencyEstimate(0, &estimate);
+  EXPECT_GT(estimate, 0);
+}
+
+TEST(WorkerLoadTest, ChooseUnmeasuredTaskFirst) {
+  EXPECT_EQ(ChooseLowLatencyTask({10, 0, 20}, 0.0), 1);
+  EXPECT_EQ(ChooseLowLatencyTask({10, 20, 0}, 0.99), 2);
+}
+
+TEST(WorkerLoadTest, ChooseProportionallyToSpeed) {
+  // Weights are 1/1 and 1/3, so the first task gets 3/4 of the draws.
+  EXPECT_EQ(ChooseLowLatencyTask({1, 3}, 0.0), 0);
+  EXPECT_EQ(ChooseLowLatencyTask({1, 3}, 0.74), 0);
+  EXPECT_EQ(ChooseLowLatencyTask({1, 3}, 0.76), 1);
+  EXPECT_EQ(ChooseLowLatencyTask({1, 3}, 0.999999), 1);
+}
+
+TEST(WorkerLoadTest, HeterogeneousWorkers) {
+  // One worker is ten times slower than the others, e.g. because it is shared
+  // with another job.
+  const std::vector<int64> latencies_micros = {1000, 1000, 10000};
+  const int64 num_elements = 300;
+  int64 round_robin_micros =
+      SimulateReads(latencies_micros, num_elements, /*load_aware=*/false);
+  int64 load_aware_micros =
+      SimulateReads(latencies_micros, num_elements, /*load_aware=*/true);
+  EXPECT_EQ(round_robin_micros, 100 * 12000);
+  EXPECT_LT(load_aware_micros, 0.6 * round_robin_micros);
+}
+
+}  // namespace data
+}  // namespace tensorflow
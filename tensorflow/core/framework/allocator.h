@@ -164,6 +164,10 @@ struct AllocatorStats {
 
   int64 largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // Stats for allocators that cache freed memory for reuse.
+  int64 num_cache_hits;  // Number of allocations served from the cache.
+  int64 bytes_in_cache;  // Bytes held by the cache, not part of bytes_in_use.
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
@@ -171,7 +175,9 @@ struct AllocatorStats {
         largest_alloc_size(0),
         bytes_reserved(0),
         peak_bytes_reserved(0),
-        largest_free_block_bytes(0) {}
+        largest_free_block_bytes(0),
+        num_cache_hits(0),
+        bytes_in_cache(0) {}
 
   std::string DebugString() const;
 };
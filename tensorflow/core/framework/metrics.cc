@@ -114,6 +114,24 @@ auto* tf_data_getnext_time_between_msecs_histogram =
                                         200., 225., 250., 300., 350., 400.,
                                         450., 500., 1000., 10000.})});
 
+auto* tf_data_snapshot_bytes_read_counter = monitoring::Counter<0>::New(
+    "/tensorflow/data/snapshot/bytes_read",
+    "The number of bytes of elements read from tf.data snapshots.");
+
+auto* tf_data_snapshot_decode_time_usecs_histogram =
+    monitoring::Sampler<0>::New(
+        {"/tensorflow/data/snapshot/decode_time",
+         "Microseconds spent reading and decoding an element of a tf.data "
+         "snapshot."},
+        // Power of 2 with bucket count 20 (> 1 second).
+        {monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* tf_data_snapshot_read_throughput_histogram = monitoring::Sampler<0>::New(
+    {"/tensorflow/data/snapshot/read_throughput",
+     "Bytes per second at which tf.data snapshot files are read."},
+    // Power of 2 with bucket count 16, from 1MB/s to 32GB/s.
+    {monitoring::Buckets::Exponential(1 << 20, 2, 16)});
+
 auto* tf_data_optimization_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
@@ -155,6 +173,23 @@ auto* xla_compilation_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/core/xla_compilation_time_usecs",
     "The total time spent on compiling XLA graphs in microseconds.");
 
+auto* xla_persistent_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/xla_persistent_cache_lookups",
+    "The number of lookups in the persistent XLA compilation cache, by result.",
+    "result");
+
+auto* grappler_cache_lookups = monitoring::Counter<1>::New(
+    "/tensorflow/core/grappler_cache_lookups",
+    "The number of lookups in the on-disk cache of optimized graphs, by "
+    "result.",
+    "result");
+
+auto* resource_mgr_lock_contention = monitoring::Counter<1>::New(
+    "/tensorflow/core/resource_mgr_lock_contention",
+    "The number of ResourceMgr lock acquisitions that had to wait for another "
+    "thread, by lock mode.",
+    "mode");
+
 auto* mlir_import_failure_count = monitoring::Counter<0>::New(
     "/tensorflow/mlir/import_failure_count",
     "The number of jobs that failed during mlir import or verification.");
@@ -198,6 +233,24 @@ void RecordTFDataFingerprint(const string& name) {
   tf_data_fingerprint_counter->GetCell(name)->IncrementBy(1);
 }
 
+void RecordTFDataSnapshotBytesRead(int64 num_bytes) {
+  static auto* tf_data_snapshot_bytes_read_cell =
+      tf_data_snapshot_bytes_read_counter->GetCell();
+  tf_data_snapshot_bytes_read_cell->IncrementBy(num_bytes);
+}
+
+void RecordTFDataSnapshotDecodeTime(uint64 duration_us) {
+  static auto* tf_data_snapshot_decode_time_cell =
+      tf_data_snapshot_decode_time_usecs_histogram->GetCell();
+  tf_data_snapshot_decode_time_cell->Add(duration_us);
+}
+
+void RecordTFDataSnapshotReadThroughput(double bytes_per_second) {
+  static auto* tf_data_snapshot_read_throughput_cell =
+      tf_data_snapshot_read_throughput_histogram->GetCell();
+  tf_data_snapshot_read_throughput_cell->Add(bytes_per_second);
+}
+
 void RecordTFDataGetNextDuration(uint64 duration_us) {
   static auto* tfdata_getnext_duration_cell =
       tf_data_getnext_duration_usecs_histogram->GetCell();
@@ -300,6 +353,21 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs) {
   }
 }
 
+void RecordXlaPersistentCacheLookup(const string& result) {
+  xla_persistent_cache_lookups->GetCell(result)->IncrementBy(1);
+}
+
+void RecordGrapplerCacheLookup(const string& result) {
+  grappler_cache_lookups->GetCell(result)->IncrementBy(1);
+}
+
+void RecordResourceMgrLockContention(bool exclusive) {
+  static auto* shared_cell = resource_mgr_lock_contention->GetCell("shared");
+  static auto* exclusive_cell =
+      resource_mgr_lock_contention->GetCell("exclusive");
+  (exclusive ? exclusive_cell : shared_cell)->IncrementBy(1);
+}
+
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   static auto* bfc_allocator_delay_cell = bfc_allocator_delay->GetCell();
   if (delay_usecs > 0) {
@@ -68,6 +68,17 @@ void RecordTFDataGetNextDuration(uint64 duration_us);
 // This elapsed time corresponds to time spent outside the GetNext() function.
 void RecordTFDataGetNextTimeBetween(uint64 duration_us);
 
+// Records the number of bytes of elements read from tf.data snapshots.
+void RecordTFDataSnapshotBytesRead(int64 num_bytes);
+
+// Records the time spent reading and decoding an element of a tf.data snapshot
+// in microseconds.
+void RecordTFDataSnapshotDecodeTime(uint64 duration_us);
+
+// Records the rate at which a tf.data snapshot file was read, in bytes per
+// second of wall time between opening the file and reaching its end.
+void RecordTFDataSnapshotReadThroughput(double bytes_per_second);
+
 // Records the number of times each tf.data fingerprint is used
 // to measure duplicate pre-processing.
 //
@@ -124,6 +135,24 @@ void UpdateGrapplerPassTime(const string& pass_name,
 // Updates the metrics stored about time XLA spents compiling graphs.
 void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 
+// Records a lookup in the persistent XLA compilation cache.
+//
+// The `result` argument identifies the outcome of the lookup (e.g. "hit",
+// "miss" or "corrupt").
+void RecordXlaPersistentCacheLookup(const string& result);
+
+// Records a lookup in the on-disk cache of optimized graphs.
+//
+// The `result` argument identifies the outcome of the lookup ("hit", "miss" or
+// "corrupt").
+void RecordGrapplerCacheLookup(const string& result);
+
+// Records that acquiring a ResourceMgr lock had to wait for another thread.
+//
+// The `exclusive` argument is true for creations and deletions, and false for
+// lookups.
+void RecordResourceMgrLockContention(bool exclusive);
+
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 
@@ -1386,6 +1387,9 @@ void Model::Optimize(AutotuneAlgorithm algorithm, int64 cpu_budget,
     case AutotuneAlgorithm::GRADIENT_DESCENT:
       OptimizeGradientDescent(cpu_budget, ram_budget, model_input_time);
       break;
+    case AutotuneAlgorithm::BOTTLENECK:
+      OptimizeBottleneck(cpu_budget, ram_budget, model_input_time);
+      break;
   }
 }
 
@@ -1571,6 +1575,112 @@ void Model::OptimizeHillClimb(int64 cpu_budget, int64 ram_budget,
   }
 }
 
+void Model::OptimizeBottleneck(int64 cpu_budget, int64 ram_budget,
+                               double model_input_time) {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock lock(mu_);
+    snapshot = output_->Snapshot();
+  }
+  VLOG(2) << "Starting optimization of tunable parameters with Bottleneck";
+  const double processing_time = TotalProcessingTime(snapshot);
+  auto parameters = CollectTunableParameters(snapshot);
+  auto essential_parameters = CollectEssentialParallelism(snapshot, parameters);
+  // Buffer size parameter will only be incremented if the output latency
+  // improvement is greater than this constant.
+  constexpr double kBufferSizeMinDelta = 1.0L;
+
+  // Buffer sizes grow by this fraction of their current value in one step.
+  constexpr double kBufferSizeGrowthRate = 0.5L;
+
+  // Lower bound for the cost of a step, so that steps which are free according
+  // to the model (e.g. because no element sizes have been recorded yet) are
+  // ranked by their output time improvement alone.
+  constexpr double kMinStepCost = 1e-6L;
+
+  // Maximum number of iterations for optimization.
+  constexpr int64 kMaxIterations = 10000;
+
+  for (auto& pair : parameters) {
+    pair.second->value = pair.second->min;
+  }
+  auto essential_parallelism = [&essential_parameters]() {
+    double result = 0;
+    for (auto& pair : essential_parameters) {
+      result += pair.second->value;
+    }
+    return result;
+  };
+  // Parameters whose next step would exceed one of the budgets. As the other
+  // parameters only grow, such a step never becomes feasible again.
+  absl::flat_hash_set<string> exhausted;
+  for (int64 i = 0; i < kMaxIterations; ++i) {
+    const double output_time =
+        OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
+    if (output_time < processing_time / cpu_budget) {
+      break;
+    }
+    const double buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+    const double parallelism = essential_parallelism();
+    double best_score = 0;
+    Parameter* best_parameter = nullptr;
+    double best_value = 0;
+    for (auto& pair : parameters) {
+      auto& parameter = pair.second;
+      if (parameter->value >= parameter->max ||
+          exhausted.contains(pair.first)) {
+        continue;
+      }
+      const double old_value = parameter->value;
+      const double step =
+          parameter->name == kBufferSize
+              ? std::max(1.0, std::floor(old_value * kBufferSizeGrowthRate))
+              : 1.0;
+      parameter->value = std::min(old_value + step, parameter->max);
+      const double new_value = parameter->value;
+      const double new_buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+      const double new_parallelism = essential_parallelism();
+      double delta = 0;
+      if (new_buffered_bytes <= ram_budget && new_parallelism <= cpu_budget) {
+        delta = output_time -
+                OutputTime(snapshot, model_input_time, /*gradients=*/nullptr);
+      } else {
+        exhausted.insert(pair.first);
+      }
+      parameter->value = old_value;
+      if (delta <= 0 ||
+          (parameter->name == kBufferSize && delta <= kBufferSizeMinDelta)) {
+        continue;
+      }
+      double cost = (new_buffered_bytes - buffered_bytes) /
+                    std::max<int64>(ram_budget, 1);
+      if (parameter->name == kParallelism) {
+        cost += (new_value - old_value) / cpu_budget;
+      }
+      cost = std::max(cost, kMinStepCost);
+      const double score = delta / cost;
+      if (score > best_score) {
+        best_score = score;
+        best_parameter = parameter.get();
+        best_value = new_value;
+      }
+    }
+    if (!best_parameter) {
+      break;
+    }
+    best_parameter->value = best_value;
+  }
+  VLOG(2) << "Number of tunable parameters: " << parameters.size();
+  for (auto& pair : parameters) {
+    auto& parameter = pair.second;
+    VLOG(2) << "Setting tunable parameter " << pair.first << " to "
+            << parameter->value;
+    mutex_lock l(*parameter->state->mu);
+    parameter->state->value = parameter->value;
+    parameter->state->cond_var->notify_all();
+  }
+}
+
 double Model::OutputTime(std::shared_ptr<Node> node, double model_input_time,
                          absl::flat_hash_map<string, double>* gradients) {
   // To store the input time for each node.
@@ -48,6 +48,7 @@ constexpr char kModelInputTimeKey[] = "model_input_time";
 enum class AutotuneAlgorithm {
   HILL_CLIMB = 0,
   GRADIENT_DESCENT = 1,
+  BOTTLENECK = 2,
 };
 
 enum class TraversalOrder {
@@ -674,6 +675,21 @@ class Model {
   void OptimizeGradientDescent(int64 cpu_budget, int64 ram_budget,
                                double model_input_time);
 
+  // This optimization algorithm starts by setting all tunable parameters to
+  // the minimum value. It then repeatedly evaluates a step of each parameter
+  // (one more thread for parallelism parameters, a geometrically growing step
+  // for buffer sizes) and takes the step with the largest decrease of the
+  // output time per unit of resource cost, where the cost is the share of the
+  // CPU budget used by the added threads plus the share of the RAM budget used
+  // by the added buffers. Steps that would take the parallelism of the
+  // essential transformations beyond the CPU budget or the worst-case total
+  // buffer size beyond the RAM budget are never taken, so that the remaining
+  // budget can still go to other parameters. This process is repeated until
+  // no step decreases the output time or the output time is less than the
+  // processing time needed to produce an element divided by CPU budget.
+  void OptimizeBottleneck(int64 cpu_budget, int64 ram_budget,
+                          double model_input_time);
+
   // Collects the output time and if `gradients` is not `nullptr`, the output
   // time gradient w.r.t. tunable parameters of the subtree rooted in the given
   // node.
@@ -16,8 +16,17 @@ limitations under the License.
 #include "tensorflow/core/framework/model.h"
 #include <memory>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace data {
@@ -947,7 +956,237 @@ TEST_P(OptimizeZeroRamBudgetTest, Model) {
 }
 
 INSTANTIATE_TEST_SUITE_P(Test, OptimizeZeroRamBudgetTest,
-                         ::testing::Values(0, 1));
+                         ::testing::Values(0, 1, 2));
+
+// Describes a node of a recorded input pipeline.
+struct NodeProfile {
+  enum Kind { kSource, kKnownRatio, kAsyncKnownRatio, kAsyncInterleaveMany };
+
+  string name;
+  Kind kind = kSource;
+  // Index of the output node in the profile, or -1 for the root.
+  int output = -1;
+  double ratio = 0;
+  // Name of the tunable parameter of asynchronous nodes and its maximum value.
+  string parameter;
+  double max = 0;
+  int64 num_elements = 0;
+  int64 processing_time = 0;
+  int64 buffered_bytes = 0;
+  int64 buffered_elements = 0;
+};
+
+constexpr char kProfileDir[] = "core/framework/testdata/model_profiles";
+
+// Reads the profile recorded in `filename`. A profile lists the nodes in the
+// format of `Node::DebugString()`, with the kind, ratio and tunable parameter
+// of each node added, and every node following the node it is an input of.
+Status ReadProfile(const string& filename, std::vector<NodeProfile>* profile) {
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), filename, &contents));
+  static const auto* const kKinds =
+      new absl::flat_hash_map<string, NodeProfile::Kind>{
+          {"source", NodeProfile::kSource},
+          {"known_ratio", NodeProfile::kKnownRatio},
+          {"async_known_ratio", NodeProfile::kAsyncKnownRatio},
+          {"async_interleave_many", NodeProfile::kAsyncInterleaveMany}};
+  // The output of each node listed as an input so far.
+  absl::flat_hash_map<string, int> outputs;
+  profile->clear();
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    if (line.empty() || absl::StartsWith(line, "#")) continue;
+    if (!absl::StartsWith(line, " ")) {
+      if (!absl::ConsumeSuffix(&line, ":")) {
+        return errors::InvalidArgument(filename, ": invalid line ", line);
+      }
+      profile->emplace_back();
+      NodeProfile& node = profile->back();
+      node.name = string(line);
+      if (profile->size() > 1) {
+        auto it = outputs.find(node.name);
+        if (it == outputs.end()) {
+          return errors::InvalidArgument(filename, ": node ", node.name,
+                                         " is not an input of a prior node");
+        }
+        node.output = it->second;
+      }
+      continue;
+    }
+    std::pair<absl::string_view, absl::string_view> field = absl::StrSplit(
+        absl::StripAsciiWhitespace(line), absl::MaxSplits('=', 1));
+    if (profile->empty()) {
+      return errors::InvalidArgument(filename, ": field ", field.first,
+                                     " outside of a node");
+    }
+    NodeProfile& node = profile->back();
+    const absl::string_view value = field.second;
+    bool ok = true;
+    if (field.first == "kind") {
+      auto it = kKinds->find(value);
+      ok = it != kKinds->end();
+      if (ok) node.kind = it->second;
+    } else if (field.first == "ratio") {
+      ok = absl::SimpleAtod(value, &node.ratio);
+    } else if (field.first == "parameter") {
+      node.parameter = string(value);
+    } else if (field.first == "max") {
+      ok = absl::SimpleAtod(value, &node.max);
+    } else if (field.first == "num_elements") {
+      ok = absl::SimpleAtoi(value, &node.num_elements);
+    } else if (field.first == "processing_time") {
+      ok = absl::SimpleAtoi(value, &node.processing_time);
+    } else if (field.first == "buffered_bytes") {
+      ok = absl::SimpleAtoi(value, &node.buffered_bytes);
+    } else if (field.first == "buffered_elements") {
+      ok = absl::SimpleAtoi(value, &node.buffered_elements);
+    } else if (field.first == "inputs") {
+      ok = absl::ConsumePrefix(&field.second, "{") &&
+           absl::ConsumeSuffix(&field.second, "}");
+      for (absl::string_view input :
+           absl::StrSplit(field.second, ',', absl::SkipEmpty())) {
+        outputs[string(input)] = profile->size() - 1;
+      }
+    }
+    // Other fields printed by `Node::DebugString()` are ignored.
+    if (!ok) {
+      return errors::InvalidArgument(filename, ": invalid value of ",
+                                     field.first, " for node ", node.name,
+                                     ": ", value);
+    }
+  }
+  if (profile->empty()) {
+    return errors::InvalidArgument(filename, ": empty profile");
+  }
+  return Status::OK();
+}
+
+// Returns the profile recorded in the given file of `kProfileDir`.
+std::vector<NodeProfile> RecordedProfile(const string& basename) {
+  std::vector<NodeProfile> profile;
+  TF_CHECK_OK(ReadProfile(
+      io::JoinPath(testing::TensorFlowSrcRoot(), kProfileDir, basename),
+      &profile));
+  return profile;
+}
+
+// Builds a model of the pipeline described by `profile`, in which all
+// parameters are tunable. Returns the nodes in the order of `profile`.
+std::vector<std::shared_ptr<Node>> ReplayProfile(
+    const std::vector<NodeProfile>& profile, Model* model) {
+  std::vector<std::shared_ptr<Node>> nodes(profile.size());
+  for (int i = 0; i < profile.size(); ++i) {
+    const NodeProfile& node_profile = profile[i];
+    std::shared_ptr<Node> output =
+        node_profile.output < 0 ? nullptr : nodes[node_profile.output];
+    std::vector<std::shared_ptr<Parameter>> parameters;
+    if (!node_profile.parameter.empty()) {
+      parameters.push_back(model::MakeParameter(
+          node_profile.parameter,
+          std::make_shared<SharedState>(kAutotune, std::make_shared<mutex>(),
+                                        std::make_shared<condition_variable>()),
+          node_profile.parameter == kBufferSize ? 0 : 1, node_profile.max));
+    }
+    model->AddNode(
+        [&node_profile, &parameters](Node::Args args) -> std::shared_ptr<Node> {
+          switch (node_profile.kind) {
+            case NodeProfile::kSource:
+              return model::MakeSourceNode(std::move(args));
+            case NodeProfile::kKnownRatio:
+              return model::MakeKnownRatioNode(std::move(args),
+                                               node_profile.ratio);
+            case NodeProfile::kAsyncKnownRatio:
+              return model::MakeAsyncKnownRatioNode(
+                  std::move(args), node_profile.ratio, parameters);
+            case NodeProfile::kAsyncInterleaveMany:
+              return model::MakeAsyncInterleaveManyNode(std::move(args),
+                                                        parameters);
+          }
+          return nullptr;
+        },
+        node_profile.name, output, &nodes[i]);
+    for (int64 j = 0; j < node_profile.num_elements; ++j) {
+      nodes[i]->record_element();
+    }
+    nodes[i]->add_processing_time(node_profile.processing_time);
+    nodes[i]->record_buffer_event(node_profile.buffered_bytes,
+                                  node_profile.buffered_elements);
+  }
+  return nodes;
+}
+
+const char* const kRecordedProfiles[] = {"image_pipeline.txt",
+                                         "tabular_pipeline.txt"};
+
+TEST(ReadProfileTest, RecordedProfiles) {
+  for (const char* basename : kRecordedProfiles) {
+    const std::vector<NodeProfile> profile = RecordedProfile(basename);
+    EXPECT_EQ(profile[0].name, "Prefetch");
+    EXPECT_EQ(profile[0].output, -1);
+    for (int i = 1; i < profile.size(); ++i) {
+      EXPECT_GE(profile[i].output, 0);
+      EXPECT_LT(profile[i].output, i);
+    }
+  }
+}
+
+TEST(OptimizeBottleneckTest, Model) {
+  const int64 cpu_budget = 8;
+  Model model;
+  std::vector<std::shared_ptr<Node>> nodes =
+      ReplayProfile(RecordedProfile("image_pipeline.txt"), &model);
+  model.Optimize(AutotuneAlgorithm::BOTTLENECK, cpu_budget,
+                 /*ram_budget=*/1 << 30, /*model_input_time=*/0);
+  const double augment = nodes[2]->parameter_value(kParallelism);
+  const double decode = nodes[3]->parameter_value(kParallelism);
+  // The transformation which dominates the processing time gets the most
+  // threads, but no more than the CPU budget.
+  EXPECT_GT(decode, augment);
+  EXPECT_GT(decode, 1);
+  EXPECT_LE(decode, cpu_budget);
+}
+
+TEST(OptimizeBottleneckTest, RamBudget) {
+  const int64 ram_budget = 1 << 20;
+  Model model;
+  std::vector<std::shared_ptr<Node>> nodes =
+      ReplayProfile(RecordedProfile("image_pipeline.txt"), &model);
+  model.Optimize(AutotuneAlgorithm::BOTTLENECK, /*cpu_budget=*/64, ram_budget,
+                 /*model_input_time=*/0);
+  EXPECT_LE(nodes[0]->TotalMaximumBufferedBytes(), ram_budget);
+  EXPECT_GT(nodes[3]->parameter_value(kParallelism), 1);
+}
+
+// Replays a recorded profile and tunes it with `algorithm`. The label reports
+// the output time predicted for the tuned parameters, which allows comparing
+// the tuning quality of the algorithms offline.
+void BM_OptimizeRecordedProfile(int iters, int profile_index, int algorithm) {
+  const std::vector<NodeProfile> profile =
+      RecordedProfile(kRecordedProfiles[profile_index]);
+  const int64 cpu_budget = 16;
+  const int64 ram_budget = 256 << 20;
+  double output_time = 0;
+  for (int i = 0; i < iters; ++i) {
+    testing::StopTiming();
+    Model model;
+    std::vector<std::shared_ptr<Node>> nodes = ReplayProfile(profile, &model);
+    testing::StartTiming();
+    model.Optimize(static_cast<AutotuneAlgorithm>(algorithm), cpu_budget,
+                   ram_budget, /*model_input_time=*/0);
+    testing::StopTiming();
+    absl::flat_hash_map<string, double> input_times = {
+        {kModelInputTimeKey, 0}};
+    output_time = nodes[0]->OutputTime(&input_times, /*gradients=*/nullptr);
+  }
+  testing::SetLabel(strings::StrCat("output_time=", output_time));
+}
+
+BENCHMARK(BM_OptimizeRecordedProfile)
+    ->ArgPair(0, 0)
+    ->ArgPair(0, 1)
+    ->ArgPair(0, 2)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 2);
 
 }  // namespace
 }  // namespace model
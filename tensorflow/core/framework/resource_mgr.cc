@@ -18,6 +18,7 @@ limitations under the License.
 #include <atomic>
 
 #include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -116,60 +117,112 @@ ResourceMgr::ResourceAndName& ResourceMgr::ResourceAndName::operator=(
   return *this;
 }
 
-ResourceMgr::ResourceMgr() : default_container_("localhost") {}
+ResourceMgr::ResourceMgr() : ResourceMgr("localhost") {}
 
 ResourceMgr::ResourceMgr(const string& default_container)
-    : default_container_(default_container) {}
+    : default_container_(default_container) {
+  for (auto& shard : shards_) {
+    shard = absl::make_unique<Shard>();
+  }
+}
 
 ResourceMgr::~ResourceMgr() { Clear(); }
 
+ResourceMgr::ShardReaderLock::ShardReaderLock(const Shard& shard)
+    : shard_(shard) {
+  shard_.shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (!shard_.mu.try_lock_shared()) {
+    shard_.contended_shared_acquisitions.fetch_add(1,
+                                                   std::memory_order_relaxed);
+    metrics::RecordResourceMgrLockContention(/*exclusive=*/false);
+    shard_.mu.lock_shared();
+  }
+}
+
+ResourceMgr::ShardReaderLock::~ShardReaderLock() { shard_.mu.unlock_shared(); }
+
+ResourceMgr::ShardWriterLock::ShardWriterLock(const Shard& shard)
+    : shard_(shard) {
+  shard_.exclusive_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (!shard_.mu.try_lock()) {
+    shard_.contended_exclusive_acquisitions.fetch_add(
+        1, std::memory_order_relaxed);
+    metrics::RecordResourceMgrLockContention(/*exclusive=*/true);
+    shard_.mu.lock();
+  }
+}
+
+ResourceMgr::ShardWriterLock::~ShardWriterLock() { shard_.mu.unlock(); }
+
+/* static */ int ResourceMgr::ShardIndex(const string& container,
+                                         const string& name) {
+  static_assert((kNumShards & (kNumShards - 1)) == 0,
+                "kNumShards must be a power of two");
+  return Hash64(name.data(), name.size(), Hash64(container)) &
+         (kNumShards - 1);
+}
+
 void ResourceMgr::Clear() {
   // We do the deallocation outside of the lock to avoid a potential deadlock
   // in case any of the destructors access the resource manager.
-  std::unordered_map<string, Container*> tmp_containers;
+  std::vector<Container*> tmp_containers;
+  for (auto& shard : shards_) {
+    ShardWriterLock l(*shard);
+    for (const auto& p : shard->containers) {
+      tmp_containers.push_back(p.second);
+    }
+    shard->containers.clear();
+  }
   {
     mutex_lock l(mu_);
-    tmp_containers = std::move(containers_);
+    container_names_.clear();
   }
-  for (const auto& p : tmp_containers) {
-    delete p.second;
+  for (Container* b : tmp_containers) {
+    delete b;
   }
-  tmp_containers.clear();
 }
 
 string ResourceMgr::DebugString() const {
-  mutex_lock l(mu_);
-  struct Line {
-    const string* container;
-    const string type;
-    const string* resource;
-    const string detail;
-  };
-  std::vector<Line> lines;
-  for (const auto& p : containers_) {
-    const string& container = p.first;
-    for (const auto& q : *p.second) {
-      const Key& key = q.first;
-      const char* type = DebugTypeName(key.first);
-      Line l{&container, port::Demangle(type), q.second.name.get(),
-             q.second.resource->DebugString()};
-      lines.push_back(l);
-    }
-  }
   std::vector<string> text;
-  text.reserve(lines.size());
-  for (const Line& line : lines) {
-    text.push_back(strings::Printf(
-        "%-20s | %-40s | %-40s | %-s", line.container->c_str(),
-        line.type.c_str(), line.resource->c_str(), line.detail.c_str()));
+  for (const auto& shard : shards_) {
+    tf_shared_lock shard_lock(shard->mu);
+    tf_shared_lock l(mu_);
+    for (const auto& p : shard->containers) {
+      const string& container = p.first;
+      for (const auto& q : *p.second) {
+        const Key& key = q.first;
+        const char* type = DebugTypeName(key.first);
+        text.push_back(strings::Printf(
+            "%-20s | %-40s | %-40s | %-s", container.c_str(),
+            port::Demangle(type).c_str(), q.second.name->c_str(),
+            q.second.resource->DebugString().c_str()));
+      }
+    }
   }
   std::sort(text.begin(), text.end());
   return absl::StrJoin(text, "\n");
 }
 
-Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
-                             const string& name, ResourceBase* resource) {
-  Container** b = &containers_[container];
+ResourceMgr::LockStats ResourceMgr::lock_stats() const {
+  LockStats stats;
+  for (const auto& shard : shards_) {
+    stats.shared_acquisitions +=
+        shard->shared_acquisitions.load(std::memory_order_relaxed);
+    stats.contended_shared_acquisitions +=
+        shard->contended_shared_acquisitions.load(std::memory_order_relaxed);
+    stats.exclusive_acquisitions +=
+        shard->exclusive_acquisitions.load(std::memory_order_relaxed);
+    stats.contended_exclusive_acquisitions +=
+        shard->contended_exclusive_acquisitions.load(
+            std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+Status ResourceMgr::DoCreate(Shard* shard, const string& container,
+                             TypeIndex type, const string& name,
+                             ResourceBase* resource) {
+  Container** b = &shard->containers[container];
   if (*b == nullptr) {
     *b = new Container;
   }
@@ -182,6 +235,8 @@ Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
                                       std::move(resource_and_name));
 
   if ((*b)->insert(std::move(key_and_value)).second) {
+    mutex_lock l(mu_);
+    container_names_.insert(container);
     TF_RETURN_IF_ERROR(InsertDebugTypeName(type.hash_code(), type.name()));
     return Status::OK();
   }
@@ -189,23 +244,31 @@ Status ResourceMgr::DoCreate(const string& container, TypeIndex type,
                                type.name());
 }
 
-Status ResourceMgr::DoLookup(const string& container, TypeIndex type,
-                             const string& name,
+bool ResourceMgr::ContainerExists(const string& container) const {
+  tf_shared_lock l(mu_);
+  return container_names_.count(container) > 0;
+}
+
+Status ResourceMgr::DoLookup(const Shard& shard, const string& container,
+                             TypeIndex type, const string& name,
                              ResourceBase** resource) const {
-  const Container* b = gtl::FindPtrOrNull(containers_, container);
-  if (b == nullptr) {
+  const Container* b = gtl::FindPtrOrNull(shard.containers, container);
+  if (b != nullptr) {
+    auto iter = b->find({type.hash_code(), name});
+    if (iter != b->end()) {
+      *resource = const_cast<ResourceBase*>(iter->second.resource.get());
+      (*resource)->Ref();
+      return Status::OK();
+    }
+  }
+  // The container may still hold resources in other shards.
+  if (!ContainerExists(container)) {
     return errors::NotFound("Container ", container,
                             " does not exist. (Could not find resource: ",
                             container, "/", name, ")");
   }
-  auto iter = b->find({type.hash_code(), name});
-  if (iter == b->end()) {
-    return errors::NotFound("Resource ", container, "/", name, "/", type.name(),
-                            " does not exist.");
-  }
-  *resource = const_cast<ResourceBase*>(iter->second.resource.get());
-  (*resource)->Ref();
-  return Status::OK();
+  return errors::NotFound("Resource ", container, "/", name, "/", type.name(),
+                          " does not exist.");
 }
 
 Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
@@ -213,11 +276,16 @@ Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
                              const string& type_name) {
   ResourceAndName resource_and_name;
   {
-    mutex_lock l(mu_);
-    Container* b = gtl::FindPtrOrNull(containers_, container);
-    if (b == nullptr) {
+    Shard& shard = GetShard(container, resource_name);
+    ShardWriterLock l(shard);
+    Container* b = gtl::FindPtrOrNull(shard.containers, container);
+    if (b == nullptr && !ContainerExists(container)) {
       return errors::NotFound("Container ", container, " does not exist.");
     }
+    if (b == nullptr) {
+      return errors::NotFound("Resource ", container, "/", resource_name, "/",
+                              type_name, " does not exist.");
+    }
     auto iter = b->find({type_hash_code, resource_name});
     if (iter == b->end()) {
       return errors::NotFound("Resource ", container, "/", resource_name, "/",
@@ -243,27 +311,44 @@ Status ResourceMgr::Delete(const ResourceHandle& handle) {
 Status ResourceMgr::Cleanup(const string& container) {
   {
     tf_shared_lock l(mu_);
-    if (!gtl::FindOrNull(containers_, container)) {
+    if (!container_names_.count(container)) {
       // Nothing to cleanup.
       return Status::OK();
     }
   }
-  Container* b = nullptr;
-  {
-    mutex_lock l(mu_);
-    auto iter = containers_.find(container);
-    if (iter == containers_.end()) {
-      // Nothing to cleanup, it's OK (concurrent cleanup).
-      return Status::OK();
-    }
-    b = iter->second;
-    containers_.erase(iter);
+  std::vector<Container*> tmp_containers;
+  RemoveContainer(container, &tmp_containers);
+  for (Container* b : tmp_containers) {
+    delete b;
   }
-  CHECK(b != nullptr);
-  delete b;
   return Status::OK();
 }
 
+void ResourceMgr::RemoveContainer(const string& container,
+                                  std::vector<Container*>* removed) {
+  // Holding every shard lock, and then `mu_` as DoCreate() does, makes the
+  // removal atomic: a concurrent Create() into `container` either completes
+  // before it, and its resource is removed, or starts after it, and then
+  // finds neither the container nor its name.
+  std::vector<std::unique_ptr<ShardWriterLock>> shard_locks;
+  shard_locks.reserve(kNumShards);
+  for (auto& shard : shards_) {
+    shard_locks.emplace_back(new ShardWriterLock(*shard));
+  }
+  mutex_lock l(mu_);
+  if (!container_names_.erase(container)) {
+    // Nothing to cleanup, it's OK (concurrent cleanup).
+    return;
+  }
+  for (auto& shard : shards_) {
+    auto iter = shard->containers.find(container);
+    if (iter != shard->containers.end()) {
+      removed->push_back(iter->second);
+      shard->containers.erase(iter);
+    }
+  }
+}
+
 static bool IsValidContainerName(StringPiece s) {
   using ::tensorflow::strings::Scanner;
   return Scanner(s)
@@ -16,11 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_MGR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_MGR_H_
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
@@ -177,9 +182,9 @@ class ResourceMgr {
   Status Lookup(const std::string& container, const std::string& name,
                 T** resource) const TF_MUST_USE_RESULT;
 
-  // Similar to Lookup, but looks up multiple resources at once, with only a
-  // single lock acquisition.  If containers_and_names[i] is uninitialized
-  // then this function does not modify resources[i].
+  // Similar to Lookup, but looks up multiple resources at once, acquiring the
+  // lock of each shard at most once.  If containers_and_names[i] is
+  // uninitialized then this function does not modify resources[i].
   template <typename T, bool use_dynamic_cast = false>
   Status LookupMany(absl::Span<std::pair<const string*, const string*> const>
                         containers_and_names,
@@ -220,6 +225,18 @@ class ResourceMgr {
   // Returns a text description for all resources.
   std::string DebugString() const;
 
+  // Counts of the acquisitions of the locks protecting the resources.  An
+  // acquisition is contended if it had to wait for another thread.  Shared
+  // acquisitions are made by lookups, exclusive ones by creations and
+  // deletions.
+  struct LockStats {
+    int64 shared_acquisitions = 0;
+    int64 contended_shared_acquisitions = 0;
+    int64 exclusive_acquisitions = 0;
+    int64 contended_exclusive_acquisitions = 0;
+  };
+  LockStats lock_stats() const;
+
  private:
   typedef std::pair<uint64, StringPiece> Key;
   struct KeyHash {
@@ -248,22 +265,87 @@ class ResourceMgr {
   };
   typedef std::unordered_map<Key, ResourceAndName, KeyHash, KeyEqual> Container;
 
+  // Resources are partitioned by (container, name) across independently
+  // locked shards, so that lookups of different resources from concurrent
+  // steps do not all serialize on one lock.  A container holding resources
+  // in several shards has a separate `Container` in each of them.
+  static constexpr int kNumShards = 16;
+  struct Shard {
+    mutable mutex mu;
+    std::unordered_map<string, Container*> containers TF_GUARDED_BY(mu);
+
+    mutable std::atomic<int64> shared_acquisitions{0};
+    mutable std::atomic<int64> contended_shared_acquisitions{0};
+    mutable std::atomic<int64> exclusive_acquisitions{0};
+    mutable std::atomic<int64> contended_exclusive_acquisitions{0};
+  };
+
+  // Scoped locks on `Shard::mu` that maintain the shard's lock counters.
+  class TF_SCOPED_LOCKABLE ShardReaderLock {
+   public:
+    explicit ShardReaderLock(const Shard& shard)
+        TF_SHARED_LOCK_FUNCTION(shard.mu);
+    ~ShardReaderLock() TF_UNLOCK_FUNCTION();
+
+   private:
+    const Shard& shard_;
+    TF_DISALLOW_COPY_AND_ASSIGN(ShardReaderLock);
+  };
+  class TF_SCOPED_LOCKABLE ShardWriterLock {
+   public:
+    explicit ShardWriterLock(const Shard& shard)
+        TF_EXCLUSIVE_LOCK_FUNCTION(shard.mu);
+    ~ShardWriterLock() TF_UNLOCK_FUNCTION();
+
+   private:
+    const Shard& shard_;
+    TF_DISALLOW_COPY_AND_ASSIGN(ShardWriterLock);
+  };
+
+  static int ShardIndex(const std::string& container, const std::string& name);
+  Shard& GetShard(const std::string& container,
+                  const std::string& name) const {
+    return *shards_[ShardIndex(container, name)];
+  }
+
   const std::string default_container_;
+
+  // Each shard is allocated separately to keep the shard locks on separate
+  // cache lines.
+  std::unique_ptr<Shard> shards_[kNumShards];
+
+  // Guards the bookkeeping that is shared by all shards.  Never held while
+  // acquiring a shard lock.
   mutable mutex mu_;
-  std::unordered_map<string, Container*> containers_ TF_GUARDED_BY(mu_);
 
-  template <typename T, bool use_dynamic_cast = false>
-  Status LookupInternal(const std::string& container, const std::string& name,
-                        T** resource) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
+  // Names of the containers that exist in at least one shard.  Only used to
+  // tell a missing container from a missing resource in error messages.
+  std::unordered_set<string> container_names_ TF_GUARDED_BY(mu_);
 
-  Status DoCreate(const std::string& container, TypeIndex type,
+  template <typename T, bool use_dynamic_cast = false>
+  Status LookupInternal(const Shard& shard, const std::string& container,
+                        const std::string& name, T** resource) const
+      TF_SHARED_LOCKS_REQUIRED(shard.mu) TF_MUST_USE_RESULT;
+
+  // Removes `container` from every shard, and appends its per-shard maps to
+  // `*removed` for the caller to delete outside of the locks.  Does nothing
+  // if the container does not exist.
+  void RemoveContainer(const std::string& container,
+                       std::vector<Container*>* removed)
+      TF_LOCKS_EXCLUDED(mu_) TF_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Returns true if `container` holds resources in any shard.
+  bool ContainerExists(const std::string& container) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  Status DoCreate(Shard* shard, const std::string& container, TypeIndex type,
                   const std::string& name, ResourceBase* resource)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) TF_MUST_USE_RESULT;
 
-  Status DoLookup(const std::string& container, TypeIndex type,
-                  const std::string& name, ResourceBase** resource) const
-      TF_SHARED_LOCKS_REQUIRED(mu_) TF_MUST_USE_RESULT;
+  Status DoLookup(const Shard& shard, const std::string& container,
+                  TypeIndex type, const std::string& name,
+                  ResourceBase** resource) const
+      TF_SHARED_LOCKS_REQUIRED(shard.mu) TF_MUST_USE_RESULT;
 
   Status DoDelete(const std::string& container, uint64 type_hash_code,
                   const std::string& resource_name,
@@ -279,7 +361,7 @@ class ResourceMgr {
   // Returns "<unknown>" if a resource with such a type was never inserted into
   // the container.
   const char* DebugTypeName(uint64 hash_code) const
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+      TF_SHARED_LOCKS_REQUIRED(mu_);
 
   // Map from type hash_code to type name.
   std::unordered_map<uint64, string> debug_type_names_ TF_GUARDED_BY(mu_);
@@ -589,16 +671,18 @@ Status ResourceMgr::Create(const std::string& container,
                            const std::string& name, T* resource) {
   CheckDeriveFromResourceBase<T>();
   CHECK(resource != nullptr);
-  mutex_lock l(mu_);
-  return DoCreate(container, TypeIndex::Make<T>(), name, resource);
+  Shard& shard = GetShard(container, name);
+  ShardWriterLock l(shard);
+  return DoCreate(&shard, container, TypeIndex::Make<T>(), name, resource);
 }
 
 template <typename T, bool use_dynamic_cast>
 Status ResourceMgr::Lookup(const std::string& container,
                            const std::string& name, T** resource) const {
   CheckDeriveFromResourceBase<T>();
-  tf_shared_lock l(mu_);
-  return LookupInternal<T, use_dynamic_cast>(container, name, resource);
+  const Shard& shard = GetShard(container, name);
+  ShardReaderLock l(shard);
+  return LookupInternal<T, use_dynamic_cast>(shard, container, name, resource);
 }
 
 template <typename T, bool use_dynamic_cast>
@@ -607,16 +691,33 @@ Status ResourceMgr::LookupMany(
         containers_and_names,
     std::vector<std::unique_ptr<T, core::RefCountDeleter>>* resources) const {
   CheckDeriveFromResourceBase<T>();
-  tf_shared_lock l(mu_);
   resources->resize(containers_and_names.size());
+  // Visit the requests grouped by shard.
+  std::vector<std::pair<int, size_t>> order;
+  order.reserve(containers_and_names.size());
   for (size_t i = 0; i < containers_and_names.size(); ++i) {
-    T* resource;
-    Status s = LookupInternal<T, use_dynamic_cast>(
-        *containers_and_names[i].first, *containers_and_names[i].second,
-        &resource);
-    if (s.ok()) {
-      (*resources)[i].reset(resource);
+    order.emplace_back(ShardIndex(*containers_and_names[i].first,
+                                  *containers_and_names[i].second),
+                       i);
+  }
+  std::sort(order.begin(), order.end());
+  size_t begin = 0;
+  while (begin < order.size()) {
+    const Shard& shard = *shards_[order[begin].first];
+    ShardReaderLock l(shard);
+    size_t end = begin;
+    for (; end < order.size() && order[end].first == order[begin].first;
+         ++end) {
+      const size_t i = order[end].second;
+      T* resource;
+      Status s = LookupInternal<T, use_dynamic_cast>(
+          shard, *containers_and_names[i].first,
+          *containers_and_names[i].second, &resource);
+      if (s.ok()) {
+        (*resources)[i].reset(resource);
+      }
     }
+    begin = end;
   }
   return Status::OK();
 }
@@ -633,11 +734,12 @@ struct TypeCastFunctor<T, true> {
 };
 
 template <typename T, bool use_dynamic_cast>
-Status ResourceMgr::LookupInternal(const std::string& container,
+Status ResourceMgr::LookupInternal(const Shard& shard,
+                                   const std::string& container,
                                    const std::string& name,
                                    T** resource) const {
   ResourceBase* found = nullptr;
-  Status s = DoLookup(container, TypeIndex::Make<T>(), name, &found);
+  Status s = DoLookup(shard, container, TypeIndex::Make<T>(), name, &found);
   if (s.ok()) {
     // It's safe to down cast 'found' to T* since
     // typeid(T).hash_code() is part of the map key.
@@ -652,17 +754,18 @@ Status ResourceMgr::LookupOrCreate(const std::string& container,
                                    std::function<Status(T**)> creator) {
   CheckDeriveFromResourceBase<T>();
   *resource = nullptr;
+  Shard& shard = GetShard(container, name);
   Status s;
   {
-    tf_shared_lock l(mu_);
-    s = LookupInternal<T, use_dynamic_cast>(container, name, resource);
+    ShardReaderLock l(shard);
+    s = LookupInternal<T, use_dynamic_cast>(shard, container, name, resource);
     if (s.ok()) return s;
   }
-  mutex_lock l(mu_);
-  s = LookupInternal<T, use_dynamic_cast>(container, name, resource);
+  ShardWriterLock l(shard);
+  s = LookupInternal<T, use_dynamic_cast>(shard, container, name, resource);
   if (s.ok()) return s;
   TF_RETURN_IF_ERROR(creator(resource));
-  s = DoCreate(container, TypeIndex::Make<T>(), name, *resource);
+  s = DoCreate(&shard, container, TypeIndex::Make<T>(), name, *resource);
   if (!s.ok()) {
     return errors::Internal("LookupOrCreate failed unexpectedly");
   }
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -165,6 +167,99 @@ TEST(ResourceMgrTest, CreateOrLookupRaceCondition) {
   EXPECT_EQ(1, atomic_int);
 }
 
+TEST(ResourceMgrTest, ConcurrentCreateAndCleanup) {
+  const int kNumThreads = 4;
+  const int kNumResourcesPerThread = 200;
+  for (int round = 0; round < 10; ++round) {
+    ResourceMgr rm;
+    {
+      thread::ThreadPool threads(Env::Default(), "create_and_cleanup",
+                                 kNumThreads + 1);
+      for (int t = 0; t < kNumThreads; ++t) {
+        threads.Schedule([&rm, t] {
+          for (int i = 0; i < kNumResourcesPerThread; ++i) {
+            TF_CHECK_OK(rm.Create("foo", strings::StrCat("r", t, "_", i),
+                                  new Resource("label")));
+          }
+        });
+      }
+      threads.Schedule([&rm] {
+        for (int i = 0; i < kNumResourcesPerThread; ++i) {
+          TF_CHECK_OK(rm.Cleanup("foo"));
+        }
+      });
+    }
+
+    // A cleanup removes the container and all its resources at once, so the
+    // container exists iff one of its resources survived.
+    bool any_resource_found = false;
+    for (int t = 0; t < kNumThreads; ++t) {
+      for (int i = 0; i < kNumResourcesPerThread; ++i) {
+        Resource* r;
+        if (rm.Lookup("foo", strings::StrCat("r", t, "_", i), &r).ok()) {
+          any_resource_found = true;
+          r->Unref();
+        }
+      }
+    }
+    HasError(FindErr<Resource>(rm, "foo", "xxx"),
+             any_resource_found ? "Not found: Resource foo/xxx"
+                                : "Not found: Container foo");
+  }
+}
+
+TEST(ResourceMgrTest, ManyResources) {
+  ResourceMgr rm;
+  const int kNumResources = 100;
+  for (int i = 0; i < kNumResources; ++i) {
+    TF_CHECK_OK(rm.Create("foo", strings::StrCat("r", i),
+                          new Resource(strings::StrCat(i))));
+  }
+  for (int i = 0; i < kNumResources; ++i) {
+    EXPECT_EQ(strings::StrCat("R/", i),
+              Find<Resource>(rm, "foo", strings::StrCat("r", i)));
+  }
+  HasError(FindErr<Resource>(rm, "foo", "xxx"), "Not found: Resource foo/xxx");
+
+  std::vector<string> names;
+  for (int i = 0; i < kNumResources; ++i) {
+    names.push_back(strings::StrCat("r", i));
+  }
+  names.push_back("xxx");
+  const string container = "foo";
+  std::vector<std::pair<const string*, const string*>> containers_and_names;
+  for (const string& name : names) {
+    containers_and_names.emplace_back(&container, &name);
+  }
+  std::vector<std::unique_ptr<Resource, core::RefCountDeleter>> resources;
+  TF_CHECK_OK(rm.LookupMany<Resource>(containers_and_names, &resources));
+  ASSERT_EQ(resources.size(), kNumResources + 1);
+  for (int i = 0; i < kNumResources; ++i) {
+    ASSERT_NE(resources[i], nullptr);
+    EXPECT_EQ(strings::StrCat("R/", i), resources[i]->DebugString());
+  }
+  EXPECT_EQ(resources[kNumResources], nullptr);
+
+  TF_CHECK_OK(rm.Cleanup("foo"));
+  for (int i = 0; i < kNumResources; ++i) {
+    HasError(FindErr<Resource>(rm, "foo", strings::StrCat("r", i)),
+             "Not found: Container foo");
+  }
+}
+
+TEST(ResourceMgrTest, LockStats) {
+  ResourceMgr rm;
+  TF_CHECK_OK(rm.Create("foo", "bar", new Resource("cat")));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ("R/cat", Find<Resource>(rm, "foo", "bar"));
+  }
+  ResourceMgr::LockStats stats = rm.lock_stats();
+  EXPECT_EQ(stats.shared_acquisitions, 10);
+  EXPECT_EQ(stats.contended_shared_acquisitions, 0);
+  EXPECT_EQ(stats.exclusive_acquisitions, 1);
+  EXPECT_EQ(stats.contended_exclusive_acquisitions, 0);
+}
+
 Status ComputePolicy(const string& attr_container,
                      const string& attr_shared_name,
                      bool use_node_name_as_default, string* result) {
@@ -352,4 +447,41 @@ TEST(ResourceHandleTest, DeleteUsingResourceHandle) {
   EXPECT_NE(LookupResource<StubResource>(&ctx, p, &lookup_r).ok(), true);
 }
 
+// Looks up `num_resources` resources from `num_threads` threads concurrently.
+static void BM_ResourceMgrLookup(int iters, int num_threads,
+                                 int num_resources) {
+  testing::StopTiming();
+  ResourceMgr rm;
+  std::vector<string> names;
+  for (int i = 0; i < num_resources; ++i) {
+    names.push_back(strings::StrCat("resource", i));
+    TF_CHECK_OK(rm.Create("container", names.back(), new Resource("label")));
+  }
+  thread::ThreadPool threads(Env::Default(), "lookups", num_threads);
+  testing::UseRealTime();
+  testing::StartTiming();
+  const int iters_per_thread = iters / num_threads + 1;
+  BlockingCounter done(num_threads);
+  for (int t = 0; t < num_threads; ++t) {
+    threads.Schedule([&rm, &names, &done, iters_per_thread, t] {
+      for (int i = 0; i < iters_per_thread; ++i) {
+        Resource* r;
+        TF_CHECK_OK(rm.Lookup("container", names[(i + t) % names.size()], &r));
+        r->Unref();
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+}
+BENCHMARK(BM_ResourceMgrLookup)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 64)
+    ->ArgPair(4, 1)
+    ->ArgPair(4, 64)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 64);
+
 }  // end namespace tensorflow
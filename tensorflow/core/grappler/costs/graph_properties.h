@@ -69,6 +69,7 @@ ABSL_CONST_INIT const char kOutputTypes[] = "_output_dtype_vector";
 // Outputs TensorShapeProto vector.
 ABSL_CONST_INIT const char kOutputShapes[] = "_output_shape_vector";
 
+class IncrementalGraphProperties;
 class SymbolicShapeRefiner;
 class TopoQueue;
 
@@ -158,6 +159,8 @@ class GraphProperties {
   }
 
  private:
+  friend class IncrementalGraphProperties;
+
   // Relaxes shapes <shapes_and_types>, determined from an EnqueueV2 node, into
   // <*queue_shapes_and_types>.
   static Status RelaxEnqueueShapesAndMergeTypes(
@@ -0,0 +1,510 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Properties are kept for a few sets of inference options and graph contexts:
+// the meta optimizer alternates between passes that see the function library
+// and passes that only see its stub.
+constexpr int kMaxStates = 4;
+
+// Above this fraction of re-inferred nodes, inferring the properties from
+// scratch is cheaper and more precise.
+constexpr double kMaxReinferredFraction = 0.5;
+
+constexpr char kStandInPrefix[] = "_IncrementalGraphProperties/";
+
+Status Fingerprint(const protobuf::MessageLite& proto, uint64* fingerprint) {
+  string serialized;
+  if (!SerializeToStringDeterministic(proto, &serialized)) {
+    return errors::Internal("Failed to serialize graph properties key");
+  }
+  *fingerprint = Fingerprint64(serialized);
+  return Status::OK();
+}
+
+// Fingerprints the inference options and everything but the nodes of the
+// graph that affects the inferred properties.
+Status ContextFingerprint(const GrapplerItem& item, bool assume_valid_feeds,
+                          bool include_input_tensor_values,
+                          bool include_output_tensor_values, uint64* key) {
+  uint64 library;
+  TF_RETURN_IF_ERROR(Fingerprint(item.graph.library(), &library));
+  uint64 versions;
+  TF_RETURN_IF_ERROR(Fingerprint(item.graph.versions(), &versions));
+  *key = FingerprintCat64(library, versions);
+  *key = FingerprintCat64(*key, assume_valid_feeds);
+  *key = FingerprintCat64(*key, include_input_tensor_values);
+  *key = FingerprintCat64(*key, include_output_tensor_values);
+  if (!assume_valid_feeds) {
+    std::vector<string> feeds;
+    for (const auto& feed : item.feed) feeds.push_back(feed.first);
+    std::sort(feeds.begin(), feeds.end());
+    for (const string& feed : feeds) {
+      *key = FingerprintCat64(*key, Fingerprint64(feed));
+    }
+  }
+  return Status::OK();
+}
+
+int64 MinSymbolicDim(const TensorShapeProto& shape, int64 min_dim) {
+  for (const auto& dim : shape.dim()) min_dim = std::min(min_dim, dim.size());
+  return min_dim;
+}
+
+int64 MinSymbolicDim(
+    const absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>&
+        properties,
+    int64 min_dim) {
+  for (const auto& node_properties : properties) {
+    for (const OpInfo::TensorProperties& tensor : node_properties.second) {
+      min_dim = MinSymbolicDim(tensor.shape(), min_dim);
+    }
+  }
+  return min_dim;
+}
+
+// Returns true if the output `port` of an unmodified `node` must be re-inferred
+// rather than fed to the re-inferred nodes, because its properties do not
+// capture everything the shape inference knows about it.
+bool MustReinfer(const NodeDef& node, int port,
+                 const std::vector<OpInfo::TensorProperties>* outputs) {
+  // Re-inferring source nodes is cheap and exact.
+  if (!HasRegularInputs(node)) return true;
+  if (outputs == nullptr || port >= static_cast<int>(outputs->size())) {
+    return true;
+  }
+  const OpInfo::TensorProperties& output = (*outputs)[port];
+  // The shapes of the resources and variants are not in the properties.
+  if (output.dtype() == DT_RESOURCE || output.dtype() == DT_VARIANT) {
+    return true;
+  }
+  // Neither are the partially known shapes held in integer vectors.
+  if (!output.has_value() &&
+      (output.dtype() == DT_INT32 || output.dtype() == DT_INT64) &&
+      !output.shape().unknown_rank() && output.shape().dim_size() <= 1) {
+    return true;
+  }
+  return false;
+}
+
+// Returns a node reproducing `output`, the properties of an unmodified tensor.
+NodeDef MakeStandIn(const string& name,
+                    const OpInfo::TensorProperties& output) {
+  NodeDef stand_in;
+  stand_in.set_name(name);
+  (*stand_in.mutable_attr())["dtype"].set_type(output.dtype());
+  if (output.has_value() && output.value().dtype() == output.dtype()) {
+    stand_in.set_op("Const");
+    *(*stand_in.mutable_attr())["value"].mutable_tensor() = output.value();
+  } else {
+    stand_in.set_op("Placeholder");
+    TensorShapeProto* shape =
+        (*stand_in.mutable_attr())["shape"].mutable_shape();
+    *shape = output.shape();
+    // Symbolic dimensions only make sense within the properties they come
+    // from.
+    for (auto& dim : *shape->mutable_dim()) {
+      if (dim.size() < -1) dim.set_size(-1);
+    }
+  }
+  return stand_in;
+}
+
+// Records in `symbols` that the symbolic dimensions of `inferred` are the
+// dimensions of `original`. Returns false if a symbolic dimension would stand
+// for two different dimensions.
+bool MatchSymbolicDims(const TensorShapeProto& inferred,
+                       const TensorShapeProto& original,
+                       absl::flat_hash_map<int64, int64>* symbols) {
+  if (inferred.unknown_rank() || original.unknown_rank() ||
+      inferred.dim_size() != original.dim_size()) {
+    return true;
+  }
+  for (int i = 0; i < inferred.dim_size(); ++i) {
+    const int64 inferred_dim = inferred.dim(i).size();
+    const int64 original_dim = original.dim(i).size();
+    if (inferred_dim >= -1 || original_dim >= -1) continue;
+    const auto inserted = symbols->emplace(inferred_dim, original_dim);
+    if (!inserted.second && inserted.first->second != original_dim) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Renames the symbolic dimensions of `properties` according to `symbols`.
+// Symbolic dimensions without a name get new ones, below `*min_symbolic_dim`.
+void RenameSymbolicDims(std::vector<OpInfo::TensorProperties>* properties,
+                        absl::flat_hash_map<int64, int64>* symbols,
+                        int64* min_symbolic_dim) {
+  for (OpInfo::TensorProperties& tensor : *properties) {
+    for (auto& dim : *tensor.mutable_shape()->mutable_dim()) {
+      if (dim.size() >= -1) continue;
+      auto it = symbols->find(dim.size());
+      if (it == symbols->end()) {
+        it = symbols->emplace(dim.size(), --*min_symbolic_dim).first;
+      }
+      dim.set_size(it->second);
+    }
+  }
+}
+
+}  // namespace
+
+Status IncrementalGraphProperties::InferStatically(
+    bool assume_valid_feeds, bool include_input_tensor_values,
+    bool include_output_tensor_values, GraphProperties* properties) {
+  if (properties->has_properties()) {
+    return errors::FailedPrecondition("Graph properties were already inferred");
+  }
+  const GrapplerItem& item = properties->item_;
+
+  uint64 key;
+  TF_RETURN_IF_ERROR(ContextFingerprint(item, assume_valid_feeds,
+                                        include_input_tensor_values,
+                                        include_output_tensor_values, &key));
+  std::vector<uint64> node_fingerprints(item.graph.node_size());
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    TF_RETURN_IF_ERROR(Fingerprint(item.graph.node(i), &node_fingerprints[i]));
+  }
+
+  auto it = std::find_if(
+      states_.begin(), states_.end(),
+      [key](const std::unique_ptr<State>& state) { return state->key == key; });
+  State* state;
+  bool updated = false;
+  if (it != states_.end()) {
+    state = it->get();
+    TF_RETURN_IF_ERROR(InferIncrementally(
+        item, assume_valid_feeds, include_input_tensor_values,
+        include_output_tensor_values, node_fingerprints, state, &updated));
+  } else {
+    if (states_.size() >= kMaxStates) {
+      // Evict the least recently used properties.
+      states_.erase(std::min_element(
+          states_.begin(), states_.end(),
+          [](const std::unique_ptr<State>& a, const std::unique_ptr<State>& b) {
+            return a->last_use < b->last_use;
+          }));
+    }
+    states_.push_back(absl::make_unique<State>());
+    state = states_.back().get();
+    state->key = key;
+  }
+  if (!updated) {
+    Status s = InferFromScratch(item, assume_valid_feeds,
+                                include_input_tensor_values,
+                                include_output_tensor_values,
+                                node_fingerprints, state);
+    if (!s.ok()) {
+      // Don't keep properties that don't match any graph.
+      states_.erase(std::find_if(states_.begin(), states_.end(),
+                                 [state](const std::unique_ptr<State>& other) {
+                                   return other.get() == state;
+                                 }));
+      return s;
+    }
+  }
+  state->last_use = ++num_uses_;
+
+  properties->input_properties_ = state->input_properties;
+  properties->output_properties_ = state->output_properties;
+  return Status::OK();
+}
+
+Status IncrementalGraphProperties::InferFromScratch(
+    const GrapplerItem& item, bool assume_valid_feeds,
+    bool include_input_tensor_values, bool include_output_tensor_values,
+    const std::vector<uint64>& node_fingerprints, State* state) {
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      assume_valid_feeds, /*aggressive_shape_inference=*/false,
+      include_input_tensor_values, include_output_tensor_values));
+  ++stats_.full_inferences;
+
+  state->node_fingerprints.clear();
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    state->node_fingerprints[item.graph.node(i).name()] = node_fingerprints[i];
+  }
+  state->input_properties = std::move(properties.input_properties_);
+  state->output_properties = std::move(properties.output_properties_);
+  state->min_symbolic_dim = MinSymbolicDim(
+      state->output_properties, MinSymbolicDim(state->input_properties, -1));
+  return Status::OK();
+}
+
+Status IncrementalGraphProperties::InferIncrementally(
+    const GrapplerItem& item, bool assume_valid_feeds,
+    bool include_input_tensor_values, bool include_output_tensor_values,
+    const std::vector<uint64>& node_fingerprints, State* state,
+    bool* updated) {
+  *updated = false;
+  const GraphDef& graph = item.graph;
+
+  absl::flat_hash_map<string, int> node_index;
+  node_index.reserve(graph.node_size());
+  std::deque<int> queue;
+  std::vector<bool> modified(graph.node_size(), false);
+  for (int i = 0; i < graph.node_size(); ++i) {
+    const NodeDef& node = graph.node(i);
+    // Queues propagate shapes from their enqueue to their dequeue nodes.
+    if (IsQueue(node) || IsEnqueue(node) || IsDequeue(node)) {
+      return Status::OK();
+    }
+    node_index[node.name()] = i;
+    const auto fingerprint = state->node_fingerprints.find(node.name());
+    if (fingerprint == state->node_fingerprints.end() ||
+        fingerprint->second != node_fingerprints[i]) {
+      modified[i] = true;
+      queue.push_back(i);
+    }
+  }
+
+  if (queue.empty()) {
+    // Nothing changed, but some nodes might have been removed.
+    if (state->node_fingerprints.size() != node_index.size()) {
+      for (auto it = state->node_fingerprints.begin();
+           it != state->node_fingerprints.end();) {
+        if (node_index.contains(it->first)) {
+          ++it;
+          continue;
+        }
+        state->input_properties.erase(it->first);
+        state->output_properties.erase(it->first);
+        state->node_fingerprints.erase(it++);
+      }
+    }
+    ++stats_.reuses;
+    *updated = true;
+    return Status::OK();
+  }
+
+  // The modified nodes and their transitive fanout need to be re-inferred.
+  std::vector<std::vector<int>> fanouts(graph.node_size());
+  for (int i = 0; i < graph.node_size(); ++i) {
+    for (const string& input : graph.node(i).input()) {
+      if (IsControlInput(input)) break;
+      const auto fanin = node_index.find(ParseTensorName(input).node());
+      if (fanin != node_index.end()) fanouts[fanin->second].push_back(i);
+    }
+  }
+  std::vector<bool> affected = modified;
+  int num_affected = queue.size();
+  while (!queue.empty()) {
+    const int i = queue.front();
+    queue.pop_front();
+    for (int fanout : fanouts[i]) {
+      if (affected[fanout]) continue;
+      affected[fanout] = true;
+      ++num_affected;
+      queue.push_back(fanout);
+    }
+  }
+
+  // Some of their unmodified inputs have to be re-inferred as well, the other
+  // inputs are fed through stand-ins.
+  std::vector<bool> reinferred = affected;
+  int num_reinferred = num_affected;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    if (affected[i]) queue.push_back(i);
+  }
+  while (!queue.empty()) {
+    const NodeDef& node = graph.node(queue.front());
+    queue.pop_front();
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) break;
+      const TensorId tensor = ParseTensorName(input);
+      const auto fanin = node_index.find(tensor.node());
+      if (fanin == node_index.end()) {
+        // The graph is invalid, let the shape inference report it.
+        return Status::OK();
+      }
+      if (reinferred[fanin->second]) continue;
+      const auto outputs = state->output_properties.find(tensor.node());
+      if (MustReinfer(graph.node(fanin->second), tensor.index(),
+                      outputs == state->output_properties.end()
+                          ? nullptr
+                          : &outputs->second)) {
+        reinferred[fanin->second] = true;
+        ++num_reinferred;
+        queue.push_back(fanin->second);
+      }
+    }
+  }
+  if (num_reinferred > kMaxReinferredFraction * graph.node_size()) {
+    return Status::OK();
+  }
+
+  // Build the graph of the re-inferred nodes.
+  GrapplerItem reinferred_item;
+  reinferred_item.id = item.id;
+  *reinferred_item.graph.mutable_versions() = graph.versions();
+  *reinferred_item.graph.mutable_library() = graph.library();
+  absl::flat_hash_map<string, string> stand_ins;
+  for (int i = 0; i < graph.node_size(); ++i) {
+    if (!reinferred[i]) continue;
+    NodeDef* node = reinferred_item.graph.add_node();
+    *node = graph.node(i);
+    node->clear_input();
+    for (const string& input : graph.node(i).input()) {
+      const TensorId tensor = ParseTensorName(input);
+      const auto fanin = node_index.find(tensor.node());
+      if (fanin != node_index.end() && reinferred[fanin->second]) {
+        node->add_input(input);
+      } else if (!IsControlInput(input)) {
+        auto inserted = stand_ins.emplace(
+            input, absl::StrCat(kStandInPrefix, tensor.node(), "/",
+                                tensor.index()));
+        if (node_index.contains(inserted.first->second)) return Status::OK();
+        node->add_input(inserted.first->second);
+      }
+    }
+  }
+  for (const auto& stand_in : stand_ins) {
+    const TensorId tensor = ParseTensorName(stand_in.first);
+    *reinferred_item.graph.add_node() = MakeStandIn(
+        stand_in.second,
+        state->output_properties.at(tensor.node()).at(tensor.index()));
+  }
+  for (const auto& feed : item.feed) {
+    const auto fed_node = node_index.find(NodeName(feed.first));
+    if (fed_node != node_index.end() && reinferred[fed_node->second]) {
+      reinferred_item.feed.push_back(feed);
+    }
+  }
+
+  GraphProperties properties(reinferred_item);
+  Status s = properties.InferStatically(
+      assume_valid_feeds, /*aggressive_shape_inference=*/false,
+      include_input_tensor_values, include_output_tensor_values);
+  if (!s.ok()) {
+    VLOG(1) << "Failed to re-infer " << num_reinferred << " nodes: " << s;
+    return Status::OK();
+  }
+
+  // Match the symbolic dimensions of the unmodified tensors with the ones they
+  // had before.
+  absl::flat_hash_map<int64, int64> symbols;
+  for (const auto& stand_in : stand_ins) {
+    const TensorId tensor = ParseTensorName(stand_in.first);
+    const std::vector<OpInfo::TensorProperties>& outputs =
+        properties.GetOutputProperties(stand_in.second);
+    if (outputs.empty()) continue;
+    if (!MatchSymbolicDims(
+            outputs[0].shape(),
+            state->output_properties.at(tensor.node())[tensor.index()].shape(),
+            &symbols)) {
+      return Status::OK();
+    }
+  }
+  for (int i = 0; i < graph.node_size(); ++i) {
+    if (!reinferred[i] || affected[i]) continue;
+    const string& name = graph.node(i).name();
+    const auto original = state->output_properties.find(name);
+    if (original == state->output_properties.end()) continue;
+    const std::vector<OpInfo::TensorProperties>& outputs =
+        properties.GetOutputProperties(name);
+    const int num_outputs =
+        std::min(outputs.size(), original->second.size());
+    for (int port = 0; port < num_outputs; ++port) {
+      if (!MatchSymbolicDims(outputs[port].shape(),
+                             original->second[port].shape(), &symbols)) {
+        return Status::OK();
+      }
+    }
+  }
+
+  // Replace the properties of the affected nodes. The unmodified nodes that
+  // were re-inferred keep their original properties, which may be more
+  // precise.
+  for (int i = 0; i < graph.node_size(); ++i) {
+    if (!affected[i]) continue;
+    const string& name = graph.node(i).name();
+    auto inputs = properties.input_properties_.find(name);
+    if (inputs == properties.input_properties_.end()) {
+      state->input_properties.erase(name);
+    } else {
+      RenameSymbolicDims(&inputs->second, &symbols, &state->min_symbolic_dim);
+      state->input_properties[name] = std::move(inputs->second);
+    }
+    auto outputs = properties.output_properties_.find(name);
+    if (outputs == properties.output_properties_.end()) {
+      state->output_properties.erase(name);
+    } else {
+      RenameSymbolicDims(&outputs->second, &symbols, &state->min_symbolic_dim);
+      state->output_properties[name] = std::move(outputs->second);
+    }
+  }
+
+  // Forget the removed nodes.
+  absl::flat_hash_map<string, uint64> fingerprints;
+  fingerprints.reserve(graph.node_size());
+  for (int i = 0; i < graph.node_size(); ++i) {
+    fingerprints[graph.node(i).name()] = node_fingerprints[i];
+  }
+  for (const auto& node : state->node_fingerprints) {
+    if (fingerprints.contains(node.first)) continue;
+    state->input_properties.erase(node.first);
+    state->output_properties.erase(node.first);
+  }
+  state->node_fingerprints = std::move(fingerprints);
+
+  ++stats_.incremental_inferences;
+  stats_.reinferred_nodes += num_reinferred;
+  VLOG(2) << "Re-inferred the properties of " << num_reinferred << " of "
+          << graph.node_size() << " nodes";
+  *updated = true;
+  return Status::OK();
+}
+
+Status InferStatically(IncrementalGraphProperties* incremental_properties,
+                       bool assume_valid_feeds,
+                       bool include_input_tensor_values,
+                       bool include_output_tensor_values,
+                       GraphProperties* properties) {
+  if (incremental_properties != nullptr) {
+    return incremental_properties->InferStatically(
+        assume_valid_feeds, include_input_tensor_values,
+        include_output_tensor_values, properties);
+  }
+  return properties->InferStatically(
+      assume_valid_feeds, /*aggressive_shape_inference=*/false,
+      include_input_tensor_values, include_output_tensor_values);
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,130 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_INCREMENTAL_GRAPH_PROPERTIES_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_INCREMENTAL_GRAPH_PROPERTIES_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Statically inferred properties of the successive versions of a graph, as it
+// is rewritten by a sequence of optimization passes.
+//
+// Each call to InferStatically compares the nodes of the graph with the nodes
+// of the graph the properties were last inferred for, and only re-infers the
+// nodes that were added or modified and their transitive fanout. The other
+// nodes keep their properties, and their outputs are fed to the re-inferred
+// nodes through placeholders (or constants, when their value is known). When
+// too much of the graph changed, or the graph contains queues whose shapes
+// propagate outside of the graph edges, all the properties are inferred from
+// scratch.
+//
+// The incremental properties are never more precise than the ones inferred
+// from scratch, but may be less precise: the symbolic relations between the
+// dimensions of the re-inferred nodes and the rest of the graph are only
+// preserved through the inputs of the re-inferred nodes.
+//
+// Aggressive shape inference is not supported.
+//
+// This class is not thread-safe.
+class IncrementalGraphProperties {
+ public:
+  struct Stats {
+    // Properties inferred from scratch.
+    int64 full_inferences = 0;
+    // Properties updated by re-inferring part of the graph.
+    int64 incremental_inferences = 0;
+    // Properties reused without any re-inference.
+    int64 reuses = 0;
+    // Nodes re-inferred by the incremental inferences.
+    int64 reinferred_nodes = 0;
+  };
+
+  IncrementalGraphProperties() = default;
+
+  // Fills `properties`, which must not have been inferred yet, like
+  // properties->InferStatically(assume_valid_feeds,
+  // /*aggressive_shape_inference=*/false, include_input_tensor_values,
+  // include_output_tensor_values) does.
+  Status InferStatically(bool assume_valid_feeds,
+                         bool include_input_tensor_values,
+                         bool include_output_tensor_values,
+                         GraphProperties* properties);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  using PropertiesMap =
+      absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>;
+
+  // The properties inferred for one set of inference options and graph
+  // context (function library, feeds and versions).
+  struct State {
+    uint64 key = 0;
+    int64 last_use = 0;
+    absl::flat_hash_map<string, uint64> node_fingerprints;
+    PropertiesMap input_properties;
+    PropertiesMap output_properties;
+    // The smallest symbolic dimension in the properties.
+    int64 min_symbolic_dim = -1;
+  };
+
+  // Infers the properties of `item` from scratch into `state`.
+  Status InferFromScratch(const GrapplerItem& item, bool assume_valid_feeds,
+                          bool include_input_tensor_values,
+                          bool include_output_tensor_values,
+                          const std::vector<uint64>& node_fingerprints,
+                          State* state);
+
+  // Re-infers the properties of the nodes of `item` that changed since
+  // `state` was inferred. Sets `*updated` to false, leaving `state` untouched,
+  // if the properties must be inferred from scratch instead.
+  Status InferIncrementally(const GrapplerItem& item, bool assume_valid_feeds,
+                            bool include_input_tensor_values,
+                            bool include_output_tensor_values,
+                            const std::vector<uint64>& node_fingerprints,
+                            State* state, bool* updated);
+
+  std::vector<std::unique_ptr<State>> states_;
+  int64 num_uses_ = 0;
+  Stats stats_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(IncrementalGraphProperties);
+};
+
+// Runs properties->InferStatically(assume_valid_feeds,
+// /*aggressive_shape_inference=*/false, include_input_tensor_values,
+// include_output_tensor_values), through `incremental_properties` if it is not
+// null.
+Status InferStatically(IncrementalGraphProperties* incremental_properties,
+                       bool assume_valid_feeds,
+                       bool include_input_tensor_values,
+                       bool include_output_tensor_values,
+                       GraphProperties* properties);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_INCREMENTAL_GRAPH_PROPERTIES_H_
@@ -0,0 +1,172 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr int kNumRelus = 10;
+
+// x -> relu_0 -> ... -> relu_9, where x has the given shape.
+GrapplerItem MakeReluChain(const PartialTensorShape& shape) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape(shape));
+  Output y = x;
+  for (int i = 0; i < kNumRelus; ++i) {
+    y = ops::Relu(s.WithOpName(strings::StrCat("relu_", i)), y);
+  }
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch.push_back(strings::StrCat("relu_", kNumRelus - 1));
+  return item;
+}
+
+int NodeIndex(const GrapplerItem& item, const string& name) {
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    if (item.graph.node(i).name() == name) return i;
+  }
+  return -1;
+}
+
+// Checks that the incremental properties of `item` match the ones inferred
+// from scratch. Only meaningful for graphs without symbolic dimensions, whose
+// ids are arbitrary.
+void ExpectSameProperties(const GrapplerItem& item,
+                          const GraphProperties& incremental) {
+  GraphProperties full(item);
+  TF_ASSERT_OK(full.InferStatically(/*assume_valid_feeds=*/false,
+                                    /*aggressive_shape_inference=*/false,
+                                    /*include_input_tensor_values=*/false,
+                                    /*include_output_tensor_values=*/true));
+  for (const NodeDef& node : item.graph.node()) {
+    const auto& expected = full.GetOutputProperties(node.name());
+    const auto& actual = incremental.GetOutputProperties(node.name());
+    ASSERT_EQ(expected.size(), actual.size()) << node.name();
+    for (int i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].DebugString(), actual[i].DebugString())
+          << node.name() << ":" << i;
+    }
+  }
+}
+
+Status InferIncrementally(IncrementalGraphProperties* incremental_properties,
+                          GraphProperties* properties) {
+  return incremental_properties->InferStatically(
+      /*assume_valid_feeds=*/false, /*include_input_tensor_values=*/false,
+      /*include_output_tensor_values=*/true, properties);
+}
+
+TEST(IncrementalGraphPropertiesTest, ReusesUnchangedGraph) {
+  GrapplerItem item = MakeReluChain(PartialTensorShape({2, 10}));
+  IncrementalGraphProperties incremental_properties;
+
+  GraphProperties first(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &first));
+  GraphProperties second(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &second));
+  ExpectSameProperties(item, second);
+
+  // Properties can only be inferred once.
+  EXPECT_FALSE(InferIncrementally(&incremental_properties, &second).ok());
+
+  const IncrementalGraphProperties::Stats& stats =
+      incremental_properties.stats();
+  EXPECT_EQ(stats.full_inferences, 1);
+  EXPECT_EQ(stats.incremental_inferences, 0);
+  EXPECT_EQ(stats.reuses, 1);
+}
+
+TEST(IncrementalGraphPropertiesTest, ReinfersModifiedNodes) {
+  GrapplerItem item = MakeReluChain(PartialTensorShape({2, 10}));
+  IncrementalGraphProperties incremental_properties;
+  GraphProperties first(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &first));
+
+  // Reshape the output of the last relu.
+  const string last = strings::StrCat("relu_", kNumRelus - 1);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output shape = ops::Const(s.WithOpName("shape"), {5, 4}, {2});
+  GraphDef shape_graph;
+  TF_ASSERT_OK(s.ToGraphDef(&shape_graph));
+  *item.graph.add_node() = shape_graph.node(0);
+  NodeDef* reshape = item.graph.mutable_node(NodeIndex(item, last));
+  reshape->set_op("Reshape");
+  reshape->add_input("shape");
+  (*reshape->mutable_attr())["Tshape"].set_type(DT_INT32);
+
+  GraphProperties second(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &second));
+  ExpectSameProperties(item, second);
+  EXPECT_EQ(second.GetOutputProperties(last)[0].shape().DebugString(),
+            PartialTensorShape({5, 4}).AsProto().DebugString());
+
+  const IncrementalGraphProperties::Stats& stats =
+      incremental_properties.stats();
+  EXPECT_EQ(stats.full_inferences, 1);
+  EXPECT_EQ(stats.incremental_inferences, 1);
+  EXPECT_LT(stats.reinferred_nodes, kNumRelus / 2);
+}
+
+TEST(IncrementalGraphPropertiesTest, PreservesSymbolicDimsOfInputs) {
+  GrapplerItem item = MakeReluChain(PartialTensorShape({-1, 10}));
+  IncrementalGraphProperties incremental_properties;
+  GraphProperties first(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &first));
+  const int64 batch_dim =
+      first.GetOutputProperties("x")[0].shape().dim(0).size();
+  EXPECT_LT(batch_dim, -1);
+
+  const string last = strings::StrCat("relu_", kNumRelus - 1);
+  item.graph.mutable_node(NodeIndex(item, last))->set_op("Tanh");
+  GraphProperties second(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &second));
+  EXPECT_EQ(incremental_properties.stats().incremental_inferences, 1);
+
+  // The re-inferred node still shares the batch dimension of the graph input.
+  const TensorShapeProto& shape = second.GetOutputProperties(last)[0].shape();
+  ASSERT_EQ(shape.dim_size(), 2);
+  EXPECT_EQ(shape.dim(0).size(), batch_dim);
+  EXPECT_EQ(shape.dim(1).size(), 10);
+  EXPECT_EQ(second.GetOutputProperties("x")[0].shape().dim(0).size(),
+            batch_dim);
+}
+
+TEST(IncrementalGraphPropertiesTest, InfersFromScratchWhenMostNodesChange) {
+  GrapplerItem item = MakeReluChain(PartialTensorShape({2, 10}));
+  IncrementalGraphProperties incremental_properties;
+  GraphProperties first(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &first));
+
+  item.graph.mutable_node(NodeIndex(item, "relu_0"))->set_op("Tanh");
+  GraphProperties second(item);
+  TF_ASSERT_OK(InferIncrementally(&incremental_properties, &second));
+  ExpectSameProperties(item, second);
+  EXPECT_EQ(incremental_properties.stats().full_inferences, 2);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -3811,9 +3812,10 @@ Status ArithmeticOptimizer::Optimize(Cluster* /*cluster*/,
   graph_properties_.reset(new GraphProperties(optimized_item));
   const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
   const Status status =
-      graph_properties_->InferStatically(assume_valid_feeds,
-                                         /*aggressive_shape_inference=*/false,
-                                         /*include_tensor_values=*/false);
+      InferStatically(incremental_graph_properties(), assume_valid_feeds,
+                      /*include_input_tensor_values=*/false,
+                      /*include_output_tensor_values=*/false,
+                      graph_properties_.get());
   const bool can_use_shapes = status.ok();
   if (!can_use_shapes) {
     VLOG(1) << "Shape inference failed." << status.error_message();
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
@@ -3935,10 +3936,10 @@ Status ConstantFolding::RunOptimizationPass(Cluster* cluster,
   // that the shape inference deals with this conservatively unless we're in
   // aggressive mode.
   const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
-  Status s = properties.InferStatically(assume_valid_feeds,
-                                        /*aggressive_shape_inference=*/false,
-                                        /*include_input_tensor_values=*/false,
-                                        /*include_output_tensor_values=*/true);
+  Status s = InferStatically(incremental_graph_properties(), assume_valid_feeds,
+                             /*include_input_tensor_values=*/false,
+                             /*include_output_tensor_values=*/true,
+                             &properties);
 
   const bool can_use_shape_info = s.ok();
   VLOG(1) << "can_use_shape_info = " << can_use_shape_info;
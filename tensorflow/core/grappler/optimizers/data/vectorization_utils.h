@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_VECTORIZATION_UTILS_H_
 
 #include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -90,6 +91,15 @@ Status VectorizeMapDefun(const FunctionDef& outer_scope,
                          const NodeDef& map_defun_node, FunctionDefLibrary* lib,
                          FunctionDef** result);
 
+// Adds to `library` a function with the signature of `orig_func`, the function
+// of the map node `map_node`, which applies `orig_func` to each slice of its
+// (batched) inputs with a MapDefun op. `map_node` must have the "f",
+// "Targuments", "output_types" and "output_shapes" attrs of a map dataset.
+// The result is meant to be passed to `VectorizeMapDefun`.
+FunctionDef* CreateMapDefunWrapper(const NodeDef& map_node,
+                                   const FunctionDef& orig_func,
+                                   FunctionDefLibrary* library);
+
 }  // namespace vectorization_utils
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,294 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include <set>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+
+// Upper bound on the number of ops fused into a single node. Every fused op
+// may need a scratch buffer in the kernel, that should stay in cache.
+constexpr int kMaxFusedOps = 64;
+
+// Returns the number of inputs of `op` if the _FusedElementwise kernel
+// supports it, and 0 otherwise.
+int FusableOpArity(const string& op) {
+  // Keep in sync with the ops registered in kernels/fused_elementwise_op.cc.
+  static const auto* const kUnaryOps = new absl::flat_hash_set<string>{
+      "Abs",   "Exp",   "Inv",     "Log",  "Neg",    "Reciprocal", "Relu",
+      "Relu6", "Rsqrt", "Sigmoid", "Sqrt", "Square", "Tanh"};
+  static const auto* const kBinaryOps = new absl::flat_hash_set<string>{
+      "Add", "AddV2",   "Maximum",           "Minimum",
+      "Mul", "RealDiv", "SquaredDifference", "Sub"};
+  if (kUnaryOps->contains(op)) return 1;
+  if (kBinaryOps->contains(op)) return 2;
+  return 0;
+}
+
+// Returns true if `shape`, without its leading dimensions of size 1, is
+// symbolically equal to a suffix of `output_shape`, i.e. if the tensor repeats
+// along the outer dimensions of the output.
+bool IsOuterBroadcast(const TensorShapeProto& shape,
+                      const TensorShapeProto& output_shape) {
+  if (shape.unknown_rank() || output_shape.unknown_rank()) return false;
+  int first = 0;
+  while (first < shape.dim_size() && shape.dim(first).size() == 1) ++first;
+  const int offset = output_shape.dim_size() - shape.dim_size();
+  if (offset + first < 0) return false;
+  for (int i = first; i < shape.dim_size(); ++i) {
+    const TensorShapeProto::Dim& dim = shape.dim(i);
+    if (IsUnknown(dim) || dim.size() != output_shape.dim(offset + i).size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if `node` can be evaluated by a _FusedElementwise kernel.
+bool IsFusionCandidate(const NodeDef& node, const GraphProperties& properties) {
+  const int arity = FusableOpArity(node.op());
+  if (arity == 0 || node.input_size() != arity) return false;
+  if (HasControlInputs(node) || !NodeIsOnCpu(&node)) return false;
+
+  const DataType dtype = GetDataTypeFromAttr(node, "T");
+  if (dtype != DT_FLOAT && dtype != DT_DOUBLE) return false;
+
+  if (!properties.HasInputProperties(node.name()) ||
+      !properties.HasOutputProperties(node.name())) {
+    return false;
+  }
+  const auto& outputs = properties.GetOutputProperties(node.name());
+  return outputs.size() == 1 && !outputs[0].shape().unknown_rank() &&
+         properties.GetInputProperties(node.name()).size() ==
+             static_cast<size_t>(arity);
+}
+
+// Returns true if the inputs and the output of `node` repeat along the outer
+// dimensions of `output_shape`.
+bool IsCompatibleWithOutput(const NodeDef& node,
+                            const GraphProperties& properties,
+                            const TensorShapeProto& output_shape) {
+  for (const auto& input : properties.GetInputProperties(node.name())) {
+    if (!IsOuterBroadcast(input.shape(), output_shape)) return false;
+  }
+  return IsOuterBroadcast(
+      properties.GetOutputProperties(node.name())[0].shape(), output_shape);
+}
+
+// A connected subgraph of elementwise ops whose only output is the output of
+// the root node.
+struct FusionGroup {
+  NodeDef* root = nullptr;
+  TensorShapeProto output_shape;
+  absl::flat_hash_map<string, const NodeDef*> members;
+};
+
+// The attributes of a _FusedElementwise node under construction.
+struct FusedProgram {
+  std::vector<string> inputs;
+  std::vector<string> fused_ops;
+  // Operands that are fused ops are encoded with their index, and operands
+  // that are inputs with -1 - their index.
+  std::vector<int> operands;
+
+  absl::flat_hash_map<string, int> input_index;
+  absl::flat_hash_map<string, int> op_index;
+};
+
+// Appends the ops computing `node` to `program`, after the ops computing its
+// operands, and returns the encoded value of `node`.
+int EmitFusedOps(const NodeDef& node, const FusionGroup& group,
+                 FusedProgram* program) {
+  const auto computed = program->op_index.find(node.name());
+  if (computed != program->op_index.end()) return computed->second;
+
+  std::vector<int> operands;
+  for (const string& input : node.input()) {
+    const TensorId tensor = ParseTensorName(input);
+    const auto member = group.members.find(string(tensor.node()));
+    if (member != group.members.end()) {
+      operands.push_back(EmitFusedOps(*member->second, group, program));
+      continue;
+    }
+    const auto inserted = program->input_index.emplace(
+        tensor.ToString(), program->inputs.size());
+    if (inserted.second) program->inputs.push_back(input);
+    operands.push_back(-1 - inserted.first->second);
+  }
+
+  const int index = program->fused_ops.size();
+  program->fused_ops.push_back(node.op());
+  program->operands.insert(program->operands.end(), operands.begin(),
+                           operands.end());
+  program->op_index.emplace(node.name(), index);
+  return index;
+}
+
+// Replaces the root of `group` with a _FusedElementwise node computing the
+// whole group. The other members of the group are left in the graph.
+void FuseGroup(const FusionGroup& group) {
+  FusedProgram program;
+  EmitFusedOps(*group.root, group, &program);
+
+  const int num_inputs = program.inputs.size();
+  NodeDef* fused = group.root;
+  const DataType dtype = GetDataTypeFromAttr(*fused, "T");
+  VLOG(2) << "Fuse " << program.fused_ops.size() << " elementwise ops into "
+          << fused->name();
+
+  fused->set_op(kFusedElementwise);
+  fused->clear_input();
+  for (const string& input : program.inputs) fused->add_input(input);
+
+  fused->clear_attr();
+  auto* attr = fused->mutable_attr();
+  (*attr)["T"].set_type(dtype);
+  (*attr)["N"].set_i(num_inputs);
+  auto* fused_ops = (*attr)["fused_ops"].mutable_list();
+  for (const string& op : program.fused_ops) fused_ops->add_s(op);
+  auto* operands = (*attr)["operands"].mutable_list();
+  for (int operand : program.operands) {
+    operands->add_i(operand < 0 ? -1 - operand : num_inputs + operand);
+  }
+}
+
+}  // namespace
+
+Status ElementwiseFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                   GraphDef* optimized_graph) {
+  // _FusedElementwise does not have a registered gradient function, so we
+  // must not perform the rewrite if the graph will be differentiated later.
+  if (!item.optimization_options().allow_non_differentiable_rewrites) {
+    return errors::Aborted("Non-differentiable rewrites are not allowed.");
+  }
+
+  int num_fusable_ops = 0;
+  for (const NodeDef& node : item.graph.node()) {
+    if (FusableOpArity(node.op()) > 0 && NodeIsOnCpu(&node)) ++num_fusable_ops;
+  }
+  if (num_fusable_ops < 2) return errors::Aborted("Nothing to do.");
+
+  GraphProperties properties(item);
+  const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
+  TF_RETURN_IF_ERROR(InferStatically(incremental_graph_properties(),
+                                     assume_valid_feeds,
+                                     /*include_input_tensor_values=*/false,
+                                     /*include_output_tensor_values=*/false,
+                                     &properties));
+
+  *optimized_graph = item.graph;
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(*optimized_graph, &topo_order));
+  NodeMap node_map(optimized_graph);
+  const std::set<string> nodes_to_preserve = item.NodesToPreserve();
+
+  // Visit the nodes in reverse topological order, so that all the consumers
+  // of a node are grouped before the node itself. A node joins the group of
+  // its consumers if they all belong to the same group, in which case its
+  // output is only used inside of the group, and otherwise becomes the root
+  // of a new group. Since the intermediate results of a group never leave it,
+  // fusing a group can't create cycles.
+  std::vector<FusionGroup> groups;
+  absl::flat_hash_map<const NodeDef*, int> group_of;
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    const NodeDef& node = **it;
+    if (!IsFusionCandidate(node, properties)) continue;
+
+    int group = -1;
+    if (nodes_to_preserve.find(node.name()) == nodes_to_preserve.end()) {
+      for (const NodeDef* fanout : node_map.GetOutputs(node.name())) {
+        const auto fanout_group = group_of.find(fanout);
+        if (fanout_group == group_of.end() ||
+            (group >= 0 && fanout_group->second != group)) {
+          group = -1;
+          break;
+        }
+        group = fanout_group->second;
+      }
+    }
+    if (group >= 0) {
+      const FusionGroup& candidate = groups[group];
+      if (candidate.members.size() >= kMaxFusedOps ||
+          node.device() != candidate.root->device() ||
+          GetDataTypeFromAttr(node, "T") !=
+              GetDataTypeFromAttr(*candidate.root, "T") ||
+          !IsCompatibleWithOutput(node, properties, candidate.output_shape)) {
+        group = -1;
+      }
+    }
+
+    if (group < 0) {
+      // The inputs of the root must repeat along the outer dimensions of its
+      // output as well.
+      const TensorShapeProto& output_shape =
+          properties.GetOutputProperties(node.name())[0].shape();
+      if (!IsCompatibleWithOutput(node, properties, output_shape)) continue;
+      group = groups.size();
+      groups.emplace_back();
+      groups.back().root = node_map.GetNode(node.name());
+      groups.back().output_shape = output_shape;
+    }
+    groups[group].members.emplace(node.name(), &node);
+    group_of.emplace(&node, group);
+  }
+
+  std::set<string> nodes_to_delete;
+  int num_fused_groups = 0;
+  for (const FusionGroup& group : groups) {
+    if (group.members.size() < 2) continue;
+    FuseGroup(group);
+    for (const auto& member : group.members) {
+      if (member.second != group.root) nodes_to_delete.insert(member.first);
+    }
+    ++num_fused_groups;
+  }
+  if (num_fused_groups == 0) return errors::Aborted("Nothing to do.");
+
+  VLOG(1) << "Fused " << nodes_to_delete.size() + num_fused_groups
+          << " elementwise ops into " << num_fused_groups << " "
+          << kFusedElementwise << " nodes";
+  EraseNodesFromGraph(nodes_to_delete, optimized_graph);
+  return Status::OK();
+}
+
+void ElementwiseFusion::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                 const GraphDef& optimized_graph,
+                                 double result) {
+  // Nothing to do for ElementwiseFusion.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,56 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Fuses connected subgraphs of elementwise ops placed on the CPU into single
+// _FusedElementwise nodes, that evaluate the whole subgraph in one pass over
+// its inputs instead of materializing every intermediate tensor.
+//
+// A subgraph is only fused if its intermediate results are not used outside of
+// it, and if all its inputs have the shape of its output, or repeat along the
+// outer dimensions of the output (e.g. a bias vector added to a matrix).
+class ElementwiseFusion : public GraphOptimizer {
+ public:
+  explicit ElementwiseFusion(RewriterConfig::Toggle opt_level)
+      : opt_level_(opt_level) {}
+
+  ~ElementwiseFusion() override {}
+
+  string name() const override { return "elementwise_fusion"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  RewriterConfig::Toggle opt_level_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_ELEMENTWISE_FUSION_H_
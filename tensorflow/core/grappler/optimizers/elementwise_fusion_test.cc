@@ -0,0 +1,233 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+
+class ElementwiseFusionTest : public GrapplerTest {
+ protected:
+  // Places all the nodes of `item` on the CPU.
+  void PlaceOnCpu(GrapplerItem* item) {
+    for (int i = 0; i < item->graph.node_size(); ++i) {
+      item->graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+  }
+};
+
+TEST_F(ElementwiseFusionTest, FuseChainWithBroadcastBias) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT,
+                           ops::Placeholder::Shape({8, 64}));
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                          ops::Placeholder::Shape({64}));
+  auto mul = ops::Mul(s.WithOpName("mul"), x, scale);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, bias);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), tanh);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+  auto scale_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}, {"scale", scale_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  PlaceOnCpu(&item);
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mul");
+    EXPECT_NE(node.name(), "add");
+    if (node.name() == "tanh") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.input(2), "bias");
+      EXPECT_EQ(node.attr().at("N").i(), 3);
+      EXPECT_EQ(node.attr().at("T").type(), DT_FLOAT);
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 3);
+      EXPECT_EQ(fused_ops[0], "Mul");
+      EXPECT_EQ(fused_ops[1], "AddV2");
+      EXPECT_EQ(fused_ops[2], "Tanh");
+
+      const auto operands = node.attr().at("operands").list().i();
+      ASSERT_EQ(operands.size(), 5);
+      EXPECT_EQ(operands[0], 0);
+      EXPECT_EQ(operands[1], 1);
+      EXPECT_EQ(operands[2], 3);
+      EXPECT_EQ(operands[3], 2);
+      EXPECT_EQ(operands[4], 4);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(ElementwiseFusionTest, FuseDiamond) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // mul = x^2 * (x^2 - x)
+  auto x = Placeholder(s.WithOpName("x"), DT_DOUBLE,
+                       ops::Placeholder::Shape({4, 100}));
+  auto square = ops::Square(s.WithOpName("square"), x);
+  auto sub = ops::Sub(s.WithOpName("sub"), square, x);
+  auto mul = ops::Mul(s.WithOpName("mul"), square, sub);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), mul);
+
+  auto x_t = GenerateRandomTensor<DT_DOUBLE>({4, 100});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  PlaceOnCpu(&item);
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "square");
+    EXPECT_NE(node.name(), "sub");
+    if (node.name() == "mul") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "x");
+
+      // The shared square is computed once.
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 3);
+      EXPECT_EQ(fused_ops[0], "Square");
+      EXPECT_EQ(fused_ops[1], "Sub");
+      EXPECT_EQ(fused_ops[2], "Mul");
+
+      const auto operands = node.attr().at("operands").list().i();
+      ASSERT_EQ(operands.size(), 5);
+      EXPECT_EQ(operands[0], 0);
+      EXPECT_EQ(operands[1], 1);
+      EXPECT_EQ(operands[2], 0);
+      EXPECT_EQ(operands[3], 1);
+      EXPECT_EQ(operands[4], 2);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<double>(tensors[0], tensors_expected[0], 1e-12);
+}
+
+TEST_F(ElementwiseFusionTest, DoNotFuseIntermediateWithExternalConsumer) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto y = Placeholder(s.WithOpName("y"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto add = ops::AddV2(s.WithOpName("add"), x, y);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto fetch_add = ops::Identity(s.WithOpName("fetch_add"), add);
+  auto fetch_relu = ops::Identity(s.WithOpName("fetch_relu"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"fetch_add", "fetch_relu"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  PlaceOnCpu(&item);
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status)) << status;
+}
+
+TEST_F(ElementwiseFusionTest, DoNotFuseInnerBroadcast) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // The kernel only broadcasts inputs along the outer dimensions.
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 1}));
+  auto y = Placeholder(s.WithOpName("y"), DT_FLOAT,
+                       ops::Placeholder::Shape({1, 64}));
+  auto add = ops::AddV2(s.WithOpName("add"), x, y);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), relu);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  PlaceOnCpu(&item);
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status)) << status;
+}
+
+TEST_F(ElementwiseFusionTest, DoNotFuseWithoutDevice) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                       ops::Placeholder::Shape({8, 64}));
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), neg);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  ElementwiseFusion optimizer(RewriterConfig::ON);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  EXPECT_TRUE(errors::IsAborted(status)) << status;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -416,7 +416,8 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
   TransposeContext context;
   if (num_gpus > 0) {
     TF_RETURN_IF_ERROR(
-        TransposeContext::InitializeTransposeContext(item, cluster, &context));
+        TransposeContext::InitializeTransposeContext(
+            item, cluster, &context, incremental_graph_properties()));
 
     const auto src_dst_formats = GetSrcAndDstDataFormats(
         context, num_gpus, num_gpus_and_num_volta.second);
@@ -424,7 +425,8 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
                                        src_dst_formats.second);
   } else {
     TF_RETURN_IF_ERROR(
-        TransposeContext::InitializeTransposeContext(item, cluster, &context));
+        TransposeContext::InitializeTransposeContext(
+            item, cluster, &context, incremental_graph_properties()));
     switch (cpu_layout_conversion_) {
       case RewriterConfig::NCHW_TO_NHWC:
         context.AssignDeviceAndDataFormats(kCPU, kNCHW, kNHWC);
@@ -222,12 +222,16 @@ class ScopedDataFormatUpgrader {
 
 // TransposeContext.
 
-Status TransposeContext::InitializeTransposeContext(const GrapplerItem& item,
-                                                    const Cluster* cluster,
-                                                    TransposeContext* context) {
+Status TransposeContext::InitializeTransposeContext(
+    const GrapplerItem& item, const Cluster* cluster, TransposeContext* context,
+    IncrementalGraphProperties* incremental_graph_properties) {
   DCHECK(context != nullptr);
   context->graph_properties = absl::make_unique<GraphProperties>(item);
-  TF_RETURN_IF_ERROR(context->graph_properties->InferStatically(false));
+  TF_RETURN_IF_ERROR(InferStatically(incremental_graph_properties,
+                                     /*assume_valid_feeds=*/false,
+                                     /*include_input_tensor_values=*/true,
+                                     /*include_output_tensor_values=*/true,
+                                     context->graph_properties.get()));
   TF_RETURN_IF_ERROR(context->graph_properties->AnnotateOutputShapes(
       &context->graph, /*allow_symbolic_shapes=*/true));
   Status status;
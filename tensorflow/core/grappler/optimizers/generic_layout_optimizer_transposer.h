@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/frame.h"
@@ -51,9 +52,12 @@ struct TransposeContext {
   // Initializes TransposeContext with given GrapplerItem. Because initializing
   // FrameMap and GraphProperties may return error, we initialize
   // TransposeContext outside constructor.
-  static Status InitializeTransposeContext(const GrapplerItem& item,
-                                           const Cluster* cluster,
-                                           TransposeContext* context);
+  // The graph properties are inferred through `incremental_graph_properties`
+  // if it is not null.
+  static Status InitializeTransposeContext(
+      const GrapplerItem& item, const Cluster* cluster,
+      TransposeContext* context,
+      IncrementalGraphProperties* incremental_graph_properties = nullptr);
 
   // Sets data formats to convert from and to for specified device type.
   void AssignDeviceAndDataFormats(absl::string_view target_device,
@@ -29,12 +29,14 @@ namespace grappler {
 
 class Cluster;
 struct GrapplerItem;
+class IncrementalGraphProperties;
 
 // An abstract interface for an algorithm for generating a candidate
 // optimization of a GrapplerItem for running on a cluster.
 class GraphOptimizer {
  public:
-  GraphOptimizer() : deadline_usec_(0) {}
+  GraphOptimizer()
+      : deadline_usec_(0), incremental_graph_properties_(nullptr) {}
   virtual ~GraphOptimizer() {}
 
   virtual string name() const = 0;
@@ -80,8 +82,20 @@ class GraphOptimizer {
     return deadline_usec_ > 0 && Env::Default()->NowMicros() > deadline_usec_;
   }
 
+  // Set the graph properties maintained by the framework across optimization
+  // passes, which optimizers may use instead of inferring the properties of
+  // the graph from scratch. A value of null means none.
+  void set_incremental_graph_properties(
+      IncrementalGraphProperties* incremental_graph_properties) {
+    incremental_graph_properties_ = incremental_graph_properties;
+  }
+  IncrementalGraphProperties* incremental_graph_properties() const {
+    return incremental_graph_properties_;
+  }
+
  private:
   uint64 deadline_usec_;
+  IncrementalGraphProperties* incremental_graph_properties_;
 };
 
 #define GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED()                              \
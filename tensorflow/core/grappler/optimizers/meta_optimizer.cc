@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
@@ -35,12 +37,14 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
 #include "tensorflow/core/grappler/optimizers/debug_stripper.h"
 #include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/elementwise_fusion.h"
 #include "tensorflow/core/grappler/optimizers/function_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/implementation_selector.h"
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/optimizers/pin_to_host_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 #include "tensorflow/core/grappler/optimizers/scoped_allocator_optimizer.h"
@@ -53,7 +57,12 @@ limitations under the License.
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
 
@@ -165,6 +174,65 @@ bool MemoryOptimizerEnabled(
   return mem_opt_type != RewriterConfig::NO_MEM_OPT;
 }
 
+// Returns true if the optimizers of a graph share the graph properties they
+// infer, so that each of them only re-infers the properties of the nodes
+// rewritten by the previous ones.
+bool IncrementalGraphPropertiesEnabled() {
+  static const bool enabled = []() {
+    bool enabled;
+    Status s = ReadBoolFromEnvVar("TF_GRAPPLER_INCREMENTAL_GRAPH_PROPERTIES",
+                                  /*default_val=*/false, &enabled);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      enabled = false;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+// Returns the number of threads that optimize the bodies of the functions in
+// the library. Setting the variable to 1 optimizes them on the calling thread.
+int64 NumFunctionOptimizationThreads() {
+  static const int64 num_threads = []() {
+    int64 num_threads;
+    Status s = ReadInt64FromEnvVar("TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+                                   port::MaxParallelism(), &num_threads);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      num_threads = port::MaxParallelism();
+    }
+    return std::max<int64>(num_threads, 1);
+  }();
+  return num_threads;
+}
+
+// Shared by all the meta optimizers in the process.
+thread::ThreadPool* FunctionOptimizationThreadPool() {
+  static thread::ThreadPool* pool =
+      new thread::ThreadPool(Env::Default(), "grappler_function_optimizer",
+                             NumFunctionOptimizationThreads());
+  return pool;
+}
+
+// Fingerprints everything about `func` that affects the optimization of its
+// body, which excludes its name: functions with identical fingerprints are
+// optimized once.
+Status FunctionBodyFingerprint(const FunctionDef& func,
+                               bool allow_non_differentiable_rewrites,
+                               Fprint128* fingerprint) {
+  FunctionDef body = func;
+  body.mutable_signature()->clear_name();
+  string serialized;
+  if (!SerializeToStringDeterministic(body, &serialized)) {
+    return errors::Internal("Failed to serialize function ",
+                            func.signature().name());
+  }
+  absl::StrAppend(&serialized, allow_non_differentiable_rewrites);
+  *fingerprint = Fingerprint128(serialized);
+  return Status::OK();
+}
+
 }  // namespace
 
 #define MK_OPT(NAME, VALUE) \
@@ -187,6 +255,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
              cfg_.experimental_disable_compressed_tensor_optimization()));
   MK_OPT("shape", new ShapeOptimizer());
   MK_OPT("remap", new Remapper(cfg_.remapping()));
+  MK_OPT("elementwise_fusion",
+         new ElementwiseFusion(cfg_.elementwise_fusion()));
   MK_OPT("layout", new GenericLayoutOptimizer(
                        /*optimization level*/ cfg_.layout_optimizer(),
                        /*CPU layout conversion*/ cfg_.cpu_layout_conversion()));
@@ -213,6 +283,14 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
 
 #undef MK_OPT
 
+bool MetaOptimizer::CanOptimizeFunctionsInParallel() const {
+  if (!cfg_.custom_optimizers().empty()) return false;
+  for (const string& optimizer_name : cfg_.optimizers()) {
+    if (!MakeNewOptimizer(optimizer_name)) return false;
+  }
+  return true;
+}
+
 MetaOptimizer::MetaOptimizer(DeviceBase* cpu_device, const ConfigProto& cfg)
     : cpu_device_(cpu_device),
       config_proto_(cfg),
@@ -276,6 +354,11 @@ Status MetaOptimizer::InitializeOptimizers(
   if (cfg_.remapping() != RewriterConfig::OFF) {
     optimizers->push_back(MakeUnique<Remapper>(cfg_.remapping()));
   }
+  if (cfg_.elementwise_fusion() == RewriterConfig::ON ||
+      cfg_.elementwise_fusion() == RewriterConfig::AGGRESSIVE) {
+    optimizers->push_back(
+        MakeUnique<ElementwiseFusion>(cfg_.elementwise_fusion()));
+  }
   if (cfg_.loop_optimization() != RewriterConfig::OFF) {
     optimizers->push_back(
         MakeUnique<LoopOptimizer>(cfg_.loop_optimization(), cpu_device_));
@@ -396,8 +479,9 @@ void MetaOptimizer::InitializeVerifiers(
   }
 }
 
-Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                                    GraphDef* optimized_graph) {
+Status MetaOptimizer::OptimizeGraph(
+    Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+    std::vector<GraphOptimizationResult>* optimization_results) {
   int min_graph_nodes = cfg_.min_graph_nodes() == 0 ? kDefaultMinGraphNodes
                                                     : cfg_.min_graph_nodes();
   if (item.graph.node_size() < min_graph_nodes) {
@@ -443,6 +527,14 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
     return Status::OK();
   }
 
+  IncrementalGraphProperties incremental_graph_properties;
+  if (IncrementalGraphPropertiesEnabled()) {
+    for (const auto& optimizer : optimizers) {
+      optimizer->set_incremental_graph_properties(
+          &incremental_graph_properties);
+    }
+  }
+
   // Invariant: optimized_graph contains the most recently optimized version of
   // the graph.
   auto original_producer = item.graph.versions().producer();
@@ -529,7 +621,7 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  optimization_results->push_back(optimization_result);
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -538,6 +630,16 @@ Status MetaOptimizer::OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
     DCHECK_EQ(optimized_graph->versions().producer(), original_producer);
   }
 
+  if (IncrementalGraphPropertiesEnabled()) {
+    const IncrementalGraphProperties::Stats& stats =
+        incremental_graph_properties.stats();
+    VLOG(1) << "Graph properties of " << item.id
+            << ": full inferences = " << stats.full_inferences
+            << ", incremental inferences = " << stats.incremental_inferences
+            << ", reuses = " << stats.reuses
+            << ", re-inferred nodes = " << stats.reinferred_nodes;
+  }
+
   const uint64 end_us = Env::Default()->NowMicros();
   metrics::UpdateGrapplerPassTime("OptimizeMainGraph", end_us - start_us);
 
@@ -697,13 +799,33 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       "Deleted $0 unreachable functions from the graph (library size = $1)",
       old_library_size - new_library_size, new_library_size);
 
+  // Reuse the result of optimizing the same item, possibly in another process.
+  OptimizedGraphCache* cache = OptimizedGraphCache::Global();
+  string cache_key;
+  if (cache != nullptr) {
+    Status s = OptimizedGraphCache::Key(item, config_proto_,
+                                        cpu_device_ != nullptr, cluster,
+                                        &cache_key);
+    if (!s.ok()) {
+      VLOG(1) << "Not caching the optimized graph: " << s;
+      cache = nullptr;
+    } else if (cache->Lookup(cache_key, optimized_graph).ok()) {
+      VLOG(1) << "Loaded optimized graph for grappler item " << item.id
+              << " from " << cache->directory();
+      metrics::UpdateGrapplerPassTime("*",
+                                      Env::Default()->NowMicros() - start_us);
+      return Status::OK();
+    }
+  }
+
   // Save a few small fields from item before we move it.
   bool optimize_function_library =
       item.optimization_options().optimize_function_library;
   const auto producer = item.graph.versions().producer();
 
   // 1. Optimize main graph
-  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph));
+  TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(item), optimized_graph,
+                                   &optimization_results_));
   VLOG(1) << "Optimized main graph.";
   GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
 
@@ -778,15 +900,98 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // Propagate `_tf_data_function` attributes from functions to their callees.
   PropagateTFDataAttrs(flib, *optimized_graph->mutable_library());
 
+  // A function optimized in the current pass over the function library.
+  struct FunctionOptimization {
+    const FunctionDef* func = nullptr;
+    bool allow_non_differentiable_rewrites = true;
+    // Index of the earlier function with an identical body, whose optimized
+    // body is reused for this one, or -1 if the body is optimized.
+    int duplicate_of = -1;
+
+    GrapplerFunctionItem func_item;
+    GraphDef optimized_func_graph;
+    std::vector<GraphOptimizationResult> optimization_results;
+    Status status;
+    FunctionDef optimized_func;
+  };
+
+  // Optimizes the body of `f->func` against `flib`. It only reads the shared
+  // state, so the bodies of different functions can be optimized concurrently.
+  bool is_tpu_graph = false;
+  const auto optimize_function_body = [&](FunctionOptimization* f) -> Status {
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+
+    // Make a GrapplerItem from a FunctionDef.
+    GrapplerFunctionItem& func_item = f->func_item;
+    TF_RETURN_IF_ERROR(
+        MakeGrapplerFunctionItem(*f->func, flib, producer, &func_item));
+
+    func_item.optimization_options().allow_non_differentiable_rewrites =
+        f->allow_non_differentiable_rewrites;
+
+    // Device set available to the function is defined only by the runtime,
+    // when we instantiate and execute the function. We can't use all devices
+    // available to the main graph, because after partitioning the function
+    // call node might execute on a remote worker.
+    if (!func_item.devices().empty()) {
+      return errors::Internal("GrapplerFunctionItem devices must be empty.");
+    }
+
+    // We are not allowed to prune certain types of ops from the graph
+    // instantiated by the function definition, because we must guarantee
+    // function execution semantics wrt side effects (see
+    // function_optimizer.cc).
+    func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
+        false;
+
+    // Optimize function body graph.
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      FunctionDefLibrary func_item_function_library;
+      func_item_function_library.Swap(func_item.graph.mutable_library());
+      *func_item.graph.mutable_library() =
+          GetFunctionDefLibraryStub(func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, func_item,
+                                              &f->optimized_func_graph);
+    }
+    GrapplerFunctionItem func_item_copy = func_item;
+    return OptimizeGraph(cluster, std::move(func_item_copy),
+                         &f->optimized_func_graph, &f->optimization_results);
+  };
+
+  const bool optimize_in_parallel =
+      NumFunctionOptimizationThreads() > 1 && CanOptimizeFunctionsInParallel();
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
+    GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+    is_tpu_graph = IsTPUGraphDef(*optimized_graph);
+
+    // All functions of a pass are optimized against the library as it was at
+    // the start of the pass, so the result does not depend on the order in
+    // which their optimizations finish.
+    std::vector<FunctionOptimization> optimizations;
+    absl::flat_hash_map<Fprint128, int, Fprint128Hasher> optimization_by_body;
 
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
-      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
-
       const string& func_name = func.signature().name();
 
       // Skip functions that are not reachable from the optimized graph.
@@ -815,78 +1020,79 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       optimize_function_library = true;
       optimized_funcs.insert(func_name);
 
-      // Make a GrapplerItem from a FunctionDef.
-      GrapplerFunctionItem func_item;
-      TF_RETURN_IF_ERROR(
-          MakeGrapplerFunctionItem(func, flib, producer, &func_item));
-
+      optimizations.emplace_back();
+      FunctionOptimization& f = optimizations.back();
+      f.func = &func;
       // If we need to compute the gradient of optimized function at runtime, we
       // can't perform non-differentiable rewrites.
-      func_item.optimization_options().allow_non_differentiable_rewrites =
+      f.allow_non_differentiable_rewrites =
           !differentiable_functions.contains(func_name);
 
-      // Device set available to the function is defined only by the runtime,
-      // when we instantiate and execute the function. We can't use all devices
-      // available to the main graph, because after partitioning the function
-      // call node might execute on a remote worker.
-      if (!func_item.devices().empty()) {
-        return errors::Internal("GrapplerFunctionItem devices must be empty.");
+      // Functions with identical bodies (e.g. the same layer traced several
+      // times) are instantiated and optimized once.
+      Fprint128 fingerprint;
+      TF_RETURN_IF_ERROR(FunctionBodyFingerprint(
+          func, f.allow_non_differentiable_rewrites, &fingerprint));
+      const auto inserted =
+          optimization_by_body.emplace(fingerprint, optimizations.size() - 1);
+      if (!inserted.second) f.duplicate_of = inserted.first->second;
+    }
+
+    std::vector<FunctionOptimization*> bodies;
+    for (FunctionOptimization& f : optimizations) {
+      if (f.duplicate_of < 0) bodies.push_back(&f);
+    }
+    VLOG(2) << "Optimizing " << bodies.size() << " distinct bodies of "
+            << optimizations.size() << " functions";
+
+    if (optimize_in_parallel && bodies.size() > 1) {
+      FunctionOptimizationThreadPool()->TransformRangeConcurrently(
+          /*block_size=*/1, bodies.size(), [&](int64 begin, int64 end) {
+            for (int64 i = begin; i < end; ++i) {
+              bodies[i]->status = optimize_function_body(bodies[i]);
+            }
+          });
+    } else {
+      for (FunctionOptimization* f : bodies) {
+        f->status = optimize_function_body(f);
+        if (!f->status.ok()) break;
       }
+    }
 
-      // We are not allowed to prune certain types of ops from the graph
-      // instantiated by the function definition, because we must guarantee
-      // function execution semantics wrt side effects (see
-      // function_optimizer.cc).
-      func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
-          false;
-
-      // Optimize function body graph.
-      GraphDef optimized_func_graph;
-      if (IsTPUGraphDef(*optimized_graph)) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        FunctionDefLibrary func_item_function_library;
-        func_item_function_library.Swap(func_item.graph.mutable_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
+    // Update the library in library order, which keeps the result
+    // deterministic.
+    for (FunctionOptimization& f : optimizations) {
+      const string& func_name = f.func->signature().name();
+
+      if (f.duplicate_of >= 0) {
+        FunctionDef optimized_func =
+            optimizations[f.duplicate_of].optimized_func;
+        optimized_func.mutable_signature()->set_name(func_name);
+        TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+        continue;
+      }
+
+      TF_RETURN_IF_ERROR(f.status);
+      for (GraphOptimizationResult& result : f.optimization_results) {
+        optimization_results_.push_back(std::move(result));
       }
 
       // Function body optimization might have created new specialized
       // functions for each instantiation context. Add them to the library.
       for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
+           f.optimized_func_graph.library().function()) {
         if (flib.Find(func_def.signature().name()) == nullptr) {
           TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
         }
       }
 
       // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
+      f.func_item.SwapFunctionBody(std::move(f.optimized_func_graph));
+      TF_RETURN_IF_ERROR(
+          MakeFunctionDef(f.func_item, flib, &f.optimized_func));
 
       // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, f.optimized_func));
     }
 
     // If optimized at least one function, update the graph library.
@@ -905,6 +1111,13 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
         *optimized_graph);
   }
 
+  if (cache != nullptr) {
+    Status s = cache->Insert(cache_key, *optimized_graph);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to cache the optimized graph: " << s;
+    }
+  }
+
   const uint64 end_us = Env::Default()->NowMicros();
   metrics::UpdateGrapplerPassTime("*", end_us - start_us);
 
@@ -938,6 +1151,8 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
          rewrite_cfg.constant_folding() != RewriterConfig::OFF ||
          rewrite_cfg.shape_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.remapping() != RewriterConfig::OFF ||
+         rewrite_cfg.elementwise_fusion() == RewriterConfig::ON ||
+         rewrite_cfg.elementwise_fusion() == RewriterConfig::AGGRESSIVE ||
          rewrite_cfg.common_subgraph_elimination() != RewriterConfig::OFF ||
          rewrite_cfg.arithmetic_optimization() != RewriterConfig::OFF ||
          rewrite_cfg.loop_optimization() != RewriterConfig::OFF ||
@@ -83,15 +83,6 @@ class MetaOptimizer : public GraphOptimizer {
       std::vector<std::unique_ptr<GraphVerifier>>* post_optimization_verifiers)
       const;
 
-  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
-  // multiple such passes: 1) for the main graph 2) for the function library
-  Status OptimizeGraph(Cluster* cluster, GrapplerItem&& item,
-                       GraphDef* optimized_graph);
-
-  DeviceBase* const cpu_device_;  // may be NULL
-  ConfigProto config_proto_;
-  RewriterConfig& cfg_;
-
   struct OptimizerResult {
     string optimizer_name;
     string message;
@@ -104,6 +95,22 @@ class MetaOptimizer : public GraphOptimizer {
     std::vector<OptimizerResult> results;
   };
 
+  // Run optimization pass over a single GrapplerItem. Meta optimizer might run
+  // multiple such passes: 1) for the main graph 2) for the function library.
+  // The result of the pass is appended to `optimization_results`.
+  Status OptimizeGraph(
+      Cluster* cluster, GrapplerItem&& item, GraphDef* optimized_graph,
+      std::vector<GraphOptimizationResult>* optimization_results);
+
+  // Returns true if the bodies of several functions may be optimized
+  // concurrently. Custom graph optimizers are not required to be thread-safe,
+  // so the function library is optimized serially when any is configured.
+  bool CanOptimizeFunctionsInParallel() const;
+
+  DeviceBase* const cpu_device_;  // may be NULL
+  ConfigProto config_proto_;
+  RewriterConfig& cfg_;
+
   Status RunOptimizer(GraphOptimizer* optimizer, Cluster* cluster,
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
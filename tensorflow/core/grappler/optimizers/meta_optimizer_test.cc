@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -26,12 +27,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
@@ -154,6 +158,63 @@ TEST_F(MetaOptimizerTest, RunsCustomOptimizer) {
   EXPECT_TRUE(TestOptimizer::IsOptimized());
 }
 
+TEST_F(MetaOptimizerTest, ReusesOptimizedGraphFromCache) {
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache");
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(cache_dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  setenv("TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR", cache_dir.c_str(), 1);
+  OptimizedGraphCache* cache = OptimizedGraphCache::Global();
+  ASSERT_NE(cache, nullptr);
+  const OptimizedGraphCache::Stats initial_stats = cache->stats();
+
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  // The first optimization runs the optimizers and fills the cache.
+  TestOptimizer::SetOptimized(false);
+  GraphDef output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+  EXPECT_EQ(cache->stats().misses, initial_stats.misses + 1);
+  EXPECT_EQ(cache->stats().insertions, initial_stats.insertions + 1);
+
+  // The second one loads the optimized graph without running them.
+  TestOptimizer::SetOptimized(false);
+  GraphDef cached_output;
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &cached_output));
+  }
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  EXPECT_EQ(cache->stats().hits, initial_stats.hits + 1);
+  CompareGraphs(output, cached_output);
+
+  // A different configuration misses the cache.
+  rewriter_config.set_constant_folding(RewriterConfig::OFF);
+  {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &cached_output));
+  }
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+  EXPECT_EQ(cache->stats().hits, initial_stats.hits + 1);
+
+  unsetenv("TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR");
+  EXPECT_EQ(OptimizedGraphCache::Global(), nullptr);
+}
+
 TEST_F(MetaOptimizerTest, RunsCustomOptimizerWithParams) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
   GrapplerItem item;
@@ -683,6 +744,119 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryWithRestrictions) {
       optimization_options_my_mul_2->allow_non_differentiable_rewrites);
 }
 
+// Returns a graph that calls `num_functions` functions with distinct bodies.
+GrapplerItem MakeFunctionLibraryItem(int num_functions) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  GrapplerItem item;
+  item.id = "main";
+  std::vector<NodeDef> nodes = {
+      NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  std::vector<FunctionDef> funcs;
+  for (int i = 0; i < num_functions; ++i) {
+    // MyFunc<i>(x) = x * i + x
+    const string func_name = absl::StrCat("MyFunc", i);
+    funcs.push_back(FDH::Create(
+        func_name, {"x:float"}, {"z:float"}, {},
+        {FDH::Const("scale", static_cast<float>(i)),
+         {{"mul"}, "Mul", {"x", "scale:output:0"}, {{"T", DT_FLOAT}}},
+         {{"add"}, "AddV2", {"mul:z:0", "x"}, {{"T", DT_FLOAT}}}},
+        /*ret_def=*/
+        {{"z", "add:z:0"}}));
+    const string call_name = absl::StrCat("call", i);
+    nodes.push_back(NDef(call_name, func_name, {"x"}, {}, kDevice));
+    item.fetch.push_back(call_name);
+  }
+  item.graph = test::function::GDef(nodes, funcs);
+  return item;
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryDeterministically) {
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+
+  const GrapplerItem item = MakeFunctionLibraryItem(64);
+  GraphDef first_output;
+  MetaOptimizer first_optimizer(nullptr, config_proto);
+  TF_ASSERT_OK(first_optimizer.Optimize(nullptr, item, &first_output));
+
+  // The functions are optimized concurrently, but the optimized graph must not
+  // depend on the order in which their optimizations finish.
+  for (int i = 0; i < 3; ++i) {
+    GraphDef output;
+    MetaOptimizer optimizer(nullptr, config_proto);
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+    CompareGraphs(first_output, output);
+    FunctionLibraryDefinition first_flib(OpRegistry::Global(),
+                                         first_output.library());
+    for (const FunctionDef& func : output.library().function()) {
+      const FunctionDef* first_func = first_flib.Find(func.signature().name());
+      ASSERT_NE(first_func, nullptr);
+      EXPECT_TRUE(FunctionDefsEqual(*first_func, func));
+    }
+  }
+}
+
+TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryDeduplicatesIdenticalBodies) {
+  using test::function::NDef;
+
+  gtl::FlatMap<string, GrapplerItem::OptimizationOptions> optimization_options;
+  GrapplerItemPropertiesAccumulator::SetOptimizationOptions(
+      &optimization_options);
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::ONE);
+  rewriter_config.add_optimizers("GrapplerItemPropertiesAccumulator");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  MetaOptimizer optimizer(nullptr, config_proto);
+
+  // Two functions with identical bodies.
+  FunctionDef mul_func_1 = FunctionDefHelper::Create(
+      "MyMul1", {"x:float", "y:float"}, {"z:float"}, {},
+      {{{"mul"}, "Mul", {"x", "y"}, {{"T", DT_FLOAT}}}},
+      /*ret_def=*/
+      {{"z", "mul:z:0"}});
+  FunctionDef mul_func_2 = mul_func_1;
+  mul_func_2.mutable_signature()->set_name("MyMul2");
+
+  GrapplerItem item;
+  item.id = "main";
+  item.graph = test::function::GDef(
+      {NDef("x0", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("x1", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice),
+       NDef("mul_1", "MyMul1", {"x0", "x1"}, {}, kDevice),
+       NDef("mul_2", "MyMul2", {"x0", "x1"}, {}, kDevice)},
+      /*funcs=*/
+      {mul_func_1, mul_func_2});
+  item.fetch = {"mul_1", "mul_2"};
+
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  GrapplerItemPropertiesAccumulator::ResetOptimizationOptions();
+
+  // Only the first of the two identical bodies is optimized ...
+  EXPECT_EQ(optimization_options.size(), 2);
+  EXPECT_NE(gtl::FindOrNull(optimization_options, "main"), nullptr);
+  EXPECT_NE(gtl::FindOrNull(optimization_options, "MyMul1"), nullptr);
+
+  // ... and the result is reused for the second one.
+  FunctionLibraryDefinition optimized_flib(OpRegistry::Global(),
+                                           output.library());
+  const FunctionDef* optimized_func_1 = optimized_flib.Find("MyMul1");
+  const FunctionDef* optimized_func_2 = optimized_flib.Find("MyMul2");
+  ASSERT_NE(optimized_func_1, nullptr);
+  ASSERT_NE(optimized_func_2, nullptr);
+  FunctionDef renamed_func_2 = *optimized_func_2;
+  renamed_func_2.mutable_signature()->set_name("MyMul1");
+  EXPECT_TRUE(FunctionDefsEqual(*optimized_func_1, renamed_func_2));
+}
+
 class SleepingOptimizer : public CustomGraphOptimizer {
  public:
   SleepingOptimizer() {}
@@ -1155,6 +1329,27 @@ INSTANTIATE_TEST_SUITE_P(MetaOptimizerTest, TfDataTestFixture,
                          ::testing::Combine(::testing::Bool(),
                                             ::testing::Bool()));
 
+// Measures the wall time of optimizing the main graph and its function library
+// with the default optimizers.
+static void BM_OptimizeFunctionLibrary(int iters, int num_functions) {
+  testing::StopTiming();
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_min_graph_nodes(-1);
+  const GrapplerItem item = MakeFunctionLibraryItem(num_functions);
+  testing::UseRealTime();
+  testing::StartTiming();
+
+  for (int i = 0; i < iters; ++i) {
+    MetaOptimizer optimizer(nullptr, config_proto);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_functions);
+}
+BENCHMARK(BM_OptimizeFunctionLibrary)->Arg(100)->Arg(5000);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,279 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/metrics.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/raw_coding.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Bump whenever the on-disk format or the meaning of a cache key changes.
+constexpr uint32 kRecordVersion = 2;
+
+constexpr char kEntrySuffix[] = ".grappler_cache";
+
+constexpr char kCacheDirEnvVar[] = "TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR";
+
+// An entry file holds:
+//   fixed32   record version
+//   varint64  length of the key, followed by the key
+//   fixed32   masked crc32c of the serialized graph
+//   bytes     serialized GraphDef
+string EncodeRecord(const string& key, const string& serialized_graph) {
+  string record;
+  core::PutFixed32(&record, kRecordVersion);
+  core::PutVarint64(&record, key.size());
+  record.append(key);
+  core::PutFixed32(&record, crc32c::Mask(crc32c::Value(
+                                serialized_graph.data(),
+                                serialized_graph.size())));
+  record.append(serialized_graph);
+  return record;
+}
+
+// Checks the header of `record` against `key`, and returns its serialized
+// graph in `*serialized_graph`. Returns an empty string on success, or a
+// description of what is wrong with the record.
+string DecodeRecord(const string& key, StringPiece record,
+                    StringPiece* serialized_graph) {
+  if (record.size() < sizeof(uint32)) {
+    return "truncated record";
+  }
+  const uint32 version = core::DecodeFixed32(record.data());
+  if (version != kRecordVersion) {
+    return absl::StrCat("unsupported record version ", version);
+  }
+  record.remove_prefix(sizeof(uint32));
+  uint64 key_size;
+  if (!core::GetVarint64(&record, &key_size) || record.size() < key_size) {
+    return "truncated record";
+  }
+  if (record.substr(0, key_size) != key) {
+    return absl::StrCat("record was written for key ",
+                        record.substr(0, key_size));
+  }
+  record.remove_prefix(key_size);
+  if (record.size() < sizeof(uint32)) {
+    return "truncated record";
+  }
+  const uint32 crc = crc32c::Unmask(core::DecodeFixed32(record.data()));
+  record.remove_prefix(sizeof(uint32));
+  if (crc != crc32c::Value(record.data(), record.size())) {
+    return "checksum mismatch";
+  }
+  *serialized_graph = record;
+  return "";
+}
+
+}  // namespace
+
+OptimizedGraphCache::OptimizedGraphCache(Env* env, string directory)
+    : env_(env), directory_(std::move(directory)) {}
+
+/* static */ OptimizedGraphCache* OptimizedGraphCache::Global() {
+  string directory;
+  Status s = ReadStringFromEnvVar(kCacheDirEnvVar, "", &directory);
+  if (!s.ok() || directory.empty()) return nullptr;
+
+  // One cache per directory, including the directories that could not be
+  // created (as nullptr), so that their creation is attempted only once.
+  static mutex* mu = new mutex;
+  static auto* caches =
+      new std::map<string, std::unique_ptr<OptimizedGraphCache>>;
+  mutex_lock l(*mu);
+  auto it = caches->find(directory);
+  if (it != caches->end()) return it->second.get();
+
+  Env* env = Env::Default();
+  std::unique_ptr<OptimizedGraphCache> cache;
+  s = env->RecursivelyCreateDir(directory);
+  if (!s.ok() && s.code() != error::ALREADY_EXISTS) {
+    LOG(WARNING) << "Disabling the optimized graph cache: could not create "
+                 << directory << ": " << s;
+  } else {
+    VLOG(1) << "Using optimized graph cache in " << directory;
+    cache.reset(new OptimizedGraphCache(env, directory));
+  }
+  return caches->emplace(directory, std::move(cache)).first->second.get();
+}
+
+/* static */ Status OptimizedGraphCache::Key(const GrapplerItem& item,
+                                             const ConfigProto& config,
+                                             bool has_cpu_device,
+                                             const Cluster* cluster,
+                                             string* key) {
+  string key_material;
+  auto append_proto = [&](const protobuf::MessageLite& proto) -> Status {
+    string serialized;
+    if (!SerializeToStringDeterministic(proto, &serialized)) {
+      return errors::Internal("Failed to serialize optimized graph cache key");
+    }
+    absl::StrAppend(&key_material, serialized.size(), ":", serialized, ";");
+    return Status::OK();
+  };
+  auto append_strings = [&](std::vector<string> strings) {
+    std::sort(strings.begin(), strings.end());
+    absl::StrAppend(&key_material, strings.size(), ";");
+    for (const string& s : strings) {
+      absl::StrAppend(&key_material, s.size(), ":", s, ";");
+    }
+  };
+
+  // The optimizers: any change in TensorFlow invalidates all entries.
+  absl::StrAppend(&key_material, kRecordVersion, ";", tf_git_version(), ";",
+                  tf_compiler_version(), ";", TF_GRAPH_DEF_VERSION, ";");
+  // Besides the RewriterConfig, the optimizers read other fields of the
+  // ConfigProto (e.g. the global jit level and the executor type), and custom
+  // optimizers get all of it.
+  TF_RETURN_IF_ERROR(append_proto(config));
+  absl::StrAppend(&key_material, has_cpu_device, ";");
+
+  // The devices the graph is optimized for.
+  append_strings({item.devices().begin(), item.devices().end()});
+  if (cluster != nullptr) {
+    // Sort the devices, which are held in an unordered map.
+    std::map<string, const DeviceProperties*> devices;
+    for (const auto& device : cluster->GetDevices()) {
+      devices.emplace(device.first, &device.second);
+    }
+    absl::StrAppend(&key_material, devices.size(), ";");
+    for (const auto& device : devices) {
+      absl::StrAppend(&key_material, device.first.size(), ":", device.first,
+                      ";");
+      TF_RETURN_IF_ERROR(append_proto(*device.second));
+    }
+  }
+
+  // The item. Its id is not part of the key, as it does not affect the
+  // optimizations.
+  TF_RETURN_IF_ERROR(append_proto(item.graph));
+  std::vector<string> feeds;
+  for (const auto& feed : item.feed) {
+    feeds.push_back(absl::StrCat(feed.first, ":",
+                                 DataTypeString(feed.second.dtype()),
+                                 feed.second.shape().DebugString()));
+  }
+  append_strings(std::move(feeds));
+  append_strings(item.fetch);
+  append_strings(item.init_ops);
+  append_strings(item.keep_ops);
+  absl::StrAppend(&key_material, item.save_op, ";", item.restore_op, ";",
+                  item.save_restore_loc_tensor, ";");
+  for (const QueueRunnerDef& queue_runner : item.queue_runners) {
+    TF_RETURN_IF_ERROR(append_proto(queue_runner));
+  }
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  absl::StrAppend(&key_material, options.allow_non_differentiable_rewrites,
+                  options.allow_pruning_stateful_and_dataset_ops,
+                  options.optimize_function_library, options.is_eager_mode,
+                  ";");
+
+  const Fprint128 fingerprint = Fingerprint128(key_material);
+  *key = absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+  return Status::OK();
+}
+
+string OptimizedGraphCache::FilePath(const string& key) const {
+  return io::JoinPath(directory_, absl::StrCat(key, kEntrySuffix));
+}
+
+Status OptimizedGraphCache::Lookup(const string& key,
+                                   GraphDef* optimized_graph) {
+  const string path = FilePath(key);
+  string contents;
+  Status s = ReadFileToString(env_, path, &contents);
+  if (!s.ok()) {
+    mutex_lock lock(mu_);
+    ++stats_.misses;
+    metrics::RecordGrapplerCacheLookup("miss");
+    return errors::NotFound("No optimized graph cache entry for ", key);
+  }
+
+  StringPiece serialized_graph;
+  string error = DecodeRecord(key, contents, &serialized_graph);
+  if (error.empty() &&
+      !optimized_graph->ParseFromArray(serialized_graph.data(),
+                                       serialized_graph.size())) {
+    error = "unparseable graph";
+  }
+
+  mutex_lock lock(mu_);
+  if (!error.empty()) {
+    ++stats_.corrupt_entries;
+    metrics::RecordGrapplerCacheLookup("corrupt");
+    // Remove the entry so that it is rewritten by the next optimization.
+    env_->DeleteFile(path).IgnoreError();
+    optimized_graph->Clear();
+    return errors::DataLoss("Corrupt optimized graph cache entry ", path, ": ",
+                            error);
+  }
+  ++stats_.hits;
+  metrics::RecordGrapplerCacheLookup("hit");
+  return Status::OK();
+}
+
+Status OptimizedGraphCache::Insert(const string& key,
+                                   const GraphDef& optimized_graph) {
+  string serialized_graph;
+  if (!optimized_graph.SerializeToString(&serialized_graph)) {
+    return errors::Internal("Failed to serialize the optimized graph for ",
+                            key);
+  }
+  const string path = FilePath(key);
+  const string tmp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(random::New64()));
+  Status s =
+      WriteStringToFile(env_, tmp_path, EncodeRecord(key, serialized_graph));
+  if (s.ok()) {
+    s = env_->RenameFile(tmp_path, path);
+  }
+  if (!s.ok()) {
+    env_->DeleteFile(tmp_path).IgnoreError();
+    return s;
+  }
+
+  mutex_lock lock(mu_);
+  ++stats_.insertions;
+  return Status::OK();
+}
+
+OptimizedGraphCache::Stats OptimizedGraphCache::stats() const {
+  mutex_lock lock(mu_);
+  return stats_;
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
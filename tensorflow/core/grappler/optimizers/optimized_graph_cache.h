@@ -0,0 +1,99 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// An on-disk cache of the graphs (and their function libraries) produced by
+// the meta optimizer, which lets processes loading the same model skip the
+// optimization pipeline.
+//
+// Entries are keyed by a fingerprint of the input GrapplerItem, the whole
+// ConfigProto of the meta optimizer, the devices of the cluster and the
+// TensorFlow build, so changing any of them (including upgrading TensorFlow)
+// misses the cache rather than reusing a stale graph. Custom optimizers are
+// only identified by their name and configuration in the ConfigProto: a
+// cache shared by binaries registering different implementations under the
+// same name must not be used. Each entry is a checksummed file written
+// through a temporary file and a rename, so that concurrent processes sharing
+// the directory never read partially written entries. Corrupt entries are
+// treated as misses and deleted. Entries are never evicted; delete the
+// directory to reclaim its space.
+//
+// This class is thread-safe.
+class OptimizedGraphCache {
+ public:
+  struct Stats {
+    int64 hits = 0;
+    int64 misses = 0;
+    int64 corrupt_entries = 0;
+    int64 insertions = 0;
+  };
+
+  OptimizedGraphCache(Env* env, string directory);
+
+  // Returns the process-wide cache in the directory named by the
+  // TF_GRAPPLER_OPTIMIZED_GRAPH_CACHE_DIR environment variable, or nullptr if
+  // the variable is unset or the directory could not be created. The variable
+  // is read on every call.
+  static OptimizedGraphCache* Global();
+
+  // Computes the key under which the result of optimizing `item` with a meta
+  // optimizer configured by `config` for the devices of `cluster` (which may
+  // be null) is cached. `has_cpu_device` tells whether the meta optimizer was
+  // given a CPU device to evaluate constants with.
+  static Status Key(const GrapplerItem& item, const ConfigProto& config,
+                    bool has_cpu_device, const Cluster* cluster, string* key);
+
+  // Reads the graph stored under `key` into `*optimized_graph`. Returns
+  // NotFound if there is no such entry and DataLoss if the entry was corrupt.
+  Status Lookup(const string& key, GraphDef* optimized_graph);
+
+  // Stores `optimized_graph` under `key`, replacing any existing entry.
+  Status Insert(const string& key, const GraphDef& optimized_graph);
+
+  Stats stats() const;
+
+  const string& directory() const { return directory_; }
+
+ private:
+  string FilePath(const string& key) const;
+
+  Env* const env_;
+  const string directory_;
+
+  mutable mutex mu_;
+  Stats stats_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OptimizedGraphCache);
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_OPTIMIZED_GRAPH_CACHE_H_
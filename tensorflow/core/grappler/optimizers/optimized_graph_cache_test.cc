@@ -0,0 +1,192 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimized_graph_cache.h"
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+string TestDirectory(const string& name) {
+  string dir = io::JoinPath(testing::TmpDir(), name);
+  int64 undeleted_files, undeleted_dirs;
+  Env::Default()
+      ->DeleteRecursively(dir, &undeleted_files, &undeleted_dirs)
+      .IgnoreError();
+  TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(dir));
+  return dir;
+}
+
+GrapplerItem MakeItem() {
+  GrapplerItem item;
+  NodeDef* node = item.graph.add_node();
+  node->set_name("x");
+  node->set_op("Placeholder");
+  node = item.graph.add_node();
+  node->set_name("y");
+  node->set_op("Identity");
+  node->add_input("x");
+  item.fetch.push_back("y");
+  return item;
+}
+
+string Key(const GrapplerItem& item, const ConfigProto& config,
+           const Cluster* cluster, bool has_cpu_device = false) {
+  string key;
+  TF_CHECK_OK(OptimizedGraphCache::Key(item, config, has_cpu_device, cluster,
+                                       &key));
+  return key;
+}
+
+TEST(OptimizedGraphCacheTest, InsertAndLookup) {
+  OptimizedGraphCache cache(Env::Default(), TestDirectory("insert_and_lookup"));
+  const string key = Key(MakeItem(), ConfigProto(), nullptr);
+
+  GraphDef graph;
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(key, &graph)));
+
+  GraphDef optimized_graph = MakeItem().graph;
+  optimized_graph.mutable_node(1)->set_op("Snapshot");
+  TF_ASSERT_OK(cache.Insert(key, optimized_graph));
+  TF_ASSERT_OK(cache.Lookup(key, &graph));
+  EXPECT_EQ(graph.SerializeAsString(), optimized_graph.SerializeAsString());
+
+  // A second cache sharing the directory, e.g. in another process, sees the
+  // entry.
+  OptimizedGraphCache other_cache(Env::Default(), cache.directory());
+  TF_ASSERT_OK(other_cache.Lookup(key, &graph));
+
+  OptimizedGraphCache::Stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.insertions, 1);
+  EXPECT_EQ(stats.corrupt_entries, 0);
+}
+
+TEST(OptimizedGraphCacheTest, CorruptEntry) {
+  const string directory = TestDirectory("corrupt_entry");
+  OptimizedGraphCache cache(Env::Default(), directory);
+  const string key = Key(MakeItem(), ConfigProto(), nullptr);
+  TF_ASSERT_OK(cache.Insert(key, MakeItem().graph));
+
+  std::vector<string> children;
+  TF_ASSERT_OK(Env::Default()->GetChildren(directory, &children));
+  ASSERT_EQ(children.size(), 1);
+  const string path = io::JoinPath(directory, children[0]);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), path, &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path, contents));
+
+  GraphDef graph;
+  EXPECT_TRUE(errors::IsDataLoss(cache.Lookup(key, &graph)));
+  EXPECT_EQ(graph.node_size(), 0);
+  EXPECT_EQ(cache.stats().corrupt_entries, 1);
+  // The corrupt entry is deleted, so the next lookup misses.
+  EXPECT_TRUE(errors::IsNotFound(cache.Lookup(key, &graph)));
+}
+
+TEST(OptimizedGraphCacheTest, MisplacedEntry) {
+  const string directory = TestDirectory("misplaced_entry");
+  OptimizedGraphCache cache(Env::Default(), directory);
+  TF_ASSERT_OK(cache.Insert("key1", MakeItem().graph));
+  TF_ASSERT_OK(Env::Default()->RenameFile(
+      io::JoinPath(directory, "key1.grappler_cache"),
+      io::JoinPath(directory, "key2.grappler_cache")));
+
+  GraphDef graph;
+  EXPECT_TRUE(errors::IsDataLoss(cache.Lookup("key2", &graph)));
+}
+
+TEST(OptimizedGraphCacheTest, KeyDependsOnInputs) {
+  const GrapplerItem item = MakeItem();
+  const ConfigProto cfg;
+  const string key = Key(item, cfg, nullptr);
+  EXPECT_EQ(key, Key(MakeItem(), ConfigProto(), nullptr));
+
+  // The item id does not affect the optimizations.
+  GrapplerItem renamed_item = MakeItem();
+  renamed_item.id = "renamed";
+  EXPECT_EQ(key, Key(renamed_item, cfg, nullptr));
+
+  GrapplerItem other_graph = MakeItem();
+  other_graph.graph.mutable_node(1)->set_op("Snapshot");
+  EXPECT_NE(key, Key(other_graph, cfg, nullptr));
+
+  GrapplerItem other_fetch = MakeItem();
+  other_fetch.fetch = {"x"};
+  EXPECT_NE(key, Key(other_fetch, cfg, nullptr));
+
+  GrapplerItem other_options = MakeItem();
+  other_options.optimization_options().allow_non_differentiable_rewrites =
+      false;
+  EXPECT_NE(key, Key(other_options, cfg, nullptr));
+
+  GrapplerItem with_device = MakeItem();
+  TF_ASSERT_OK(
+      with_device.AddDevice("/job:localhost/replica:0/task:0/device:CPU:0"));
+  EXPECT_NE(key, Key(with_device, cfg, nullptr));
+
+  ConfigProto other_cfg;
+  other_cfg.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_constant_folding(RewriterConfig::OFF);
+  EXPECT_NE(key, Key(item, other_cfg, nullptr));
+
+  // The optimizers also read fields of the ConfigProto outside of the
+  // RewriterConfig.
+  ConfigProto jit_cfg;
+  jit_cfg.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_global_jit_level(OptimizerOptions::ON_1);
+  EXPECT_NE(key, Key(item, jit_cfg, nullptr));
+
+  ConfigProto executor_cfg;
+  executor_cfg.mutable_experimental()->set_executor_type("SINGLE_THREADED");
+  EXPECT_NE(key, Key(item, executor_cfg, nullptr));
+
+  ConfigProto custom_cfg;
+  auto* custom_optimizer = custom_cfg.mutable_graph_options()
+                               ->mutable_rewrite_options()
+                               ->add_custom_optimizers();
+  custom_optimizer->set_name("Custom");
+  const string custom_key = Key(item, custom_cfg, nullptr);
+  EXPECT_NE(key, custom_key);
+  (*custom_optimizer->mutable_parameter_map())["param"].set_i(1);
+  EXPECT_NE(custom_key, Key(item, custom_cfg, nullptr));
+
+  EXPECT_NE(key, Key(item, cfg, nullptr, /*has_cpu_device=*/true));
+
+  DeviceProperties cpu;
+  cpu.set_type("CPU");
+  VirtualCluster cpu_cluster({{"/CPU:0", cpu}});
+  DeviceProperties gpu;
+  gpu.set_type("GPU");
+  VirtualCluster gpu_cluster({{"/CPU:0", cpu}, {"/GPU:0", gpu}});
+  const string cpu_key = Key(item, cfg, &cpu_cluster);
+  EXPECT_NE(key, cpu_key);
+  EXPECT_NE(cpu_key, Key(item, cfg, &gpu_cluster));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <cmath>
+
 #include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/incremental_graph_properties.h"
 #include "tensorflow/core/grappler/graph_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -27,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/util.h"
@@ -48,9 +53,13 @@ namespace grappler {
 //   (1) Conv2D + BiasAdd + <Activation>
 //   (2) Conv2D + FusedBatchNorm + <Activation>
 //   (3) Conv2D + Squeeze + BiasAdd
+//   (4) Conv2D + BiasAdd + Add + <Activation>
+//   (5) Conv2D + BiasAdd + GeluApproximate
 //
 // MatMul + ... -> _FusedMatMul:
 //   (1) MatMul + BiasAdd + <Activation>
+//   (2) MatMul + BiasAdd + Add + <Activation>
+//   (3) MatMul + BiasAdd + GeluApproximate
 //
 // DepthwiseConv2dNative + ... -> _FusedDepthwiseConv2dNative:
 //   (1) DepthwiseConv2dNative + BiasAdd + <Activation>
@@ -60,6 +69,9 @@ namespace grappler {
 //   (2) FusedBatchNorm + SideInput + <Activation>
 //
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
+// The Add must not broadcast, and GeluApproximate is the tanh approximation
+// x * 0.5 * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))) built from
+// primitive ops. Patterns with Add and GeluApproximate are fused only on CPU.
 //
 // Both Conv2D and MatMul implemented as Tensor contraction (on CPU), so all the
 // patterns are "ContractionWith...".
@@ -171,7 +183,6 @@ struct ContractionWithBatchNormAndActivation {
   float epsilon = 0.0;
 };
 
-#ifdef INTEL_MKL
 // Contraction node followed by a BiasAdd and Add.
 struct ContractionWithBiasAddAndAdd {
   ContractionWithBiasAddAndAdd() = default;
@@ -205,7 +216,19 @@ struct ContractionWithBiasAndAddActivation {
   int port_id = 0;
   int activation = kMissingIndex;
 };
-#endif  // INTEL_MKL
+
+// Contraction node followed by a BiasAdd and the tanh approximation of Gelu:
+//   0.5 * x * (1 + Tanh(sqrt(2 / pi) * (x + 0.044715 * Pow(x, 3))))
+struct ContractionWithBiasAddAndGeluApproximate {
+  ContractionWithBiasAddAndGeluApproximate() = default;
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  // The Mul node that produces the output of the Gelu.
+  int gelu = kMissingIndex;
+  // The other nodes that compute the Gelu, not including its constants.
+  std::vector<int> gelu_nodes;
+};
 
 bool IsInPreserveSet(const RemapperContext& ctx, const NodeDef* node) {
   return ctx.nodes_to_preserve.count(node->name()) > 0;
@@ -625,7 +648,6 @@ bool FindConv2DWithBatchNormAndActivation(
   return true;
 }
 
-#ifdef INTEL_MKL
 // As AddN has multiple inputs, this function tries to find Conv2D + Bias
 // pattern in specific input port.
 bool FindContractionWithBiasInPort(const RemapperContext& ctx,
@@ -664,7 +686,9 @@ bool IsAddWithNoBroadcast(const RemapperContext& ctx, const NodeDef& node) {
 bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
                                       const utils::MutableNodeView& node_view,
                                       ContractionWithBiasAddAndAdd* matched) {
+#ifdef INTEL_MKL
   if (DisableMKL()) return false;
+#endif  // INTEL_MKL
   // Fusion with AddN is supported only when it has two inputs.
   // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(node_view) || node_view.NumRegularFanins() != 2)
@@ -675,6 +699,7 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
   const auto* node_def = node_view.node();
   if (!IsAddN(*node_def) && !IsAddWithNoBroadcast(ctx, *node_def)) return false;
 
+#ifdef INTEL_MKL
 #ifdef ENABLE_INTEL_MKL_BFLOAT16
   // MKL AddN ops only support float and bfloat16 data types.
   if (!HasDataType(node_def, DT_FLOAT) && !HasDataType(node_def, DT_BFLOAT16))
@@ -683,6 +708,7 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
   // MKL AddN ops only support float data type.
   if (!HasDataType(node_def, DT_FLOAT)) return false;
 #endif  // ENABLE_INTEL_MKL_BFLOAT16
+#endif  // INTEL_MKL
 
   ContractionWithBiasAdd base;
   matched->port_id = 0;
@@ -697,7 +723,18 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
     }
   }
 
-  // We successfully found a Conv2D+BiasAdd+{AddN,Add} pattern.
+  // MKL fuses the Add only into Conv2D. Eigen output kernels fuse it into
+  // Conv2D and MatMul on CPU.
+  const NodeDef& contraction = ctx.graph_view.graph()->node(base.contraction);
+#ifdef INTEL_MKL
+  if (!IsConv2D(contraction)) return false;
+#else
+  if ((!IsConv2D(contraction) && !IsMatMul(contraction)) ||
+      !HaveSameDataType(node_def, &contraction) || !IsCpuCompatible(ctx, base))
+    return false;
+#endif  // INTEL_MKL
+
+  // We successfully found a {Conv2D,MatMul}+BiasAdd+{AddN,Add} pattern.
   matched->contraction = base.contraction;
   matched->bias_add = base.bias_add;
   matched->add = node_view.node_index();
@@ -715,7 +752,9 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
 bool FindContractionWithBiasAndAddActivation(
     const RemapperContext& ctx, int node_index,
     ContractionWithBiasAndAddActivation* matched) {
+#ifdef INTEL_MKL
   if (DisableMKL()) return false;
+#endif  // INTEL_MKL
   const auto* node_view = ctx.graph_view.GetNode(node_index);
   // TODO(lyandy): Forward controls for patterns with control dependencies.
   if (HasControlFaninOrFanout(*node_view)) return false;
@@ -728,6 +767,7 @@ bool FindContractionWithBiasAndAddActivation(
   // Currently, Contraction + Bias + Add + Tanh pattern is not supported
   if (IsTanh(*node_def)) return false;
 
+#ifdef INTEL_MKL
 #ifdef ENABLE_INTEL_MKL_BFLOAT16
   // MKL activation op only supports float and bfloat16 data types.
   if (!HasDataType(node_def, DT_FLOAT) && !HasDataType(node_def, DT_BFLOAT16))
@@ -736,6 +776,10 @@ bool FindContractionWithBiasAndAddActivation(
   // MKL activation op only supports float data type.
   if (!HasDataType(node_def, DT_FLOAT)) return false;
 #endif  // ENABLE_INTEL_MKL_BFLOAT16
+#else
+  // Eigen output kernels do not support LeakyRelu after the Add.
+  if (IsLeakyRelu(*node_def)) return false;
+#endif  // INTEL_MKL
 
   // And input to activation must match ContractionWithBiasAddAndAdd pattern.
   if (node_view->NumRegularFanins() < 1) return false;
@@ -748,6 +792,14 @@ bool FindContractionWithBiasAndAddActivation(
     return false;
   }
 
+  // The Add is fused together with the activation, so it must have no other
+  // consumers.
+  const auto* add_node_def = add_node_view->node();
+  if (!HasAtMostOneFanoutAtPort0(*add_node_view) ||
+      !HaveSameDataType(node_def, add_node_def) ||
+      IsInPreserveSet(ctx, add_node_def))
+    return false;
+
   // Get the contraction node
   const auto* bias_add_node_view =
       add_node_view->GetRegularFanin(base.port_id).node_view();
@@ -758,14 +810,158 @@ bool FindContractionWithBiasAndAddActivation(
   // Currently, only conv + bias + add + leakyrelu is enabled
   if (!IsConv2D(*contraction_node_def) && IsLeakyRelu(*node_def)) return false;
 
-  // We successfully found a Conv2D+BiasAdd+AddN+activation pattern.
+  // We successfully found a {Conv2D,MatMul}+BiasAdd+{AddN,Add}+activation
+  // pattern.
   const ContractionWithBiasAndAddActivation pattern{
       base.contraction, base.bias_add, base.add, base.port_id, node_index};
   *matched = pattern;
 
   return true;
 }
-#endif
+
+// Returns true if `node` is a scalar constant of type `dtype` that is equal to
+// `value`, up to rounding.
+bool IsScalarConstWithValue(const NodeDef& node, DataType dtype,
+                            double value) {
+  if (!IsConstant(node) || !HasDataType(&node, dtype, "dtype")) return false;
+  const auto* value_attr = gtl::FindOrNull(node.attr(), "value");
+  Tensor tensor;
+  if (value_attr == nullptr || !tensor.FromProto(value_attr->tensor()) ||
+      tensor.NumElements() != 1) {
+    return false;
+  }
+  double actual;
+  switch (dtype) {
+    case DT_FLOAT:
+      actual = tensor.flat<float>()(0);
+      break;
+    case DT_DOUBLE:
+      actual = tensor.flat<double>()(0);
+      break;
+    default:
+      return false;
+  }
+  return std::abs(actual - value) <= 1e-5 * std::abs(value);
+}
+
+bool FindContractionWithBiasAddAndGeluApproximate(
+    const RemapperContext& ctx, int node_index,
+    ContractionWithBiasAddAndGeluApproximate* matched) {
+  using NodeView = utils::MutableNodeView;
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  // TODO(lyandy): Forward controls for patterns with control dependencies.
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  // Root of the pattern must be a Mul.
+  const auto* node_def = node_view->node();
+  if (!IsMul(*node_def) || node_view->NumRegularFanins() != 2) return false;
+  const DataType dtype = GetDataTypeFromAttr(*node_def, "T");
+  if (dtype != DT_FLOAT) return false;
+
+  std::vector<int> gelu_nodes;
+  // Returns the node read by regular fanin `port` of `view` if it is an
+  // intermediate node of the Gelu: an `is_op` node of type `dtype` whose
+  // output is used only once.
+  const auto intermediate = [&](const NodeView* view, int port,
+                                bool (*is_op)(const NodeDef&))
+      -> const NodeView* {
+    if (view == nullptr || port < 0 || port >= view->NumRegularFanins()) {
+      return nullptr;
+    }
+    const auto& fanin = view->GetRegularFanin(port);
+    const auto* fanin_view = fanin.node_view();
+    const auto* fanin_def = fanin_view->node();
+    if (fanin.index() != 0 || !is_op(*fanin_def) ||
+        !HasDataType(fanin_def, dtype) ||
+        HasControlFaninOrFanout(*fanin_view) ||
+        !HasAtMostOneFanoutAtPort0(*fanin_view) ||
+        IsInPreserveSet(ctx, fanin_def)) {
+      return nullptr;
+    }
+    gelu_nodes.push_back(fanin_view->node_index());
+    return fanin_view;
+  };
+  // Returns the port of the input of the binary node `view` other than the
+  // scalar constant `value`, or -1 if neither input is such a constant.
+  const auto other_port = [&](const NodeView* view, double value) -> int {
+    if (view == nullptr || view->NumRegularFanins() != 2) return -1;
+    for (int port = 0; port < 2; ++port) {
+      const auto* fanin_def = view->GetRegularFanin(port).node_view()->node();
+      if (IsScalarConstWithValue(*fanin_def, dtype, value)) return 1 - port;
+    }
+    return -1;
+  };
+  const auto fanin_def = [](const NodeView* view, int port) {
+    return view->GetRegularFanin(port).node_view()->node();
+  };
+
+  // All the uses of x must read output 0 of the same BiasAdd.
+  const NodeView* x = nullptr;
+  const auto reads_x = [&x](const NodeView* view, int port) {
+    const auto& fanin = view->GetRegularFanin(port);
+    if (fanin.index() != 0 || !IsBiasAdd(*fanin.node_view()->node())) {
+      return false;
+    }
+    if (x == nullptr) x = fanin.node_view();
+    return fanin.node_view() == x;
+  };
+
+  // The root is either x * (0.5 * (1 + tanh(...))), or
+  // (0.5 * x) * (1 + tanh(...)).
+  const NodeView* one_plus_tanh = nullptr;
+  const int x_port = IsBiasAdd(*fanin_def(node_view, 0)) ? 0 : 1;
+  if (reads_x(node_view, x_port)) {
+    const NodeView* half = intermediate(node_view, 1 - x_port, IsMul);
+    one_plus_tanh = intermediate(half, other_port(half, 0.5), IsAdd);
+  } else {
+    const int half_x_port = IsMul(*fanin_def(node_view, 0)) ? 0 : 1;
+    const NodeView* half_x = intermediate(node_view, half_x_port, IsMul);
+    const int half_x_x_port = other_port(half_x, 0.5);
+    if (half_x_x_port < 0 || !reads_x(half_x, half_x_x_port)) return false;
+    one_plus_tanh = intermediate(node_view, 1 - half_x_port, IsAdd);
+  }
+  const NodeView* tanh =
+      intermediate(one_plus_tanh, other_port(one_plus_tanh, 1.0), IsTanh);
+  const NodeView* scaled = intermediate(tanh, 0, IsMul);
+  const NodeView* inner =
+      intermediate(scaled, other_port(scaled, 0.7978845608028654), IsAdd);
+  if (inner == nullptr) return false;
+
+  // inner = x + 0.044715 * Pow(x, 3)
+  const int cube_port = IsMul(*fanin_def(inner, 0)) ? 0 : 1;
+  const NodeView* scaled_cube = intermediate(inner, cube_port, IsMul);
+  const NodeView* cube =
+      intermediate(scaled_cube, other_port(scaled_cube, 0.044715), IsPow);
+  if (cube == nullptr || cube->NumRegularFanins() != 2 ||
+      !IsScalarConstWithValue(*fanin_def(cube, 1), dtype, 3.0))
+    return false;
+
+  // The BiasAdd must be used only by the Gelu.
+  if (!reads_x(inner, 1 - cube_port) || !reads_x(cube, 0) ||
+      x->NumRegularFanouts() != 3)
+    return false;
+
+  ContractionWithBiasAdd base;
+  if (!FindContractionWithBias(ctx, x->node_index(), &base,
+                               /*check_device_compatible=*/false) ||
+      !HaveSameDataType(node_def, x->node()) ||
+      IsInPreserveSet(ctx, x->node()))
+    return false;
+
+  // Eigen output kernels compute the Gelu on CPU.
+  const NodeDef& contraction = ctx.graph_view.graph()->node(base.contraction);
+  if ((!IsConv2D(contraction) && !IsMatMul(contraction)) ||
+      !IsCpuCompatible(ctx, base))
+    return false;
+
+  // We successfully found a {Conv2D,MatMul}+BiasAdd+GeluApproximate pattern.
+  matched->contraction = base.contraction;
+  matched->bias_add = base.bias_add;
+  matched->gelu = node_index;
+  matched->gelu_nodes = std::move(gelu_nodes);
+
+  return true;
+}
 
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
@@ -1274,7 +1470,6 @@ Status AddFusedConv2DNode(RemapperContext* ctx,
   return Status::OK();
 }
 
-#ifdef INTEL_MKL
 Status AddFusedContractionNode(RemapperContext* ctx,
                                const ContractionWithBiasAddAndAdd& matched,
                                std::vector<bool>* invalidated_nodes,
@@ -1282,29 +1477,36 @@ Status AddFusedContractionNode(RemapperContext* ctx,
   const GraphDef* graph = ctx->graph_view.graph();
   const NodeDef& contraction = graph->node(matched.contraction);
   const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& add = graph->node(matched.add);
 
-  // MKL version only support fusion for Conv2D
-  DCHECK(IsConv2D(contraction));
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and Add:"
+          << " add=" << add.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
 
-  NodeDef fused_conv2d;
-  const NodeDef& add = graph->node(matched.add);
-  fused_conv2d.set_name(add.name());
-  fused_conv2d.set_op(kFusedConv2D);
-  fused_conv2d.set_device(contraction.device());
-  fused_conv2d.add_input(contraction.input(0));  // 0: input
-  fused_conv2d.add_input(contraction.input(1));  // 1: filter
-  fused_conv2d.add_input(bias_add.input(1));     // 2: bias
+  NodeDef fused_op;
+  fused_op.set_name(add.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
 
   // Add OP has two inputs, one is conv+bias pattern matched previously,
   // the other input to add is fused here.
-  fused_conv2d.add_input(add.input(1 - matched.port_id));
+  fused_op.add_input(add.input(1 - matched.port_id));  // 3: add
 
-  CopyConv2DAttributes(contraction, &fused_conv2d);
-  SetFusedOpAttributes(&fused_conv2d, {"BiasAdd", "Add"}, 2);
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "Add"}, 2);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
-  mutation->AddNode(std::move(fused_conv2d), &status);
+  mutation->AddNode(std::move(fused_op), &status);
   TF_RETURN_IF_ERROR(status);
   TF_RETURN_IF_ERROR(mutation->Apply());
 
@@ -1319,31 +1521,42 @@ Status AddFusedContractionNode(
     RemapperContext* ctx, const ContractionWithBiasAndAddActivation& matched,
     std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
   const GraphDef* graph = ctx->graph_view.graph();
-  // MKL version only support fusion for Conv2D
   const NodeDef& contraction = graph->node(matched.contraction);
-  DCHECK(IsConv2D(contraction));
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& add = graph->node(matched.add);
   const NodeDef& activation = graph->node(matched.activation);
 
-  NodeDef fused_conv2d;
-  fused_conv2d.set_name(activation.name());
-  fused_conv2d.set_op(kFusedConv2D);
-  fused_conv2d.set_device(contraction.device());
-  fused_conv2d.add_input(contraction.input(0));  // 0: input
-  fused_conv2d.add_input(contraction.input(1));  // 1: filter
-  const NodeDef& bias_add = graph->node(matched.bias_add);
-  fused_conv2d.add_input(bias_add.input(1));  // 2: bias
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd, Add and "
+          << activation.op() << ":"
+          << " activation=" << activation.name() << " add=" << add.name()
+          << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(activation.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
 
   // Add OP has two inputs, one is conv+bias pattern matched previously,
   // the other input to add is fused here.
-  const NodeDef& add = graph->node(matched.add);
-  fused_conv2d.add_input(add.input(1 - matched.port_id));
+  fused_op.add_input(add.input(1 - matched.port_id));  // 3: add
 
-  CopyConv2DAttributes(contraction, &fused_conv2d);
-  SetFusedOpAttributes(&fused_conv2d, {"BiasAdd", "Add", activation.op()}, 2);
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    // leaky relu has a special attribute alpha
+    CopyConv2DAttributes(contraction, &fused_op, &activation);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "Add", activation.op()}, 2);
 
   utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
   Status status;
-  mutation->AddNode(std::move(fused_conv2d), &status);
+  mutation->AddNode(std::move(fused_op), &status);
   TF_RETURN_IF_ERROR(status);
   TF_RETURN_IF_ERROR(mutation->Apply());
 
@@ -1354,7 +1567,53 @@ Status AddFusedContractionNode(
 
   return Status::OK();
 }
-#endif
+
+Status AddFusedContractionNode(
+    RemapperContext* ctx,
+    const ContractionWithBiasAddAndGeluApproximate& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& gelu = graph->node(matched.gelu);
+
+  VLOG(2) << "Fuse " << contraction.op() << " with BiasAdd and "
+          << "GeluApproximate:"
+          << " gelu=" << gelu.name() << " bias_add=" << bias_add.name()
+          << " contraction=" << contraction.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(gelu.name());
+  fused_op.set_device(contraction.device());
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
+  fused_op.add_input(bias_add.input(1));     // 2: bias
+
+  if (IsConv2D(contraction)) {
+    fused_op.set_op(kFusedConv2D);
+    CopyConv2DAttributes(contraction, &fused_op);
+  } else if (IsMatMul(contraction)) {
+    fused_op.set_op(kFusedMatMul);
+    CopyMatMulAttributes(contraction, &fused_op);
+  }
+
+  SetFusedOpAttributes(&fused_op, {"BiasAdd", "GeluApproximate"});
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.gelu] = true;
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  for (int gelu_node : matched.gelu_nodes) {
+    (*nodes_to_delete)[gelu_node] = true;
+  }
+
+  return Status::OK();
+}
 
 Status AddFusedBatchNormExNode(RemapperContext* ctx,
                                const FusedBatchNormEx& matched,
@@ -1667,6 +1926,7 @@ bool IsConv2DWithAdd(const RemapperContext& ctx, int node_index) {
 //   (2) Fusing side input and/or activation into FusedBatchNorm.
 //   (3) Fusing Conv2D biasadd and relu on GPU
 //   (4) INTEL_MKL specific: Conv2D -> Add or Conv2D -> BiasAdd -> Add.
+//   (5) Fusing {Conv2D,MatMul} + BiasAdd + Add (+ activation) on CPU.
 bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   // Candidate for a FusedBatchNorm splitting.
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1741,8 +2001,34 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index) {
   return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
          IsConv2DWithAdd(ctx, node_index);
 #else
+  // Candidate for a {Conv2D,MatMul} + BiasAdd + Add (+ activation) fusion,
+  // that must check that the Add does not broadcast.
+  const auto is_contraction_with_bias_add_and_add_candidate = [&]() -> bool {
+    const auto* add_node_view = node_view;
+    if (IsSupportedActivation(*node_def)) {
+      if (node_view->NumRegularFanins() < 1) return false;
+      add_node_view = node_view->GetRegularFanin(0).node_view();
+    }
+    const auto* add_node_def = add_node_view->node();
+    if (!IsAdd(*add_node_def) && !IsAddN(*add_node_def)) return false;
+    if (add_node_view->NumRegularFanins() != 2) return false;
+
+    for (int i = 0; i < 2; ++i) {
+      const auto* bias_add_node_view =
+          add_node_view->GetRegularFanin(i).node_view();
+      if (!IsBiasAdd(*bias_add_node_view->node())) continue;
+      if (bias_add_node_view->NumRegularFanins() < 1) continue;
+      const auto* contraction_node_def =
+          bias_add_node_view->GetRegularFanin(0).node_view()->node();
+      if (IsConv2D(*contraction_node_def) || IsMatMul(*contraction_node_def))
+        return true;
+    }
+    return false;
+  };
+
   return is_relu_biasadd_conv2d_candidate() || is_batch_norm_candidate() ||
-         is_batch_norm_fusion_candidate();
+         is_batch_norm_fusion_candidate() ||
+         is_contraction_with_bias_add_and_add_candidate();
 #endif  // INTEL_MKL
 }
 
@@ -1779,48 +2065,39 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
     // Infer properties lazily in case they are not needed.
     if (!ctx.inferred_graph_properties && RequiresInferredShapes(ctx, i)) {
       const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
-      TF_RETURN_IF_ERROR(ctx.graph_properties.InferStatically(
-          assume_valid_feeds,
-          /*aggressive_shape_inference=*/false,
+      TF_RETURN_IF_ERROR(InferStatically(
+          incremental_graph_properties(), assume_valid_feeds,
           /*include_input_tensor_values=*/true,
-          /*include_output_tensor_values=*/false));
+          /*include_output_tensor_values=*/false, &ctx.graph_properties));
       ctx.inferred_graph_properties = true;
     }
 
 #ifdef INTEL_MKL
-    ContractionWithBiasAddAndAdd contract_with_bias_and_add;
-    ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
+    const bool allow_add_rewrites = !item.optimization_options().is_eager_mode;
+#else
+    const bool allow_add_rewrites = allow_non_differentiable_rewrites;
+#endif  // INTEL_MKL
 
-    if (!item.optimization_options().is_eager_mode) {
-      // Remap Conv2D+BiasAdd+Add+relu into the _FusedConv2D.
-      if (FindContractionWithBiasAndAddActivation(
-              ctx, i, &contract_with_bias_and_add_activation)) {
-        TF_RETURN_IF_ERROR(
-            AddFusedContractionNode(&ctx, contract_with_bias_and_add_activation,
-                                    &invalidated_nodes, &nodes_to_delete));
-        continue;
-      }
-
-      // Remap Conv2D+BiasAdd+Add into the _FusedConv2D.
-      if (FindContractionWithBiasAddAndAdd(ctx, i,
-                                           &contract_with_bias_and_add)) {
-        TF_RETURN_IF_ERROR(
-            AddFusedContractionNode(&ctx, contract_with_bias_and_add,
-                                    &invalidated_nodes, &nodes_to_delete));
-        continue;
-      }
+    // Remap {Conv2D,MatMul}+BiasAdd+Add+Activation into the
+    // _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
+    if (allow_add_rewrites &&
+        FindContractionWithBiasAndAddActivation(
+            ctx, i, &contract_with_bias_and_add_activation)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_add_activation,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
     }
-#endif  //! INTEL_MKL
 
-    // Infer properties lazily in case they are not needed.
-    if (!ctx.inferred_graph_properties && RequiresInferredShapes(ctx, i)) {
-      const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
-      TF_RETURN_IF_ERROR(ctx.graph_properties.InferStatically(
-          assume_valid_feeds,
-          /*aggressive_shape_inference=*/false,
-          /*include_input_tensor_values=*/true,
-          /*include_output_tensor_values=*/false));
-      ctx.inferred_graph_properties = true;
+    // Remap {Conv2D,MatMul}+BiasAdd+Add into the _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndAdd contract_with_bias_and_add;
+    if (allow_add_rewrites &&
+        FindContractionWithBiasAddAndAdd(ctx, i, &contract_with_bias_and_add)) {
+      TF_RETURN_IF_ERROR(AddFusedContractionNode(
+          &ctx, contract_with_bias_and_add, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
     }
 
     // Remap {Conv2D,DepthwiseConv2D,MatMul}+BiasAdd into the
@@ -1852,6 +2129,18 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
 // TODO(penporn):
 // Remove this once TF-MKL supports _FusedConv2D with these operations.
 #ifndef INTEL_MKL
+    // Remap {Conv2D,MatMul}+BiasAdd+GeluApproximate into the
+    // _Fused{Conv2D,MatMul}.
+    ContractionWithBiasAddAndGeluApproximate contract_with_bias_and_gelu;
+    if (allow_non_differentiable_rewrites &&
+        FindContractionWithBiasAddAndGeluApproximate(
+            ctx, i, &contract_with_bias_and_gelu)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedContractionNode(&ctx, contract_with_bias_and_gelu,
+                                  &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
     // Remap Conv2D+Squeeze+BiasAdd into the _FusedConv2D+Squeeze.
     ContractionWithSqueezeAndBiasAdd contract_with_squeeze_and_bias;
     if (allow_non_differentiable_rewrites &&
@@ -978,6 +978,229 @@ TEST_F(RemapperTest, FuseConv2DWithSqueezeAndBias) {
   ASSERT_EQ(tensors.size(), 1);
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAddAndAdd) {
+  using ::tensorflow::ops::Placeholder;
+
+  for (const string& activation : {"None", "Relu", "Relu6", "Elu"}) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto lhs_shape = ops::Placeholder::Shape({8, 32});
+    auto rhs_shape = ops::Placeholder::Shape({32, 64});
+    auto bias_shape = ops::Placeholder::Shape({64});
+    auto residual_shape = ops::Placeholder::Shape({8, 64});
+
+    auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+    auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+    auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+    auto residual =
+        Placeholder(s.WithOpName("residual"), DT_FLOAT, residual_shape);
+
+    auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+    auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+    auto add = ops::AddV2(s.WithOpName("add"), residual, bias_add);
+
+    ops::Identity fetch = [&]() -> ops::Identity {
+      auto activate = s.WithOpName("activation");
+      auto fetch = s.WithOpName("fetch");
+
+      if (activation == "Relu") {
+        return ops::Identity(fetch, ops::Relu(activate, add));
+      } else if (activation == "Relu6") {
+        return ops::Identity(fetch, ops::Relu6(activate, add));
+      } else if (activation == "Elu") {
+        return ops::Identity(fetch, ops::Elu(activate, add));
+      }
+
+      return ops::Identity(fetch, add);
+    }();
+
+    auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+    auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+    auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+    auto residual_t = GenerateRandomTensor<DT_FLOAT>({8, 64});
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"lhs", lhs_t},
+                 {"rhs", rhs_t},
+                 {"bias", bias_t},
+                 {"residual", residual_t}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+    // Place all nodes on CPU.
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    const string fused_node = activation == "None" ? "add" : "activation";
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "matmul");
+      EXPECT_NE(node.name(), "bias_add");
+      if (node.name() == fused_node) {
+        EXPECT_EQ(node.op(), "_FusedMatMul");
+        ASSERT_EQ(node.input_size(), 4);
+        EXPECT_EQ(node.input(0), "lhs");
+        EXPECT_EQ(node.input(1), "rhs");
+
+        EXPECT_EQ(node.attr().at("num_args").i(), 2);
+        EXPECT_EQ(node.input(2), "bias");
+        EXPECT_EQ(node.input(3), "residual");
+
+        const auto fused_ops = node.attr().at("fused_ops").list().s();
+        if (activation == "None") {
+          ASSERT_EQ(fused_ops.size(), 2);
+        } else {
+          ASSERT_EQ(fused_ops.size(), 3);
+          EXPECT_EQ(fused_ops[2], activation);
+        }
+        EXPECT_EQ(fused_ops[0], "BiasAdd");
+        EXPECT_EQ(fused_ops[1], "Add");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
+  }
+}
+
+TEST_F(RemapperTest, DoNotFuseMatMulWithBiasAddAndBroadcastingAdd) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({8, 32}));
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT,
+                         ops::Placeholder::Shape({32, 64}));
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                          ops::Placeholder::Shape({64}));
+  auto row = Placeholder(s.WithOpName("row"), DT_FLOAT,
+                         ops::Placeholder::Shape({1, 64}));
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+  auto add = ops::AddV2(s.WithOpName("add"), bias_add, row);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), add);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Only the BiasAdd is fused.
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    if (node.name() == "bias_add") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      found++;
+    } else if (node.name() == "add") {
+      EXPECT_EQ(node.op(), "AddV2");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+}
+
+TEST_F(RemapperTest, FuseMatMulWithBiasAddAndGeluApproximate) {
+  using ::tensorflow::ops::Placeholder;
+
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto lhs_shape = ops::Placeholder::Shape({8, 32});
+  auto rhs_shape = ops::Placeholder::Shape({32, 64});
+  auto bias_shape = ops::Placeholder::Shape({64});
+
+  auto lhs = Placeholder(s.WithOpName("lhs"), DT_FLOAT, lhs_shape);
+  auto rhs = Placeholder(s.WithOpName("rhs"), DT_FLOAT, rhs_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, bias_shape);
+
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), lhs, rhs);
+  auto x = ops::BiasAdd(s.WithOpName("bias_add"), matmul, bias);
+
+  // gelu = x * 0.5 * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+  auto three = ops::Const(s.WithOpName("three"), 3.0f);
+  auto coeff = ops::Const(s.WithOpName("coeff"), 0.044715f);
+  auto sqrt_2_over_pi =
+      ops::Const(s.WithOpName("sqrt_2_over_pi"), 0.7978845608f);
+  auto one = ops::Const(s.WithOpName("one"), 1.0f);
+  auto half = ops::Const(s.WithOpName("half"), 0.5f);
+
+  auto cube = ops::Pow(s.WithOpName("cube"), x, three);
+  auto scaled_cube = ops::Mul(s.WithOpName("scaled_cube"), coeff, cube);
+  auto inner = ops::AddV2(s.WithOpName("inner"), x, scaled_cube);
+  auto scaled = ops::Mul(s.WithOpName("scaled"), sqrt_2_over_pi, inner);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), scaled);
+  auto one_plus_tanh = ops::AddV2(s.WithOpName("one_plus_tanh"), one, tanh);
+  auto half_x = ops::Mul(s.WithOpName("half_x"), half, x);
+  auto gelu = ops::Mul(s.WithOpName("gelu"), half_x, one_plus_tanh);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), gelu);
+
+  auto lhs_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto rhs_t = GenerateRandomTensor<DT_FLOAT>({32, 64});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({64});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"lhs", lhs_t}, {"rhs", rhs_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    for (const string& name : {"matmul", "bias_add", "cube", "scaled_cube",
+                               "inner", "scaled", "tanh", "one_plus_tanh",
+                               "half_x"}) {
+      EXPECT_NE(node.name(), name);
+    }
+    if (node.name() == "gelu") {
+      EXPECT_EQ(node.op(), "_FusedMatMul");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "lhs");
+      EXPECT_EQ(node.input(1), "rhs");
+
+      EXPECT_EQ(node.attr().at("num_args").i(), 1);
+      EXPECT_EQ(node.input(2), "bias");
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 2);
+      EXPECT_EQ(fused_ops[0], "BiasAdd");
+      EXPECT_EQ(fused_ops[1], "GeluApproximate");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-5);
+}
 #endif  // !INTEL_MKL
 
 }  // namespace grappler
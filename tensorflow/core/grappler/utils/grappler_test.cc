@@ -77,6 +77,7 @@ void SetAllOptimizers(RewriterConfig* cfg, RewriterConfig::Toggle value) {
   cfg->set_constant_folding(value);
   cfg->set_debug_stripper(value);
   cfg->set_dependency_optimization(value);
+  cfg->set_elementwise_fusion(value);
   cfg->set_function_optimization(value);
   cfg->set_implementation_selector(value);
   cfg->set_layout_optimizer(value);
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -70,6 +71,7 @@ class BatchResource : public serving::BatchResourceBase {
                        const std::vector<int32>& allowed_batch_sizes,
                        FunctionLibraryRuntime::Handle fhandle,
                        bool enable_large_batch_splitting,
+                       int64 target_latency_micros,
                        std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
@@ -82,7 +84,7 @@ class BatchResource : public serving::BatchResourceBase {
                                batch_timeout_micros, max_enqueued_batches,
                                allowed_batch_sizes,
                                enable_large_batch_splitting),
-        allowed_batch_sizes));
+        allowed_batch_sizes, target_latency_micros));
     return Status::OK();
   }
 
@@ -92,11 +94,12 @@ class BatchResource : public serving::BatchResourceBase {
   BatchResource(FunctionLibraryRuntime::Handle fhandle,
                 std::shared_ptr<BatcherT> batcher,
                 const BatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                int64 target_latency_micros)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), target_latency_micros),
         fhandle_(fhandle) {}
 
   void ProcessFuncBatchImpl(
@@ -164,6 +167,12 @@ class BatchFunctionKernel : public AsyncOpKernel {
       has_attribute_enable_large_batch_splitting_ = false;
     }
 
+    // When set, batch sizes and timeouts are tuned to keep the latency of
+    // each call under this target, instead of using `batch_timeout_micros`.
+    OP_REQUIRES_OK(c, ReadInt64FromEnvVar(
+                          "TF_BATCH_FUNCTION_TARGET_LATENCY_MICROS",
+                          /*default_val=*/0, &target_latency_micros_));
+
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
   }
 
@@ -181,7 +190,8 @@ class BatchFunctionKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, fhandle_,
-          enable_large_batch_splitting_, &new_resource));
+          enable_large_batch_splitting_, target_latency_micros_,
+          &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
@@ -234,6 +244,7 @@ class BatchFunctionKernel : public AsyncOpKernel {
   FunctionLibraryRuntime::Handle fhandle_;
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
+  int64 target_latency_micros_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("BatchFunction").Device(DEVICE_CPU),
@@ -267,7 +278,7 @@ class BatchKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle, false,
-          &new_resource));
+          /*target_latency_micros=*/0, &new_resource));
       *r = new_resource.release();
       return Status::OK();
     };
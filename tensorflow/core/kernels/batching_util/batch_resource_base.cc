@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/percentile_sampler.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/util/incremental_barrier.h"
@@ -74,6 +75,30 @@ void RecordBatchDelayMs(int64 batch_delay_ms, const string& model_name) {
   cell->GetCell(model_name)->Add(static_cast<double>(batch_delay_ms));
 }
 
+void RecordQueuingDelayUsecs(int64 queuing_delay_usecs,
+                             const string& model_name) {
+  static auto* cell = monitoring::Sampler<1>::New(
+      {"/tensorflow/serving/batching/queuing_delay_usecs",
+       "Histogram of the time inputs wait to be processed, from being "
+       "batched until their batch is processed, by model_name (if "
+       "available).",
+       "model_name"},
+      // Power of 2 buckets from 10us to about 80s.
+      monitoring::Buckets::Exponential(10, 2, 24));
+  cell->GetCell(model_name)->Add(static_cast<double>(queuing_delay_usecs));
+}
+
+void RecordBatchFillRatio(double fill_ratio, const string& model_name) {
+  static auto* cell = monitoring::Sampler<1>::New(
+      {"/tensorflow/serving/batching/batch_fill_ratio",
+       "Histogram of the ratio of processed batch sizes, before padding, to "
+       "the maximum batch size, by model_name (if available).",
+       "model_name"},
+      monitoring::Buckets::Explicit(
+          {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0}));
+  cell->GetCell(model_name)->Add(fill_ratio);
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -439,7 +464,32 @@ Status BatchResourceBase::SplitOutputTensors(
   return Status::OK();
 }
 
-void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
+void BatchResourceBase::RecordBatchStart(const BatchT& batch,
+                                         const string& model_name,
+                                         LatencySloBatchTuner* tuner) const {
+  const uint64 current_time = EnvTime::NowNanos();
+  uint64 max_queuing_delay = 0;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    const uint64 queuing_delay = current_time - batch.task(i).start_time;
+    RecordQueuingDelayUsecs(queuing_delay / EnvTime::kMicrosToNanos,
+                            model_name);
+    max_queuing_delay = std::max(max_queuing_delay, queuing_delay);
+  }
+  int64 max_batch_size =
+      batcher_queue_options_.enable_large_batch_splitting
+          ? batcher_queue_options_.max_execution_batch_size
+          : batcher_queue_options_.input_batch_size_limit;
+  if (tuner != nullptr) {
+    tuner->RecordQueueingDelay(max_queuing_delay / EnvTime::kMicrosToNanos);
+    max_batch_size = tuner->decision().batch_size;
+  }
+  RecordBatchFillRatio(
+      std::min(1.0, static_cast<double>(batch.size()) / max_batch_size),
+      model_name);
+}
+
+void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch,
+                                         LatencySloBatchTuner* tuner) const {
   if (batch->empty()) {
     return;
   }
@@ -500,11 +550,18 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
     RecordBatchDelayMs((current_time - batch->task(i).start_time) * 1e-6,
                        model_name);
   }
+  RecordBatchStart(*batch, model_name, tuner);
+  const int padded_batch_size = RoundToLowestAllowedBatchSize(batch->size());
   // Releases the cleanup method here, because the callback of the function
   // library runtime will handle it now.
   finally.release();
   ProcessFuncBatchImpl(
       last_task, args, &combined_outputs, [&](const Status& run_status) {
+        if (tuner != nullptr && run_status.ok()) {
+          tuner->RecordBatchCost(
+              padded_batch_size,
+              (EnvTime::NowNanos() - current_time) / EnvTime::kMicrosToNanos);
+        }
         Status final_status;
         auto run_finally = gtl::MakeCleanup([&]() {
           // We do the cleanup here as an optimization, so that
@@ -538,6 +595,7 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
 
   OP_REQUIRES_OK_ASYNC(last_task_context, ValidateBatch(*batch),
                        last_task_callback);
+  RecordBatchStart(*batch, GetModelName(last_task_context), /*tuner=*/nullptr);
 
   // All tasks should have the same number of input edges.
   const int num_input_edges = batch->task(0).inputs.size();
@@ -624,21 +682,54 @@ Status BatchResourceBase::LookupOrCreateBatcherQueue(const string& queue_name,
     return Status::OK();
   }
 
+  std::shared_ptr<LatencySloBatchTuner> tuner;
+  TF_RETURN_IF_ERROR(MaybeCreateLatencySloBatchTuner(&tuner));
+  BatcherT::QueueOptions queue_options = batcher_queue_options_;
+  queue_options.latency_slo_batch_tuner = tuner;
+
   std::unique_ptr<BatcherQueueT> new_queue;
-  auto process_batch_callback = [this](std::unique_ptr<BatchT> batch) {
+  auto process_batch_callback = [this, tuner](std::unique_ptr<BatchT> batch) {
     if (!has_process_batch_function_) {
       ProcessBatch(std::move(batch));
     } else {
-      ProcessFuncBatch(std::move(batch));
+      ProcessFuncBatch(std::move(batch), tuner.get());
     }
   };
-  TF_RETURN_IF_ERROR(batcher_->AddQueue(batcher_queue_options_,
-                                        process_batch_callback, &new_queue));
+  TF_RETURN_IF_ERROR(
+      batcher_->AddQueue(queue_options, process_batch_callback, &new_queue));
   *queue = new_queue.get();
   batcher_queues_[queue_name] = std::move(new_queue);
   return Status::OK();
 }
 
+Status BatchResourceBase::MaybeCreateLatencySloBatchTuner(
+    std::shared_ptr<LatencySloBatchTuner>* tuner) const {
+  // The cost of a batch is only known when it is processed by the batch
+  // function.
+  if (target_latency_micros_ <= 0 || !has_process_batch_function_) {
+    return Status::OK();
+  }
+  LatencySloBatchTuner::Options options;
+  options.target_latency_micros = target_latency_micros_;
+  if (!allowed_batch_sizes_.empty()) {
+    options.batch_sizes = allowed_batch_sizes_;
+  } else {
+    // Powers of two up to the maximum batch size.
+    const int32 max_batch_size =
+        batcher_queue_options_.enable_large_batch_splitting
+            ? batcher_queue_options_.max_execution_batch_size
+            : batcher_queue_options_.input_batch_size_limit;
+    for (int32 size = 1; size < max_batch_size; size *= 2) {
+      options.batch_sizes.push_back(size);
+    }
+    options.batch_sizes.push_back(max_batch_size);
+  }
+  std::unique_ptr<LatencySloBatchTuner> new_tuner;
+  TF_RETURN_IF_ERROR(LatencySloBatchTuner::Create(options, &new_tuner));
+  *tuner = std::move(new_tuner);
+  return Status::OK();
+}
+
 Status BatchResourceBase::CreateBatchTask(
     OpKernelContext* context,
     std::unique_ptr<BatchResourceBase::BatchTask>* output) const {
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_tuner.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
 #include "tensorflow/core/platform/context.h"
@@ -99,14 +100,21 @@ class BatchResourceBase : public ResourceBase {
   using BatcherQueueT = BatchScheduler<BatchResourceBase::BatchTask>;
   using BatchT = Batch<BatchResourceBase::BatchTask>;
 
+  // If `target_latency_micros` is positive, each batcher queue picks the size
+  // and timeout of its batches to maximize throughput while keeping the
+  // latency of batch function calls under that target; see
+  // LatencySloBatchTuner. Batch sizes are then bounded by the configured
+  // maximum batch size, and `allowed_batch_sizes` if set.
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<BatcherT> batcher,
                     const BatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    int64 target_latency_micros = 0)
       : has_process_batch_function_(has_process_batch_function),
         batcher_(std::move(batcher)),
         batcher_queue_options_(batcher_queue_options),
-        allowed_batch_sizes_(std::move(allowed_batch_sizes)) {}
+        allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+        target_latency_micros_(target_latency_micros) {}
 
   static BatcherT::QueueOptions GetBatcherQueueOptions(
       int32 num_batch_threads, int32 max_batch_size, int32 batch_timeout_micros,
@@ -160,7 +168,10 @@ class BatchResourceBase : public ResourceBase {
   Status SplitOutputTensors(const std::vector<Tensor>& combined_outputs,
                             BatchT* batch) const;
 
-  void ProcessFuncBatch(std::unique_ptr<BatchT> batch) const;
+  // Processes a batch with the batch function. `tuner`, if not null, is told
+  // how long it took.
+  void ProcessFuncBatch(std::unique_ptr<BatchT> batch,
+                        LatencySloBatchTuner* tuner) const;
 
   // Processes a batch of one or more BatchTask entries.
   void ProcessBatch(std::unique_ptr<BatchT> batch) const;
@@ -175,6 +186,15 @@ class BatchResourceBase : public ResourceBase {
   static Status EmitIndexTensor(OpKernelContext* context, const BatchT& batch,
                                 int output_index);
 
+  // Records the queueing delay and fill ratio of 'batch' in the batching
+  // metrics, and tells `tuner` about the delay if it is not null.
+  void RecordBatchStart(const BatchT& batch, const string& model_name,
+                        LatencySloBatchTuner* tuner) const;
+
+  // Creates the tuner for a new batcher queue, if a target latency is set.
+  Status MaybeCreateLatencySloBatchTuner(
+      std::shared_ptr<LatencySloBatchTuner>* tuner) const;
+
   // Looks up the batcher queue for 'queue_name'. If it did't previously exist,
   // creates it.
   Status LookupOrCreateBatcherQueue(const string& queue_name,
@@ -194,6 +214,10 @@ class BatchResourceBase : public ResourceBase {
       TF_GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  // The target latency of batch function calls, or 0 to use fixed batch sizes
+  // and timeouts.
+  const int64 target_latency_micros_;
 };
 
 }  // namespace serving
@@ -0,0 +1,263 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_TUNER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_TUNER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Picks the size and timeout of batches so as to maximize throughput while
+// keeping the latency of each task under a target.
+//
+// The latency of a task is bounded by the batch timeout, the time its batch
+// waits for a batch thread once closed, and the time to process the batch. The
+// tuner learns the processing cost of each candidate batch size online, as a
+// moving average plus a multiple of the moving mean absolute deviation, which
+// stands in for a high percentile of the cost. It also learns how long closed
+// batches wait for a thread. It then picks the candidate size with the highest
+// estimated throughput (batch size over cost) whose cost fits in the target,
+// and gives the rest of the target to the batch timeout.
+//
+// Sizes that have not been measured yet are assumed to cost as much per task
+// as the closest smaller measured size. Among sizes of equal throughput the
+// largest one is picked, so the tuner keeps trying larger batches as long as
+// they fit in the target and are not slower per task.
+//
+// This class is thread-safe.
+class LatencySloBatchTuner {
+ public:
+  struct Options {
+    // The target latency of a task, from when it is scheduled until its batch
+    // has been processed.
+    int64 target_latency_micros = 0;
+
+    // The batch sizes to choose from, in increasing order. Recorded batches
+    // are attributed to the smallest candidate size they fit in.
+    std::vector<int32> batch_sizes;
+
+    // The weight of a new measurement in the moving averages.
+    double cost_decay = 0.1;
+
+    // How many mean absolute deviations above the mean cost to budget for each
+    // batch.
+    double deviation_multiplier = 3.0;
+  };
+
+  // The size limit and timeout of the next batch.
+  struct Decision {
+    int32 batch_size = 0;
+    int64 batch_timeout_micros = 0;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<LatencySloBatchTuner>* tuner);
+
+  // Records that a batch of `batch_size` tasks, after padding, took
+  // `cost_micros` to process.
+  void RecordBatchCost(int32 batch_size, int64 cost_micros);
+
+  // Records that the oldest task of a batch waited `delay_micros` between
+  // being scheduled and its batch starting to be processed.
+  void RecordQueueingDelay(int64 delay_micros);
+
+  // Returns the current choice of batch size and timeout. Until the first
+  // batch has been measured, batches of the largest size are closed as soon
+  // as a batch thread is available.
+  Decision decision() const;
+
+  // Returns the estimated cost of a batch of the `i`th candidate size, or a
+  // negative number if no batch has been measured yet.
+  double EstimatedCostMicros(int i) const;
+
+ private:
+  struct CostEstimate {
+    int64 num_samples = 0;
+    double mean_micros = 0;
+    double deviation_micros = 0;
+  };
+
+  explicit LatencySloBatchTuner(const Options& options);
+
+  static void Update(double sample, double decay, CostEstimate* estimate);
+
+  double EstimatedCostMicrosLocked(int i) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Recomputes `decision_` from the current estimates.
+  void UpdateDecision() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+  // Indexed like `options_.batch_sizes`.
+  std::vector<CostEstimate> costs_ TF_GUARDED_BY(mu_);
+  // How long closed batches wait for a batch thread.
+  CostEstimate thread_wait_ TF_GUARDED_BY(mu_);
+  Decision decision_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LatencySloBatchTuner);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+inline Status LatencySloBatchTuner::Create(
+    const Options& options, std::unique_ptr<LatencySloBatchTuner>* tuner) {
+  if (options.target_latency_micros <= 0) {
+    return errors::InvalidArgument(
+        "target_latency_micros must be positive; was ",
+        options.target_latency_micros);
+  }
+  if (options.batch_sizes.empty()) {
+    return errors::InvalidArgument("batch_sizes must not be empty");
+  }
+  for (int i = 0; i < options.batch_sizes.size(); ++i) {
+    if (options.batch_sizes[i] <= 0 ||
+        (i > 0 && options.batch_sizes[i] <= options.batch_sizes[i - 1])) {
+      return errors::InvalidArgument(
+          "batch_sizes must be positive and strictly increasing");
+    }
+  }
+  if (options.cost_decay <= 0 || options.cost_decay > 1) {
+    return errors::InvalidArgument("cost_decay must be in (0, 1]; was ",
+                                   options.cost_decay);
+  }
+  if (options.deviation_multiplier < 0) {
+    return errors::InvalidArgument(
+        "deviation_multiplier must be non-negative; was ",
+        options.deviation_multiplier);
+  }
+  tuner->reset(new LatencySloBatchTuner(options));
+  return Status::OK();
+}
+
+inline LatencySloBatchTuner::LatencySloBatchTuner(const Options& options)
+    : options_(options), costs_(options.batch_sizes.size()) {
+  decision_.batch_size = options_.batch_sizes.back();
+  decision_.batch_timeout_micros = 0;
+}
+
+inline void LatencySloBatchTuner::RecordBatchCost(int32 batch_size,
+                                                  int64 cost_micros) {
+  const auto it = std::lower_bound(options_.batch_sizes.begin(),
+                                   options_.batch_sizes.end(), batch_size);
+  if (it == options_.batch_sizes.end()) return;
+  mutex_lock l(mu_);
+  Update(cost_micros, options_.cost_decay,
+         &costs_[it - options_.batch_sizes.begin()]);
+  UpdateDecision();
+}
+
+inline void LatencySloBatchTuner::RecordQueueingDelay(int64 delay_micros) {
+  mutex_lock l(mu_);
+  // Only the part of the delay that is not spent waiting for the batch to
+  // fill up is outside of the tuner's control.
+  const int64 thread_wait_micros =
+      std::max<int64>(0, delay_micros - decision_.batch_timeout_micros);
+  Update(thread_wait_micros, options_.cost_decay, &thread_wait_);
+}
+
+inline LatencySloBatchTuner::Decision LatencySloBatchTuner::decision() const {
+  mutex_lock l(mu_);
+  return decision_;
+}
+
+inline double LatencySloBatchTuner::EstimatedCostMicros(int i) const {
+  mutex_lock l(mu_);
+  return EstimatedCostMicrosLocked(i);
+}
+
+/*static*/ inline void LatencySloBatchTuner::Update(double sample,
+                                                    double decay,
+                                                    CostEstimate* estimate) {
+  if (estimate->num_samples++ == 0) {
+    estimate->mean_micros = sample;
+    estimate->deviation_micros = 0;
+    return;
+  }
+  const double deviation = std::abs(sample - estimate->mean_micros);
+  estimate->mean_micros += decay * (sample - estimate->mean_micros);
+  estimate->deviation_micros +=
+      decay * (deviation - estimate->deviation_micros);
+}
+
+inline double LatencySloBatchTuner::EstimatedCostMicrosLocked(int i) const {
+  const CostEstimate& estimate = costs_[i];
+  if (estimate.num_samples == 0) return -1;
+  return estimate.mean_micros +
+         options_.deviation_multiplier * estimate.deviation_micros;
+}
+
+inline void LatencySloBatchTuner::UpdateDecision() {
+  const double thread_wait_micros =
+      thread_wait_.mean_micros +
+      options_.deviation_multiplier * thread_wait_.deviation_micros;
+  const double budget_micros =
+      options_.target_latency_micros - thread_wait_micros;
+
+  int best = -1;
+  double best_cost_micros = 0;
+  double best_throughput = 0;
+  // The per-task cost of the closest smaller measured size.
+  double cost_per_task_micros = -1;
+  for (int i = 0; i < options_.batch_sizes.size(); ++i) {
+    const int32 batch_size = options_.batch_sizes[i];
+    double cost_micros = EstimatedCostMicrosLocked(i);
+    if (cost_micros >= 0) {
+      cost_per_task_micros = cost_micros / batch_size;
+    } else if (cost_per_task_micros >= 0) {
+      cost_micros = cost_per_task_micros * batch_size;
+    } else {
+      // Nothing is known about sizes this small.
+      continue;
+    }
+    if (cost_micros > budget_micros) continue;
+    const double throughput = batch_size / std::max(cost_micros, 1.0);
+    if (best < 0 || throughput >= best_throughput) {
+      best = i;
+      best_cost_micros = cost_micros;
+      best_throughput = throughput;
+    }
+  }
+
+  if (best < 0) {
+    // No measured size fits in the target: fall back to the smallest size and
+    // never wait for batches to fill up.
+    decision_.batch_size = options_.batch_sizes.front();
+    decision_.batch_timeout_micros = 0;
+    return;
+  }
+  decision_.batch_size = options_.batch_sizes[best];
+  decision_.batch_timeout_micros =
+      static_cast<int64>(std::max(0.0, budget_micros - best_cost_micros));
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_LATENCY_SLO_BATCH_TUNER_H_
@@ -0,0 +1,140 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_tuner.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+std::unique_ptr<LatencySloBatchTuner> CreateTuner(
+    int64 target_latency_micros, const std::vector<int32>& batch_sizes) {
+  LatencySloBatchTuner::Options options;
+  options.target_latency_micros = target_latency_micros;
+  options.batch_sizes = batch_sizes;
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  TF_CHECK_OK(LatencySloBatchTuner::Create(options, &tuner));
+  return tuner;
+}
+
+TEST(LatencySloBatchTunerTest, InvalidOptions) {
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  LatencySloBatchTuner::Options options;
+  options.batch_sizes = {1, 2};
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+
+  options.target_latency_micros = 1000;
+  options.batch_sizes = {};
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options.batch_sizes = {2, 2};
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options.batch_sizes = {0, 2};
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+
+  options.batch_sizes = {1, 2};
+  options.cost_decay = 0;
+  EXPECT_FALSE(LatencySloBatchTuner::Create(options, &tuner).ok());
+  options.cost_decay = 0.5;
+  TF_EXPECT_OK(LatencySloBatchTuner::Create(options, &tuner));
+}
+
+TEST(LatencySloBatchTunerTest, InitialDecision) {
+  auto tuner = CreateTuner(100000, {2, 4, 8});
+  LatencySloBatchTuner::Decision decision = tuner->decision();
+  EXPECT_EQ(8, decision.batch_size);
+  EXPECT_EQ(0, decision.batch_timeout_micros);
+  EXPECT_LT(tuner->EstimatedCostMicros(0), 0);
+}
+
+TEST(LatencySloBatchTunerTest, PicksHighestThroughputWithinTarget) {
+  auto tuner = CreateTuner(100000, {2, 4, 8});
+  tuner->RecordBatchCost(2, 1000);
+  tuner->RecordBatchCost(4, 1500);
+  // Too slow for the target, even though it has the highest throughput.
+  tuner->RecordBatchCost(8, 200000);
+
+  LatencySloBatchTuner::Decision decision = tuner->decision();
+  EXPECT_EQ(4, decision.batch_size);
+  EXPECT_EQ(100000 - 1500, decision.batch_timeout_micros);
+}
+
+TEST(LatencySloBatchTunerTest, BatchesAreAttributedToTheirPaddedSize) {
+  auto tuner = CreateTuner(100000, {2, 4, 8});
+  tuner->RecordBatchCost(3, 1500);
+  EXPECT_LT(tuner->EstimatedCostMicros(0), 0);
+  EXPECT_EQ(1500, tuner->EstimatedCostMicros(1));
+  // Larger than any candidate size.
+  tuner->RecordBatchCost(9, 1500);
+  EXPECT_LT(tuner->EstimatedCostMicros(2), 0);
+}
+
+TEST(LatencySloBatchTunerTest, ExploresLargerSizes) {
+  auto tuner = CreateTuner(20000, {2, 4, 8, 64});
+  tuner->RecordBatchCost(2, 1000);
+
+  // The larger sizes are assumed to cost as much per task as size 2. Size 64
+  // would not fit in the target, so size 8 is tried next.
+  LatencySloBatchTuner::Decision decision = tuner->decision();
+  EXPECT_EQ(8, decision.batch_size);
+  EXPECT_EQ(20000 - 4000, decision.batch_timeout_micros);
+}
+
+TEST(LatencySloBatchTunerTest, FallsBackToSmallestSize) {
+  auto tuner = CreateTuner(1000, {2, 4, 8});
+  tuner->RecordBatchCost(2, 2000);
+  LatencySloBatchTuner::Decision decision = tuner->decision();
+  EXPECT_EQ(2, decision.batch_size);
+  EXPECT_EQ(0, decision.batch_timeout_micros);
+}
+
+TEST(LatencySloBatchTunerTest, BudgetsForCostVariance) {
+  LatencySloBatchTuner::Options options;
+  options.target_latency_micros = 100000;
+  options.batch_sizes = {4};
+  options.cost_decay = 0.5;
+  options.deviation_multiplier = 2;
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(options, &tuner));
+
+  tuner->RecordBatchCost(4, 1000);
+  tuner->RecordBatchCost(4, 3000);
+  // Mean 2000, mean absolute deviation 1000.
+  EXPECT_EQ(2000 + 2 * 1000, tuner->EstimatedCostMicros(0));
+  EXPECT_EQ(100000 - 4000, tuner->decision().batch_timeout_micros);
+}
+
+TEST(LatencySloBatchTunerTest, BudgetsForWaitingForThreads) {
+  LatencySloBatchTuner::Options options;
+  options.target_latency_micros = 100000;
+  options.batch_sizes = {4};
+  options.deviation_multiplier = 0;
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(options, &tuner));
+
+  tuner->RecordBatchCost(4, 1000);
+  EXPECT_EQ(99000, tuner->decision().batch_timeout_micros);
+
+  // The batch waited 10ms longer than its timeout.
+  tuner->RecordQueueingDelay(99000 + 10000);
+  tuner->RecordBatchCost(4, 1000);
+  EXPECT_EQ(89000, tuner->decision().batch_timeout_micros);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
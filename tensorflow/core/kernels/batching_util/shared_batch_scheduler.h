@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -27,6 +28,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/latency_slo_batch_tuner.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -194,6 +196,13 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If set, the size limit and timeout of each batch are picked by the
+    // tuner when the batch is started, instead of being the maximum batch
+    // size and `batch_timeout_micros`. The tuned size is capped at the maximum
+    // batch size. The caller is responsible for reporting batch costs to the
+    // tuner.
+    std::shared_ptr<LatencySloBatchTuner> latency_slo_batch_tuner;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -345,6 +354,10 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Sets the size limit and timeout of the open batch, from the tuner if
+  // there is one.
+  void UpdateOpenBatchLimits() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -375,6 +388,11 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ TF_GUARDED_BY(mu_);
 
+  // The size at which the open batch is closed, and the time after
+  // 'open_batch_start_time_micros_' at which it becomes schedulable.
+  size_t open_batch_size_limit_ TF_GUARDED_BY(mu_);
+  int64 open_batch_timeout_micros_ TF_GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled.
   // Used to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ TF_GUARDED_BY(mu_) = false;
@@ -595,7 +613,9 @@ Queue<TaskType>::Queue(
       process_batch_callback_(process_batch_callback),
       schedulable_batch_callback_(schedulable_batch_callback) {
   // Create an initial, open batch.
+  mutex_lock l(mu_);
   batches_.emplace_back(new Batch<TaskType>);
+  UpdateOpenBatchLimits();
 }
 
 template <typename TaskType>
@@ -629,8 +649,8 @@ Status Queue<TaskType>::ScheduleWithoutSplit(std::unique_ptr<TaskType>* task) {
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() >
-        options_.input_batch_size_limit) {
+    if (batches_.back()->size() + (*task)->size() > open_batch_size_limit_ &&
+        !batches_.back()->empty()) {
       if (batches_.size() >= options_.max_enqueued_batches) {
         return errors::Unavailable(
             "The batch scheduling queue to which this task was submitted is "
@@ -682,19 +702,20 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
                                    options_.input_batch_size_limit);
   }
 
-  // The max size to be enqueued.
-  const int max_execution_batch_size = options_.max_execution_batch_size;
-
   bool notify_of_schedulable_batch = false;
   {
     mutex_lock l(mu_);
 
     DCHECK(!closed_);
 
+    // The max size to be enqueued, which the tuner may lower below
+    // `options_.max_execution_batch_size`.
+    const int max_execution_batch_size = open_batch_size_limit_;
+
     const int num_new_batches_schedulable =
         options_.max_enqueued_batches - batches_.size();
-    const int open_batch_capacity =
-        max_execution_batch_size - batches_.back()->size();
+    const int open_batch_capacity = std::max<int>(
+        0, max_execution_batch_size - batches_.back()->size());
     const int scheduling_capacity =
         (num_new_batches_schedulable * max_execution_batch_size) +
         open_batch_capacity;
@@ -710,8 +731,7 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
           "full");
     }
 
-    const int64 open_batch_remaining_slot =
-        max_execution_batch_size - batches_.back()->size();
+    const int64 open_batch_remaining_slot = open_batch_capacity;
 
     const int64 input_task_size = (*task)->size();
 
@@ -726,7 +746,7 @@ Status Queue<TaskType>::ScheduleWithSplit(std::unique_ptr<TaskType>* task) {
 
     for (int i = 0; i < output_tasks.size(); ++i) {
       if (batches_.back()->size() + output_tasks[i]->size() >
-          options_.max_execution_batch_size) {
+          open_batch_size_limit_) {
         StartNewBatch();
       }
       if (batches_.back()->empty()) {
@@ -772,9 +792,9 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
   const int num_new_batches_schedulable =
       options_.max_enqueued_batches - batches_.size();
-  const int open_batch_capacity =
-      max_execution_batch_size() - batches_.back()->size();
-  return (num_new_batches_schedulable * max_execution_batch_size()) +
+  const int open_batch_capacity = std::max<int>(
+      0, open_batch_size_limit_ - batches_.back()->size());
+  return (num_new_batches_schedulable * open_batch_size_limit_) +
          open_batch_capacity;
 }
 
@@ -857,17 +877,20 @@ template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
   batches_.back()->Close();
   batches_.emplace_back(new Batch<TaskType>(++traceme_context_id_counter_));
+  UpdateOpenBatchLimits();
 }
 
 template <typename TaskType>
 Status Queue<TaskType>::SplitInputBatchIntoSubtasks(
     std::unique_ptr<TaskType>* input_task,
     std::vector<std::unique_ptr<TaskType>>* output_tasks) {
-  const int open_batch_remaining_slot =
-      max_execution_batch_size() - batches_.back()->size();
+  // Fill the open batch and the following ones up to the size limit picked
+  // by the tuner, if any.
+  const int open_batch_remaining_slot = std::max<int>(
+      0, open_batch_size_limit_ - batches_.back()->size());
   return options_.split_input_task_func(
       std::move(input_task), open_batch_remaining_slot,
-      max_execution_batch_size(), std::move(output_tasks));
+      open_batch_size_limit_, std::move(output_tasks));
 }
 
 template <typename TaskType>
@@ -876,9 +899,22 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= max_execution_batch_size() ||
+  return closed_ || open_batch->size() >= open_batch_size_limit_ ||
          env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+             open_batch_start_time_micros_ + open_batch_timeout_micros_;
+}
+
+template <typename TaskType>
+void Queue<TaskType>::UpdateOpenBatchLimits() {
+  open_batch_size_limit_ = max_execution_batch_size();
+  open_batch_timeout_micros_ = options_.batch_timeout_micros;
+  if (options_.latency_slo_batch_tuner != nullptr) {
+    const LatencySloBatchTuner::Decision decision =
+        options_.latency_slo_batch_tuner->decision();
+    open_batch_size_limit_ = std::min<size_t>(
+        open_batch_size_limit_, std::max<int32>(1, decision.batch_size));
+    open_batch_timeout_micros_ = decision.batch_timeout_micros;
+  }
 }
 
 template <typename TaskType>
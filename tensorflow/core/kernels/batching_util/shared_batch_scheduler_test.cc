@@ -186,6 +186,129 @@ TEST(SharedBatchSchedulerTest, ObeyBatchSizeConstraint) {
   EXPECT_EQ((std::vector<size_t>{3, 1, 6}), callback_data_b);
 }
 
+TEST(SharedBatchSchedulerTest, ObeysLatencySloBatchTuner) {
+  mutex mu;
+  std::vector<std::vector<size_t>> callback_data;
+  auto callback = [&mu,
+                   &callback_data](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    std::vector<size_t> batch_data;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batch_data.push_back(batch->mutable_task(i)->size());
+    }
+    mutex_lock l(mu);
+    callback_data.push_back(batch_data);
+  };
+
+  // Teach the tuner that batches of size 4 have the best throughput within
+  // the target latency, and leave a timeout of almost 10 seconds.
+  LatencySloBatchTuner::Options tuner_options;
+  tuner_options.target_latency_micros = 10 * 1000 * 1000;
+  tuner_options.batch_sizes = {2, 4, 8};
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(tuner_options, &tuner));
+  tuner->RecordBatchCost(2, 1000);
+  tuner->RecordBatchCost(4, 1500);
+  tuner->RecordBatchCost(8, 20 * 1000 * 1000);
+  ASSERT_EQ(4, tuner->decision().batch_size);
+
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 10;
+    queue_options.batch_timeout_micros = 0;
+    queue_options.max_enqueued_batches = 3;
+    queue_options.latency_slo_batch_tuner = std::move(tuner);
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // The tuned size limit closes each batch once it holds 4 tasks.
+    TF_ASSERT_OK(ScheduleTask(3, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(3 /* 2 + 3 > 4 */, queue.get()));
+  }
+
+  ASSERT_EQ(3, callback_data.size());
+  EXPECT_EQ((std::vector<size_t>{3, 1}), callback_data[0]);
+  EXPECT_EQ((std::vector<size_t>{2}), callback_data[1]);
+  EXPECT_EQ((std::vector<size_t>{3}), callback_data[2]);
+}
+
+TEST(SharedBatchSchedulerTest, ObeysLatencySloBatchTunerWithSplitting) {
+  mutex mu;
+  std::vector<std::vector<size_t>> callback_data;
+  auto callback = [&mu,
+                   &callback_data](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    std::vector<size_t> batch_data;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batch_data.push_back(batch->mutable_task(i)->size());
+    }
+    mutex_lock l(mu);
+    callback_data.push_back(batch_data);
+  };
+
+  LatencySloBatchTuner::Options tuner_options;
+  tuner_options.target_latency_micros = 10 * 1000 * 1000;
+  tuner_options.batch_sizes = {2, 4, 8};
+  std::unique_ptr<LatencySloBatchTuner> tuner;
+  TF_ASSERT_OK(LatencySloBatchTuner::Create(tuner_options, &tuner));
+  tuner->RecordBatchCost(2, 1000);
+  tuner->RecordBatchCost(4, 1500);
+  tuner->RecordBatchCost(8, 20 * 1000 * 1000);
+  ASSERT_EQ(4, tuner->decision().batch_size);
+
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 10;
+    queue_options.batch_timeout_micros = 0;
+    queue_options.max_enqueued_batches = 5;
+    queue_options.enable_large_batch_splitting = true;
+    queue_options.max_execution_batch_size = 8;
+    queue_options.split_input_task_func =
+        [](std::unique_ptr<FakeTask>* input_task, int first_output_task_size,
+           int max_batch_size,
+           std::vector<std::unique_ptr<FakeTask>>* output_tasks) {
+          // The tuned size limit, not `max_execution_batch_size`, bounds the
+          // size of the split tasks.
+          EXPECT_EQ(4, max_batch_size);
+          int remaining_size = (*input_task)->size();
+          input_task->reset();
+          int task_size = first_output_task_size;
+          while (remaining_size > 0) {
+            if (task_size > 0) {
+              task_size = std::min(remaining_size, task_size);
+              output_tasks->emplace_back(new FakeTask(task_size));
+              remaining_size -= task_size;
+            }
+            task_size = max_batch_size;
+          }
+          return Status::OK();
+        };
+    queue_options.latency_slo_batch_tuner = std::move(tuner);
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // The second task fills the open batch up to the tuned limit of 4 and
+    // spills over into two more batches.
+    TF_ASSERT_OK(ScheduleTask(3, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(7, queue.get()));
+  }
+
+  ASSERT_EQ(3, callback_data.size());
+  EXPECT_EQ((std::vector<size_t>{3, 1}), callback_data[0]);
+  EXPECT_EQ((std::vector<size_t>{4}), callback_data[1]);
+  EXPECT_EQ((std::vector<size_t>{2}), callback_data[2]);
+}
+
 TEST(SharedBatchSchedulerTest, ObeysTimeout) {
   // Set up a fake clock, which only advances when we explicitly tell it to.
   test_util::FakeClockEnv env(Env::Default());
@@ -224,6 +224,9 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
       if (fusion == FusedComputationType::kBiasAddWithLeakyRelu) {
         OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args,
                                                 &fusion_args.leakyrelu_alpha));
+      } else if (BiasAddArgs<T>::HasAdd(fusion)) {
+        OP_REQUIRES_OK(context,
+                       InitBiasAddAndAddArgs(context, *output, &bias_add_args));
       } else {
         OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
       }
@@ -271,6 +274,26 @@ struct LaunchFusedConv2DOp<CPUDevice, T> {
         conv2d(WithBiasAddAndElu<T>(bias_add_args), context, input, filter,
                output);
         break;
+      case FusedComputationType::kBiasAddWithGeluApproximate:
+        conv2d(WithBiasAddAndGeluApproximate<T>(bias_add_args), context,
+               input, filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithAdd:
+        conv2d(WithBiasAddAndAdd<T>(bias_add_args), context, input, filter,
+               output);
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu:
+        conv2d(WithBiasAddAndAddAndRelu<T>(bias_add_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu6:
+        conv2d(WithBiasAddAndAddAndRelu6<T>(bias_add_args), context, input,
+               filter, output);
+        break;
+      case FusedComputationType::kBiasAddWithAddAndElu:
+        conv2d(WithBiasAddAndAddAndElu<T>(bias_add_args), context, input,
+               filter, output);
+        break;
       case FusedComputationType::kFusedBatchNorm:
         conv2d(
             WithFusedBatchNorm<T>(fusion_args.epsilon, fused_batch_norm_args),
@@ -733,6 +756,11 @@ class FusedConv2DOp : public OpKernel {
           {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
           {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
           {FCT::kBiasAddWithLeakyRelu, {"BiasAdd", "LeakyRelu"}},
+          {FCT::kBiasAddWithGeluApproximate, {"BiasAdd", "GeluApproximate"}},
+          {FCT::kBiasAddWithAdd, {"BiasAdd", "Add"}},
+          {FCT::kBiasAddWithAddAndRelu, {"BiasAdd", "Add", "Relu"}},
+          {FCT::kBiasAddWithAddAndRelu6, {"BiasAdd", "Add", "Relu6"}},
+          {FCT::kBiasAddWithAddAndElu, {"BiasAdd", "Add", "Elu"}},
           {FCT::kFusedBatchNorm, {"FusedBatchNorm"}},
           {FCT::kFusedBatchNormWithRelu, {"FusedBatchNorm", "Relu"}},
           {FCT::kFusedBatchNormWithRelu6, {"FusedBatchNorm", "Relu6"}},
@@ -663,6 +663,39 @@ class FusedConv2DOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunConv2DWithBiasAndAddAndActivation(
+      const Tensor& input_data, const Tensor& filter_data,
+      const Tensor& bias_data, const Tensor& add_data,
+      const string& activation_type, Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::Conv2D conv = ops::Conv2D(
+        root.WithOpName("conv"),
+        ops::Const(root.WithOpName("input"), Input::Initializer(input_data)),
+        ops::Const(root.WithOpName("filter"), Input::Initializer(filter_data)),
+        {1, 1, 1, 1}, "SAME");
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), conv,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::AddV2 with_add = ops::AddV2(
+        root.WithOpName("with_add"), with_bias,
+        ops::Const(root.WithOpName("add"), Input::Initializer(add_data)));
+
+    if (activation_type == "Relu") {
+      ops::Relu(root.WithOpName("with_activation"), with_add);
+    } else if (activation_type == "Relu6") {
+      ops::Relu6(root.WithOpName("with_activation"), with_add);
+    } else if (activation_type == "Elu") {
+      ops::Elu(root.WithOpName("with_activation"), with_add);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_add);
+    }
+
+    RunAndFetch(root, "with_activation", output, /*allow_gpu_device=*/false);
+  }
+
   void RunConv2DWithBatchNorm(
       const Tensor& input_data, const Tensor& filter_data,
       const Tensor& scale_data, const Tensor& offset_data,
@@ -929,6 +962,42 @@ class FusedConv2DOpTest : public OpsTestBase {
                              run_default, run_fused);
   }
 
+  // Verifies that computing Conv2D+BiasAdd+Add+{Activation} in a graph is
+  // identical to FusedConv2D. Activation "None" fuses only the Add.
+  void VerifyConv2DWithBiasAndAddAndActivation(const string& activation,
+                                               int filter_size,
+                                               int filter_count) {
+    DataType dtype = DataTypeToEnum<T>::v();
+
+    // Residual added to the output of the "SAME" convolution.
+    Tensor add(dtype,
+               {kImageBatchCount, kImageHeight, kImageWidth, filter_count});
+    add.flat<T>() = add.flat<T>().setRandom();
+    add.flat<T>() -= add.flat<T>().constant(static_cast<T>(0.5f));
+
+    const BiasAddGraphRunner run_default =
+        [this, &activation, &add](const Tensor& input_data,
+                                  const Tensor& filter_data,
+                                  const Tensor& bias_data, Tensor* out) {
+          RunConv2DWithBiasAndAddAndActivation(input_data, filter_data,
+                                               bias_data, add, activation, out);
+        };
+
+    std::vector<string> fused_ops = {"BiasAdd", "Add"};
+    if (activation != "None") fused_ops.push_back(activation);
+    const BiasAddGraphRunner run_fused =
+        [this, &fused_ops, &add](const Tensor& input_data,
+                                 const Tensor& filter_data,
+                                 const Tensor& bias_data, Tensor* out) {
+          RunFusedConv2DOp(input_data, filter_data, {bias_data, add}, fused_ops,
+                           "SAME", /*explicit_paddings=*/{}, out);
+        };
+
+    VerifyBiasAddTensorsNear(kDepth, kImageWidth, kImageHeight,
+                             kImageBatchCount, filter_size, filter_count,
+                             run_default, run_fused);
+  }
+
   // Verifies that computing Conv2D+FusedBatchNorm in a graph is identical to
   // FusedConv2D.
   void VerifyConv2DWithBatchNorm(int filter_size, int filter_count,
@@ -1084,6 +1153,28 @@ TYPED_TEST_P(FusedConv2DWithBiasOpTest,
         /*explicit_paddings=*/{0, 0, 1, 2, 3, 4, 0, 0});
   }
 }
+
+// -------------------------------------------------------------------------- //
+// Conv2D + BiasAdd + Add + {Activation}                                      //
+// -------------------------------------------------------------------------- //
+
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, OneByOneConvolutionAndAdd) {
+  const int filter_size = 1;
+  const int filter_count = 12;
+  for (const string& activation : {"None", "Relu", "Relu6", "Elu"}) {
+    this->VerifyConv2DWithBiasAndAddAndActivation(activation, filter_size,
+                                                  filter_count);
+  }
+}
+
+TYPED_TEST_P(FusedConv2DWithBiasOpTest, SpatialConvolutionAndAdd) {
+  const int filter_size = 3;
+  const int filter_count = 12;
+  for (const string& activation : {"None", "Relu", "Relu6", "Elu"}) {
+    this->VerifyConv2DWithBiasAndAddAndActivation(activation, filter_size,
+                                                  filter_count);
+  }
+}
 #endif
 
 // -------------------------------------------------------------------------- //
@@ -1160,15 +1251,17 @@ TYPED_TEST_P(FusedConv2DWithBatchNormOpTest,
 #endif
 
 #ifndef INTEL_MKL
-REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,          //
-                            OneByOneConvolution,                //
-                            ImageSizeConvolution,               //
-                            SpatialConvolution,                 //
-                            ExplicitPaddingConvolution,         //
-                            OneByOneConvolutionAndActivation,   //
-                            ImageSizeConvolutionAndActivation,  //
-                            SpatialConvolutionAndActivation,    //
-                            ExplicitPaddingConvolutionAndActivation);
+REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBiasOpTest,                //
+                            OneByOneConvolution,                      //
+                            ImageSizeConvolution,                     //
+                            SpatialConvolution,                       //
+                            ExplicitPaddingConvolution,               //
+                            OneByOneConvolutionAndActivation,         //
+                            ImageSizeConvolutionAndActivation,        //
+                            SpatialConvolutionAndActivation,          //
+                            ExplicitPaddingConvolutionAndActivation,  //
+                            OneByOneConvolutionAndAdd,                //
+                            SpatialConvolutionAndAdd);
 
 REGISTER_TYPED_TEST_SUITE_P(FusedConv2DWithBatchNormOpTest,     //
                             OneByOneConvolution,                //
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -57,6 +58,8 @@ constexpr char kCacheCompleted[] = "cache_completed";
 constexpr char kIndex[] = "index";
 constexpr char kImpl[] = "Impl";
 constexpr char kCacheDataset[] = "CacheDataset";
+constexpr char kRamBudgetEnvVar[] = "TF_DATA_CACHE_RAM_BUDGET_BYTES";
+constexpr char kSpillDirectoryEnvVar[] = "TF_DATA_CACHE_SPILL_DIR";
 
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
@@ -647,13 +650,126 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDatasetBase {
   const Tensor resource_handle_;
 };
 
+namespace {
+
+// Writes the `in_memory` elements followed by the elements of `spill_file`, if
+// any, to the checkpoint under `key_prefix`. The spilled elements are read
+// back one at a time, so that they are never all held in memory.
+Status WriteCacheToCheckpoint(
+    IteratorStateWriter* writer, StringPiece key_prefix,
+    const std::vector<std::vector<Tensor>>& in_memory,
+    CacheSpillFile* spill_file) {
+  const int64 num_spilled =
+      spill_file == nullptr ? 0 : spill_file->num_elements();
+  std::unique_ptr<CacheSpillFile::Reader> reader;
+  if (num_spilled > 0) {
+    TF_RETURN_IF_ERROR(spill_file->NewReader(/*index=*/0, &reader));
+  }
+  auto it = in_memory.begin();
+  return WriteElementsToCheckpoint(
+      writer, key_prefix, in_memory.size() + num_spilled,
+      [&](std::vector<Tensor>* element) {
+        if (it != in_memory.end()) {
+          *element = *it++;
+          return Status::OK();
+        }
+        return reader->Read(element);
+      });
+}
+
+// Accumulates the elements of a memory cache. Elements are kept in memory
+// until their total size reaches `ram_budget` bytes, and the following ones
+// are appended to a `CacheSpillFile` in `spill_directory`. A non-positive
+// `ram_budget` keeps all elements in memory.
+class CacheBuilder {
+ public:
+  CacheBuilder(int64 ram_budget, const string& spill_directory)
+      : ram_budget_(ram_budget), spill_directory_(spill_directory) {}
+
+  // Adds an element after the elements added so far. Sets `*in_memory` to
+  // whether the element is kept in memory.
+  Status Add(const std::vector<Tensor>& element, bool* in_memory) {
+    *in_memory = false;
+    if (spill_file_ == nullptr) {
+      const int64 bytes = GetTotalBytes(element);
+      if (ram_budget_ <= 0 || in_memory_bytes_ + bytes <= ram_budget_) {
+        in_memory_bytes_ += bytes;
+        in_memory_.push_back(element);
+        *in_memory = true;
+        return Status::OK();
+      }
+      std::unique_ptr<CacheSpillFile> spill_file;
+      TF_RETURN_IF_ERROR(CacheSpillFile::Create(
+          Env::Default(), spill_directory_, &spill_file));
+      spill_file_ = std::move(spill_file);
+    }
+    return spill_file_->Append(element);
+  }
+
+  // Returns the number of elements added so far.
+  int64 size() const {
+    return in_memory_.size() +
+           (spill_file_ == nullptr ? 0 : spill_file_->num_elements());
+  }
+
+  // Writes the elements added so far to the checkpoint under `key_prefix`.
+  Status Save(IteratorStateWriter* writer, StringPiece key_prefix) {
+    if (spill_file_ != nullptr) {
+      TF_RETURN_IF_ERROR(spill_file_->Flush());
+    }
+    return WriteCacheToCheckpoint(writer, key_prefix, in_memory_,
+                                  spill_file_.get());
+  }
+
+  // Adds the elements written by `Save` under `key_prefix`, one at a time.
+  Status Restore(IteratorStateReader* reader, StringPiece key_prefix) {
+    return ReadElementsFromCheckpoint(
+        reader, key_prefix, [this](std::vector<Tensor> element) {
+          bool in_memory;
+          return Add(element, &in_memory);
+        });
+  }
+
+  // Marks `cache` as completed with the elements added so far, which are
+  // moved out of the builder.
+  Status Complete(MemoryCache* cache) {
+    if (spill_file_ != nullptr) {
+      TF_RETURN_IF_ERROR(spill_file_->Close());
+      VLOG(2) << "Cached " << in_memory_.size() << " elements in memory and "
+              << spill_file_->num_elements() << " elements on disk.";
+    }
+    cache->Complete(std::move(in_memory_), std::move(spill_file_));
+    Reset();
+    return Status::OK();
+  }
+
+  // Drops the elements added so far.
+  void Reset() {
+    in_memory_.clear();
+    in_memory_bytes_ = 0;
+    spill_file_.reset();
+  }
+
+ private:
+  const int64 ram_budget_;
+  const string spill_directory_;
+  std::vector<std::vector<Tensor>> in_memory_;
+  int64 in_memory_bytes_ = 0;
+  std::shared_ptr<CacheSpillFile> spill_file_;
+};
+
+}  // namespace
+
 class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
  public:
   explicit MemoryDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                             std::shared_ptr<MemoryCache> cache)
+                             std::shared_ptr<MemoryCache> cache,
+                             int64 ram_budget, const string& spill_directory)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
-        cache_(std::move(cache)) {
+        cache_(std::move(cache)),
+        ram_budget_(ram_budget),
+        spill_directory_(spill_directory) {
     input_->Ref();
   }
 
@@ -724,8 +840,9 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex_lock l(mu_);
       if (cache_->IsCompleted()) {
         TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kCacheCompleted), ""));
-        TF_RETURN_IF_ERROR(
-            WriteElementsToCheckpoint(writer, prefix(), cache_->data()));
+        std::shared_ptr<CacheSpillFile> spill_file = cache_->spill_file();
+        TF_RETURN_IF_ERROR(WriteCacheToCheckpoint(
+            writer, prefix(), cache_->data(), spill_file.get()));
       }
       return SaveInput(ctx, writer, iterator_);
     }
@@ -736,10 +853,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       iterator_.reset();
       cache_->Reset();
       if (reader->Contains(full_name(kCacheCompleted))) {
-        std::vector<std::vector<Tensor>> temp_cache;
-        TF_RETURN_IF_ERROR(
-            ReadElementsFromCheckpoint(reader, prefix(), &temp_cache));
-        cache_->Complete(std::move(temp_cache));
+        CacheBuilder builder(dataset()->ram_budget_,
+                             dataset()->spill_directory_);
+        TF_RETURN_IF_ERROR(builder.Restore(reader, prefix()));
+        TF_RETURN_IF_ERROR(builder.Complete(cache_));
       }
       TF_RETURN_IF_ERROR(InitializeIterator(ctx));
       return RestoreInput(ctx, reader, iterator_);
@@ -749,11 +866,14 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
     class MemoryWriterIterator : public DatasetIterator<MemoryDatasetBase> {
      public:
       explicit MemoryWriterIterator(const Params& params, MemoryCache* cache)
-          : DatasetIterator<MemoryDatasetBase>(params), cache_(cache) {}
+          : DatasetIterator<MemoryDatasetBase>(params),
+            cache_(cache),
+            temp_cache_(params.dataset->ram_budget_,
+                        params.dataset->spill_directory_) {}
 
       ~MemoryWriterIterator() override {
         mutex_lock l(mu_);
-        if (!temp_cache_.empty() && !cache_->IsCompleted()) {
+        if (temp_cache_.size() > 0 && !cache_->IsCompleted()) {
           LOG(WARNING)
               << "The calling iterator did not fully read the dataset being "
                  "cached. In order to avoid unexpected truncation of the "
@@ -779,16 +899,19 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           if (!cache_->IsCompleted()) {
             VLOG(2) << "Finalizing the cache because EOF has been reached.";
-            cache_->Complete(std::move(temp_cache_));
+            TF_RETURN_IF_ERROR(temp_cache_.Complete(cache_));
           }
           return Status::OK();
         }
-        RecordBufferEnqueue(ctx, *out_tensors);
-        temp_cache_.emplace_back(*out_tensors);
+        bool in_memory;
+        TF_RETURN_IF_ERROR(temp_cache_.Add(*out_tensors, &in_memory));
+        if (in_memory) {
+          RecordBufferEnqueue(ctx, *out_tensors);
+        }
         if (temp_cache_.size() == dataset()->input_->Cardinality()) {
           VLOG(2) << "Finalizing the cache because its size matches the "
                      "expected input cardinality.";
-          cache_->Complete(std::move(temp_cache_));
+          TF_RETURN_IF_ERROR(temp_cache_.Complete(cache_));
         }
         return Status::OK();
       }
@@ -804,8 +927,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                           IteratorStateWriter* writer) override {
         mutex_lock l(mu_);
         if (!cache_->IsCompleted()) {
-          TF_RETURN_IF_ERROR(
-              WriteElementsToCheckpoint(writer, prefix(), temp_cache_));
+          TF_RETURN_IF_ERROR(temp_cache_.Save(writer, prefix()));
         }
         return SaveInput(ctx, writer, input_impl_);
       }
@@ -814,8 +936,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
                              IteratorStateReader* reader) override {
         mutex_lock l(mu_);
         if (!reader->Contains(full_name(kCacheCompleted))) {
-          TF_RETURN_IF_ERROR(
-              ReadElementsFromCheckpoint(reader, prefix(), &temp_cache_));
+          temp_cache_.Reset();
+          TF_RETURN_IF_ERROR(temp_cache_.Restore(reader, prefix()));
         }
         return RestoreInput(ctx, reader, input_impl_);
       }
@@ -824,7 +946,7 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
-      std::vector<std::vector<Tensor>> temp_cache_ TF_GUARDED_BY(mu_);
+      CacheBuilder temp_cache_ TF_GUARDED_BY(mu_);
     };  // MemoryWriterIterator
 
     class MemoryReaderIterator : public DatasetIterator<MemoryDatasetBase> {
@@ -858,10 +980,24 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
           index_++;
           *end_of_sequence = false;
           return Status::OK();
-        } else {
-          *end_of_sequence = true;
+        }
+        if (spill_file_ == nullptr) {
+          spill_file_ = cache_->spill_file();
+        }
+        if (spill_file_ != nullptr &&
+            index_ < cache_->size() + spill_file_->num_elements()) {
+          if (spill_reader_ == nullptr) {
+            TF_RETURN_IF_ERROR(
+                spill_file_->NewReader(index_ - cache_->size(),
+                                       &spill_reader_));
+          }
+          TF_RETURN_IF_ERROR(spill_reader_->Read(out_tensors));
+          index_++;
+          *end_of_sequence = false;
           return Status::OK();
         }
+        *end_of_sequence = true;
+        return Status::OK();
       }
 
      protected:
@@ -886,6 +1022,8 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
           TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kIndex), &temp));
           index_ = static_cast<size_t>(temp);
         }
+        spill_file_.reset();
+        spill_reader_.reset();
         return Status::OK();
       }
 
@@ -893,6 +1031,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
       mutex mu_;
       MemoryCache* const cache_ TF_GUARDED_BY(mu_);  // not owned.
       size_t index_ TF_GUARDED_BY(mu_);
+      // Elements of the cache which did not fit into the RAM budget, and the
+      // reader of the ones following `index_`, created by the first read.
+      std::shared_ptr<CacheSpillFile> spill_file_ TF_GUARDED_BY(mu_);
+      std::unique_ptr<CacheSpillFile::Reader> spill_reader_ TF_GUARDED_BY(mu_);
     };  // MemoryReaderIterator
 
     Status InitializeIterator(IteratorContext* ctx)
@@ -919,6 +1061,9 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
 
   const DatasetBase* const input_;
   const std::shared_ptr<MemoryCache> cache_;
+  // Number of bytes of elements kept in memory, or 0 for no limit.
+  const int64 ram_budget_;
+  const string spill_directory_;
 };  // MemoryDatasetBase
 
 // This version of memory dataset has an exclusive ownership of the memory cache
@@ -927,8 +1072,10 @@ class CacheDatasetOp::MemoryDatasetBase : public DatasetBase {
 class CacheDatasetOp::MemoryDataset : public CacheDatasetOp::MemoryDatasetBase {
  public:
   MemoryDataset(OpKernelContext* ctx, const DatasetBase* input,
-                MemoryCacheManager* manager, ResourceHandle&& resource_handle)
-      : MemoryDatasetBase(ctx, input, manager->get()),
+                MemoryCacheManager* manager, ResourceHandle&& resource_handle,
+                int64 ram_budget, const string& spill_directory)
+      : MemoryDatasetBase(ctx, input, manager->get(), ram_budget,
+                          spill_directory),
         manager_(manager),
         resource_handle_(std::move(resource_handle)),
         resource_mgr_(ctx->resource_manager()) {}
@@ -969,8 +1116,10 @@ class CacheDatasetOp::MemoryDatasetV2
  public:
   MemoryDatasetV2(OpKernelContext* ctx, const DatasetBase* input,
                   MemoryCacheManager* manager, ResourceHandle&& resource_handle,
-                  bool owns_resource)
-      : MemoryDatasetBase(ctx, input, manager->get()),
+                  bool owns_resource, int64 ram_budget,
+                  const string& spill_directory)
+      : MemoryDatasetBase(ctx, input, manager->get(), ram_budget,
+                          spill_directory),
         manager_(manager),
         owns_resource_(owns_resource),
         resource_handle_(std::move(resource_handle)),
@@ -1013,7 +1162,11 @@ class CacheDatasetOp::MemoryDatasetV2
 
 CacheDatasetOp::CacheDatasetOp(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx),
-      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {}
+      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar(kRamBudgetEnvVar, 0, &ram_budget_));
+  OP_REQUIRES_OK(ctx, ReadStringFromEnvVar(kSpillDirectoryEnvVar, "",
+                                           &spill_directory_));
+}
 
 void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                  DatasetBase** output) {
@@ -1046,7 +1199,8 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
       }
       // Ownership of manager is transferred onto `MemoryDatasetV2`.
       *output = new MemoryDatasetV2(ctx, input, manager, std::move(handle),
-                                    owns_resource);
+                                    owns_resource, ram_budget_,
+                                    spill_directory_);
     } else {
       MemoryCacheManager* manager;
       OP_REQUIRES_OK(
@@ -1058,7 +1212,8 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
       auto handle =
           MakeResourceHandle<MemoryCacheManager>(ctx, container, name);
       // Ownership of manager is transferred onto `MemoryDataset`.
-      *output = new MemoryDataset(ctx, input, manager, std::move(handle));
+      *output = new MemoryDataset(ctx, input, manager, std::move(handle),
+                                  ram_budget_, spill_directory_);
     }
   } else {
     if (op_version_ == 2) {
@@ -44,6 +44,12 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   class MemoryDatasetV2;
 
   const int op_version_;
+  // Number of bytes of elements which in-memory caches keep in memory before
+  // spilling the following ones to `spill_directory_`, or 0 for no limit. Set
+  // through the TF_DATA_CACHE_RAM_BUDGET_BYTES and TF_DATA_CACHE_SPILL_DIR
+  // environment variables.
+  int64 ram_budget_ = 0;
+  string spill_directory_;
 };
 
 }  // namespace data
@@ -13,6 +13,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/path.h"
 
 namespace tensorflow {
@@ -365,6 +366,118 @@ INSTANTIATE_TEST_CASE_P(CacheDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+TEST_F(CacheDatasetOpTest, SpillToDisk) {
+  // Only the first element, of 3 int64 values, fits into the RAM budget.
+  const string spill_directory = io::JoinPath(testing::TmpDir(), "cache_spill");
+  setenv("TF_DATA_CACHE_RAM_BUDGET_BYTES", "24", /*overwrite=*/1);
+  setenv("TF_DATA_CACHE_SPILL_DIR", spill_directory.c_str(), /*overwrite=*/1);
+  auto unset_env = gtl::MakeCleanup([] {
+    unsetenv("TF_DATA_CACHE_RAM_BUDGET_BYTES");
+    unsetenv("TF_DATA_CACHE_SPILL_DIR");
+  });
+  auto dataset_params = CacheDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  const std::vector<Tensor> expected_outputs = CreateTensors<int64>(
+      TensorShape({3, 1}), {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+
+  // Test the write mode.
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  while (!end_of_sequence) {
+    TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+  std::vector<string> spill_files;
+  TF_ASSERT_OK(device_->env()->GetChildren(spill_directory, &spill_files));
+  EXPECT_FALSE(spill_files.empty());
+
+  // Test the read mode, restoring the iterator from a checkpoint taken while
+  // reading the spilled elements.
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  out_tensors.clear();
+  TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                               dataset_params.iterator_prefix(), *dataset_,
+                               &iterator_));
+  end_of_sequence = false;
+  while (!end_of_sequence) {
+    TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+}
+
+TEST_F(CacheDatasetOpTest, SpillToDiskSaveAndRestoreInWriteMode) {
+  const string spill_directory =
+      io::JoinPath(testing::TmpDir(), "cache_spill_write_mode");
+  setenv("TF_DATA_CACHE_RAM_BUDGET_BYTES", "24", /*overwrite=*/1);
+  setenv("TF_DATA_CACHE_SPILL_DIR", spill_directory.c_str(), /*overwrite=*/1);
+  auto unset_env = gtl::MakeCleanup([] {
+    unsetenv("TF_DATA_CACHE_RAM_BUDGET_BYTES");
+    unsetenv("TF_DATA_CACHE_SPILL_DIR");
+  });
+  auto dataset_params = CacheDatasetParams3();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  const std::vector<Tensor> expected_outputs = CreateTensors<int64>(
+      TensorShape({3, 1}), {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+
+  // Checkpoint the writer iterator once the second element has been spilled,
+  // and restore it, which spills the second element again.
+  bool end_of_sequence = false;
+  std::vector<Tensor> out_tensors;
+  TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                  &end_of_sequence));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                               dataset_params.iterator_prefix(), *dataset_,
+                               &iterator_));
+  std::vector<string> spill_files;
+  TF_ASSERT_OK(device_->env()->GetChildren(spill_directory, &spill_files));
+  EXPECT_FALSE(spill_files.empty());
+  while (!end_of_sequence) {
+    TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+
+  // The completed cache holds the elements of the checkpoint.
+  TF_ASSERT_OK(dataset_->MakeIterator(iterator_ctx_.get(), /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator_));
+  out_tensors.clear();
+  end_of_sequence = false;
+  while (!end_of_sequence) {
+    TF_EXPECT_OK(iterator_->GetNext(iterator_ctx_.get(), &out_tensors,
+                                    &end_of_sequence));
+  }
+  TF_EXPECT_OK(ExpectEqual(out_tensors, expected_outputs,
+                           /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
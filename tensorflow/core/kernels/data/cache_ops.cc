@@ -22,21 +22,144 @@ limitations under the License.
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 
 namespace tensorflow {
 namespace data {
 namespace {
 
 constexpr char kMemoryCache[] = "MemoryCache";
+constexpr char kSpillFilePrefix[] = "tf_data_cache_spill_";
+
+// Number of reads of spilled elements kept in flight by a reader.
+constexpr int64 kSpillReadAheadBuffers = 4;
 
 }  // namespace
 
 string MemoryCacheManager::DebugString() const { return kMemoryCache; }
 
+Status CacheSpillFile::Create(Env* env, const string& directory,
+                              std::unique_ptr<CacheSpillFile>* out) {
+  string filename;
+  if (directory.empty()) {
+    if (!env->LocalTempFilename(&filename)) {
+      return errors::Unavailable(
+          "Failed to create a temporary file for spilling the cache.");
+    }
+  } else {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory));
+    filename = io::JoinPath(
+        directory, strings::StrCat(kSpillFilePrefix, env->NowMicros(), "_",
+                                   random::New64()));
+  }
+  out->reset(new CacheSpillFile(env, filename));
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &(*out)->file_));
+  (*out)->writer_ = absl::make_unique<io::RecordWriter>((*out)->file_.get());
+  VLOG(2) << "Spilling cache elements to " << filename;
+  return Status::OK();
+}
+
+CacheSpillFile::~CacheSpillFile() {
+  Status s = Close();
+  s.Update(env_->DeleteFile(filename_));
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete cache spill file " << filename_ << ": "
+                 << s;
+  }
+}
+
+Status CacheSpillFile::Append(const std::vector<Tensor>& element) {
+  if (writer_ == nullptr) {
+    return errors::FailedPrecondition("Cache spill file ", filename_,
+                                      " is closed.");
+  }
+  experimental::SnapshotRecord record;
+  for (const Tensor& tensor : element) {
+    tensor.AsProtoTensorContent(record.add_tensor());
+  }
+  TF_RETURN_IF_ERROR(writer_->WriteRecord(record.SerializeAsString()));
+  ++num_elements_;
+  return Status::OK();
+}
+
+Status CacheSpillFile::Flush() {
+  if (writer_ == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(writer_->Flush());
+  return file_->Flush();
+}
+
+Status CacheSpillFile::Close() {
+  if (writer_ == nullptr) {
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(writer_->Close());
+  writer_.reset();
+  TF_RETURN_IF_ERROR(file_->Close());
+  file_.reset();
+  return Status::OK();
+}
+
+Status CacheSpillFile::NewReader(int64 index,
+                                 std::unique_ptr<Reader>* out) const {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(filename_, &file));
+  out->reset(new Reader(std::move(file), num_elements_));
+  while (index > 0) {
+    const int num_to_skip = std::min<int64>(index, kint32max);
+    int num_skipped;
+    TF_RETURN_IF_ERROR((*out)->reader_.SkipRecords(num_to_skip, &num_skipped));
+    index -= num_skipped;
+    (*out)->num_elements_ -= num_skipped;
+  }
+  return Status::OK();
+}
+
+CacheSpillFile::Reader::Reader(std::unique_ptr<RandomAccessFile> file,
+                               int64 num_elements)
+    : file_(std::move(file)),
+      reader_(file_.get(),
+              [] {
+                io::RecordReaderOptions options;
+                options.read_ahead_buffers = kSpillReadAheadBuffers;
+                return options;
+              }()),
+      num_elements_(num_elements) {}
+
+Status CacheSpillFile::Reader::Read(std::vector<Tensor>* element) {
+  if (num_elements_ <= 0) {
+    return errors::OutOfRange("Reached the end of the cache spill file.");
+  }
+  tstring serialized;
+  TF_RETURN_IF_ERROR(reader_.ReadRecord(&serialized));
+  experimental::SnapshotRecord record;
+  if (!record.ParseFromArray(serialized.data(), serialized.size())) {
+    return errors::DataLoss("Failed to parse a spilled cache element.");
+  }
+  element->reserve(element->size() + record.tensor_size());
+  for (const TensorProto& proto : record.tensor()) {
+    Tensor tensor;
+    if (!tensor.FromProto(proto)) {
+      return errors::DataLoss("Failed to parse a spilled cache element.");
+    }
+    element->push_back(std::move(tensor));
+  }
+  --num_elements_;
+  return Status::OK();
+}
+
 void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache) {
+  Complete(std::move(cache), /*spill_file=*/nullptr);
+}
+
+void MemoryCache::Complete(std::vector<std::vector<Tensor>>&& cache,
+                           std::shared_ptr<CacheSpillFile> spill_file) {
   mutex_lock l(mu_);
   if (!completed_) {
     cache_ = std::move(cache);
+    spill_file_ = std::move(spill_file);
     completed_ = true;
   }
 }
@@ -50,6 +173,7 @@ void MemoryCache::Reset() {
   mutex_lock l(mu_);
   completed_ = false;
   cache_.clear();
+  spill_file_.reset();
 }
 
 const std::vector<Tensor>& MemoryCache::at(int64 index) {
@@ -63,6 +187,11 @@ size_t MemoryCache::size() {
   return cache_.size();
 }
 
+std::shared_ptr<CacheSpillFile> MemoryCache::spill_file() {
+  tf_shared_lock l(mu_);
+  return spill_file_;
+}
+
 const std::vector<std::vector<Tensor>>& MemoryCache::data() {
   tf_shared_lock l(mu_);
   return cache_;
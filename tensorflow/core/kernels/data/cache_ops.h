@@ -18,15 +18,80 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 namespace data {
 
+// A local file holding the elements of a `MemoryCache` which do not fit into
+// its RAM budget. The elements are stored sequentially, as one record with a
+// serialized `TensorProto` per component. The file is deleted when the object
+// is destroyed.
+class CacheSpillFile {
+ public:
+  class Reader;
+
+  // Creates an empty spill file in `directory`, or in one of the local
+  // temporary directories if `directory` is empty.
+  static Status Create(Env* env, const string& directory,
+                       std::unique_ptr<CacheSpillFile>* out);
+
+  ~CacheSpillFile();
+
+  // Appends an element to the file.
+  Status Append(const std::vector<Tensor>& element);
+
+  // Makes the appended elements visible to readers.
+  Status Flush();
+
+  // Closes the file for appending.
+  Status Close();
+
+  // Returns the number of elements in the file.
+  int64 num_elements() const { return num_elements_; }
+
+  // Creates a reader of the elements flushed so far, starting from the
+  // element at `index`.
+  Status NewReader(int64 index, std::unique_ptr<Reader>* out) const;
+
+ private:
+  CacheSpillFile(Env* env, string filename) : env_(env), filename_(filename) {}
+
+  Env* const env_;
+  const string filename_;
+  std::unique_ptr<WritableFile> file_;
+  std::unique_ptr<io::RecordWriter> writer_;
+  int64 num_elements_ = 0;
+};
+
+// Reads the elements of a `CacheSpillFile` in order, keeping reads of the
+// following elements in flight.
+class CacheSpillFile::Reader {
+ public:
+  // Reads the next element into `element`.
+  Status Read(std::vector<Tensor>* element);
+
+ private:
+  friend class CacheSpillFile;
+
+  Reader(std::unique_ptr<RandomAccessFile> file, int64 num_elements);
+
+  const std::unique_ptr<RandomAccessFile> file_;
+  io::SequentialRecordReader reader_;
+  // Number of elements which have not been read yet.
+  int64 num_elements_;
+};
+
 // A thread-safe data structure for caching dataset elements.
 //
 // The expected use is that a single `MemoryWriterIterator` populates the
 // cache with dataset elements. Once all elements are cached, the cache can
 // be used by one or more `MemoryReaderIterator`s.
+//
+// Elements which do not fit into the RAM budget of the writer are kept in a
+// `CacheSpillFile` and follow the in-memory elements.
 class MemoryCache {
  public:
   MemoryCache() = default;
@@ -34,18 +99,27 @@ class MemoryCache {
   // Marks the cache as completed.
   void Complete(std::vector<std::vector<Tensor>>&& cache);
 
+  // Marks the cache as completed, with the elements following `cache` stored
+  // in `spill_file`.
+  void Complete(std::vector<std::vector<Tensor>>&& cache,
+                std::shared_ptr<CacheSpillFile> spill_file);
+
   // Returns whether the cache is completed.
   bool IsCompleted();
 
   // Resets the cache.
   void Reset();
 
-  // Returns the element at the given index.
+  // Returns the in-memory element at the given index.
   const std::vector<Tensor>& at(int64 index);
 
-  // Returns the size of the cache.
+  // Returns the number of in-memory elements of the cache.
   size_t size();
 
+  // Returns the file holding the elements which follow the in-memory ones, or
+  // nullptr if all elements are in memory.
+  std::shared_ptr<CacheSpillFile> spill_file();
+
   // Returns a reference to the cache's data. The returned reference will be
   // invalidated by any call to Reset().
   const std::vector<std::vector<Tensor>>& data();
@@ -55,6 +129,7 @@ class MemoryCache {
   // Determines whether all elements of the dataset have been cached.
   bool completed_ TF_GUARDED_BY(mu_) = false;
   std::vector<std::vector<Tensor>> cache_ TF_GUARDED_BY(mu_);
+  std::shared_ptr<CacheSpillFile> spill_file_ TF_GUARDED_BY(mu_);
 };
 
 // A resource wrapping a shared instance of a memory cache.
@@ -262,6 +262,35 @@ bool IsOpAllowlisted(const OpDef* op_def) {
          AllowlistedStatefulOpRegistry::Global()->Contains(op_def->name());
 }
 
+// Returns whether the function can use the multi-device function backend.
+bool UseMultiDeviceFunction(const FunctionDef& fdef) {
+  auto attr = fdef.attr().find(FunctionLibraryDefinition::kIntsOnDeviceAttr);
+  if (attr != fdef.attr().end() && attr->second.b()) {
+    VLOG(1) << "Disabling multi-device execution for a function that uses the "
+            << FunctionLibraryDefinition::kIntsOnDeviceAttr << " attribute.";
+    return false;
+  }
+  auto validate_arg = [](const OpDef::ArgDef& arg) {
+    if (!arg.number_attr().empty() || !arg.type_list_attr().empty()) {
+      VLOG(1) << "Disabling multi-device execution for a function with "
+              << "a vector argument " << arg.name() << ".";
+      return false;
+    }
+    return true;
+  };
+  for (const auto& arg : fdef.signature().input_arg()) {
+    if (!validate_arg(arg)) {
+      return false;
+    }
+  }
+  for (const auto& arg : fdef.signature().output_arg()) {
+    if (!validate_arg(arg)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status LookupFunction(const FunctionLibraryDefinition& lib_def,
                       const string& name, const FunctionDef** fdef) {
   *fdef = lib_def.Find(name);
@@ -498,34 +527,19 @@ Status FunctionMetadata::Create(
   const FunctionDef* fdef;
   TF_RETURN_IF_ERROR(LookupFunction(*(*out_metadata)->lib_def(),
                                     (*out_metadata)->func().name(), &fdef));
+  (*out_metadata)->use_multi_device_function_ = UseMultiDeviceFunction(*fdef);
+  return Status::OK();
+}
 
-  auto attr = fdef->attr().find(FunctionLibraryDefinition::kIntsOnDeviceAttr);
-  if (attr != fdef->attr().end() && attr->second.b()) {
-    VLOG(1) << "Disabling multi-device execution for a function that uses the "
-            << FunctionLibraryDefinition::kIntsOnDeviceAttr << " attribute.";
-    (*out_metadata)->use_multi_device_function_ = false;
-    return Status::OK();
-  }
-  auto validate_arg = [](const OpDef::ArgDef& arg) {
-    if (!arg.number_attr().empty() || !arg.type_list_attr().empty()) {
-      VLOG(1) << "Disabling multi-device execution for a function with "
-              << "a vector argument " << arg.name() << ".";
-      return false;
-    }
-    return true;
-  };
-  for (const auto& arg : fdef->signature().input_arg()) {
-    if (!validate_arg(arg)) {
-      (*out_metadata)->use_multi_device_function_ = false;
-      return Status::OK();
-    }
-  }
-  for (const auto& arg : fdef->signature().output_arg()) {
-    if (!validate_arg(arg)) {
-      (*out_metadata)->use_multi_device_function_ = false;
-      return Status::OK();
-    }
-  }
+Status FunctionMetadata::Create(
+    NameAttrList&& func, std::unique_ptr<FunctionLibraryDefinition> lib_def,
+    Params params, std::shared_ptr<FunctionMetadata>* out_metadata) {
+  out_metadata->reset(new FunctionMetadata(std::move(func), params));
+  (*out_metadata)->lib_def_ = std::move(lib_def);
+  const FunctionDef* fdef;
+  TF_RETURN_IF_ERROR(LookupFunction(*(*out_metadata)->lib_def(),
+                                    (*out_metadata)->func().name(), &fdef));
+  (*out_metadata)->use_multi_device_function_ = UseMultiDeviceFunction(*fdef);
   return Status::OK();
 }
 
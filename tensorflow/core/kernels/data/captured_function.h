@@ -77,6 +77,15 @@ class FunctionMetadata {
                        NameAttrList&& func, Params params,
                        std::shared_ptr<FunctionMetadata>* out_metadata);
 
+  // Creates a new instance of the `FunctionMetadata` class for a function which
+  // is defined in `lib_def` rather than in the function library of the kernel,
+  // such as a function generated at runtime. The function is always executed
+  // as a whole, without short-circuiting.
+  static Status Create(NameAttrList&& func,
+                       std::unique_ptr<FunctionLibraryDefinition> lib_def,
+                       Params params,
+                       std::shared_ptr<FunctionMetadata>* out_metadata);
+
   // Returns the named list of function arguments.
   const NameAttrList& func() const { return func_; }
 
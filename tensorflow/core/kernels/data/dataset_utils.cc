@@ -48,14 +48,42 @@ constexpr char kNumComponents[] = "num_components";
 Status WriteElementsToCheckpoint(
     IteratorStateWriter* writer, StringPiece key_prefix,
     const std::vector<std::vector<Tensor>>& elements) {
+  auto it = elements.begin();
+  return WriteElementsToCheckpoint(
+      writer, key_prefix, elements.size(),
+      [&it](std::vector<Tensor>* element) {
+        *element = *it++;
+        return Status::OK();
+      });
+}
+
+Status ReadElementsFromCheckpoint(IteratorStateReader* reader,
+                                  StringPiece key_prefix,
+                                  std::vector<std::vector<Tensor>>* elements) {
+  // Element `i` is restored into `elements->at(i)`, so that callers may pass a
+  // pre-sized buffer (e.g. the shuffle buffer) whose first slots are filled.
+  int64 i = 0;
+  return ReadElementsFromCheckpoint(
+      reader, key_prefix, [elements, &i](std::vector<Tensor> element) {
+        elements->emplace_back();
+        elements->at(i++) = std::move(element);
+        return Status::OK();
+      });
+}
+
+Status WriteElementsToCheckpoint(
+    IteratorStateWriter* writer, StringPiece key_prefix, int64 num_elements,
+    const std::function<Status(std::vector<Tensor>*)>& next_element) {
   TF_RETURN_IF_ERROR(
-      writer->WriteScalar(key_prefix, kNumElements, elements.size()));
-  for (int i = 0; i < elements.size(); ++i) {
-    const std::vector<Tensor>& element = elements[i];
+      writer->WriteScalar(key_prefix, kNumElements, num_elements));
+  std::vector<Tensor> element;
+  for (int64 i = 0; i < num_elements; ++i) {
+    element.clear();
+    TF_RETURN_IF_ERROR(next_element(&element));
     std::string element_prefix = absl::StrCat(key_prefix, "::", i);
     TF_RETURN_IF_ERROR(
         writer->WriteScalar(element_prefix, kNumComponents, element.size()));
-    for (int j = 0; j < elements[i].size(); ++j) {
+    for (int j = 0; j < element.size(); ++j) {
       TF_RETURN_IF_ERROR(writer->WriteTensor(
           element_prefix, absl::StrCat(kComponent, "[", j, "]"), element[j]));
     }
@@ -63,27 +91,23 @@ Status WriteElementsToCheckpoint(
   return Status::OK();
 }
 
-Status ReadElementsFromCheckpoint(IteratorStateReader* reader,
-                                  StringPiece key_prefix,
-                                  std::vector<std::vector<Tensor>>* elements) {
+Status ReadElementsFromCheckpoint(
+    IteratorStateReader* reader, StringPiece key_prefix,
+    const std::function<Status(std::vector<Tensor>)>& consume_element) {
   int64 num_elements;
   TF_RETURN_IF_ERROR(
       reader->ReadScalar(key_prefix, kNumElements, &num_elements));
-  elements->reserve(num_elements);
-  for (int i = 0; i < num_elements; ++i) {
+  for (int64 i = 0; i < num_elements; ++i) {
     std::string element_prefix = absl::StrCat(key_prefix, "::", i);
     int64 num_components;
     TF_RETURN_IF_ERROR(
         reader->ReadScalar(element_prefix, kNumComponents, &num_components));
-    elements->emplace_back();
-    std::vector<Tensor>& element = elements->at(i);
-    element.reserve(num_components);
+    std::vector<Tensor> element(num_components);
     for (int j = 0; j < num_components; ++j) {
-      element.emplace_back();
       TF_RETURN_IF_ERROR(reader->ReadTensor(
-          element_prefix, absl::StrCat(kComponent, "[", j, "]"),
-          &element.back()));
+          element_prefix, absl::StrCat(kComponent, "[", j, "]"), &element[j]));
     }
+    TF_RETURN_IF_ERROR(consume_element(std::move(element)));
   }
   return Status::OK();
 }
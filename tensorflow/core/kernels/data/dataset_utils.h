@@ -15,6 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_DATA_DATASET_UTILS_H_
 #define TENSORFLOW_CORE_KERNELS_DATA_DATASET_UTILS_H_
 
+#include <functional>
+
 #include "tensorflow/core/common_runtime/function.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -118,6 +120,19 @@ Status ReadElementsFromCheckpoint(IteratorStateReader* reader,
                                   StringPiece key_prefix,
                                   std::vector<std::vector<Tensor>>* elements);
 
+// Like the above, but writes the `num_elements` elements returned by
+// successive calls to `next_element`, so that they need not all be held in
+// memory.
+Status WriteElementsToCheckpoint(
+    IteratorStateWriter* writer, StringPiece key_prefix, int64 num_elements,
+    const std::function<Status(std::vector<Tensor>*)>& next_element);
+
+// Like the above, but passes each element to `consume_element` as soon as it
+// is read instead of collecting them.
+Status ReadElementsFromCheckpoint(
+    IteratorStateReader* reader, StringPiece key_prefix,
+    const std::function<Status(std::vector<Tensor>)>& consume_element);
+
 // Dataset op level determinism policy.
 class DeterminismPolicy {
  public:
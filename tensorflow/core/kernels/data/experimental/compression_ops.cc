@@ -23,7 +23,9 @@ namespace data {
 namespace experimental {
 
 CompressElementOp::CompressElementOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx) {}
+    : OpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kCodec, &codec_));
+}
 
 void CompressElementOp::Compute(OpKernelContext* ctx) {
   std::vector<Tensor> components;
@@ -31,7 +33,7 @@ void CompressElementOp::Compute(OpKernelContext* ctx) {
     components.push_back(ctx->input(i));
   }
   CompressedElement compressed;
-  OP_REQUIRES_OK(ctx, CompressElement(components, &compressed));
+  OP_REQUIRES_OK(ctx, CompressElement(components, codec_, &compressed));
 
   Tensor* output;
   OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
@@ -49,12 +51,34 @@ void UncompressElementOp::Compute(OpKernelContext* ctx) {
   const Variant& variant = tensor.scalar<Variant>()();
   const CompressedElement* compressed = variant.get<CompressedElement>();
 
+  OP_REQUIRES(ctx, compressed != nullptr,
+              errors::InvalidArgument(
+                  "Expected a CompressedElement variant tensor, but got ",
+                  variant.TypeName()));
+  OP_REQUIRES(ctx,
+              compressed->component_metadata_size() == output_types_.size(),
+              errors::FailedPrecondition(
+                  "Expected ", output_types_.size(),
+                  " outputs from uncompress, but got ",
+                  compressed->component_metadata_size()));
+
+  // Uncompress memcopyable components directly into the output tensors.
+  auto allocate_output = [this, ctx](int index, DataType dtype,
+                                     const TensorShape& shape,
+                                     Tensor* tensor) -> Status {
+    if (dtype != output_types_[index]) {
+      return errors::FailedPrecondition(
+          "Expected a tensor of type ", DataTypeString(output_types_[index]),
+          " but got a tensor of type ", DataTypeString(dtype));
+    }
+    Tensor* output;
+    TF_RETURN_IF_ERROR(ctx->allocate_output(index, shape, &output));
+    *tensor = *output;
+    return Status::OK();
+  };
   std::vector<Tensor> components;
-  OP_REQUIRES_OK(ctx, UncompressElement(*compressed, &components));
-  OP_REQUIRES(ctx, components.size() == output_types_.size(),
-              errors::FailedPrecondition("Expected ", output_types_.size(),
-                                         " outputs from uncompress, but got ",
-                                         components.size()));
+  OP_REQUIRES_OK(ctx,
+                 UncompressElement(*compressed, allocate_output, &components));
   for (int i = 0; i < components.size(); ++i) {
     OP_REQUIRES(
         ctx, components[i].dtype() == output_types_[i],
@@ -62,7 +86,9 @@ void UncompressElementOp::Compute(OpKernelContext* ctx) {
                                    DataTypeString(output_types_[i]),
                                    " but got a tensor of type ",
                                    DataTypeString(components[i].dtype())));
-    ctx->set_output(i, components[i]);
+    if (!DataTypeCanUseMemcpy(components[i].dtype())) {
+      ctx->set_output(i, components[i]);
+    }
   }
 }
 
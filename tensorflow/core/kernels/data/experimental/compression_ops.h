@@ -23,9 +23,14 @@ namespace experimental {
 
 class CompressElementOp : public OpKernel {
  public:
+  static constexpr const char* const kCodec = "codec";
+
   explicit CompressElementOp(OpKernelConstruction* ctx);
 
   void Compute(OpKernelContext* ctx) override;
+
+ private:
+  std::string codec_;
 };
 
 class UncompressElementOp : public OpKernel {
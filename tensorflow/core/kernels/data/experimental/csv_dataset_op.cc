@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstring>
+
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
@@ -26,6 +28,60 @@ namespace data {
 namespace experimental {
 namespace {
 
+// Finds the end of unquoted fields, i.e. the first delimiter, line break or
+// (when quoted fields are enabled) stray quote. Scans eight bytes at a time,
+// which matters for wide records and long string fields.
+class FieldEndScanner {
+ public:
+  FieldEndScanner(char delim, bool use_quote_delim) {
+    AddSpecialChar(delim);
+    AddSpecialChar('\n');
+    AddSpecialChar('\r');
+    if (use_quote_delim) AddSpecialChar('"');
+  }
+
+  // Returns a pointer to the first special character in [begin, end), or
+  // `end` if there is none.
+  const char* Find(const char* begin, const char* end) const {
+    const char* p = begin;
+    for (; end - p >= kWordSize; p += kWordSize) {
+      uint64 word;
+      std::memcpy(&word, p, kWordSize);
+      uint64 found = 0;
+      for (int i = 0; i < num_patterns_; ++i) {
+        found |= HasZeroByte(word ^ patterns_[i]);
+      }
+      // `found` tells whether the word has a special character, but not
+      // reliably where, so the word is searched again byte by byte.
+      if (found != 0) break;
+    }
+    for (; p < end; ++p) {
+      if (is_special_[static_cast<uint8>(*p)]) return p;
+    }
+    return end;
+  }
+
+ private:
+  static constexpr ptrdiff_t kWordSize = sizeof(uint64);
+  static constexpr uint64 kOnes = 0x0101010101010101ULL;
+  static constexpr uint64 kHighBits = 0x8080808080808080ULL;
+
+  // Returns a non-zero value iff one of the bytes of `word` is zero.
+  static uint64 HasZeroByte(uint64 word) {
+    return (word - kOnes) & ~word & kHighBits;
+  }
+
+  void AddSpecialChar(char c) {
+    if (is_special_[static_cast<uint8>(c)]) return;
+    is_special_[static_cast<uint8>(c)] = true;
+    patterns_[num_patterns_++] = kOnes * static_cast<uint8>(c);
+  }
+
+  bool is_special_[256] = {};
+  uint64 patterns_[4];
+  int num_patterns_ = 0;
+};
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx)
@@ -180,6 +236,7 @@ class CSVDatasetOp : public DatasetOpKernel {
           exclude_cols_(std::move(exclude_cols)),
           use_quote_delim_(use_quote_delim),
           delim_(delim),
+          field_end_scanner_(delim, use_quote_delim),
           na_value_(std::move(na_value)),
           op_version_(op_version),
           use_compression_(!compression_type.empty()),
@@ -502,7 +559,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         pos_++;  // Starting quotation mark
 
         Status parse_result;
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter finds 1 quote, filling buffer if necessary
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             if (errors::IsOutOfRange(s)) {
@@ -514,49 +571,52 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
-          char ch = buffer_[pos_];
-          if (ch == '"') {
-            // When we encounter a quote, we look ahead to the next character to
-            // decide what to do
-            pos_++;
-            if (pos_ >= buffer_.size()) {
-              Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
-              if (errors::IsOutOfRange(s)) {
-                // This was the last field. We are done
-                *end_of_record = true;
-                parse_result.Update(QuotedFieldToOutput(
-                    ctx, StringPiece(), out_tensors, earlier_pieces, include));
-                return parse_result;
-              } else if (!s.ok()) {
-                return s;
-              }
-            }
-
-            char next = buffer_[pos_];
-            pos_++;
-            if (next == dataset()->delim_) {
-              parse_result.Update(QuotedFieldToOutput(
-                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
-                  out_tensors, earlier_pieces, include));
-              return parse_result;
-
-            } else if (next == '\n' || next == '\r') {
+          // Skip to the next quote, which either ends the field or escapes
+          // another quote.
+          const char* quote = static_cast<const char*>(
+              std::memchr(&buffer_[pos_], '"', buffer_.size() - pos_));
+          if (quote == nullptr) {
+            pos_ = buffer_.size();
+            continue;
+          }
+          pos_ = quote - buffer_.data();
+          // When we encounter a quote, we look ahead to the next character to
+          // decide what to do
+          pos_++;
+          if (pos_ >= buffer_.size()) {
+            Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
+            if (errors::IsOutOfRange(s)) {
+              // This was the last field. We are done
               *end_of_record = true;
               parse_result.Update(QuotedFieldToOutput(
-                  ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
-                  out_tensors, earlier_pieces, include));
-              if (next == '\r') SkipNewLineIfNecessary();
+                  ctx, StringPiece(), out_tensors, earlier_pieces, include));
               return parse_result;
-            } else if (next != '"') {
-              // Take note of the error, but keep going to end of field.
-              include = false;  // So we don't get funky errors when trying to
-                                // unescape the quotes.
-              parse_result.Update(errors::InvalidArgument(
-                  "Quote inside a string has to be escaped by another quote"));
+            } else if (!s.ok()) {
+              return s;
             }
+          }
 
-          } else {
-            pos_++;
+          char next = buffer_[pos_];
+          pos_++;
+          if (next == dataset()->delim_) {
+            parse_result.Update(QuotedFieldToOutput(
+                ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
+                out_tensors, earlier_pieces, include));
+            return parse_result;
+
+          } else if (next == '\n' || next == '\r') {
+            *end_of_record = true;
+            parse_result.Update(QuotedFieldToOutput(
+                ctx, StringPiece(&buffer_[start], pos_ - 1 - start),
+                out_tensors, earlier_pieces, include));
+            if (next == '\r') SkipNewLineIfNecessary();
+            return parse_result;
+          } else if (next != '"') {
+            // Take note of the error, but keep going to end of field.
+            include = false;  // So we don't get funky errors when trying to
+                              // unescape the quotes.
+            parse_result.Update(errors::InvalidArgument(
+                "Quote inside a string has to be escaped by another quote"));
           }
         }
       }
@@ -635,7 +695,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        while (true) {  // Each iter finds 1 special char, or refills the buffer
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -651,8 +711,13 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
-          char ch = buffer_[pos_];
+          const char* buffer_end = buffer_.data() + buffer_.size();
+          const char* field_end =
+              dataset()->field_end_scanner_.Find(&buffer_[pos_], buffer_end);
+          pos_ = field_end - buffer_.data();
+          if (field_end == buffer_end) continue;
 
+          char ch = *field_end;
           if (ch == dataset()->delim_) {
             parse_result.Update(UnquotedFieldToOutput(
                 ctx, StringPiece(&buffer_[start], pos_ - start), out_tensors,
@@ -909,6 +974,7 @@ class CSVDatasetOp : public DatasetOpKernel {
     const std::vector<int64> exclude_cols_;
     const bool use_quote_delim_;
     const char delim_;
+    const FieldEndScanner field_end_scanner_;
     const tstring na_value_;
     const int op_version_;
     const bool use_compression_;
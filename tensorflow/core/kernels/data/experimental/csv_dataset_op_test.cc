@@ -0,0 +1,250 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "csv_dataset";
+constexpr char kDatasetType[] = "CSV";
+constexpr int kOpVersion = 2;
+
+tstring LocalTempFilename() {
+  std::string path;
+  CHECK(Env::Default()->LocalTempFilename(&path));
+  return tstring(path);
+}
+
+// Reads `num_columns` string columns, which default to the empty string.
+class CSVDatasetParams : public DatasetParams {
+ public:
+  CSVDatasetParams(tstring filename, int64 buffer_size, char field_delim,
+                   bool use_quote_delim, int num_columns, string node_name)
+      : DatasetParams(DataTypeVector(num_columns, DT_STRING),
+                      std::vector<PartialTensorShape>(num_columns,
+                                                      PartialTensorShape({})),
+                      std::move(node_name)),
+        filename_(std::move(filename)),
+        buffer_size_(buffer_size),
+        field_delim_(1, field_delim),
+        use_quote_delim_(use_quote_delim),
+        num_columns_(num_columns) {
+    op_version_ = kOpVersion;
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    std::vector<Tensor> input_tensors = {
+        CreateTensor<tstring>(TensorShape({1}), {filename_}),
+        CreateTensor<tstring>(TensorShape({}), {""}),
+        CreateTensor<int64>(TensorShape({}), {buffer_size_}),
+        CreateTensor<bool>(TensorShape({}), {false}),
+        CreateTensor<tstring>(TensorShape({}), {field_delim_}),
+        CreateTensor<bool>(TensorShape({}), {use_quote_delim_}),
+        CreateTensor<tstring>(TensorShape({}), {""}),
+        CreateTensor<int64>(TensorShape({0}), {})};
+    for (int i = 0; i < num_columns_; ++i) {
+      input_tensors.push_back(CreateTensor<tstring>(TensorShape({1}), {""}));
+    }
+    input_tensors.push_back(CreateTensor<int64>(TensorShape({0}), {}));
+    return input_tensors;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {"filenames",  "compression_type", "buffer_size",
+                    "header",     "field_delim",      "use_quote_delim",
+                    "na_value",   "select_cols"};
+    for (int i = 0; i < num_columns_; ++i) {
+      input_names->push_back(absl::StrCat("record_defaults_", i));
+    }
+    input_names->push_back("exclude_cols");
+    return Status::OK();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{"output_types", output_dtypes_},
+                    {"output_shapes", output_shapes_}};
+    return Status::OK();
+  }
+
+  string dataset_type() const override { return kDatasetType; }
+
+ private:
+  tstring filename_;
+  int64 buffer_size_;
+  tstring field_delim_;
+  bool use_quote_delim_;
+  int num_columns_;
+};
+
+class CSVDatasetOpTest : public DatasetOpsTestBase {};
+
+CSVDatasetParams CreateCSVDatasetParams(const string& contents,
+                                        int64 buffer_size, char field_delim,
+                                        bool use_quote_delim,
+                                        int num_columns) {
+  tstring filename = LocalTempFilename();
+  Status s = WriteDataToFile(filename, contents.c_str());
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to create the test file " << filename << ": " << s;
+  }
+  return CSVDatasetParams(filename, buffer_size, field_delim, use_quote_delim,
+                          num_columns, kNodeName);
+}
+
+// The unquoted fields are scanned eight bytes at a time from their first
+// character. These records have fields of 1 to 17 characters, so that their
+// delimiters and line breaks fall on every offset around the 8-byte words.
+std::vector<std::vector<string>> WordBoundaryRecords() {
+  std::vector<std::vector<string>> records;
+  for (int length = 1; length <= 17; ++length) {
+    records.push_back({string(length, 'a'), string(length, 'b'),
+                       string(length, 'c')});
+  }
+  return records;
+}
+
+// Joins `records`, alternating between LF and CRLF line breaks.
+string JoinRecords(const std::vector<std::vector<string>>& records,
+                   char field_delim) {
+  string contents;
+  for (int i = 0; i < records.size(); ++i) {
+    absl::StrAppend(&contents,
+                    absl::StrJoin(records[i], string(1, field_delim)),
+                    i % 2 == 0 ? "\n" : "\r\n");
+  }
+  return contents;
+}
+
+std::vector<Tensor> RecordsToTensors(
+    const std::vector<std::vector<string>>& records) {
+  std::vector<Tensor> tensors;
+  for (const auto& record : records) {
+    for (const string& field : record) {
+      tensors.push_back(CreateTensor<tstring>(TensorShape({}), {field}));
+    }
+  }
+  return tensors;
+}
+
+// Test case 1: unquoted fields ending around 8-byte words, with quoted fields
+// enabled.
+CSVDatasetParams CSVDatasetParams1() {
+  return CreateCSVDatasetParams(JoinRecords(WordBoundaryRecords(), ','),
+                                /*buffer_size=*/1024, /*field_delim=*/',',
+                                /*use_quote_delim=*/true, /*num_columns=*/3);
+}
+
+// Test case 2: same as 1, with a tab delimiter and without quoted fields.
+CSVDatasetParams CSVDatasetParams2() {
+  return CreateCSVDatasetParams(JoinRecords(WordBoundaryRecords(), '\t'),
+                                /*buffer_size=*/1024, /*field_delim=*/'\t',
+                                /*use_quote_delim=*/false, /*num_columns=*/3);
+}
+
+// Test case 3: without quoted fields, quotes on 8-byte word boundaries are
+// part of the field.
+CSVDatasetParams CSVDatasetParams3() {
+  return CreateCSVDatasetParams(
+      "abcdefg\"|abcdefgh\"\r\n\"abcdefghijklmno\"|x\n",
+      /*buffer_size=*/1024, /*field_delim=*/'|',
+      /*use_quote_delim=*/false, /*num_columns=*/2);
+}
+
+// Records with quoted fields that contain delimiters, escaped quotes and line
+// breaks, and whose last record does not end with a line break.
+constexpr char kQuotedRecords[] =
+    "\"a quoted field, with \"\"escaped\"\" quotes\",12345678\r\n"
+    "\"x\"\"y\",abcdefghijklmnopq\n"
+    "12345678,\"line\r\nbreak\"\r\n"
+    "1234567,\"\"\n"
+    "last,\"quoted\"";
+
+std::vector<Tensor> QuotedRecordsOutputs() {
+  return RecordsToTensors({{"a quoted field, with \"escaped\" quotes",
+                            "12345678"},
+                           {"x\"y", "abcdefghijklmnopq"},
+                           {"12345678", "line\r\nbreak"},
+                           {"1234567", ""},
+                           {"last", "quoted"}});
+}
+
+// Test cases 4 to 7: small buffers, so that fields, escaped quotes and CRLF
+// line breaks span buffer refills. With a buffer of 1 byte, every quoted field
+// and every CRLF spans a refill.
+CSVDatasetParams QuotedRecordsParams(int64 buffer_size) {
+  return CreateCSVDatasetParams(kQuotedRecords, buffer_size,
+                                /*field_delim=*/',', /*use_quote_delim=*/true,
+                                /*num_columns=*/2);
+}
+
+std::vector<GetNextTestCase<CSVDatasetParams>> GetNextTestCases() {
+  return {
+      {/*dataset_params=*/CSVDatasetParams1(),
+       /*expected_outputs=*/RecordsToTensors(WordBoundaryRecords())},
+      {/*dataset_params=*/CSVDatasetParams2(),
+       /*expected_outputs=*/RecordsToTensors(WordBoundaryRecords())},
+      {/*dataset_params=*/CSVDatasetParams3(),
+       /*expected_outputs=*/
+       RecordsToTensors({{"abcdefg\"", "abcdefgh\""},
+                         {"\"abcdefghijklmno\"", "x"}})},
+      {/*dataset_params=*/QuotedRecordsParams(/*buffer_size=*/1),
+       /*expected_outputs=*/QuotedRecordsOutputs()},
+      {/*dataset_params=*/QuotedRecordsParams(/*buffer_size=*/3),
+       /*expected_outputs=*/QuotedRecordsOutputs()},
+      {/*dataset_params=*/QuotedRecordsParams(/*buffer_size=*/8),
+       /*expected_outputs=*/QuotedRecordsOutputs()},
+      {/*dataset_params=*/QuotedRecordsParams(/*buffer_size=*/9),
+       /*expected_outputs=*/QuotedRecordsOutputs()}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(CSVDatasetOpTest, CSVDatasetParams,
+                         GetNextTestCases())
+
+class ParameterizedQuoteOnWordBoundaryTest
+    : public CSVDatasetOpTest,
+      public ::testing::WithParamInterface<int64> {};
+
+TEST_P(ParameterizedQuoteOnWordBoundaryTest, UnquotedFieldWithQuote) {
+  // The quotes are at offsets 7, 8 and 16 of the fields. The fields fit in the
+  // buffer of 1024 bytes and span the refills of the buffer of 5 bytes.
+  auto dataset_params = CreateCSVDatasetParams(
+      "abcdefg\",x\nabcdefgh\",x\r\nabcdefgh12345678\",x\nok,row\n",
+      /*buffer_size=*/GetParam(), /*field_delim=*/',',
+      /*use_quote_delim=*/true, /*num_columns=*/2);
+  TF_ASSERT_OK(Initialize(dataset_params));
+
+  bool end_of_sequence = false;
+  std::vector<Tensor> next;
+  for (int i = 0; i < 3; ++i) {
+    next.clear();
+    EXPECT_EQ(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence).code(),
+        error::INVALID_ARGUMENT);
+  }
+  next.clear();
+  TF_ASSERT_OK(
+      iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+  ASSERT_FALSE(end_of_sequence);
+  TF_EXPECT_OK(ExpectEqual(next, RecordsToTensors({{"ok", "row"}}),
+                           /*compare_order=*/true));
+}
+
+INSTANTIATE_TEST_SUITE_P(CSVDatasetOpTest,
+                         ParameterizedQuoteOnWordBoundaryTest,
+                         ::testing::Values(5, 1024));
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
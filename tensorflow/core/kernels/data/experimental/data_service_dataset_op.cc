@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/data_service.h"
 #include "tensorflow/core/data/service/grpc_util.h"
+#include "tensorflow/core/data/service/worker_load.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/model.h"
@@ -35,11 +36,15 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/serialization_utils.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -65,6 +70,22 @@ const int64 kRetryTimeoutMicros = 1000LL * 1000 * 60 * 60;  // 60 minutes.
 // Default interval between task list refreshes.
 const int64 kDefaultTaskRefreshIntervalMs = 1000;  // 1 second.
 
+// Whether clients should favor tasks whose workers respond quickly, instead of
+// reading from all tasks in turn.
+bool LoadAwareReads() {
+  static const bool load_aware_reads = []() {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_DATA_SERVICE_LOAD_AWARE_READS",
+                                  /*default_val=*/false, &value);
+    if (!s.ok()) {
+      LOG(WARNING) << s;
+      return false;
+    }
+    return value;
+  }();
+  return load_aware_reads;
+}
+
 }  // namespace
 
 // Dataset for reading data from the tf.data service non-deterministically.
@@ -182,8 +203,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     explicit Iterator(const Params& params, int64 iterator_index)
         : DatasetIterator<Dataset>(params),
           iterator_index_(iterator_index),
-          max_outstanding_requests_(params.dataset->max_outstanding_requests_) {
-    }
+          load_aware_reads_(LoadAwareReads()),
+          max_outstanding_requests_(params.dataset->max_outstanding_requests_),
+          parent_generator_(random::New64(), random::New64()),
+          generator_(&parent_generator_) {}
 
     ~Iterator() override {
       VLOG(1) << "Destroying data service dataset iterator for job id "
@@ -319,6 +342,9 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       bool in_use TF_GUARDED_BY(&Iterator::mu_) = false;
       // Indicates whether the worker has returned end_of_sequence for the task.
       bool end_of_sequence TF_GUARDED_BY(&Iterator::mu_) = false;
+      // Moving average of the time to get an element for the task, or 0 if no
+      // element has been received yet.
+      double latency_estimate_micros TF_GUARDED_BY(&Iterator::mu_) = 0;
     };
 
     // Periodically refresh the task list.
@@ -434,10 +460,15 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       });
       VLOG(1) << "Starting worker thread";
       std::shared_ptr<Task> task_to_process;
+      int64 latency_micros = -1;
       while (true) {
         {
           mutex_lock l(mu_);
           if (task_to_process) {
+            if (latency_micros >= 0) {
+              UpdateLatencyEstimate(latency_micros,
+                                    &task_to_process->latency_estimate_micros);
+            }
             task_to_process->in_use = false;
             task_to_process = nullptr;
             worker_thread_cv_.notify_one();
@@ -460,23 +491,28 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
             return;
           }
           // Search for a task to update.
-          int num_tasks = tasks_.size();
-          for (int i = 0; i < num_tasks; ++i) {
-            int index = (next_task_index_ + i) % num_tasks;
-            std::shared_ptr<Task>& task = tasks_[index];
-            if (!task->in_use && !task->end_of_sequence) {
-              task->in_use = true;
-              task_to_process = task;
-              next_task_index_ = (index + 1) % num_tasks;
-              break;
+          if (load_aware_reads_) {
+            task_to_process = ChooseLowLatencyTask();
+          } else {
+            int num_tasks = tasks_.size();
+            for (int i = 0; i < num_tasks; ++i) {
+              int index = (next_task_index_ + i) % num_tasks;
+              std::shared_ptr<Task>& task = tasks_[index];
+              if (!task->in_use && !task->end_of_sequence) {
+                task_to_process = task;
+                next_task_index_ = (index + 1) % num_tasks;
+                break;
+              }
             }
           }
           DCHECK(task_to_process != nullptr);
+          task_to_process->in_use = true;
           VLOG(3) << "Processing task " << task_to_process->task_id;
         }
-        int64 deadline_micros =
-            Env::Default()->NowMicros() + kRetryTimeoutMicros;
+        const int64 start_micros = Env::Default()->NowMicros();
+        int64 deadline_micros = start_micros + kRetryTimeoutMicros;
         Status s = GetElement(task_to_process.get(), deadline_micros);
+        latency_micros = Env::Default()->NowMicros() - start_micros;
         if (!s.ok()) {
           mutex_lock l(mu_);
           VLOG(1) << "Failed to get element from worker "
@@ -557,6 +593,25 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       return Status::OK();
     }
 
+    // Picks an available task, favoring tasks which have been answering
+    // quickly.
+    std::shared_ptr<Task> ChooseLowLatencyTask()
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<std::shared_ptr<Task>> candidates;
+      std::vector<double> latency_estimates_micros;
+      for (const std::shared_ptr<Task>& task : tasks_) {
+        if (!task->in_use && !task->end_of_sequence) {
+          candidates.push_back(task);
+          latency_estimates_micros.push_back(task->latency_estimate_micros);
+        }
+      }
+      if (candidates.empty()) {
+        return nullptr;
+      }
+      return candidates[data::ChooseLowLatencyTask(latency_estimates_micros,
+                                                   generator_.RandDouble())];
+    }
+
     bool SpaceInBuffer() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       return results_.size() + outstanding_requests_ <
              max_outstanding_requests_;
@@ -567,6 +622,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     }
 
     const int64 iterator_index_;
+    // Whether to favor fast tasks over reading from all tasks in turn.
+    const bool load_aware_reads_;
 
     mutex mu_;
     condition_variable get_next_cv_ TF_GUARDED_BY(mu_);
@@ -588,6 +645,10 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // The index of the next task in `tasks_` to read from.
     int64 next_task_index_ TF_GUARDED_BY(mu_) = 0;
 
+    // Randomness for choosing tasks when `load_aware_reads_` is set.
+    random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
+    random::SimplePhilox generator_ TF_GUARDED_BY(mu_);
+
     // The number tasks in the `tasks_` list that have reached end_of_sequence.
     int64 finished_tasks_ TF_GUARDED_BY(mu_) = 0;
 
@@ -15,14 +15,17 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include <deque>
 #include <queue>
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -32,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/path.h"
@@ -39,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -49,6 +54,23 @@ namespace snapshot_util {
 /* static */ constexpr const int64
     CustomReader::kSnappyReaderOutputBufferSizeBytes;
 
+namespace {
+
+// Environment variable which sets the number of elements that each shard of a
+// snapshot decodes ahead of its consumer. Reading ahead is disabled by default.
+constexpr char kReadAheadElementsEnvVar[] =
+    "TF_DATA_SNAPSHOT_READ_AHEAD_ELEMENTS";
+
+// Threads which decode snapshot shards ahead of their consumers. The pool is
+// shared by all shards, which bounds the number of concurrent decodes.
+thread::ThreadPool* ReadAheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "snapshot_read_ahead", port::MaxParallelism());
+  return pool;
+}
+
+}  // namespace
+
 std::string HashDirectory(const std::string& path, uint64 hash) {
   return io::JoinPath(
       path, strings::Printf("%llu", static_cast<unsigned long long>(hash)));
@@ -344,14 +366,16 @@ class Reader::Dataset : public DatasetBase {
   explicit Dataset(const std::string& shard_dir, const std::string& compression,
                    const int64 version, const DataTypeVector& dtypes,
                    const std::vector<PartialTensorShape>& shapes,
-                   const int64 start_index, DatasetContext::Params params)
+                   const int64 start_index, const int64 read_ahead_elements,
+                   DatasetContext::Params params)
       : DatasetBase(DatasetContext(std::move(params))),
         shard_dir_(shard_dir),
         compression_(compression),
         version_(version),
         dtypes_(dtypes),
         shapes_(shapes),
-        start_index_(start_index) {}
+        start_index_(start_index),
+        read_ahead_elements_(read_ahead_elements) {}
 
   const DataTypeVector& output_dtypes() const override { return dtypes_; }
 
@@ -390,10 +414,17 @@ class Reader::Dataset : public DatasetBase {
     explicit Iterator(const Params& params)
         : DatasetIterator<Dataset>(params), current_checkpoint_id_(0) {}
 
+    ~Iterator() override {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      while (reading_) {
+        cond_var_.wait(l);
+      }
+    }
+
     Status Initialize(IteratorContext* ctx) override {
-      TF_RETURN_IF_ERROR(Reader::Create(
-          ctx->env(), GetCurrentFilename(), dataset()->compression_,
-          dataset()->version_, dataset()->dtypes_, &reader_));
+      env_ = ctx->env();
+      TF_RETURN_IF_ERROR(OpenCurrentFile());
       bool end_of_sequence;
       for (int64 i = 0; i < dataset()->start_index_; ++i) {
         // TODO(frankchn): Optimize this to not parse every single element.
@@ -407,18 +438,26 @@ class Reader::Dataset : public DatasetBase {
     Status GetNextInternal(IteratorContext* ctx,
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) override {
-      *end_of_sequence = false;
-      Status s = reader_->ReadTensors(out_tensors);
-      if (!errors::IsOutOfRange(s)) {
-        return s;
+      if (dataset()->read_ahead_elements_ <= 0) {
+        return ReadElement(out_tensors, end_of_sequence);
+      }
+      mutex_lock l(mu_);
+      MaybeStartReadAhead();
+      while (buffer_.empty() && reading_) {
+        cond_var_.wait(l);
       }
-      Status status = AdvanceToNextFile(ctx->env());
-      if (errors::IsNotFound(status)) {
-        *end_of_sequence = true;
-        return Status::OK();
-      } else {
-        return status;
+      if (buffer_.empty()) {
+        // The end of the shard or an error has already been returned. Keep
+        // returning the error, as the reader can't move past it.
+        *end_of_sequence = status_.ok();
+        return status_;
       }
+      BufferedElement element = std::move(buffer_.front());
+      buffer_.pop_front();
+      MaybeStartReadAhead();
+      *out_tensors = std::move(element.value);
+      *end_of_sequence = element.end_of_sequence;
+      return element.status;
     }
 
     Status SaveInternal(SerializationContext* ctx,
@@ -438,24 +477,129 @@ class Reader::Dataset : public DatasetBase {
     }
 
    private:
+    struct BufferedElement {
+      Status status;
+      std::vector<Tensor> value;
+      bool end_of_sequence = false;
+    };
+
     std::string GetCurrentFilename() {
       return GetCheckpointFileName(dataset()->shard_dir_,
                                    current_checkpoint_id_);
     }
 
-    Status AdvanceToNextFile(Env* env) {
-      current_checkpoint_id_++;
-      TF_RETURN_IF_ERROR(env->FileExists(GetCurrentFilename()));
-      return Reader::Create(env, GetCurrentFilename(), dataset()->compression_,
+    Status OpenCurrentFile() {
+      file_start_micros_ = EnvTime::NowMicros();
+      return Reader::Create(env_, GetCurrentFilename(), dataset()->compression_,
                             dataset()->version_, dataset()->dtypes_, &reader_);
     }
 
+    Status AdvanceToNextFile() {
+      const uint64 elapsed_micros = EnvTime::NowMicros() - file_start_micros_;
+      uint64 file_size;
+      if (elapsed_micros > 0 &&
+          env_->GetFileSize(GetCurrentFilename(), &file_size).ok()) {
+        metrics::RecordTFDataSnapshotReadThroughput(file_size * 1e6 /
+                                                    elapsed_micros);
+      }
+      current_checkpoint_id_++;
+      TF_RETURN_IF_ERROR(env_->FileExists(GetCurrentFilename()));
+      return OpenCurrentFile();
+    }
+
+    // Reads the next element of the shard, moving on to the next file of the
+    // shard at the end of the current one.
+    Status ReadElement(std::vector<Tensor>* out_tensors,
+                       bool* end_of_sequence) {
+      *end_of_sequence = false;
+      while (true) {
+        const uint64 start_micros = EnvTime::NowMicros();
+        Status s = reader_->ReadTensors(out_tensors);
+        if (s.ok()) {
+          metrics::RecordTFDataSnapshotDecodeTime(EnvTime::NowMicros() -
+                                                  start_micros);
+          metrics::RecordTFDataSnapshotBytesRead(GetTotalBytes(*out_tensors));
+          return Status::OK();
+        }
+        if (!errors::IsOutOfRange(s)) {
+          return s;
+        }
+        out_tensors->clear();
+        Status status = AdvanceToNextFile();
+        if (errors::IsNotFound(status)) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(status);
+      }
+    }
+
+    // Schedules reads until `read_ahead_elements_` elements are buffered,
+    // unless reads are already scheduled.
+    void MaybeStartReadAhead() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (reading_ || done_ || cancelled_ ||
+          buffer_.size() >=
+              static_cast<size_t>(dataset()->read_ahead_elements_)) {
+        return;
+      }
+      reading_ = true;
+      ReadAheadThreadPool()->Schedule([this]() { ReadAhead(); });
+    }
+
+    // Reads elements into `buffer_` until it is full. Rather than waiting for
+    // the consumer, returns the thread to the pool once the buffer is full.
+    void ReadAhead() {
+      while (true) {
+        {
+          mutex_lock l(mu_);
+          if (cancelled_ || buffer_.size() >= static_cast<size_t>(
+                                dataset()->read_ahead_elements_)) {
+            reading_ = false;
+            cond_var_.notify_all();
+            return;
+          }
+        }
+        // Only one `ReadAhead()` runs at a time, so the reader can be used
+        // without holding `mu_`.
+        BufferedElement element;
+        element.status = ReadElement(&element.value, &element.end_of_sequence);
+        mutex_lock l(mu_);
+        const bool last = !element.status.ok() || element.end_of_sequence;
+        if (last) {
+          status_ = element.status;
+          done_ = true;
+          reading_ = false;
+        }
+        buffer_.push_back(std::move(element));
+        cond_var_.notify_all();
+        if (last) {
+          return;
+        }
+      }
+    }
+
+    Env* env_ = nullptr;
     std::unique_ptr<Reader> reader_;
 
     // Stores the id current checkpoint file that we are in the process of
     // reading (e.g. if the file is currently 00000001.snapshot, then this will
     // be 1).
     uint64 current_checkpoint_id_;
+
+    // Time at which the current file was opened.
+    uint64 file_start_micros_ = 0;
+
+    mutex mu_;
+    condition_variable cond_var_;
+    // Elements read ahead of the consumer, in order.
+    std::deque<BufferedElement> buffer_ TF_GUARDED_BY(mu_);
+    // Whether `ReadAhead()` is scheduled or running.
+    bool reading_ TF_GUARDED_BY(mu_) = false;
+    // Whether the end of the shard or an error has been buffered.
+    bool done_ TF_GUARDED_BY(mu_) = false;
+    // The error that ended the read-ahead, if any.
+    Status status_ TF_GUARDED_BY(mu_);
+    bool cancelled_ TF_GUARDED_BY(mu_) = false;
   };
 
   const std::string shard_dir_;
@@ -464,6 +608,9 @@ class Reader::Dataset : public DatasetBase {
   const DataTypeVector dtypes_;
   const std::vector<PartialTensorShape> shapes_;
   const int64 start_index_;
+  // Number of elements to decode ahead of the consumer, or 0 to decode
+  // elements on the consumer's thread.
+  const int64 read_ahead_elements_;
 };
 
 class Reader::NestedDataset : public DatasetBase {
@@ -567,6 +714,9 @@ Status Reader::MakeNestedDataset(Env* env,
                                  const int64 start_index,
                                  DatasetBase** output) {
   std::vector<DatasetBase*> datasets;
+  int64 read_ahead_elements;
+  TF_RETURN_IF_ERROR(
+      ReadInt64FromEnvVar(kReadAheadElementsEnvVar, 0, &read_ahead_elements));
 
   datasets.reserve(shard_dirs.size());
   for (const auto& shard_dir : shard_dirs) {
@@ -579,7 +729,7 @@ Status Reader::MakeNestedDataset(Env* env,
 
     datasets.push_back(
         new Dataset(shard_dir, compression_type, version, dtypes, shapes,
-                    dataset_start_index,
+                    dataset_start_index, read_ahead_elements,
                     DatasetContext::Params({"snapshot_util::Reader::Dataset",
                                             "snapshot_util_reader_Dataset"})));
   }
@@ -15,11 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/experimental/snapshot_util.h"
 
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -91,6 +95,181 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kSnappy, 2);
 }
 
+constexpr char kReadAheadElementsEnvVar[] =
+    "TF_DATA_SNAPSHOT_READ_AHEAD_ELEMENTS";
+
+// Reads the shards of snapshots through `Reader::MakeNestedDataset`, with the
+// number of elements read ahead given by the test parameter.
+class SnapshotReaderTest : public DatasetOpsTestBase,
+                           public ::testing::WithParamInterface<int> {
+ protected:
+  void SetUp() override {
+    // Only the iterator context of this dataset is used.
+    TF_ASSERT_OK(Initialize(RangeDatasetParams(0, 0, 1)));
+    setenv(kReadAheadElementsEnvVar, std::to_string(GetParam()).c_str(),
+           /*overwrite=*/1);
+  }
+
+  void TearDown() override { unsetenv(kReadAheadElementsEnvVar); }
+
+  // Writes a shard whose file `i` holds the scalars `files[i]`, and returns
+  // its directory.
+  std::string WriteShard(const std::string& name,
+                         const std::vector<std::vector<int64>>& files) {
+    const std::string shard_dir = io::JoinPath(testing::TmpDir(), name);
+    int64 undeleted_files, undeleted_dirs;
+    Env::Default()
+        ->DeleteRecursively(shard_dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(shard_dir));
+    for (int i = 0; i < files.size(); ++i) {
+      std::unique_ptr<Writer> writer;
+      TF_CHECK_OK(Writer::Create(Env::Default(),
+                                 GetCheckpointFileName(shard_dir, i),
+                                 io::compression::kNone, /*version=*/2,
+                                 {DT_INT64}, &writer));
+      for (int64 value : files[i]) {
+        TF_CHECK_OK(writer->WriteTensors({Tensor(value)}));
+      }
+      TF_CHECK_OK(writer->Close());
+    }
+    return shard_dir;
+  }
+
+  // Flips a byte of the first record of file `file_index` of the shard, so
+  // that reading it fails its checksum.
+  void CorruptFile(const std::string& shard_dir, int file_index) {
+    const std::string filename = GetCheckpointFileName(shard_dir, file_index);
+    std::string contents;
+    TF_CHECK_OK(ReadFileToString(Env::Default(), filename, &contents));
+    // Skip the length and its checksum.
+    CHECK_GT(contents.size(), 12u);
+    contents[12] ^= 0xff;
+    TF_CHECK_OK(WriteStringToFile(Env::Default(), filename, contents));
+  }
+
+  // Makes iterators over the shards of the snapshot in `shard_dirs`, starting
+  // at element `start_index` of the snapshot.
+  void MakeShardIterators(
+      const std::vector<std::string>& shard_dirs, int64 start_index,
+      std::vector<std::unique_ptr<IteratorBase>>* shard_iterators) {
+    DatasetBase* nested_dataset;
+    TF_ASSERT_OK(Reader::MakeNestedDataset(
+        Env::Default(), shard_dirs, io::compression::kNone, /*version=*/2,
+        {DT_INT64}, {PartialTensorShape({})}, start_index, &nested_dataset));
+    Tensor nested_dataset_tensor(DT_VARIANT, TensorShape({}));
+    TF_ASSERT_OK(
+        StoreDatasetInVariantTensor(nested_dataset, &nested_dataset_tensor));
+    std::unique_ptr<IteratorBase> nested_iterator;
+    TF_ASSERT_OK(nested_dataset->MakeIterator(
+        iterator_ctx_.get(), /*parent=*/nullptr, "nested", &nested_iterator));
+    bool end_of_sequence = false;
+    while (true) {
+      std::vector<Tensor> shard;
+      TF_ASSERT_OK(nested_iterator->GetNext(iterator_ctx_.get(), &shard,
+                                            &end_of_sequence));
+      if (end_of_sequence) break;
+      ASSERT_EQ(shard.size(), 1);
+      shard_tensors_.push_back(shard[0]);
+      DatasetBase* shard_dataset;
+      TF_ASSERT_OK(GetDatasetFromVariantTensor(shard[0], &shard_dataset));
+      shard_iterators->emplace_back();
+      TF_ASSERT_OK(shard_dataset->MakeIterator(
+          iterator_ctx_.get(), /*parent=*/nullptr,
+          absl::StrCat("shard", shard_iterators->size()),
+          &shard_iterators->back()));
+    }
+  }
+
+  // Reads `iterator` to the end, and returns the values read.
+  std::vector<int64> ReadShard(IteratorBase* iterator) {
+    std::vector<int64> values;
+    bool end_of_sequence = false;
+    while (true) {
+      std::vector<Tensor> element;
+      TF_CHECK_OK(
+          iterator->GetNext(iterator_ctx_.get(), &element, &end_of_sequence));
+      if (end_of_sequence) break;
+      // Moving to the next file of a shard must not produce empty elements.
+      CHECK_EQ(element.size(), 1);
+      values.push_back(element[0].scalar<int64>()());
+    }
+    return values;
+  }
+
+ private:
+  // Own the shard datasets.
+  std::vector<Tensor> shard_tensors_;
+};
+
+TEST_P(SnapshotReaderTest, ReadsMultipleFilesPerShard) {
+  const std::vector<std::string> shard_dirs = {
+      WriteShard("multi_file_shard_0", {{0, 2}, {4}, {6, 8}}),
+      WriteShard("multi_file_shard_1", {{1, 3, 5}, {7}})};
+  std::vector<std::unique_ptr<IteratorBase>> iterators;
+  MakeShardIterators(shard_dirs, /*start_index=*/0, &iterators);
+  ASSERT_EQ(iterators.size(), 2);
+  EXPECT_EQ(ReadShard(iterators[0].get()), (std::vector<int64>{0, 2, 4, 6, 8}));
+  EXPECT_EQ(ReadShard(iterators[1].get()), (std::vector<int64>{1, 3, 5, 7}));
+}
+
+TEST_P(SnapshotReaderTest, SkipsEmptyFiles) {
+  const std::vector<std::string> shard_dirs = {
+      WriteShard("empty_file_shard", {{0}, {}, {}, {1, 2}, {}})};
+  std::vector<std::unique_ptr<IteratorBase>> iterators;
+  MakeShardIterators(shard_dirs, /*start_index=*/0, &iterators);
+  ASSERT_EQ(iterators.size(), 1);
+  EXPECT_EQ(ReadShard(iterators[0].get()), (std::vector<int64>{0, 1, 2}));
+}
+
+TEST_P(SnapshotReaderTest, RestoresInTheMiddleOfAFile) {
+  const std::vector<std::string> shard_dirs = {
+      WriteShard("restore_shard_0", {{0, 2, 4}, {6, 8}}),
+      WriteShard("restore_shard_1", {{1, 3, 5}, {7, 9}})};
+  // Restoring at element 7 of the snapshot skips 4 elements of the first
+  // shard and 3 of the second one, and starts with the second shard.
+  std::vector<std::unique_ptr<IteratorBase>> iterators;
+  MakeShardIterators(shard_dirs, /*start_index=*/7, &iterators);
+  ASSERT_EQ(iterators.size(), 2);
+  EXPECT_EQ(ReadShard(iterators[0].get()), (std::vector<int64>{7, 9}));
+  EXPECT_EQ(ReadShard(iterators[1].get()), (std::vector<int64>{8}));
+
+  // Element 1 of the second file of the first shard.
+  iterators.clear();
+  MakeShardIterators({shard_dirs[0]}, /*start_index=*/4, &iterators);
+  ASSERT_EQ(iterators.size(), 1);
+  EXPECT_EQ(ReadShard(iterators[0].get()), (std::vector<int64>{8}));
+}
+
+TEST_P(SnapshotReaderTest, ReturnsErrorOfCorruptFile) {
+  const std::string shard_dir =
+      WriteShard("corrupt_shard", {{0, 1}, {2, 3}, {4}});
+  CorruptFile(shard_dir, /*file_index=*/1);
+  std::vector<std::unique_ptr<IteratorBase>> iterators;
+  MakeShardIterators({shard_dir}, /*start_index=*/0, &iterators);
+  ASSERT_EQ(iterators.size(), 1);
+
+  bool end_of_sequence = false;
+  for (int64 expected : {0, 1}) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(iterators[0]->GetNext(iterator_ctx_.get(), &element,
+                                       &end_of_sequence));
+    ASSERT_FALSE(end_of_sequence);
+    EXPECT_EQ(element[0].scalar<int64>()(), expected);
+  }
+  // The error does not turn into the end of the shard on later calls.
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Tensor> element;
+    Status s = iterators[0]->GetNext(iterator_ctx_.get(), &element,
+                                     &end_of_sequence);
+    EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+    EXPECT_FALSE(end_of_sequence);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(ReadAhead, SnapshotReaderTest,
+                         ::testing::Values(0, 1, 4));
+
 void SnapshotReaderBenchmarkLoop(int iters, std::string compression_type,
                                  int version) {
   tensorflow::testing::StopTiming();
@@ -32,6 +32,12 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/util/batch_util.h"
+#include "tensorflow/core/util/env_var.h"
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization_utils.h"
+#endif  // !IS_MOBILE_PLATFORM
 
 namespace tensorflow {
 namespace data {
@@ -67,6 +73,115 @@ constexpr char kErrorMessage[] = "error_message";
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
+// Environment variable which sets the number of input elements to which a
+// vectorized version of the map function is applied at once. Micro-batching is
+// disabled by default.
+constexpr char kMicroBatchSizeEnvVar[] = "TF_DATA_MAP_MICRO_BATCH_SIZE";
+
+// Creates the metadata of a function which applies the map function of the
+// `ctx` op, described by `metadata`, to a batch of input elements at once.
+// Fails if some operation of the map function cannot be vectorized.
+Status CreateVectorizedFunction(OpKernelConstruction* ctx,
+                                const FunctionMetadata& metadata,
+                                FunctionMetadata::Params params,
+                                std::shared_ptr<FunctionMetadata>* out) {
+#if defined(IS_MOBILE_PLATFORM)
+  return errors::Unimplemented(
+      "Map vectorization is not supported on mobile platforms.");
+#else
+  if (!metadata.short_circuit_info().indices.empty()) {
+    return errors::FailedPrecondition(
+        "The map function returns its inputs unchanged.");
+  }
+  const FunctionDef* fdef = metadata.lib_def()->Find(metadata.func().name());
+  if (fdef == nullptr) {
+    return errors::NotFound("Could not find the map function ",
+                            metadata.func().name());
+  }
+  // Applying a stateful function to a batch would not be equivalent to
+  // applying it to each element in turn.
+  if (grappler::function_utils::IsFunctionStateful(*metadata.lib_def(),
+                                                   *fdef)) {
+    return errors::FailedPrecondition("The map function is stateful.");
+  }
+  FunctionDefLibrary library = metadata.lib_def()->ToProto();
+  FunctionDef* wrapper = grappler::vectorization_utils::CreateMapDefunWrapper(
+      ctx->def(), *fdef, &library);
+  FunctionDef* vectorized;
+  TF_RETURN_IF_ERROR(grappler::vectorization_utils::VectorizeMapDefun(
+      *wrapper, wrapper->node_def(0), &library, &vectorized));
+  // A remaining MapDefun op would still invoke the map function once per
+  // element.
+  for (const NodeDef& node : vectorized->node_def()) {
+    if (node.op() == "MapDefun") {
+      return errors::Unimplemented(
+          "Some operations of the map function cannot be vectorized.");
+    }
+  }
+  NameAttrList func;
+  func.set_name(vectorized->signature().name());
+  return FunctionMetadata::Create(
+      std::move(func),
+      absl::make_unique<FunctionLibraryDefinition>(OpRegistry::Global(),
+                                                   library),
+      params, out);
+#endif  // IS_MOBILE_PLATFORM
+}
+
+// Stacks the components of `elements`, which must have matching types and
+// shapes, into `batch`.
+Status BatchElements(std::vector<std::vector<Tensor>>* elements,
+                     std::vector<Tensor>* batch) {
+  const std::vector<Tensor>& first = elements->front();
+  const int64 num_elements = elements->size();
+  batch->clear();
+  batch->reserve(first.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    for (const auto& element : *elements) {
+      if (element.size() != first.size() ||
+          element[i].dtype() != first[i].dtype() ||
+          element[i].shape() != first[i].shape()) {
+        return errors::InvalidArgument(
+            "Input elements have different types or shapes.");
+      }
+    }
+    TensorShape batch_shape = first[i].shape();
+    batch_shape.InsertDim(0, num_elements);
+    batch->emplace_back(first[i].dtype(), batch_shape);
+  }
+  for (int64 index = 0; index < num_elements; ++index) {
+    std::vector<Tensor>& element = (*elements)[index];
+    for (size_t i = 0; i < element.size(); ++i) {
+      // Keep the element, which may be needed if the batch cannot be mapped.
+      TF_RETURN_IF_ERROR(
+          batch_util::CopyElementToSlice(element[i], &(*batch)[i], index));
+    }
+  }
+  return Status::OK();
+}
+
+// Splits the components of `batch` into `num_elements` elements.
+Status UnbatchElements(const std::vector<Tensor>& batch, int64 num_elements,
+                       std::vector<std::vector<Tensor>>* elements) {
+  elements->assign(num_elements, std::vector<Tensor>());
+  for (const Tensor& component : batch) {
+    if (component.dims() == 0 || component.dim_size(0) != num_elements) {
+      return errors::InvalidArgument(
+          "Vectorized map function returned a component of shape ",
+          component.shape().DebugString(), " for a batch of ", num_elements,
+          " elements.");
+    }
+    TensorShape element_shape = component.shape();
+    element_shape.RemoveDim(0);
+    for (int64 index = 0; index < num_elements; ++index) {
+      (*elements)[index].emplace_back(component.dtype(), element_shape);
+      TF_RETURN_IF_ERROR(batch_util::CopySliceToElement(
+          component, &(*elements)[index].back(), index));
+    }
+  }
+  return Status::OK();
+}
+
 }  // namespace
 
 class ParallelMapDatasetOp::Dataset : public DatasetBase {
@@ -76,7 +191,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           const std::vector<PartialTensorShape>& output_shapes,
           DeterminismPolicy deterministic,
           std::unique_ptr<CapturedFunction> captured_func,
-          bool preserve_cardinality, int op_version)
+          std::unique_ptr<CapturedFunction> vectorized_func,
+          int64 micro_batch_size, bool preserve_cardinality, int op_version)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         num_parallel_calls_(num_parallel_calls),
@@ -85,6 +201,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         deterministic_(deterministic),
         preserve_cardinality_(preserve_cardinality),
         captured_func_(std::move(captured_func)),
+        vectorized_func_(std::move(vectorized_func)),
+        micro_batch_size_(vectorized_func_ ? micro_batch_size : 1),
         op_version_(op_version) {
     input_->Ref();
   }
@@ -209,6 +327,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           deterministic_(params.dataset->deterministic_.IsDeterministic() ||
                          params.dataset->deterministic_.IsDefault()),
           preserve_cardinality_(params.dataset->preserve_cardinality_),
+          micro_batch_size_(params.dataset->micro_batch_size_),
           autotune_(params.dataset->num_parallel_calls_ == model::kAutotune) {}
 
     ~Iterator() override {
@@ -226,6 +345,15 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           [this]() { CancelThreads(/*wait=*/false); }, &deregister_fn_));
       TF_RETURN_IF_ERROR(
           dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+      if (dataset()->vectorized_func_) {
+        Status s = dataset()->vectorized_func_->Instantiate(
+            ctx, &instantiated_vectorized_func_);
+        if (!s.ok()) {
+          VLOG(1) << "Mapping one element at a time, as the vectorized map "
+                  << "function cannot be instantiated: " << s;
+          micro_batch_size_ = 1;
+        }
+      }
       return dataset()->captured_func_->Instantiate(
           ctx, &instantiated_captured_func_);
     }
@@ -424,7 +552,15 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         CallCompleted(ctx, result);
         return;
       }
+      RunFunction(ctx, result, std::move(input_element));
+    }
 
+    // Applies the map function to `input_element`, storing the result in
+    // `result->return_values`.
+    void RunFunction(const std::shared_ptr<IteratorContext>& ctx,
+                     const std::shared_ptr<InvocationResult>& result,
+                     std::vector<Tensor> input_element)
+        TF_LOCKS_EXCLUDED(*mu_) {
       auto done = [this, ctx, result](Status status) {
         result->status.Update(status);
         RecordBufferEnqueue(ctx.get(), result->return_values);
@@ -462,6 +598,94 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       }
     }
 
+    // Applies the vectorized map function to the next `results.size()` input
+    // elements at once, and splits its outputs among `results`. Falls back to
+    // applying the map function to each element when the elements cannot be
+    // batched or when the vectorized function fails.
+    void CallBatchedFunction(
+        const std::shared_ptr<IteratorContext>& ctx,
+        const std::vector<std::shared_ptr<InvocationResult>>& results)
+        TF_LOCKS_EXCLUDED(*mu_) {
+      profiler::TraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "ParallelMapProduceBatch",
+            {{"element_id", results.front()->id},
+             {"num_elements", results.size()}});
+      });
+      auto batch_results =
+          std::make_shared<std::vector<std::shared_ptr<InvocationResult>>>();
+      auto input_elements =
+          std::make_shared<std::vector<std::vector<Tensor>>>();
+      for (const auto& result : results) {
+        std::vector<Tensor> input_element;
+        result->status = input_impl_->GetNext(ctx.get(), &input_element,
+                                              &result->end_of_input);
+        if (result->end_of_input || !result->status.ok()) {
+          CallCompleted(ctx, result);
+          continue;
+        }
+        batch_results->push_back(result);
+        input_elements->push_back(std::move(input_element));
+      }
+      auto run_each = [this, ctx, batch_results, input_elements]() {
+        for (size_t i = 0; i < batch_results->size(); ++i) {
+          RunFunction(ctx, (*batch_results)[i],
+                      std::move((*input_elements)[i]));
+        }
+      };
+      std::vector<Tensor> batch;
+      if (batch_results->size() < 2 ||
+          !BatchElements(input_elements.get(), &batch).ok()) {
+        run_each();
+        return;
+      }
+
+      auto return_values = std::make_shared<std::vector<Tensor>>();
+      auto done = [this, ctx, batch_results, return_values,
+                   run_each](Status status) {
+        std::vector<std::vector<Tensor>> elements;
+        if (status.ok()) {
+          status = UnbatchElements(*return_values, batch_results->size(),
+                                   &elements);
+        }
+        if (!status.ok()) {
+          // Mapping the elements one at a time reports any error against the
+          // element which raises it.
+          VLOG(2) << "Vectorized map function failed: " << status;
+          run_each();
+          return;
+        }
+        for (size_t i = 0; i < batch_results->size(); ++i) {
+          const auto& result = (*batch_results)[i];
+          result->return_values = std::move(elements[i]);
+          RecordBufferEnqueue(ctx.get(), result->return_values);
+          CallCompleted(ctx, result);
+        }
+      };
+
+      if (dataset()->vectorized_func_->use_inter_op_parallelism()) {
+        instantiated_vectorized_func_->RunAsync(
+            ctx.get(), std::move(batch), return_values.get(), std::move(done),
+            model_node());
+      } else {
+        auto fn = std::bind(
+            [this, ctx, return_values](std::vector<Tensor> batch) {
+              return instantiated_vectorized_func_->Run(
+                  ctx.get(), std::move(batch), return_values.get());
+            },
+            std::move(batch));
+        RecordStop(ctx.get());
+        (*ctx->runner())(
+            [this, ctx, fn = std::move(fn), done = std::move(done)]() {
+              RecordStart(ctx.get());
+              auto cleanup =
+                  gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
+              done(fn());
+            });
+        RecordStart(ctx.get());
+      }
+    }
+
     Status ProcessResult(IteratorContext* ctx,
                          const std::shared_ptr<InvocationResult>& result,
                          std::vector<Tensor>* out_tensors,
@@ -500,10 +724,14 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         tf_shared_lock l(*mu_);  // mu_ == num_parallel_calls_->mu
         new_calls.reserve(num_parallel_calls_->value);
       }
+      // With micro-batching, each of the `num_parallel_calls` calls maps
+      // `micro_batch_size_` elements, and calls are only started once there
+      // is room for all of their elements.
       auto busy = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
         int64 num_parallel_calls = num_parallel_calls_->value;
-        return num_calls_ >= num_parallel_calls ||
-               invocation_results_.size() >= num_parallel_calls;
+        int64 capacity = num_parallel_calls * micro_batch_size_;
+        return num_calls_ + micro_batch_size_ > capacity ||
+               invocation_results_.size() + micro_batch_size_ > capacity;
       };
       // Counts the total number of calls to use as an id of InvocationResult.
       int64 num_total_calls = 0;
@@ -519,15 +747,24 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
             return;
           }
           while (!busy()) {
-            invocation_results_.push_back(
-                std::make_shared<InvocationResult>(num_total_calls++));
-            new_calls.push_back(invocation_results_.back());
-            num_calls_++;
+            for (int64 i = 0; i < micro_batch_size_; ++i) {
+              invocation_results_.push_back(
+                  std::make_shared<InvocationResult>(num_total_calls++));
+              new_calls.push_back(invocation_results_.back());
+              num_calls_++;
+            }
           }
           cond_var_->notify_all();
         }
-        for (const auto& call : new_calls) {
-          CallFunction(ctx, call);
+        if (micro_batch_size_ == 1) {
+          for (const auto& call : new_calls) {
+            CallFunction(ctx, call);
+          }
+        } else {
+          for (auto it = new_calls.begin(); it != new_calls.end();
+               it += micro_batch_size_) {
+            CallBatchedFunction(ctx, {it, it + micro_batch_size_});
+          }
         }
         new_calls.clear();
       }
@@ -634,10 +871,13 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     const std::shared_ptr<model::SharedState> num_parallel_calls_;
     const bool deterministic_;
     const bool preserve_cardinality_;
+    // Number of elements mapped by each invocation of the vectorized function.
+    int64 micro_batch_size_;
     const bool autotune_;
     // Counts the number of outstanding calls.
     int64 num_calls_ TF_GUARDED_BY(*mu_) = 0;
     std::unique_ptr<InstantiatedCapturedFunction> instantiated_captured_func_;
+    std::unique_ptr<InstantiatedCapturedFunction> instantiated_vectorized_func_;
     std::unique_ptr<IteratorBase> input_impl_;
     // Buffer for storing the invocation results.
     std::deque<std::shared_ptr<InvocationResult>> invocation_results_
@@ -658,6 +898,10 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
   const DeterminismPolicy deterministic_;
   const bool preserve_cardinality_;
   const std::unique_ptr<CapturedFunction> captured_func_;
+  // Applies the map function to a batch of elements, or null if the map
+  // function cannot be vectorized.
+  const std::unique_ptr<CapturedFunction> vectorized_func_;
+  const int64 micro_batch_size_;
   const int op_version_;
 };
 
@@ -688,6 +932,18 @@ ParallelMapDatasetOp::ParallelMapDatasetOp(OpKernelConstruction* ctx)
   }
   OP_REQUIRES_OK(ctx,
                  ctx->GetAttr(kPreserveCardinality, &preserve_cardinality_));
+  OP_REQUIRES_OK(ctx, ReadInt64FromEnvVar(kMicroBatchSizeEnvVar,
+                                          /*default_val=*/1,
+                                          &micro_batch_size_));
+  if (micro_batch_size_ > 1) {
+    Status s = CreateVectorizedFunction(ctx, *func_metadata_, params,
+                                        &vectorized_func_metadata_);
+    if (!s.ok()) {
+      VLOG(1) << "Mapping one element at a time, as the map function cannot "
+              << "be vectorized: " << s;
+      vectorized_func_metadata_ = nullptr;
+    }
+  }
 }
 
 void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -711,6 +967,12 @@ void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   OP_REQUIRES_OK(ctx,
                  CapturedFunction::Create(ctx, func_metadata_, kOtherArguments,
                                           &captured_func));
+  std::unique_ptr<CapturedFunction> vectorized_func;
+  if (vectorized_func_metadata_) {
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, vectorized_func_metadata_,
+                                                 kOtherArguments,
+                                                 &vectorized_func));
+  }
 
   if (num_parallel_calls == model::kAutotune) {
     metrics::RecordTFDataAutotune(kDatasetType);
@@ -719,6 +981,7 @@ void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   *output =
       new Dataset(ctx, input, num_parallel_calls, output_types_, output_shapes_,
                   deterministic_, std::move(captured_func),
+                  std::move(vectorized_func), micro_batch_size_,
                   preserve_cardinality_, op_version_);
 }
 
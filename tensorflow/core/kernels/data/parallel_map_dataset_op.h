@@ -49,6 +49,10 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
   class Dataset;
   const int op_version_;
   std::shared_ptr<FunctionMetadata> func_metadata_ = nullptr;
+  // Metadata of the vectorized map function, or null if micro-batching is
+  // disabled or the map function cannot be vectorized.
+  std::shared_ptr<FunctionMetadata> vectorized_func_metadata_ = nullptr;
+  int64 micro_batch_size_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   bool sloppy_;
@@ -11,8 +11,15 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/parallel_map_dataset_op.h"
 
+#include <atomic>
+
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/grappler/optimizers/data/vectorization/vectorizer_registry.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/kernels/data/name_utils.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 
 namespace tensorflow {
 namespace data {
@@ -21,6 +28,63 @@ namespace {
 constexpr char kNodeName[] = "parallel_map_dataset";
 constexpr int kOpVersion = 2;
 
+// An identity op counting its invocations, used to check how many times the
+// map function is called.
+std::atomic<int64> num_counting_identity_calls(0);
+
+REGISTER_OP("CountingIdentity")
+    .Input("x: int32")
+    .Output("y: int32")
+    .SetShapeFn(shape_inference::UnchangedShape);
+
+class CountingIdentityOp : public OpKernel {
+ public:
+  explicit CountingIdentityOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    ++num_counting_identity_calls;
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(Name("CountingIdentity").Device(DEVICE_CPU),
+                        CountingIdentityOp);
+
+// `CountingIdentity` is elementwise, so it is vectorized by applying it to the
+// whole batch.
+class CountingIdentityVectorizer : public grappler::Vectorizer {
+ public:
+  Status Vectorize(const Node& node, Graph* outer_scope,
+                   grappler::VectorizerInput&& inputs,
+                   grappler::VectorizerOutput* outputs) override {
+    NodeBuilder::NodeOut input;
+    TF_RETURN_IF_ERROR(inputs.stacked(0, &input));
+    Node* new_node;
+    TF_RETURN_IF_ERROR(NodeBuilder(strings::StrCat("vectorized/", node.name()),
+                                   node.type_string())
+                           .Input(input)
+                           .Finalize(outer_scope, &new_node));
+    outputs->push_back({new_node, 0, true});
+    return Status::OK();
+  }
+};
+
+REGISTER_VECTORIZER("CountingIdentity", CountingIdentityVectorizer);
+
+FunctionDef CountingIdentityInt32() {
+  return FunctionDefHelper::Define(
+      // Name
+      "CountingIdentityInt32",
+      // Args
+      {"x: int32"},
+      // Return values
+      {"y: int32"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"y"}, "CountingIdentity", {"x"}, {}}});
+}
+
 class ParallelMapDatasetParams : public DatasetParams {
  public:
   template <typename T>
@@ -268,6 +332,26 @@ ParallelMapDatasetParams ParallelMapDatasetParamsWithInvalidNumParallelCalls() {
       /*node_name=*/kNodeName);
 }
 
+// Maps 10 int32 elements with `CountingIdentityInt32`.
+ParallelMapDatasetParams CountingIdentityDatasetParams() {
+  return ParallelMapDatasetParams(
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<int32>(TensorShape({10}),
+                                              {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+          /*node_name=*/"tensor_slice"),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/2,
+      /*func=*/FunctionDefHelper::FunctionRef("CountingIdentityInt32"),
+      /*func_lib*/ {CountingIdentityInt32()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT32},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+}
+
 std::vector<GetNextTestCase<ParallelMapDatasetParams>> GetNextTestCases() {
   return {{/*dataset_params=*/ParallelMapDatasetParams1(),
            /*expected_outputs=*/
@@ -412,6 +496,76 @@ TEST_F(ParallelMapDatasetOpTest, InvalidNumParallelCalls) {
             tensorflow::error::INVALID_ARGUMENT);
 }
 
+TEST_F(ParallelMapDatasetOpTest, MicroBatching) {
+  setenv("TF_DATA_MAP_MICRO_BATCH_SIZE", "4", /*overwrite=*/1);
+  auto unset_env =
+      gtl::MakeCleanup([] { unsetenv("TF_DATA_MAP_MICRO_BATCH_SIZE"); });
+  // `XTimesTwoInt32` can be vectorized. The 10 elements are mapped in two
+  // batches of 4 elements and one batch of 2 elements.
+  auto dataset_params = ParallelMapDatasetParams(
+      TensorSliceDatasetParams(
+          /*components=*/{CreateTensor<int32>(TensorShape({10}),
+                                              {0, 1, 2, 3, 4, 5, 6, 7, 8, 9})},
+          /*node_name=*/"tensor_slice"),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/2,
+      /*func=*/FunctionDefHelper::FunctionRef("XTimesTwoInt32"),
+      /*func_lib*/ {test::function::XTimesTwoInt32()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT32},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/true,
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int32>(TensorShape{},
+                           {{0}, {2}, {4}, {6}, {8}, {10}, {12}, {14}, {16},
+                            {18}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(ParallelMapDatasetOpTest, CallsFunctionOncePerElement) {
+  num_counting_identity_calls = 0;
+  auto dataset_params = CountingIdentityDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int32>(TensorShape{},
+                           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*compare_order=*/true));
+  EXPECT_EQ(num_counting_identity_calls, 10);
+}
+
+TEST_F(ParallelMapDatasetOpTest, MicroBatchingCallsFunctionOncePerBatch) {
+  setenv("TF_DATA_MAP_MICRO_BATCH_SIZE", "4", /*overwrite=*/1);
+  auto unset_env =
+      gtl::MakeCleanup([] { unsetenv("TF_DATA_MAP_MICRO_BATCH_SIZE"); });
+  // The vectorized function is called once for each of the batches of 4, 4
+  // and 2 elements.
+  num_counting_identity_calls = 0;
+  auto dataset_params = CountingIdentityDatasetParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int32>(TensorShape{},
+                           {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*compare_order=*/true));
+  EXPECT_EQ(num_counting_identity_calls, 3);
+}
+
+TEST_F(ParallelMapDatasetOpTest, MicroBatchingFallback) {
+  setenv("TF_DATA_MAP_MICRO_BATCH_SIZE", "4", /*overwrite=*/1);
+  auto unset_env =
+      gtl::MakeCleanup([] { unsetenv("TF_DATA_MAP_MICRO_BATCH_SIZE"); });
+  // The polymorphic `XTimesTwo` cannot be vectorized, so the elements are
+  // mapped one at a time.
+  auto dataset_params = ParallelMapDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<int64>(TensorShape{}, {{0}, {6}, {12}, {18}}),
+      /*compare_order=*/true));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
+#include <algorithm>
+#include <cstring>
 #include <deque>
 #include <tuple>
 #include <vector>
@@ -31,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace data {
@@ -75,6 +78,202 @@ constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
 constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
+namespace {
+
+// Setting this environment variable to true buffers eligible elements in a
+// CompactShuffleBuffer. The compact buffer produces the same elements in the
+// same order, and writes the same checkpoints, as the default buffer.
+constexpr char kCompactBufferEnvVar[] = "TF_DATA_COMPACT_SHUFFLE_BUFFER";
+
+// Elements whose components all have fully defined shapes and memcpy-able
+// dtypes, and that are no larger than this, can be buffered in a
+// CompactShuffleBuffer. For such elements the per-Tensor allocations and
+// bookkeeping dominate the footprint of the shuffle buffer.
+constexpr int64 kMaxCompactElementBytes = 1024;
+
+// The number of rows a CompactShuffleBuffer allocates on first use.
+constexpr int64 kInitialCompactBufferRows = 1024;
+
+// The number of dequeued elements whose tensors a CompactShuffleBuffer keeps
+// for reuse.
+constexpr int kMaxSpareCompactElements = 16;
+
+bool CompactShuffleBufferEnabled() {
+  bool enabled;
+  Status s = ReadBoolFromEnvVar(kCompactBufferEnvVar, false, &enabled);
+  if (!s.ok()) {
+    LOG(WARNING) << "Not using a compact shuffle buffer: " << s;
+    return false;
+  }
+  return enabled;
+}
+
+// A shuffle buffer that stores component `i` of the element in slot `j` as
+// row `j` of a single contiguous tensor per component. Buffering an element
+// therefore costs no allocation, and moving one between slots is a row copy.
+// The storage grows geometrically as the buffer fills up, up to `capacity`
+// rows.
+class CompactShuffleBuffer {
+ public:
+  // Returns true if elements with the given component dtypes and shapes can be
+  // buffered compactly.
+  static bool IsSupported(const DataTypeVector& dtypes,
+                          const std::vector<PartialTensorShape>& shapes) {
+    if (dtypes.empty()) return false;
+    int64 element_bytes = 0;
+    for (size_t i = 0; i < dtypes.size(); ++i) {
+      if (!DataTypeCanUseMemcpy(dtypes[i]) || !shapes[i].IsFullyDefined()) {
+        return false;
+      }
+      element_bytes += shapes[i].num_elements() * DataTypeSize(dtypes[i]);
+    }
+    return element_bytes <= kMaxCompactElementBytes;
+  }
+
+  CompactShuffleBuffer(const DataTypeVector& dtypes,
+                       const std::vector<PartialTensorShape>& shapes,
+                       int64 capacity)
+      : dtypes_(dtypes), capacity_(capacity) {
+    for (size_t i = 0; i < dtypes_.size(); ++i) {
+      TensorShape shape;
+      shapes[i].AsTensorShape(&shape);
+      row_bytes_.push_back(shape.num_elements() * DataTypeSize(dtypes_[i]));
+      shapes_.push_back(std::move(shape));
+    }
+    spare_elements_.reserve(kMaxSpareCompactElements);
+    Clear();
+  }
+
+  // The number of slots currently backed by storage.
+  int64 rows() const { return rows_; }
+
+  // Copies `element` into slot `index`, growing the storage if necessary.
+  Status Put(int64 index, const std::vector<Tensor>& element) {
+    if (element.size() != dtypes_.size()) {
+      return errors::InvalidArgument("Expected an element with ",
+                                     dtypes_.size(), " components, got ",
+                                     element.size());
+    }
+    for (size_t i = 0; i < element.size(); ++i) {
+      if (element[i].dtype() != dtypes_[i] ||
+          element[i].shape() != shapes_[i]) {
+        return errors::InvalidArgument(
+            "Expected component ", i, " to be a ", DataTypeString(dtypes_[i]),
+            " tensor of shape ", shapes_[i].DebugString(), ", got a ",
+            DataTypeString(element[i].dtype()), " tensor of shape ",
+            element[i].shape().DebugString());
+      }
+    }
+    Reserve(index + 1);
+    for (size_t i = 0; i < element.size(); ++i) {
+      std::memcpy(Row(i, index), element[i].tensor_data().data(),
+                  row_bytes_[i]);
+    }
+    return Status::OK();
+  }
+
+  // Copies the element in slot `index` into newly allocated tensors.
+  void Get(Allocator* allocator, int64 index,
+           std::vector<Tensor>* element) const {
+    Allocate(allocator, element);
+    CopyRow(index, element);
+  }
+
+  // Like `Get`, but reuses the tensors of an element returned by an earlier
+  // call once the caller has released all the references to them, so that
+  // dequeuing does not allocate in the steady state.
+  void GetReusingStorage(Allocator* allocator, int64 index,
+                         std::vector<Tensor>* element) {
+    std::vector<Tensor>* storage = nullptr;
+    for (std::vector<Tensor>& spare : spare_elements_) {
+      if (std::all_of(spare.begin(), spare.end(),
+                      [](const Tensor& t) { return t.RefCountIsOne(); })) {
+        storage = &spare;
+        break;
+      }
+    }
+    if (storage == nullptr) {
+      if (spare_elements_.size() == kMaxSpareCompactElements) {
+        Get(allocator, index, element);
+        return;
+      }
+      spare_elements_.emplace_back();
+      storage = &spare_elements_.back();
+      Allocate(allocator, storage);
+    }
+    CopyRow(index, storage);
+    *element = *storage;
+  }
+
+  // Copies the element in slot `from` into slot `to`.
+  void Move(int64 from, int64 to) {
+    DCHECK_LT(from, rows_);
+    DCHECK_LT(to, rows_);
+    if (from == to) return;
+    for (size_t i = 0; i < dtypes_.size(); ++i) {
+      std::memcpy(Row(i, to), Row(i, from), row_bytes_[i]);
+    }
+  }
+
+  // Releases all storage.
+  void Clear() {
+    slabs_.assign(dtypes_.size(), Tensor());
+    rows_ = 0;
+    spare_elements_.clear();
+  }
+
+ private:
+  void Allocate(Allocator* allocator, std::vector<Tensor>* element) const {
+    element->clear();
+    element->reserve(dtypes_.size());
+    for (size_t i = 0; i < dtypes_.size(); ++i) {
+      element->emplace_back(allocator, dtypes_[i], shapes_[i]);
+    }
+  }
+
+  void CopyRow(int64 index, std::vector<Tensor>* element) const {
+    DCHECK_LT(index, rows_);
+    for (size_t i = 0; i < dtypes_.size(); ++i) {
+      std::memcpy(const_cast<char*>((*element)[i].tensor_data().data()),
+                  Row(i, index), row_bytes_[i]);
+    }
+  }
+
+  char* Row(size_t component, int64 index) const {
+    return const_cast<char*>(slabs_[component].tensor_data().data()) +
+           index * row_bytes_[component];
+  }
+
+  void Reserve(int64 rows) {
+    if (rows <= rows_) return;
+    const int64 new_rows = std::min(
+        capacity_, std::max(rows, std::max(2 * rows_,
+                                           kInitialCompactBufferRows)));
+    for (size_t i = 0; i < dtypes_.size(); ++i) {
+      TensorShape slab_shape({new_rows});
+      slab_shape.AppendShape(shapes_[i]);
+      Tensor slab(dtypes_[i], slab_shape);
+      if (rows_ > 0) {
+        std::memcpy(const_cast<char*>(slab.tensor_data().data()),
+                    slabs_[i].tensor_data().data(), rows_ * row_bytes_[i]);
+      }
+      slabs_[i] = std::move(slab);
+    }
+    rows_ = new_rows;
+  }
+
+  const DataTypeVector dtypes_;
+  std::vector<TensorShape> shapes_;
+  std::vector<int64> row_bytes_;
+  const int64 capacity_;
+  std::vector<Tensor> slabs_;
+  int64 rows_ = 0;
+  // Elements previously returned by `GetReusingStorage`.
+  std::vector<std::vector<Tensor>> spare_elements_;
+};
+
+}  // namespace
+
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx) {}
 
@@ -148,9 +347,17 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           seed_generator_(seed_generator),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
           generator_(&parent_generator_) {
-      buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
-          params.dataset->buffer_size_);
-      slices_.push_back(absl::make_unique<Slice>(0, 0));
+      if (CompactShuffleBufferEnabled() &&
+          CompactShuffleBuffer::IsSupported(params.dataset->output_dtypes(),
+                                            params.dataset->output_shapes())) {
+        compact_buffer_ = absl::make_unique<CompactShuffleBuffer>(
+            params.dataset->output_dtypes(), params.dataset->output_shapes(),
+            params.dataset->buffer_size_);
+      } else {
+        buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
+            params.dataset->buffer_size_);
+      }
+      slices_.emplace_back(0, 0);
     }
 
     Status Initialize(IteratorContext* ctx) override {
@@ -196,8 +403,8 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             return Status::OK();
           }
           epoch_++;
-          int64 n = slices_.back()->end;
-          slices_.push_back(absl::make_unique<Slice>(n, n));
+          int64 n = slices_.back().end;
+          slices_.emplace_back(n, n);
           if (ctx->split_provider()) {
             TF_RETURN_IF_ERROR(ctx->split_provider()->Reset());
           }
@@ -210,10 +417,15 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
                     << this->dataset()->buffer_size_;
           }
           this->RecordBufferEnqueue(ctx, input_element);
-          buffer_->at(slices_.back()->end % this->dataset()->buffer_size_) =
-              std::move(input_element);
+          const int64 index =
+              slices_.back().end % this->dataset()->buffer_size_;
+          if (compact_buffer_) {
+            TF_RETURN_IF_ERROR(compact_buffer_->Put(index, input_element));
+          } else {
+            buffer_->at(index) = std::move(input_element);
+          }
           num_elements_++;
-          slices_.back()->end++;
+          slices_.back().end++;
         } else {
           input_impl_.reset();
         }
@@ -234,7 +446,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         *end_of_sequence = false;
         // Garbage collect all empty slices.
         while (!slices_.empty() &&
-               slices_.front()->start == slices_.front()->end) {
+               slices_.front().start == slices_.front().end) {
           slices_.pop_front();
           // Reinitialize the RNG state for the next epoch.
           num_random_samples_ = 0;
@@ -245,15 +457,21 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // Choose an element to produce uniformly at random from the first
         // slice, and then remove the element from the slice.
         int64 offset =
-            Random() % (slices_.front()->end - slices_.front()->start);
+            Random() % (slices_.front().end - slices_.front().start);
         int64 index =
-            (slices_.front()->start + offset) % this->dataset()->buffer_size_;
-        *out_tensors = std::move(buffer_->at(index));
+            (slices_.front().start + offset) % this->dataset()->buffer_size_;
+        const int64 start_index =
+            slices_.front().start % this->dataset()->buffer_size_;
+        if (compact_buffer_) {
+          compact_buffer_->GetReusingStorage(ctx->allocator({}), index,
+                                             out_tensors);
+          compact_buffer_->Move(start_index, index);
+        } else {
+          *out_tensors = std::move(buffer_->at(index));
+          std::swap(buffer_->at(index), buffer_->at(start_index));
+        }
         this->RecordBufferDequeue(ctx, *out_tensors);
-        std::swap(buffer_->at(index),
-                  buffer_->at(slices_.front()->start %
-                              this->dataset()->buffer_size_));
-        slices_.front()->start++;
+        slices_.front().start++;
         num_elements_--;
       } else {
         DCHECK(input_impl_ == nullptr);
@@ -302,17 +520,32 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      if (compact_buffer_) {
+        // Checkpoint the buffer in the same format as the non-compact buffer,
+        // so that checkpoints do not depend on the buffer representation.
+        std::vector<std::vector<Tensor>> elements(compact_buffer_->rows());
+        for (const Slice& slice : slices_) {
+          for (int64 i = slice.start; i < slice.end; ++i) {
+            const int64 index = i % this->dataset()->buffer_size_;
+            compact_buffer_->Get(cpu_allocator(), index, &elements[index]);
+          }
+        }
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), elements));
+      } else {
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      }
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(this->full_name(absl::StrJoin(
                                     std::make_tuple(kSlicesStart, i), "_")),
-                                slices_[i]->start));
+                                slices_[i].start));
         TF_RETURN_IF_ERROR(writer->WriteScalar(
             this->full_name(absl::StrJoin(std::make_tuple(kSlicesEnd, i), "_")),
-            slices_[i]->end));
+            slices_[i].end));
       }
       if (data_produced_) {
         TF_RETURN_IF_ERROR(
@@ -357,10 +590,22 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->full_name(kSlicesSize), &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
-          this->dataset()->buffer_size_);
-      TF_RETURN_IF_ERROR(
-          ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      if (compact_buffer_) {
+        std::vector<std::vector<Tensor>> elements;
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(reader, prefix(), &elements));
+        compact_buffer_->Clear();
+        for (int64 i = 0; i < elements.size(); ++i) {
+          if (!elements[i].empty()) {
+            TF_RETURN_IF_ERROR(compact_buffer_->Put(i, elements[i]));
+          }
+        }
+      } else {
+        buffer_ = absl::make_unique<std::vector<std::vector<Tensor>>>(
+            this->dataset()->buffer_size_);
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(reader, prefix(), buffer_.get()));
+      }
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64 start;
@@ -372,7 +617,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_RETURN_IF_ERROR(reader->ReadScalar(
             this->full_name(absl::StrJoin(std::make_tuple(kSlicesEnd, i), "_")),
             &end));
-        slices_.push_back(absl::make_unique<Slice>(start, end));
+        slices_.emplace_back(start, end);
       }
       data_produced_ = reader->Contains(this->full_name(kDataProduced));
 
@@ -405,8 +650,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
+    // Exactly one of `buffer_` and `compact_buffer_` is set.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
+    std::unique_ptr<CompactShuffleBuffer> compact_buffer_ TF_GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_) = nullptr;
     int64 epoch_ TF_GUARDED_BY(mu_) = 0;
     int64 num_elements_ TF_GUARDED_BY(mu_) = 0;
@@ -416,7 +663,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     // The slice at the front of the deque references data from the earliest
     // buffered epoch. It is an invariant that all slices reference
     // non-overlapping sections of `buffer_`.
-    std::deque<std::unique_ptr<Slice>> slices_ TF_GUARDED_BY(mu_);
+    std::deque<Slice> slices_ TF_GUARDED_BY(mu_);
     random::PhiloxRandom parent_generator_ TF_GUARDED_BY(mu_);
     random::SingleSampleAdapter<random::PhiloxRandom> generator_
         TF_GUARDED_BY(mu_);
@@ -11,8 +11,10 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/data/shuffle_dataset_op.h"
 
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/data/dataset_test_base.h"
 #include "tensorflow/core/kernels/data/dataset_utils.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 
 namespace tensorflow {
 namespace data {
@@ -20,6 +22,16 @@ namespace {
 
 constexpr char kShuffleNodeName[] = "shuffle_dataset";
 constexpr char kShuffleAndRepeatNodeName[] = "shuffle_and_repeat_dataset";
+constexpr char kCompactBufferEnvVar[] = "TF_DATA_COMPACT_SHUFFLE_BUFFER";
+
+// Selects the shuffle buffer of the iterators created from now on.
+void SetCompactShuffleBuffer(bool enabled) {
+  if (enabled) {
+    setenv(kCompactBufferEnvVar, "true", /*overwrite=*/1);
+  } else {
+    unsetenv(kCompactBufferEnvVar);
+  }
+}
 
 class ShuffleDatasetParams : public DatasetParams {
  public:
@@ -316,56 +328,65 @@ std::vector<GetNextTestCase<ShuffleDatasetParams>> GetNextTestCases() {
 
 class ParameterizedGetNextTest : public ShuffleDatasetOpTest,
                                  public ::testing::WithParamInterface<
-                                     GetNextTestCase<ShuffleDatasetParams>> {};
-
-TEST_P(ParameterizedGetNextTest, GetNext) {
-  auto test_case = GetParam();
-  TF_ASSERT_OK(Initialize(test_case.dataset_params));
-
-  bool end_of_sequence = false;
-  std::vector<Tensor> shuffled_out_tensors;
-  while (!end_of_sequence) {
-    std::vector<Tensor> next;
-    TF_EXPECT_OK(
-        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
-    shuffled_out_tensors.insert(shuffled_out_tensors.end(), next.begin(),
-                                next.end());
-    // For the forever-repeat case, we test only a finite number of steps of
-    // the infinite sequence.
-    if (test_case.dataset_params.count() == -1 &&
-        shuffled_out_tensors.size() ==
-            test_case.expected_shuffle_outputs.size()) {
-      break;
+                                     GetNextTestCase<ShuffleDatasetParams>> {
+ protected:
+  void TestGetNext(const GetNextTestCase<ShuffleDatasetParams>& test_case) {
+    TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+    bool end_of_sequence = false;
+    std::vector<Tensor> shuffled_out_tensors;
+    while (!end_of_sequence) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      shuffled_out_tensors.insert(shuffled_out_tensors.end(), next.begin(),
+                                  next.end());
+      // For the forever-repeat case, we test only a finite number of steps of
+      // the infinite sequence.
+      if (test_case.dataset_params.count() == -1 &&
+          shuffled_out_tensors.size() ==
+              test_case.expected_shuffle_outputs.size()) {
+        break;
+      }
     }
-  }
 
-  // Reshuffle the dataset.
-  end_of_sequence = false;
-  TF_ASSERT_OK(dataset_->MakeIterator(
-      iterator_ctx_.get(), /*parent=*/nullptr,
-      test_case.dataset_params.iterator_prefix(), &iterator_));
-  std::vector<Tensor> reshuffled_out_tensors;
-  while (!end_of_sequence) {
-    std::vector<Tensor> next;
-    TF_EXPECT_OK(
-        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
-    reshuffled_out_tensors.insert(reshuffled_out_tensors.end(), next.begin(),
-                                  next.end());
-    // For the forever-repeat case, we test only a finite number of steps of
-    // the infinite sequence.
-    if (test_case.dataset_params.count() == -1 &&
-        reshuffled_out_tensors.size() ==
-            test_case.expected_shuffle_outputs.size()) {
-      break;
+    // Reshuffle the dataset.
+    end_of_sequence = false;
+    TF_ASSERT_OK(dataset_->MakeIterator(
+        iterator_ctx_.get(), /*parent=*/nullptr,
+        test_case.dataset_params.iterator_prefix(), &iterator_));
+    std::vector<Tensor> reshuffled_out_tensors;
+    while (!end_of_sequence) {
+      std::vector<Tensor> next;
+      TF_EXPECT_OK(
+          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+      reshuffled_out_tensors.insert(reshuffled_out_tensors.end(), next.begin(),
+                                    next.end());
+      // For the forever-repeat case, we test only a finite number of steps of
+      // the infinite sequence.
+      if (test_case.dataset_params.count() == -1 &&
+          reshuffled_out_tensors.size() ==
+              test_case.expected_shuffle_outputs.size()) {
+        break;
+      }
     }
+
+    TF_EXPECT_OK(ExpectEqual(shuffled_out_tensors,
+                             test_case.expected_shuffle_outputs,
+                             /*compare_order=*/true));
+    TF_EXPECT_OK(ExpectEqual(reshuffled_out_tensors,
+                             test_case.expected_reshuffle_outputs,
+                             /*compare_order=*/true));
   }
+};
 
-  TF_EXPECT_OK(ExpectEqual(shuffled_out_tensors,
-                           test_case.expected_shuffle_outputs,
-                           /*compare_order=*/true));
-  TF_EXPECT_OK(ExpectEqual(reshuffled_out_tensors,
-                           test_case.expected_reshuffle_outputs,
-                           /*compare_order=*/true));
+TEST_P(ParameterizedGetNextTest, GetNext) { TestGetNext(GetParam()); }
+
+// The compact buffer produces the same elements as the default one.
+TEST_P(ParameterizedGetNextTest, GetNextWithCompactBuffer) {
+  SetCompactShuffleBuffer(true);
+  auto reset_buffer = gtl::MakeCleanup([] { SetCompactShuffleBuffer(false); });
+  TestGetNext(GetParam());
 }
 
 INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest, ParameterizedGetNextTest,
@@ -509,46 +530,186 @@ IteratorSaveAndRestoreTestCases() {
 class ParameterizedIteratorSaveAndRestoreTest
     : public ShuffleDatasetOpTest,
       public ::testing::WithParamInterface<
-          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {};
+          IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>> {
+ protected:
+  // Runs the test case starting with a compact buffer iff `compact_buffer`,
+  // and switching to the other buffer at each restore iff
+  // `switch_buffer_on_restore`.
+  void TestIteratorSaveAndRestore(
+      const IteratorSaveAndRestoreTestCase<ShuffleDatasetParams>& test_case,
+      bool compact_buffer, bool switch_buffer_on_restore) {
+    auto reset_buffer =
+        gtl::MakeCleanup([] { SetCompactShuffleBuffer(false); });
+    SetCompactShuffleBuffer(compact_buffer);
+    TF_ASSERT_OK(Initialize(test_case.dataset_params));
+
+    std::unique_ptr<SerializationContext> serialization_ctx;
+    TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+
+    bool end_of_sequence = false;
+    std::vector<Tensor> out_tensors;
+    int cur_iteration = 0;
+    const std::vector<int>& breakpoints = test_case.breakpoints;
+    for (int breakpoint : breakpoints) {
+      VariantTensorDataWriter writer;
+      TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+      std::vector<const VariantTensorData*> data;
+      writer.GetData(&data);
+      VariantTensorDataReader reader(data);
+      if (switch_buffer_on_restore) {
+        compact_buffer = !compact_buffer;
+        SetCompactShuffleBuffer(compact_buffer);
+      }
+      TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                   test_case.dataset_params.iterator_prefix(),
+                                   *dataset_, &iterator_));
+
+      while (cur_iteration <= breakpoint) {
+        std::vector<Tensor> next;
+        TF_EXPECT_OK(
+            iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+        out_tensors.insert(out_tensors.end(), next.begin(), next.end());
+        cur_iteration++;
+      }
+    }
+
+    TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
+                             /*compare_order=*/true));
+  }
+};
 
 TEST_P(ParameterizedIteratorSaveAndRestoreTest, IteratorSaveAndRestore) {
-  auto test_case = GetParam();
-  TF_ASSERT_OK(Initialize(test_case.dataset_params));
+  TestIteratorSaveAndRestore(GetParam(), /*compact_buffer=*/false,
+                             /*switch_buffer_on_restore=*/false);
+}
 
+TEST_P(ParameterizedIteratorSaveAndRestoreTest,
+       IteratorSaveAndRestoreWithCompactBuffer) {
+  TestIteratorSaveAndRestore(GetParam(), /*compact_buffer=*/true,
+                             /*switch_buffer_on_restore=*/false);
+}
+
+// Restores the default (non-compact) buffer before every element, so that all
+// of its elements go through the checkpoint.
+TEST_F(ShuffleDatasetOpTest, IteratorSaveAndRestoreBufferAtEveryElement) {
+  auto dataset_params = ShuffleDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
   std::unique_ptr<SerializationContext> serialization_ctx;
   TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
 
   bool end_of_sequence = false;
   std::vector<Tensor> out_tensors;
-  int cur_iteration = 0;
-  const std::vector<int>& breakpoints = test_case.breakpoints;
-  for (int breakpoint : breakpoints) {
+  while (!end_of_sequence) {
     VariantTensorDataWriter writer;
-    TF_EXPECT_OK(iterator_->Save(serialization_ctx.get(), &writer));
+    TF_ASSERT_OK(iterator_->Save(serialization_ctx.get(), &writer));
     std::vector<const VariantTensorData*> data;
     writer.GetData(&data);
     VariantTensorDataReader reader(data);
-    TF_EXPECT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
-                                 test_case.dataset_params.iterator_prefix(),
-                                 *dataset_, &iterator_));
-
-    while (cur_iteration <= breakpoint) {
-      std::vector<Tensor> next;
-      TF_EXPECT_OK(
-          iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
-      out_tensors.insert(out_tensors.end(), next.begin(), next.end());
-      cur_iteration++;
+    TF_ASSERT_OK(RestoreIterator(iterator_ctx_.get(), &reader,
+                                 dataset_params.iterator_prefix(), *dataset_,
+                                 &iterator_));
+    std::vector<Tensor> next;
+    TF_ASSERT_OK(
+        iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+    if (!end_of_sequence) {
+      ASSERT_EQ(next.size(), 1);
+      out_tensors.push_back(next[0]);
     }
   }
+  TF_EXPECT_OK(ExpectEqual(
+      out_tensors,
+      CreateTensors<int64>(TensorShape({}),
+                           {{2}, {3}, {0}, {5}, {6}, {4}, {7}, {8}, {9}, {1}}),
+      /*compare_order=*/true));
+}
 
-  TF_EXPECT_OK(ExpectEqual(out_tensors, test_case.expected_shuffle_outputs,
-                           /*compare_order=*/true));
+// Checkpoints written with either buffer restore into the other one.
+TEST_P(ParameterizedIteratorSaveAndRestoreTest,
+       IteratorSaveAndRestoreAcrossBuffers) {
+  TestIteratorSaveAndRestore(GetParam(), /*compact_buffer=*/false,
+                             /*switch_buffer_on_restore=*/true);
+  TestIteratorSaveAndRestore(GetParam(), /*compact_buffer=*/true,
+                             /*switch_buffer_on_restore=*/true);
 }
 
 INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+struct CompactBufferTestCase {
+  ShuffleDatasetParams dataset_params;
+  int64 expected_num_tensors;
+};
+
+// Elements with several non-scalar components, and a buffer that outgrows the
+// initial size of the compact buffer.
+std::vector<CompactBufferTestCase> CompactBufferTestCases() {
+  std::vector<int64> matrices;
+  std::vector<float> vectors;
+  for (int i = 0; i < 20; ++i) {
+    matrices.push_back(i);
+    matrices.push_back(-i);
+    vectors.push_back(i / 2.0f);
+  }
+  return {
+      {/*dataset_params=*/ShuffleDatasetParams(
+           TensorSliceDatasetParams(
+               /*components=*/{CreateTensor<int64>(TensorShape{10, 2, 2},
+                                                   matrices),
+                               CreateTensor<float>(TensorShape{10, 2},
+                                                   vectors)},
+               /*node_name=*/"tensor_slice"),
+           /*buffer_size=*/4,
+           /*seed=*/1,
+           /*seed2=*/2,
+           /*count=*/2,
+           /*reshuffle_each_iteration=*/false,
+           /*output_dtypes=*/{DT_INT64, DT_FLOAT},
+           /*output_shapes=*/
+           {PartialTensorShape({2, 2}), PartialTensorShape({2})},
+           /*node_name=*/kShuffleAndRepeatNodeName),
+       /*expected_num_tensors=*/40},
+      {/*dataset_params=*/ShuffleDatasetParams(
+           RangeDatasetParams(0, 3000, 1),
+           /*buffer_size=*/2500,
+           /*seed=*/1,
+           /*seed2=*/2,
+           /*count=*/1,
+           /*reshuffle_each_iteration=*/false,
+           /*output_dtypes=*/{DT_INT64},
+           /*output_shapes=*/{PartialTensorShape({})},
+           /*node_name=*/kShuffleNodeName),
+       /*expected_num_tensors=*/3000}};
+}
+
+TEST_F(ShuffleDatasetOpTest, CompactBufferMatchesDefaultBuffer) {
+  auto reset_buffer = gtl::MakeCleanup([] { SetCompactShuffleBuffer(false); });
+  for (const CompactBufferTestCase& test_case : CompactBufferTestCases()) {
+    std::vector<Tensor> default_outputs;
+    std::vector<Tensor> compact_outputs;
+    for (bool compact_buffer : {false, true}) {
+      SetCompactShuffleBuffer(compact_buffer);
+      TF_ASSERT_OK(Initialize(test_case.dataset_params));
+      std::vector<Tensor>* outputs =
+          compact_buffer ? &compact_outputs : &default_outputs;
+      bool end_of_sequence = false;
+      while (!end_of_sequence) {
+        std::vector<Tensor> next;
+        TF_ASSERT_OK(
+            iterator_->GetNext(iterator_ctx_.get(), &next, &end_of_sequence));
+        // Keep copies of the tensors, so that the compact buffer can reuse
+        // the ones it returned.
+        for (const Tensor& t : next) {
+          outputs->push_back(tensor::DeepCopy(t));
+        }
+      }
+    }
+    EXPECT_EQ(default_outputs.size(), test_case.expected_num_tensors);
+    TF_EXPECT_OK(ExpectEqual(compact_outputs, default_outputs,
+                             /*compare_order=*/true));
+  }
+}
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
@@ -61,7 +61,9 @@ Status InitializeFusedComputation(
       *fused_computation == FusedComputationType::kBiasAddWithRelu ||
       *fused_computation == FusedComputationType::kBiasAddWithRelu6 ||
       *fused_computation == FusedComputationType::kBiasAddWithElu ||
-      *fused_computation == FusedComputationType::kBiasAddWithLeakyRelu) {
+      *fused_computation == FusedComputationType::kBiasAddWithLeakyRelu ||
+      *fused_computation ==
+          FusedComputationType::kBiasAddWithGeluApproximate) {
     if (num_args != 1) {
       return errors::InvalidArgument(
           "Fused ", kernel_name,
@@ -73,6 +75,18 @@ Status InitializeFusedComputation(
     }
   }
 
+  if (*fused_computation == FusedComputationType::kBiasAddWithAdd ||
+      *fused_computation == FusedComputationType::kBiasAddWithAddAndRelu ||
+      *fused_computation == FusedComputationType::kBiasAddWithAddAndRelu6 ||
+      *fused_computation == FusedComputationType::kBiasAddWithAddAndElu) {
+    if (num_args != 2) {
+      return errors::InvalidArgument(
+          "Fused ", kernel_name,
+          " with BiasAdd and Add must have two extra arguments: bias, and the "
+          "tensor to add.");
+    }
+  }
+
   if (*fused_computation == FusedComputationType::kFusedBatchNorm ||
       *fused_computation == FusedComputationType::kFusedBatchNormWithRelu ||
       *fused_computation == FusedComputationType::kFusedBatchNormWithRelu6 ||
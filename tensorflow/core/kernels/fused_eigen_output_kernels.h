@@ -19,9 +19,10 @@ limitations under the License.
 //
 // Supported fused computations:
 //   (1) {Conv2D/MatMul} + BiasAdd + <Activation>
-//   (2) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
+//   (2) {Conv2D/MatMul} + BiasAdd + Add + <Activation>
+//   (3) {Conv2D/MatMul} + FusedBatchNorm + <Activation>
 //
-// Activation: Relu, Relu6, Elu, etc...
+// Activation: Relu, Relu6, Elu, GeluApproximate, etc...
 
 #ifndef TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
 #define TENSORFLOW_CORE_KERNELS_FUSED_EIGEN_OUTPUT_KERNELS_H_
@@ -40,6 +41,11 @@ enum class FusedComputationType {
   kBiasAddWithRelu6,
   kBiasAddWithElu,
   kBiasAddWithLeakyRelu,
+  kBiasAddWithGeluApproximate,
+  kBiasAddWithAdd,
+  kBiasAddWithAddAndRelu,
+  kBiasAddWithAddAndRelu6,
+  kBiasAddWithAddAndElu,
   kFusedBatchNorm,
   kFusedBatchNormWithRelu,
   kFusedBatchNormWithRelu6,
@@ -129,17 +135,47 @@ struct LeakyRelu {
   };
 };
 
+// Applies the tanh approximation of `Gelu` to the passed input expression:
+//   0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+struct GeluApproximate {
+  template <typename XprType>
+  static auto apply(XprType expr) {
+    using Scalar = typename XprType::Scalar;
+    const Scalar sqrt_2_over_pi = static_cast<Scalar>(0.7978845608028654);
+    const Scalar coeff = static_cast<Scalar>(0.044715);
+    const auto inner = expr.constant(sqrt_2_over_pi) *
+                       (expr + expr.constant(coeff) * expr.cube());
+    return expr * expr.constant(static_cast<Scalar>(0.5)) *
+           (inner.tanh() + expr.constant(static_cast<Scalar>(1)));
+  };
+};
+
 template <typename T>
 struct BiasAddArgs {
   const T* bias_add_data = nullptr;
   float leakyrelu_alpha;
 
+  // Used by the `BiasAdd + Add` fusions only: the tensor added to the output,
+  // which has the shape of the output, and the size of the innermost output
+  // dimension.
+  const T* add_data = nullptr;
+  int64 output_depth = 0;
+
   static bool IsSupported(FusedComputationType fusion) {
     return fusion == FusedComputationType::kBiasAdd ||
            fusion == FusedComputationType::kBiasAddWithRelu ||
            fusion == FusedComputationType::kBiasAddWithRelu6 ||
            fusion == FusedComputationType::kBiasAddWithElu ||
-           fusion == FusedComputationType::kBiasAddWithLeakyRelu;
+           fusion == FusedComputationType::kBiasAddWithLeakyRelu ||
+           fusion == FusedComputationType::kBiasAddWithGeluApproximate ||
+           HasAdd(fusion);
+  }
+
+  static bool HasAdd(FusedComputationType fusion) {
+    return fusion == FusedComputationType::kBiasAddWithAdd ||
+           fusion == FusedComputationType::kBiasAddWithAddAndRelu ||
+           fusion == FusedComputationType::kBiasAddWithAddAndRelu6 ||
+           fusion == FusedComputationType::kBiasAddWithAddAndElu;
   }
 };
 
@@ -254,6 +290,45 @@ struct BiasAddOutputKernel<T, LeakyRelu> {
   float leakyrelu_alpha;
 };
 
+// Output kernel that fuses BiasAdd and an Add of a tensor with the shape of the
+// output (e.g. a residual connection) into the output of tensor contraction +
+// activation function defined by Activation.
+//
+// The added tensor has the layout of the output: column `j + col` of the
+// contraction output block starts at offset `(j + col) * output_depth + i`.
+template <typename T, typename Activation = Identity>
+struct BiasAddAndAddOutputKernel {
+  explicit BiasAddAndAddOutputKernel(const BiasAddArgs<T>& args)
+      : bias_data(args.bias_add_data),
+        add_data(args.add_data),
+        output_depth(args.output_depth) {}
+
+  template <typename StorageIndex, typename Scalar>
+  EIGEN_ALWAYS_INLINE void operator()(
+      const ContractionOutputMapper<Scalar, StorageIndex>& output_mapper,
+      const Eigen::TensorContractionParams& params, StorageIndex i,
+      StorageIndex j, StorageIndex num_rows, StorageIndex num_cols) const {
+    DCHECK(params.swapped_arguments);
+
+    const T* bias_base = bias_data + i;
+    typename TTypes<T>::UnalignedConstTensor bias(bias_base, num_rows);
+
+    for (int col = 0; col < num_cols; ++col) {
+      T* output_base = &output_mapper(0, col);
+      const T* add_base = add_data + (j + col) * output_depth + i;
+      typename TTypes<T>::UnalignedTensor output(output_base, num_rows);
+      typename TTypes<T>::UnalignedConstTensor add(add_base, num_rows);
+      const auto expr = output + bias + add;
+      output = Activation::template apply<decltype(expr)>(expr);
+    }
+  }
+
+ private:
+  const T* bias_data;
+  const T* add_data;
+  int64 output_depth;
+};
+
 // Output kernel that fuses FusedBatchNorm operation into the output of tensor
 // contraction + activation function defined by Activation.
 template <typename T, typename Activation = Identity>
@@ -356,6 +431,16 @@ using WithBiasAddAndElu = BiasAddOutputKernel<T, Elu>;
 template <typename T>
 using WithBiasAddAndLeakyRelu = BiasAddOutputKernel<T, LeakyRelu>;
 template <typename T>
+using WithBiasAddAndGeluApproximate = BiasAddOutputKernel<T, GeluApproximate>;
+template <typename T>
+using WithBiasAddAndAdd = BiasAddAndAddOutputKernel<T>;
+template <typename T>
+using WithBiasAddAndAddAndRelu = BiasAddAndAddOutputKernel<T, Relu>;
+template <typename T>
+using WithBiasAddAndAddAndRelu6 = BiasAddAndAddOutputKernel<T, Relu6>;
+template <typename T>
+using WithBiasAddAndAddAndElu = BiasAddAndAddOutputKernel<T, Elu>;
+template <typename T>
 using WithFusedBatchNorm = FusedBatchNormOutputKernel<T>;
 template <typename T>
 using WithFusedBatchNormAndRelu = FusedBatchNormOutputKernel<T, Relu>;
@@ -389,6 +474,32 @@ Status InitBiasAddArgs(OpKernelContext* context, BiasAddArgs<T>* args,
   return Status::OK();
 }
 
+// Initializes the arguments of the `BiasAdd + Add` fusions, which take the
+// added tensor as their second extra argument.
+template <typename T>
+Status InitBiasAddAndAddArgs(OpKernelContext* context, const Tensor& output,
+                             BiasAddArgs<T>* args) {
+  TF_RETURN_IF_ERROR(InitBiasAddArgs(context, args));
+
+  const Tensor& bias = context->input(2);
+  const Tensor& add = context->input(3);
+  const int64 output_depth = output.dim_size(output.dims() - 1);
+
+  if (bias.dim_size(0) != output_depth)
+    return errors::InvalidArgument(
+        "bias must have the size of the innermost output dimension ",
+        output_depth, ", got ", bias.shape().DebugString());
+  if (add.shape() != output.shape())
+    return errors::InvalidArgument(
+        "added tensor must have the shape of the output ",
+        output.shape().DebugString(), ", got ", add.shape().DebugString());
+
+  args->add_data = reinterpret_cast<const T*>(add.tensor_data().data());
+  args->output_depth = output_depth;
+
+  return Status::OK();
+}
+
 template <typename T>
 Status InitFusedBatchNormArgs(OpKernelContext* context, float epsilon,
                               FusedBatchNormArgs<T>* args,
@@ -0,0 +1,381 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+//
+// _FusedElementwise evaluates a graph of elementwise ops tile by tile: each
+// tile of the output is computed from the matching elements of the inputs,
+// with the intermediate values held in small scratch buffers that stay in
+// cache. Every input is read once and the output is written once.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <memory>
+
+#include "absl/strings/str_join.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/util/bcast.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+template <typename T>
+class FusedElementwiseOp;  // forward declare kernel
+
+template <typename T>
+struct FusedElementwiseSupport {
+  using InputBuffer = typename TTypes<T>::UnalignedConstFlat;
+  using OutputBuffer = typename TTypes<T>::UnalignedFlat;
+
+  using UnaryFn = void (*)(const InputBuffer&, OutputBuffer*);
+  using BinaryFn = void (*)(const InputBuffer&, const InputBuffer&,
+                            OutputBuffer*);
+
+  struct ComputeFnRegistration {
+    UnaryFn unary_fn = nullptr;
+    BinaryFn binary_fn = nullptr;
+    int cost = 0;
+
+    int arity() const { return unary_fn != nullptr ? 1 : 2; }
+  };
+
+  FusedElementwiseSupport();
+
+  const ComputeFnRegistration* Find(const string& name) const {
+    auto it = compute_fns.find(name);
+    return it == compute_fns.end() ? nullptr : &it->second;
+  }
+
+ private:
+  template <typename Functor>
+  static void ComputeUnary(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.unaryExpr(typename Functor::func());
+  }
+
+  template <typename Functor>
+  static void ComputeBinary(const InputBuffer& in0, const InputBuffer& in1,
+                            OutputBuffer* out) {
+    *out = in0.binaryExpr(in1, typename Functor::func());
+  }
+
+  static void ComputeRelu(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.cwiseMax(static_cast<T>(0));
+  }
+
+  static void ComputeRelu6(const InputBuffer& in, OutputBuffer* out) {
+    *out = in.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+  }
+
+  template <typename Functor>
+  static int Cost() {
+    return Eigen::internal::functor_traits<typename Functor::func>::Cost;
+  }
+
+  template <typename Functor>
+  void RegisterUnary(const string& name) {
+    compute_fns[name].unary_fn = ComputeUnary<Functor>;
+    compute_fns[name].cost = Cost<Functor>();
+  }
+
+  template <typename Functor>
+  void RegisterBinary(const string& name) {
+    compute_fns[name].binary_fn = ComputeBinary<Functor>;
+    compute_fns[name].cost = Cost<Functor>();
+  }
+
+  std::unordered_map<string, ComputeFnRegistration> compute_fns;
+};
+
+template <typename T>
+FusedElementwiseSupport<T>::FusedElementwiseSupport() {
+  // Keep in sync with the ops fused by the ElementwiseFusion optimizer.
+  RegisterUnary<functor::abs<T>>("Abs");
+  RegisterUnary<functor::exp<T>>("Exp");
+  RegisterUnary<functor::inverse<T>>("Inv");
+  RegisterUnary<functor::log<T>>("Log");
+  RegisterUnary<functor::neg<T>>("Neg");
+  RegisterUnary<functor::inverse<T>>("Reciprocal");
+  RegisterUnary<functor::rsqrt<T>>("Rsqrt");
+  RegisterUnary<functor::sigmoid<T>>("Sigmoid");
+  RegisterUnary<functor::sqrt<T>>("Sqrt");
+  RegisterUnary<functor::square<T>>("Square");
+  RegisterUnary<functor::tanh<T>>("Tanh");
+
+  compute_fns["Relu"].unary_fn = ComputeRelu;
+  compute_fns["Relu"].cost =
+      Eigen::internal::functor_traits<Eigen::internal::scalar_max_op<T>>::Cost;
+  compute_fns["Relu6"].unary_fn = ComputeRelu6;
+  compute_fns["Relu6"].cost =
+      Eigen::internal::functor_traits<Eigen::internal::scalar_max_op<T>>::Cost +
+      Eigen::internal::functor_traits<Eigen::internal::scalar_min_op<T>>::Cost;
+
+  RegisterBinary<functor::add<T>>("Add");
+  RegisterBinary<functor::add<T>>("AddV2");
+  RegisterBinary<functor::maximum<T>>("Maximum");
+  RegisterBinary<functor::minimum<T>>("Minimum");
+  RegisterBinary<functor::mul<T>>("Mul");
+  RegisterBinary<functor::div<T>>("RealDiv");
+  RegisterBinary<functor::squared_difference<T>>("SquaredDifference");
+  RegisterBinary<functor::sub<T>>("Sub");
+}
+
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  using Support = FusedElementwiseSupport<T>;
+  using InputBuffer = typename Support::InputBuffer;
+  using OutputBuffer = typename Support::OutputBuffer;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<string> fused_ops;
+    std::vector<int32> operands;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands));
+
+    const int num_inputs = context->num_inputs();
+    int next_operand = 0;
+    for (const string& op : fused_ops) {
+      const auto* reg = support_.Find(op);
+      OP_REQUIRES(context, reg != nullptr,
+                  errors::Unimplemented("_FusedElementwise does not support ",
+                                        op));
+      OP_REQUIRES(
+          context, next_operand + reg->arity() <= operands.size(),
+          errors::InvalidArgument("Missing operands for fused op ", op));
+      const int num_values = num_inputs + instructions_.size();
+
+      Instruction instruction;
+      instruction.reg = reg;
+      for (int i = 0; i < reg->arity(); ++i) {
+        const int operand = operands[next_operand++];
+        // An op can read the inputs and the values of the preceding ops.
+        OP_REQUIRES(context, operand >= 0 && operand < num_values,
+                    errors::InvalidArgument("Invalid operand ", operand,
+                                            " of fused op ", op));
+        instruction.operands[i] = operand;
+      }
+      instructions_.push_back(instruction);
+      cost_ += reg->cost;
+    }
+    OP_REQUIRES(context, next_operand == operands.size(),
+                errors::InvalidArgument("Expected ", next_operand,
+                                        " operands, got ", operands.size()));
+
+    // The value at which each value is read for the last time.
+    last_use_.resize(num_inputs + instructions_.size(), -1);
+    for (int i = 0; i < instructions_.size(); ++i) {
+      const Instruction& instruction = instructions_[i];
+      for (int j = 0; j < instruction.reg->arity(); ++j) {
+        last_use_[instruction.operands[j]] = num_inputs + i;
+      }
+    }
+
+    VLOG(2) << "Fused elementwise ops: [" << absl::StrJoin(fused_ops, ", ")
+            << "]; cost=" << cost_;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const int num_inputs = ctx->num_inputs();
+
+    // Broadcast the shapes of the inputs.
+    TensorShape output_shape = ctx->input(0).shape();
+    for (int i = 1; i < num_inputs; ++i) {
+      BCast bcast(BCast::FromShape(output_shape),
+                  BCast::FromShape(ctx->input(i).shape()),
+                  /*fewer_dims_optimization=*/false);
+      OP_REQUIRES(ctx, bcast.IsValid(),
+                  errors::InvalidArgument(
+                      "Incompatible shapes: ", output_shape.DebugString(),
+                      " vs. ", ctx->input(i).shape().DebugString()));
+      output_shape = BCast::ToShape(bcast.output_shape());
+    }
+
+    // Inputs with the size of the output are read in place. The others
+    // repeat along the outer dimensions of the output, and are copied tile by
+    // tile to scratch buffers.
+    std::vector<int> forwardable_inputs;
+    std::vector<bool> broadcast(num_inputs, false);
+    for (int i = 0; i < num_inputs; ++i) {
+      const TensorShape& shape = ctx->input(i).shape();
+      OP_REQUIRES(ctx, IsOuterBroadcast(shape, output_shape),
+                  errors::InvalidArgument(
+                      "_FusedElementwise can only broadcast inputs along the "
+                      "outer dimensions of the output ",
+                      output_shape.DebugString(), ", got input ",
+                      shape.DebugString()));
+      if (shape == output_shape) {
+        forwardable_inputs.push_back(i);
+      } else if (shape.num_elements() != output_shape.num_elements()) {
+        broadcast[i] = true;
+      }
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            forwardable_inputs, 0, output_shape, &output));
+    if (output_shape.num_elements() == 0) return;
+
+    // Assign scratch buffers to the broadcast inputs and the intermediate
+    // values, reusing the buffers of the values that are no longer read.
+    std::vector<int> slots(last_use_.size(), -1);
+    std::vector<int> free_slots;
+    int num_slots = 0;
+    const auto allocate_slot = [&]() {
+      if (free_slots.empty()) return num_slots++;
+      const int slot = free_slots.back();
+      free_slots.pop_back();
+      return slot;
+    };
+    for (int i = 0; i < num_inputs; ++i) {
+      if (broadcast[i]) slots[i] = allocate_slot();
+    }
+    for (int i = 0; i + 1 < instructions_.size(); ++i) {
+      const Instruction& instruction = instructions_[i];
+      // The operands are read in the same pass that writes the result, so the
+      // result can reuse the buffer of an operand read for the last time.
+      for (int j = 0; j < instruction.reg->arity(); ++j) {
+        const int operand = instruction.operands[j];
+        if (slots[operand] >= 0 && last_use_[operand] == num_inputs + i &&
+            std::find(free_slots.begin(), free_slots.end(),
+                      slots[operand]) == free_slots.end()) {
+          free_slots.push_back(slots[operand]);
+        }
+      }
+      slots[num_inputs + i] = allocate_slot();
+    }
+
+    std::vector<const T*> inputs(num_inputs);
+    std::vector<int64> input_sizes(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+      inputs[i] = ctx->input(i).flat<T>().data();
+      input_sizes[i] = ctx->input(i).NumElements();
+    }
+    T* out = output->flat<T>().data();
+
+    auto compute_fn = [&](int64 begin, int64 end) {
+      std::unique_ptr<T[]> scratch(new T[num_slots * kTileSize]);
+      const auto slot_data = [&](int value) {
+        return scratch.get() + slots[value] * kTileSize;
+      };
+
+      for (int64 tile = begin; tile < end; tile += kTileSize) {
+        const int64 len = std::min<int64>(kTileSize, end - tile);
+
+        // Copies the tile of the broadcast inputs to their buffers.
+        for (int i = 0; i < num_inputs; ++i) {
+          if (!broadcast[i]) continue;
+          T* dst = slot_data(i);
+          const int64 size = input_sizes[i];
+          if (size == 1) {
+            std::fill_n(dst, len, inputs[i][0]);
+            continue;
+          }
+          for (int64 k = 0, pos = tile % size; k < len;) {
+            const int64 n = std::min(len - k, size - pos);
+            std::copy_n(inputs[i] + pos, n, dst + k);
+            k += n;
+            pos = 0;
+          }
+        }
+
+        const auto value = [&](int v) -> const T* {
+          return slots[v] >= 0 ? slot_data(v) : inputs[v] + tile;
+        };
+        for (int i = 0; i < instructions_.size(); ++i) {
+          const Instruction& instruction = instructions_[i];
+          OutputBuffer result(i + 1 == instructions_.size()
+                                  ? out + tile
+                                  : slot_data(num_inputs + i),
+                              len);
+          const InputBuffer in0(value(instruction.operands[0]), len);
+          if (instruction.reg->arity() == 1) {
+            instruction.reg->unary_fn(in0, &result);
+          } else {
+            const InputBuffer in1(value(instruction.operands[1]), len);
+            instruction.reg->binary_fn(in0, in1, &result);
+          }
+        }
+      }
+    };
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    const int kOverheadCycles = static_cast<int>(instructions_.size()) * 10;
+    Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * num_inputs,
+                             /*bytes_stored=*/sizeof(T),
+                             kOverheadCycles + cost_);
+    device.parallelFor(output_shape.num_elements(), cost, AlignBlockSize,
+                       std::move(compute_fn));
+  }
+
+ private:
+  struct Instruction {
+    const typename Support::ComputeFnRegistration* reg = nullptr;
+    int operands[2] = {-1, -1};
+  };
+
+  // Number of elements of the output evaluated at once, small enough for the
+  // scratch buffers of a few values to stay in the L1 cache.
+  static constexpr int64 kTileSize = 512;
+
+  // Returns true if `shape`, without its leading dimensions of size 1, is a
+  // suffix of `output_shape`.
+  static bool IsOuterBroadcast(const TensorShape& shape,
+                               const TensorShape& output_shape) {
+    int first = 0;
+    while (first < shape.dims() && shape.dim_size(first) == 1) ++first;
+    const int offset = output_shape.dims() - shape.dims();
+    if (offset + first < 0) return false;
+    for (int i = first; i < shape.dims(); ++i) {
+      if (shape.dim_size(i) != output_shape.dim_size(offset + i)) return false;
+    }
+    return true;
+  }
+
+  static inline int64 AlignBlockSize(int64 block_size) {
+    // Align block size to whole tiles when there are many of them.
+    if (block_size >= 4 * kTileSize) {
+      return (block_size + kTileSize - 1) & ~(kTileSize - 1);
+    }
+    return (block_size + 15) & ~15;
+  }
+
+  Support support_;
+  std::vector<Instruction> instructions_;
+  std::vector<int> last_use_;
+  int cost_ = 0;
+};
+
+template <typename T>
+constexpr int64 FusedElementwiseOp<T>::kTileSize;
+
+#define REGISTER_CPU(T)                                                     \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
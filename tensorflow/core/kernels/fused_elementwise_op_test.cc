@@ -0,0 +1,118 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  Status InitFusedOp(int num_inputs, const std::vector<string>& fused_ops,
+                     const std::vector<int32>& operands) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+            .Input(FakeInput(num_inputs, DataTypeToEnum<T>::v()))
+            .Attr("T", DataTypeToEnum<T>::v())
+            .Attr("fused_ops", fused_ops)
+            .Attr("operands", operands)
+            .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, ChainWithBroadcastBias_F) {
+  // tanh(x * scale + bias), with more than one tile per row of the output.
+  const int rows = 3;
+  const int cols = 700;
+  TF_ASSERT_OK(InitFusedOp<float>(3, {"Mul", "AddV2", "Tanh"},
+                                  {0, 1, 3, 2, 4}));
+
+  std::vector<float> x(rows * cols), scale(rows * cols), bias(cols);
+  for (int i = 0; i < rows * cols; ++i) {
+    x[i] = 0.01f * (i % 97) - 0.5f;
+    scale[i] = 0.02f * (i % 13);
+  }
+  for (int j = 0; j < cols; ++j) bias[j] = 0.001f * j - 0.3f;
+  AddInputFromArray<float>(TensorShape({rows, cols}), x);
+  AddInputFromArray<float>(TensorShape({rows, cols}), scale);
+  AddInputFromArray<float>(TensorShape({cols}), bias);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({rows, cols}));
+  auto expected_flat = expected.flat<float>();
+  for (int i = 0; i < rows * cols; ++i) {
+    expected_flat(i) = std::tanh(x[i] * scale[i] + bias[i % cols]);
+  }
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+}
+
+TEST_F(FusedElementwiseOpTest, ReusedValues_D) {
+  // x^2 * (x^2 - x) + 1, where the scalar 1 is broadcast over the output.
+  TF_ASSERT_OK(InitFusedOp<double>(2, {"Square", "Sub", "Mul", "Add"},
+                                   {0, 2, 0, 2, 3, 4, 1}));
+
+  AddInputFromArray<double>(TensorShape({2, 2}), {-1.0, 0.5, 2.0, 3.0});
+  AddInputFromArray<double>(TensorShape({1, 1}), {1.0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_DOUBLE, TensorShape({2, 2}));
+  test::FillValues<double>(&expected, {3.0, 0.9375, 9.0, 55.0});
+  test::ExpectTensorNear<double>(expected, *GetOutput(0), 1e-12);
+}
+
+TEST_F(FusedElementwiseOpTest, Relu6OfDifference_F) {
+  TF_ASSERT_OK(InitFusedOp<float>(2, {"Sub", "Relu6"}, {0, 1, 2}));
+
+  AddInputFromArray<float>(TensorShape({4}), {10.0f, 1.0f, 3.0f, -2.0f});
+  AddInputFromArray<float>(TensorShape({4}), {1.0f, 2.0f, 0.5f, -4.0f});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {6.0f, 0.0f, 2.5f, 2.0f});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, InnerBroadcastIsInvalid) {
+  TF_ASSERT_OK(InitFusedOp<float>(2, {"Add", "Relu"}, {0, 1, 2}));
+
+  AddInputFromArray<float>(TensorShape({2, 1}), {1.0f, 2.0f});
+  AddInputFromArray<float>(TensorShape({1, 2}), {3.0f, 4.0f});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidOperand) {
+  // An op can't read its own value.
+  Status status = InitFusedOp<float>(1, {"Neg", "Exp"}, {0, 2});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, UnsupportedOp) {
+  Status status = InitFusedOp<float>(1, {"Erf"}, {0});
+  EXPECT_TRUE(errors::IsUnimplemented(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -316,6 +316,401 @@ class MutableHashTableOfTensors final : public LookupInterface {
 
 namespace {
 
+// Hash functions for MutableShardedHashTable. Both the high bits (used to pick
+// the shard) and the low bits (used to pick the slot) must be well mixed, so
+// integral keys go through the splitmix64 finalizer rather than being used as
+// their own hash.
+template <typename T>
+inline uint64 ShardedTableHash(const T& key) {
+  uint64 h = static_cast<uint64>(key);
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+inline uint64 ShardedTableHash(const tstring& key) { return Hash64(key); }
+
+}  // namespace
+
+// Lookup table with a flat open-addressing layout, sharded by key hash. Each
+// shard is a linear-probing table of contiguous key, value and slot-state
+// arrays guarded by its own reader/writer lock, so concurrent Find calls never
+// block each other and Insert/Remove only block the shards they touch. Each
+// value must be a scalar or a vector.
+//
+// The keys of a batch are grouped by shard before probing, so each shard lock
+// is taken at most once per call.
+template <class K, class V>
+class MutableShardedHashTable final : public LookupInterface {
+ public:
+  MutableShardedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(value_shape_) ||
+                    TensorShapeUtils::IsVector(value_shape_),
+                errors::InvalidArgument(
+                    "Value must be a scalar or a vector, got shape ",
+                    value_shape_.DebugString()));
+    value_dim_ = value_shape_.num_elements();
+
+    int64 num_shards;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards));
+    OP_REQUIRES(ctx, num_shards > 0 && (num_shards & (num_shards - 1)) == 0,
+                errors::InvalidArgument(
+                    "num_shards must be a positive power of 2, got: ",
+                    num_shards));
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "max_load_factor", &max_load_factor_));
+    OP_REQUIRES(ctx, max_load_factor_ > 0 && max_load_factor_ < 1,
+                errors::InvalidArgument(
+                    "max_load_factor must be between 0 and 1, got: ",
+                    max_load_factor_));
+
+    shard_bits_ = 0;
+    while ((int64{1} << shard_bits_) < num_shards) ++shard_bits_;
+    shards_.reserve(num_shards);
+    for (int64 i = 0; i < num_shards; ++i) {
+      shards_.emplace_back(new Shard);
+      mutex_lock l(shards_.back()->mu);
+      ResetShard(shards_.back().get());
+    }
+  }
+
+  size_t size() const override {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+      tf_shared_lock l(shard->mu);
+      total += shard->num_entries;
+    }
+    return total;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    const int64 num_keys = key_values.size();
+    auto value_values = value->shaped<V, 2>({num_keys, value_dim_});
+    const auto default_flat = default_value.flat<V>();
+
+    // is_full_size_default is true:
+    //   Each key has an independent default value, key_values(i)
+    //   corresponding uses default_flat(i) as its default value.
+    //
+    // is_full_size_default is false:
+    //   All keys will share the default_flat(0) as default value.
+    const bool is_full_size_default =
+        default_flat.size() == value_values.size();
+
+    std::vector<K> keys;
+    std::vector<uint64> hashes;
+    std::vector<int64> shard_starts, order;
+    GroupByShard(key_values, &keys, &hashes, &shard_starts, &order);
+
+    for (int64 s = 0; s < shards_.size(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      const Shard& shard = *shards_[s];
+      tf_shared_lock l(shard.mu);
+      for (int64 k = shard_starts[s]; k < shard_starts[s + 1]; ++k) {
+        const int64 i = order[k];
+        const int64 slot = FindSlot(shard, keys[i], hashes[i]);
+        if (slot >= 0) {
+          const V* slot_value = &shard.values[slot * value_dim_];
+          for (int64 j = 0; j < value_dim_; ++j) {
+            value_values(i, j) = slot_value[j];
+          }
+        } else {
+          const int64 default_offset = is_full_size_default ? i * value_dim_ : 0;
+          for (int64 j = 0; j < value_dim_; ++j) {
+            value_values(i, j) = default_flat(default_offset + j);
+          }
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return DoInsert(/*clear=*/false, keys, values);
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+    std::vector<K> key_copies;
+    std::vector<uint64> hashes;
+    std::vector<int64> shard_starts, order;
+    GroupByShard(key_values, &key_copies, &hashes, &shard_starts, &order);
+
+    for (int64 s = 0; s < shards_.size(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      Shard* shard = shards_[s].get();
+      mutex_lock l(shard->mu);
+      for (int64 k = shard_starts[s]; k < shard_starts[s + 1]; ++k) {
+        const int64 i = order[k];
+        const int64 slot = FindSlot(*shard, key_copies[i], hashes[i]);
+        if (slot < 0) continue;
+        shard->states[slot] = kDeleted;
+        // Release any memory held by the key and value.
+        shard->keys[slot] = K();
+        for (int64 j = 0; j < value_dim_; ++j) {
+          shard->values[slot * value_dim_ + j] = V();
+        }
+        --shard->num_entries;
+        ++shard->num_deleted;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return DoInsert(/*clear=*/true, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    // Hold all shard locks so that the export is a consistent snapshot.
+    std::vector<std::unique_ptr<tf_shared_lock>> locks;
+    locks.reserve(shards_.size());
+    int64 size = 0;
+    for (const auto& shard : shards_) {
+      locks.emplace_back(new tf_shared_lock(shard->mu));
+      size += shard->num_entries;
+    }
+
+    TensorShape values_shape({size});
+    values_shape.AppendShape(value_shape_);
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output("values", values_shape, &values));
+
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->shaped<V, 2>({size, value_dim_});
+    int64 i = 0;
+    for (const auto& shard : shards_) {
+      for (int64 slot = 0; slot < shard->states.size(); ++slot) {
+        if (shard->states[slot] != kFull) continue;
+        keys_data(i) = shard->keys[slot];
+        for (int64 j = 0; j < value_dim_; ++j) {
+          values_data(i, j) = shard->values[slot * value_dim_ + j];
+        }
+        ++i;
+      }
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64 MemoryUsed() const override {
+    int64 ret = sizeof(MutableShardedHashTable);
+    for (const auto& shard : shards_) {
+      tf_shared_lock l(shard->mu);
+      ret += sizeof(Shard) + shard->states.size() *
+                                 (sizeof(uint8) + sizeof(K) +
+                                  value_dim_ * sizeof(V));
+    }
+    return ret;
+  }
+
+ private:
+  enum SlotState : uint8 { kEmpty = 0, kFull = 1, kDeleted = 2 };
+
+  // The number of slots a shard starts with. Always a power of 2.
+  static constexpr int64 kInitialShardCapacity = 16;
+
+  struct Shard {
+    mutable mutex mu;
+    // Slot i holds keys[i] and values[i * value_dim_ ... (i + 1) * value_dim_).
+    std::vector<uint8> states TF_GUARDED_BY(mu);
+    std::vector<K> keys TF_GUARDED_BY(mu);
+    std::vector<V> values TF_GUARDED_BY(mu);
+    int64 num_entries TF_GUARDED_BY(mu) = 0;
+    int64 num_deleted TF_GUARDED_BY(mu) = 0;
+  };
+
+  int64 ShardIndex(uint64 hash) const {
+    return shard_bits_ == 0 ? 0 : static_cast<int64>(hash >> (64 - shard_bits_));
+  }
+
+  // Copies and hashes every key, and computes a permutation `order` of the
+  // key indices such that the keys of shard s are at positions
+  // [shard_starts[s], shard_starts[s + 1]).
+  void GroupByShard(typename TTypes<K>::ConstFlat key_values,
+                    std::vector<K>* keys, std::vector<uint64>* hashes,
+                    std::vector<int64>* shard_starts,
+                    std::vector<int64>* order) const {
+    const int64 num_keys = key_values.size();
+    keys->resize(num_keys);
+    hashes->resize(num_keys);
+    shard_starts->assign(shards_.size() + 1, 0);
+    for (int64 i = 0; i < num_keys; ++i) {
+      (*keys)[i] = SubtleMustCopyIfIntegral(key_values(i));
+      (*hashes)[i] = ShardedTableHash((*keys)[i]);
+      ++(*shard_starts)[ShardIndex((*hashes)[i]) + 1];
+    }
+    for (int64 s = 0; s < shards_.size(); ++s) {
+      (*shard_starts)[s + 1] += (*shard_starts)[s];
+    }
+    std::vector<int64> next(shard_starts->begin(), shard_starts->end() - 1);
+    order->resize(num_keys);
+    for (int64 i = 0; i < num_keys; ++i) {
+      (*order)[next[ShardIndex((*hashes)[i])]++] = i;
+    }
+  }
+
+  // Returns the slot holding `key` in `shard`, or -1 if there is none.
+  int64 FindSlot(const Shard& shard, const K& key, uint64 hash) const
+      TF_SHARED_LOCKS_REQUIRED(shard.mu) {
+    const int64 mask = shard.states.size() - 1;
+    for (int64 slot = hash & mask;; slot = (slot + 1) & mask) {
+      const uint8 state = shard.states[slot];
+      if (state == kEmpty) return -1;
+      if (state == kFull && shard.keys[slot] == key) return slot;
+    }
+  }
+
+  void ResetShard(Shard* shard) const TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->states.assign(kInitialShardCapacity, kEmpty);
+    shard->keys.assign(kInitialShardCapacity, K());
+    shard->values.assign(kInitialShardCapacity * value_dim_, V());
+    shard->num_entries = 0;
+    shard->num_deleted = 0;
+  }
+
+  // Moves the entries of `shard` into a table with `capacity` slots, dropping
+  // all tombstones.
+  void Rehash(Shard* shard, int64 capacity) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    std::vector<uint8> old_states(capacity, kEmpty);
+    std::vector<K> old_keys(capacity);
+    std::vector<V> old_values(capacity * value_dim_);
+    old_states.swap(shard->states);
+    old_keys.swap(shard->keys);
+    old_values.swap(shard->values);
+    shard->num_deleted = 0;
+
+    const int64 mask = capacity - 1;
+    for (int64 old_slot = 0; old_slot < old_states.size(); ++old_slot) {
+      if (old_states[old_slot] != kFull) continue;
+      int64 slot = ShardedTableHash(old_keys[old_slot]) & mask;
+      while (shard->states[slot] != kEmpty) slot = (slot + 1) & mask;
+      shard->states[slot] = kFull;
+      shard->keys[slot] = std::move(old_keys[old_slot]);
+      for (int64 j = 0; j < value_dim_; ++j) {
+        shard->values[slot * value_dim_ + j] =
+            std::move(old_values[old_slot * value_dim_ + j]);
+      }
+    }
+  }
+
+  // Inserts or updates `key`, whose value is read from row `row` of
+  // `value_values`.
+  void InsertIntoShard(Shard* shard, const K& key, uint64 hash,
+                       typename TTypes<V, 2>::ConstTensor value_values,
+                       int64 row) const TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    int64 capacity = shard->states.size();
+    if (shard->num_entries + shard->num_deleted + 1 >
+        max_load_factor_ * capacity) {
+      // Grow if the live entries alone would exceed half the load factor;
+      // otherwise rehashing in place is enough to reclaim the tombstones.
+      if (shard->num_entries + 1 > max_load_factor_ * capacity / 2) {
+        capacity *= 2;
+      }
+      Rehash(shard, capacity);
+    }
+
+    const int64 mask = capacity - 1;
+    int64 target = -1;
+    for (int64 slot = hash & mask;; slot = (slot + 1) & mask) {
+      const uint8 state = shard->states[slot];
+      if (state == kFull) {
+        if (shard->keys[slot] == key) {
+          target = slot;
+          break;
+        }
+      } else if (state == kDeleted) {
+        if (target < 0) target = slot;
+      } else {
+        if (target < 0) target = slot;
+        break;
+      }
+    }
+
+    if (shard->states[target] != kFull) {
+      if (shard->states[target] == kDeleted) --shard->num_deleted;
+      shard->states[target] = kFull;
+      shard->keys[target] = key;
+      ++shard->num_entries;
+    }
+    for (int64 j = 0; j < value_dim_; ++j) {
+      shard->values[target * value_dim_ + j] =
+          SubtleMustCopyIfIntegral(value_values(row, j));
+    }
+  }
+
+  Status DoInsert(bool clear, const Tensor& keys, const Tensor& values) {
+    const auto key_values = keys.flat<K>();
+    const auto value_values =
+        values.shaped<V, 2>({key_values.size(), value_dim_});
+    std::vector<K> key_copies;
+    std::vector<uint64> hashes;
+    std::vector<int64> shard_starts, order;
+    GroupByShard(key_values, &key_copies, &hashes, &shard_starts, &order);
+
+    if (clear) {
+      // Hold all shard locks so that no reader observes a partial import.
+      std::vector<std::unique_ptr<mutex_lock>> locks;
+      locks.reserve(shards_.size());
+      for (const auto& shard : shards_) {
+        locks.emplace_back(new mutex_lock(shard->mu));
+        ResetShard(shard.get());
+      }
+      for (int64 s = 0; s < shards_.size(); ++s) {
+        for (int64 k = shard_starts[s]; k < shard_starts[s + 1]; ++k) {
+          const int64 i = order[k];
+          InsertIntoShard(shards_[s].get(), key_copies[i], hashes[i],
+                          value_values, i);
+        }
+      }
+      return Status::OK();
+    }
+
+    for (int64 s = 0; s < shards_.size(); ++s) {
+      if (shard_starts[s] == shard_starts[s + 1]) continue;
+      Shard* shard = shards_[s].get();
+      mutex_lock l(shard->mu);
+      for (int64 k = shard_starts[s]; k < shard_starts[s + 1]; ++k) {
+        const int64 i = order[k];
+        InsertIntoShard(shard, key_copies[i], hashes[i], value_values, i);
+      }
+    }
+    return Status::OK();
+  }
+
+  TensorShape value_shape_;
+  int64 value_dim_;
+  float max_load_factor_;
+  int shard_bits_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+template <class K, class V>
+constexpr int64 MutableShardedHashTable<K, V>::kInitialShardCapacity;
+
+namespace {
+
 template <typename T>
 inline uint64 HashScalar(const T& key) {
   return static_cast<uint64>(key);
@@ -1098,6 +1493,33 @@ REGISTER_KERNEL(tstring, int64);
 
 #undef REGISTER_KERNEL
 
+// Register the MutableShardedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("MutableShardedHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::MutableShardedHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(int64, int32);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, tstring);
+REGISTER_KERNEL(int64, Variant);
+REGISTER_KERNEL(tstring, bool);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableDenseHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                            \
   REGISTER_KERNEL_BUILDER(                                                 \
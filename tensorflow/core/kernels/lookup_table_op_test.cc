@@ -0,0 +1,296 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/lookup_ops.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace ops {
+namespace {
+
+TEST(MutableShardedHashTableTest, InsertAndFind) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_INT64, DT_FLOAT,
+                                       MutableShardedHashTable::NumShards(4));
+  auto insert = LookupTableInsert(
+      root, table, Const(root, {1LL, 2LL, 3LL}), Const(root, {1.f, 2.f, 3.f}));
+  auto find = LookupTableFind(root, table, Const(root, {3LL, 4LL, 1LL}),
+                              Const(root, -1.f));
+  auto size = LookupTableSize(root, table);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({find.values, size.size}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0],
+                                 test::AsTensor<float>({3.f, -1.f, 1.f}));
+  test::ExpectTensorEqual<int64>(outputs[1], test::AsScalar<int64>(3));
+}
+
+TEST(MutableShardedHashTableTest, FullSizeDefault) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_STRING, DT_INT64);
+  auto insert = LookupTableInsert(root, table, Const(root, {"a", "b"}),
+                                  Const(root, {10LL, 20LL}));
+  auto find = LookupTableFind(root, table, Const(root, {"c", "b", "d"}),
+                              Const(root, {-1LL, -2LL, -3LL}));
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({find.values}, &outputs));
+  test::ExpectTensorEqual<int64>(outputs[0],
+                                 test::AsTensor<int64>({-1, 20, -3}));
+}
+
+TEST(MutableShardedHashTableTest, VectorValues) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(
+      root, DT_INT64, DT_INT64, MutableShardedHashTable::ValueShape({2}));
+  auto insert =
+      LookupTableInsert(root, table, Const(root, {0LL, 1LL}),
+                        Const(root, {{0LL, 1LL}, {2LL, 3LL}}));
+  auto find = LookupTableFind(root, table, Const(root, {1LL, 7LL}),
+                              Const(root, {-1LL, -2LL}));
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({find.values}, &outputs));
+  test::ExpectTensorEqual<int64>(
+      outputs[0], test::AsTensor<int64>({2, 3, -1, -2}, TensorShape({2, 2})));
+}
+
+TEST(MutableShardedHashTableTest, OverwriteAndRemove) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_INT64, DT_INT32);
+  auto keys = Const(root, {1LL, 2LL, 3LL});
+  auto insert = LookupTableInsert(root, table, keys, Const(root, {1, 2, 3}));
+  auto overwrite = LookupTableInsert(root, table, Const(root, {2LL}),
+                                     Const(root, {20}));
+  auto remove = LookupTableRemove(root, table, Const(root, {1LL, 5LL}));
+  auto find = LookupTableFind(root, table, keys, Const(root, 0));
+  auto size = LookupTableSize(root, table);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  TF_ASSERT_OK(session.Run({}, {}, {overwrite}, nullptr));
+  TF_ASSERT_OK(session.Run({}, {}, {remove}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({find.values, size.size}, &outputs));
+  test::ExpectTensorEqual<int32>(outputs[0], test::AsTensor<int32>({0, 20, 3}));
+  test::ExpectTensorEqual<int64>(outputs[1], test::AsScalar<int64>(2));
+
+  // Removed slots are reused by later insertions.
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  TF_ASSERT_OK(session.Run({find.values, size.size}, &outputs));
+  test::ExpectTensorEqual<int32>(outputs[0], test::AsTensor<int32>({1, 2, 3}));
+  test::ExpectTensorEqual<int64>(outputs[1], test::AsScalar<int64>(3));
+}
+
+TEST(MutableShardedHashTableTest, GrowsPastInitialCapacity) {
+  constexpr int kNumKeys = 10000;
+  std::vector<int64> key_values(kNumKeys);
+  std::vector<float> value_values(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    key_values[i] = i * 7919;
+    value_values[i] = i;
+  }
+  Tensor keys = test::AsTensor<int64>(key_values);
+  Tensor values = test::AsTensor<float>(value_values);
+
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_INT64, DT_FLOAT,
+                                       MutableShardedHashTable::NumShards(2));
+  auto insert = LookupTableInsert(root, table, Const(root, keys),
+                                  Const(root, values));
+  auto find = LookupTableFind(root, table, Const(root, keys), Const(root, -1.f));
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({find.values}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0], values);
+}
+
+TEST(MutableShardedHashTableTest, ExportImportRoundTrip) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_INT64, DT_FLOAT);
+  auto insert =
+      LookupTableInsert(root, table, Const(root, {5LL, 6LL, 7LL}),
+                        Const(root, {0.5f, 0.6f, 0.7f}));
+  auto exported = LookupTableExport(root, table, DT_INT64, DT_FLOAT);
+
+  auto restored = MutableShardedHashTable(root, DT_INT64, DT_FLOAT);
+  auto stale = LookupTableInsert(root, restored, Const(root, {1LL}),
+                                 Const(root, {1.f}));
+  auto import = LookupTableImport(root, restored, exported.keys,
+                                  exported.values);
+  auto find = LookupTableFind(root, restored, Const(root, {7LL, 5LL, 1LL}),
+                              Const(root, 0.f));
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  TF_ASSERT_OK(session.Run({}, {}, {insert}, nullptr));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({exported.keys}, &outputs));
+  std::vector<int64> keys(outputs[0].flat<int64>().data(),
+                          outputs[0].flat<int64>().data() +
+                              outputs[0].NumElements());
+  std::sort(keys.begin(), keys.end());
+  EXPECT_EQ(keys, std::vector<int64>({5, 6, 7}));
+
+  // Importing replaces the previous contents of the table.
+  TF_ASSERT_OK(session.Run({}, {}, {stale}, nullptr));
+  TF_ASSERT_OK(session.Run({}, {}, {import}, nullptr));
+  TF_ASSERT_OK(session.Run({find.values}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0],
+                                 test::AsTensor<float>({0.7f, 0.5f, 0.f}));
+}
+
+TEST(MutableShardedHashTableTest, InvalidNumShards) {
+  Scope root = Scope::NewRootScope();
+  auto table = MutableShardedHashTable(root, DT_INT64, DT_FLOAT,
+                                       MutableShardedHashTable::NumShards(3));
+  auto size = LookupTableSize(root, table);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  Status s = session.Run({size.size}, &outputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+  EXPECT_TRUE(absl::StrContains(s.error_message(), "power of 2")) << s;
+}
+
+}  // namespace
+}  // namespace ops
+
+namespace {
+
+constexpr int64 kBenchmarkTableSize = 1 << 18;
+constexpr int64 kBenchmarkBatchSize = 1024;
+
+Node* BenchmarkTable(Graph* g, const string& op) {
+  Node* table;
+  NodeBuilder builder(g->NewName("table"), op);
+  builder.Attr("key_dtype", DT_INT64)
+      .Attr("value_dtype", DT_FLOAT)
+      .Attr("shared_name", "benchmark_table");
+  TF_CHECK_OK(builder.Finalize(g, &table));
+  return table;
+}
+
+Tensor BenchmarkKeys(int64 num_keys, int64 offset) {
+  Tensor keys(DT_INT64, TensorShape({num_keys}));
+  auto flat = keys.flat<int64>();
+  for (int64 i = 0; i < num_keys; ++i) {
+    flat(i) = ((offset + i) * 2654435761LL) % kBenchmarkTableSize;
+  }
+  return keys;
+}
+
+// Fills the table in the init graph, then runs `num_finds` lookups of
+// kBenchmarkBatchSize keys each, and `num_inserts` concurrent updates, in
+// every step of the main graph. The independent nodes of the main graph run
+// concurrently on the inter-op thread pool.
+void BM_LookupTable(int iters, const string& op, int num_finds,
+                    int num_inserts) {
+  testing::StopTiming();
+  Graph* init = new Graph(OpRegistry::Global());
+  Tensor all_values(DT_FLOAT, TensorShape({kBenchmarkTableSize}));
+  all_values.flat<float>().setConstant(1.f);
+  Tensor all_keys(DT_INT64, TensorShape({kBenchmarkTableSize}));
+  for (int64 i = 0; i < kBenchmarkTableSize; ++i) {
+    all_keys.flat<int64>()(i) = i;
+  }
+  TF_CHECK_OK(NodeBuilder(init->NewName("insert"), "LookupTableInsertV2")
+                  .Input(BenchmarkTable(init, op))
+                  .Input(test::graph::Constant(init, all_keys))
+                  .Input(test::graph::Constant(init, all_values))
+                  .Finalize(init, nullptr));
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* table = BenchmarkTable(g, op);
+  Node* default_value = test::graph::Constant(g, test::AsScalar<float>(0.f));
+  for (int i = 0; i < num_finds; ++i) {
+    TF_CHECK_OK(
+        NodeBuilder(g->NewName("find"), "LookupTableFindV2")
+            .Input(table)
+            .Input(test::graph::Constant(
+                g, BenchmarkKeys(kBenchmarkBatchSize, i * kBenchmarkBatchSize)))
+            .Input(default_value)
+            .Finalize(g, nullptr));
+  }
+  Tensor batch_values(DT_FLOAT, TensorShape({kBenchmarkBatchSize}));
+  batch_values.flat<float>().setConstant(2.f);
+  for (int i = 0; i < num_inserts; ++i) {
+    TF_CHECK_OK(
+        NodeBuilder(g->NewName("insert"), "LookupTableInsertV2")
+            .Input(table)
+            .Input(test::graph::Constant(
+                g, BenchmarkKeys(kBenchmarkBatchSize, i * kBenchmarkBatchSize)))
+            .Input(test::graph::Constant(g, batch_values))
+            .Finalize(g, nullptr));
+  }
+
+  testing::ItemsProcessed(static_cast<int64>(iters) *
+                          (num_finds + num_inserts) * kBenchmarkBatchSize);
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g, nullptr, init).Run(iters);
+}
+
+void BM_MutableHashTableFind(int iters, int num_finds) {
+  BM_LookupTable(iters, "MutableHashTableV2", num_finds, 0);
+}
+
+void BM_MutableShardedHashTableFind(int iters, int num_finds) {
+  BM_LookupTable(iters, "MutableShardedHashTable", num_finds, 0);
+}
+
+void BM_MutableHashTableFindInsert(int iters, int num_finds) {
+  BM_LookupTable(iters, "MutableHashTableV2", num_finds, num_finds / 4);
+}
+
+void BM_MutableShardedHashTableFindInsert(int iters, int num_finds) {
+  BM_LookupTable(iters, "MutableShardedHashTable", num_finds, num_finds / 4);
+}
+
+BENCHMARK(BM_MutableHashTableFind)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK(BM_MutableShardedHashTableFind)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK(BM_MutableHashTableFindInsert)->Arg(8)->Arg(32);
+BENCHMARK(BM_MutableShardedHashTableFindInsert)->Arg(8)->Arg(32);
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 // Implements matmul operations with other kernels baked into the
 // processing, to optimize latency and memory usage:
 //  - MatMul + BiasAdd + <Activation>
+//  - MatMul + BiasAdd + Add + <Activation>
 //  - MatMul + FusedBatchNorm + <Activation>
 //
 // Activation: Relu, Relu6, Elu, etc...
@@ -71,7 +72,10 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
     auto& d = context->eigen_device<CPUDevice>();
 
     BiasAddArgs<T> bias_add_args;
-    if (BiasAddArgs<T>::IsSupported(fusion)) {
+    if (BiasAddArgs<T>::HasAdd(fusion)) {
+      OP_REQUIRES_OK(context,
+                     InitBiasAddAndAddArgs(context, *output, &bias_add_args));
+    } else if (BiasAddArgs<T>::IsSupported(fusion)) {
       OP_REQUIRES_OK(context, InitBiasAddArgs(context, &bias_add_args));
     }
 
@@ -92,6 +96,26 @@ struct LaunchFusedMatMulOp<CPUDevice, T> {
         out.device(d) =
             lhs.contract(rhs, dim_pair, WithBiasAddAndElu<T>(bias_add_args));
         break;
+      case FusedComputationType::kBiasAddWithGeluApproximate:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndGeluApproximate<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAdd:
+        out.device(d) =
+            lhs.contract(rhs, dim_pair, WithBiasAddAndAdd<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndAddAndRelu<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAddAndRelu6:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndAddAndRelu6<T>(bias_add_args));
+        break;
+      case FusedComputationType::kBiasAddWithAddAndElu:
+        out.device(d) = lhs.contract(
+            rhs, dim_pair, WithBiasAddAndAddAndElu<T>(bias_add_args));
+        break;
       case FusedComputationType::kUndefined:
         OP_REQUIRES_OK(context, errors::Internal("Fusion type is undefined"));
         break;
@@ -116,7 +140,13 @@ class FusedMatMulOp : public OpKernel {
       patterns = {{FCT::kBiasAdd, {"BiasAdd"}},
                   {FCT::kBiasAddWithRelu, {"BiasAdd", "Relu"}},
                   {FCT::kBiasAddWithRelu6, {"BiasAdd", "Relu6"}},
-                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}}};
+                  {FCT::kBiasAddWithElu, {"BiasAdd", "Elu"}},
+                  {FCT::kBiasAddWithGeluApproximate,
+                   {"BiasAdd", "GeluApproximate"}},
+                  {FCT::kBiasAddWithAdd, {"BiasAdd", "Add"}},
+                  {FCT::kBiasAddWithAddAndRelu, {"BiasAdd", "Add", "Relu"}},
+                  {FCT::kBiasAddWithAddAndRelu6, {"BiasAdd", "Add", "Relu6"}},
+                  {FCT::kBiasAddWithAddAndElu, {"BiasAdd", "Add", "Elu"}}};
     }
 
     OP_REQUIRES_OK(context, InitializeFusedComputation(
@@ -143,6 +143,69 @@ class FusedMatMulOpTest : public OpsTestBase {
     RunAndFetch(root, "with_activation", output, allow_gpu_device);
   }
 
+  void RunMatMulWithBiasAndAddAndActivation(
+      const Tensor& lhs_data, const Tensor& rhs_data, const Tensor& bias_data,
+      const Tensor& add_data, bool transpose_a, bool transpose_b,
+      const string& activation_type, Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::MatMul matmul = ops::MatMul(
+        root.WithOpName("matmul"),
+        ops::Const(root.WithOpName("lhs"), Input::Initializer(lhs_data)),
+        ops::Const(root.WithOpName("rhs"), Input::Initializer(rhs_data)),
+        ops::MatMul::Attrs().TransposeA(transpose_a).TransposeB(transpose_b));
+
+    ops::BiasAdd with_bias = ops::BiasAdd(
+        root.WithOpName("with_bias"), matmul,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    ops::AddV2 with_add = ops::AddV2(
+        root.WithOpName("with_add"), with_bias,
+        ops::Const(root.WithOpName("add"), Input::Initializer(add_data)));
+
+    if (activation_type == "Relu") {
+      ops::Relu(root.WithOpName("with_activation"), with_add);
+    } else if (activation_type == "Relu6") {
+      ops::Relu6(root.WithOpName("with_activation"), with_add);
+    } else if (activation_type == "Elu") {
+      ops::Elu(root.WithOpName("with_activation"), with_add);
+    } else {
+      ops::Identity(root.WithOpName("with_activation"), with_add);
+    }
+
+    RunAndFetch(root, "with_activation", output, /*allow_gpu_device=*/false);
+  }
+
+  void RunMatMulWithBiasAndGeluApproximate(const Tensor& lhs_data,
+                                           const Tensor& rhs_data,
+                                           const Tensor& bias_data,
+                                           bool transpose_a, bool transpose_b,
+                                           Tensor* output) {
+    Scope root = tensorflow::Scope::NewRootScope();
+
+    ops::MatMul matmul = ops::MatMul(
+        root.WithOpName("matmul"),
+        ops::Const(root.WithOpName("lhs"), Input::Initializer(lhs_data)),
+        ops::Const(root.WithOpName("rhs"), Input::Initializer(rhs_data)),
+        ops::MatMul::Attrs().TransposeA(transpose_a).TransposeB(transpose_b));
+
+    ops::BiasAdd x = ops::BiasAdd(
+        root.WithOpName("with_bias"), matmul,
+        ops::Const(root.WithOpName("bias"), Input::Initializer(bias_data)));
+
+    // x * 0.5 * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+    const T sqrt_2_over_pi = static_cast<T>(0.7978845608028654);
+    auto cube = ops::Pow(root, x, static_cast<T>(3));
+    auto scaled_cube = ops::Mul(root, static_cast<T>(0.044715), cube);
+    auto inner = ops::AddV2(root, x, scaled_cube);
+    auto tanh = ops::Tanh(root, ops::Mul(root, sqrt_2_over_pi, inner));
+    auto one_plus_tanh = ops::AddV2(root, static_cast<T>(1), tanh);
+    ops::Mul(root.WithOpName("with_gelu"),
+             ops::Mul(root, static_cast<T>(0.5), x), one_plus_tanh);
+
+    RunAndFetch(root, "with_gelu", output, /*allow_gpu_device=*/false);
+  }
+
   void RunFusedMatMulOp(const Tensor& lhs_data, const Tensor& rhs_data,
                         const std::vector<Tensor>& args_data,
                         const std::vector<string>& fused_ops, bool transpose_a,
@@ -183,7 +246,8 @@ class FusedMatMulOpTest : public OpsTestBase {
 
   void VerifyBiasAddTensorsNear(int m, int k, int n,
                                 const BiasAddGraphRunner& run_default,
-                                const BiasAddGraphRunner& run_fused) {
+                                const BiasAddGraphRunner& run_fused,
+                                double atol = 1e-5) {
     DataType dtype = DataTypeToEnum<T>::v();
 
     Tensor lhs(dtype, {m, k});
@@ -209,7 +273,7 @@ class FusedMatMulOpTest : public OpsTestBase {
     ASSERT_EQ(matmul.dtype(), fused_matmul.dtype());
     ASSERT_EQ(matmul.shape(), fused_matmul.shape());
 
-    test::ExpectClose(matmul, fused_matmul, /*atol=*/1e-5);
+    test::ExpectClose(matmul, fused_matmul, atol);
   }
 
   // Verifies that computing MatMul+BiasAdd in a graph is identical to
@@ -256,6 +320,62 @@ class FusedMatMulOpTest : public OpsTestBase {
 
     VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
   }
+
+  // Verifies that computing MatMul+BiasAdd+Add+{Activation} in a graph is
+  // identical to FusedMatMul. Activation "None" fuses only the Add.
+  void VerifyMatMulWithBiasAndAddAndActivation(int m, int k, int n,
+                                               bool transpose_a,
+                                               bool transpose_b,
+                                               const string& activation) {
+    DataType dtype = DataTypeToEnum<T>::v();
+
+    Tensor add(dtype, {transpose_a ? k : m, transpose_b ? k : n});
+    add.flat<T>() = add.flat<T>().setRandom();
+    add.flat<T>() -= add.flat<T>().constant(static_cast<T>(0.5f));
+
+    const BiasAddGraphRunner run_default =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunMatMulWithBiasAndAddAndActivation(input_data, filter_data,
+                                               bias_data, add, transpose_a,
+                                               transpose_b, activation, out);
+        };
+
+    std::vector<string> fused_ops = {"BiasAdd", "Add"};
+    if (activation != "None") fused_ops.push_back(activation);
+    const BiasAddGraphRunner run_fused =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunFusedMatMulOp(input_data, filter_data, {bias_data, add},
+                           fused_ops, transpose_a, transpose_b, out);
+        };
+
+    VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused);
+  }
+
+  // Verifies that computing MatMul+BiasAdd+GeluApproximate in a graph is
+  // identical to FusedMatMul, up to the rounding of the Gelu primitives.
+  void VerifyMatMulWithBiasAndGeluApproximate(int m, int k, int n,
+                                              bool transpose_a,
+                                              bool transpose_b) {
+    const BiasAddGraphRunner run_default =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunMatMulWithBiasAndGeluApproximate(input_data, filter_data,
+                                              bias_data, transpose_a,
+                                              transpose_b, out);
+        };
+
+    const BiasAddGraphRunner run_fused =
+        [&](const Tensor& input_data, const Tensor& filter_data,
+            const Tensor& bias_data, Tensor* out) {
+          RunFusedMatMulOp(input_data, filter_data, {bias_data},
+                           {"BiasAdd", "GeluApproximate"}, transpose_a,
+                           transpose_b, out);
+        };
+
+    VerifyBiasAddTensorsNear(m, k, n, run_default, run_fused, /*atol=*/1e-4);
+  }
 };
 
 // MatMul with BatchNorm can be tested only with `T=float`, because default
@@ -323,15 +443,47 @@ TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithActivation) {
   }
 }
 
-REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,        //
-                            MatMul256x256x256,                //
-                            MatMul1x256x256,                  //
-                            MatMul256x256x1,                  //
-                            MatMul1x256x1,                    //
-                            MatMul256x256x256WithActivation,  //
-                            MatMul1x256x256WithActivation,    //
-                            MatMul256x256x1WithActivation,    //
-                            MatMul1x256x1WithActivation);
+// -------------------------------------------------------------------------- //
+// MatMul + BiasAdd + Add + {Activation}                                      //
+// -------------------------------------------------------------------------- //
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithAdd) {
+  for (const string& activation : {"None", "Relu", "Relu6", "Elu"}) {
+    this->VerifyMatMulWithBiasAndAddAndActivation(256, 256, 256, false, false,
+                                                  activation);
+    this->VerifyMatMulWithBiasAndAddAndActivation(256, 256, 256, true, true,
+                                                  activation);
+  }
+}
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul1x256x1WithAdd) {
+  for (const string& activation : {"None", "Relu", "Relu6", "Elu"}) {
+    this->VerifyMatMulWithBiasAndAddAndActivation(1, 256, 1, false, false,
+                                                  activation);
+  }
+}
+
+// -------------------------------------------------------------------------- //
+// MatMul + BiasAdd + GeluApproximate                                         //
+// -------------------------------------------------------------------------- //
+
+TYPED_TEST_P(FusedMatMulWithBiasOpTest, MatMul256x256x256WithGeluApproximate) {
+  this->VerifyMatMulWithBiasAndGeluApproximate(256, 256, 256, false, false);
+  this->VerifyMatMulWithBiasAndGeluApproximate(256, 256, 256, true, true);
+}
+
+REGISTER_TYPED_TEST_SUITE_P(FusedMatMulWithBiasOpTest,             //
+                            MatMul256x256x256,                     //
+                            MatMul1x256x256,                       //
+                            MatMul256x256x1,                       //
+                            MatMul1x256x1,                         //
+                            MatMul256x256x256WithActivation,       //
+                            MatMul1x256x256WithActivation,         //
+                            MatMul256x256x1WithActivation,         //
+                            MatMul1x256x1WithActivation,           //
+                            MatMul256x256x256WithAdd,              //
+                            MatMul1x256x1WithAdd,                  //
+                            MatMul256x256x256WithGeluApproximate);
 
 // TODO(ezhulenev): Add support for more data types.
 using FusedBiasAddDataTypes = ::testing::Types<float>;
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -257,7 +258,7 @@ struct RestoreOp {
 
   // Run this restore operation using a new BundleReader.
   void run_with_new_reader() {
-    BundleReader reader(Env::Default(), reader_prefix);
+    BundleReader reader(Env::Default(), reader_prefix, reader_options);
     if (!reader.status().ok()) {
       status = reader.status();
       return;
@@ -274,7 +275,20 @@ struct RestoreOp {
     VLOG(1) << "Restoring tensor " << idx << " : " << tensor_name << " : "
             << restored_full_shape.num_elements();
     Tensor* restored_tensor;
-    if (shape_and_slice.empty()) {
+    Tensor mapped_tensor;
+    std::vector<TensorSlice> stored_slices;
+    if (shape_and_slice.empty() && reader->options().use_mmap) {
+      TF_RETURN_IF_ERROR(
+          reader->LookupTensorSlices(tensor_name, &stored_slices));
+    }
+    if (shape_and_slice.empty() && reader->options().use_mmap &&
+        stored_slices.empty()) {
+      // Lookup the full tensor, letting the reader alias the mapped data file
+      // instead of copying into a freshly allocated output.
+      TF_RETURN_IF_ERROR(reader->Lookup(tensor_name, &mapped_tensor));
+      context->set_output(idx, mapped_tensor);
+      restored_tensor = &mapped_tensor;
+    } else if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
           context->allocate_output(idx, restored_full_shape, &restored_tensor));
@@ -327,6 +341,7 @@ struct RestoreOp {
   string tensor_name;
   string shape_and_slice;
   string reader_prefix;
+  BundleReader::Options reader_options;
 
   ::tensorflow::Status status;
 };
@@ -353,7 +368,12 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   std::vector<std::unique_ptr<RestoreOp> > pool_restore_ops;
   std::vector<std::unique_ptr<RestoreOp> > direct_restore_ops;
 
-  BundleReader default_reader(Env::Default(), prefix_string);
+  // Read-only consumers such as model servers can opt into restoring
+  // tensors as views of the memory-mapped checkpoint.
+  BundleReader::Options reader_options;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_RESTORE_USE_MMAP", false,
+                                        &reader_options.use_mmap));
+  BundleReader default_reader(Env::Default(), prefix_string, reader_options);
   TF_RETURN_IF_ERROR(default_reader.status());
 
   std::vector<string> mismatched_errors;
@@ -379,8 +399,9 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   for (auto i : sorted_name_idx) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    auto op =
-        new RestoreOp{context, i, tensor_name, shape_and_slice, prefix_string};
+    auto op = new RestoreOp{context,       i,
+                            tensor_name,   shape_and_slice,
+                            prefix_string, reader_options};
     if (op->should_run_in_pool(&default_reader)) {
       pool_restore_ops.emplace_back(op);
     } else {
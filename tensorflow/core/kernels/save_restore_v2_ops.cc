@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -105,9 +106,15 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    // Large saves can opt into spreading the tensors over several data files
+    // that are written and checksummed concurrently.
+    int64 num_shards;
+    OP_REQUIRES_OK(context,
+                   ReadInt64FromEnvVar("TF_SAVE_NUM_SHARDS", 1, &num_shards));
+    ParallelBundleWriter writer(Env::Default(), prefix_string, num_shards);
     OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
+    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string
+            << ", num_shards: " << num_shards;
 
     for (int i = 0; i < num_tensors; ++i) {
       const string& tensor_name = tensor_names_flat(i);
@@ -0,0 +1,206 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace io {
+
+namespace {
+// Reads mostly wait on the file system, so the pool is sized for the number of
+// concurrent reads rather than for the number of cores.
+constexpr int kMinReadAheadThreads = 16;
+
+thread::ThreadPool* ReadAheadThreadPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "read_ahead",
+      std::max(kMinReadAheadThreads, port::MaxParallelism()));
+  return pool;
+}
+}  // namespace
+
+struct ReadAheadInputStream::Buffer {
+  explicit Buffer(int64 offset, size_t capacity)
+      : offset(offset), capacity(capacity), scratch(new char[capacity]) {}
+
+  // Blocks until the read has finished.
+  void Wait() {
+    mutex_lock l(mu);
+    while (!done) {
+      cv.wait(l);
+    }
+  }
+
+  const int64 offset;
+  const size_t capacity;
+  std::unique_ptr<char[]> scratch;
+
+  mutex mu;
+  condition_variable cv;
+  bool done TF_GUARDED_BY(mu) = false;
+  // Only accessed by the reader after `Wait()` returns.
+  StringPiece data;
+  Status status;
+};
+
+ReadAheadInputStream::ReadAheadInputStream(RandomAccessFile* file,
+                                           size_t buffer_bytes,
+                                           int num_buffers)
+    : file_(file),
+      buffer_bytes_(std::max<size_t>(buffer_bytes, 1)),
+      num_buffers_(std::max(num_buffers, 1)) {}
+
+ReadAheadInputStream::~ReadAheadInputStream() { DiscardBuffers(); }
+
+void ReadAheadInputStream::FillWindow() {
+  while (!end_of_file_ &&
+         buffers_.size() < static_cast<size_t>(num_buffers_)) {
+    auto buffer = std::make_shared<Buffer>(next_read_offset_, buffer_bytes_);
+    next_read_offset_ += buffer_bytes_;
+    buffers_.push_back(buffer);
+    RandomAccessFile* file = file_;
+    ReadAheadThreadPool()->Schedule([file, buffer]() {
+      StringPiece data;
+      Status s = file->Read(buffer->offset, buffer->capacity, &data,
+                            buffer->scratch.get());
+      mutex_lock l(buffer->mu);
+      buffer->data = data;
+      buffer->status = s;
+      buffer->done = true;
+      buffer->cv.notify_all();
+    });
+  }
+}
+
+Status ReadAheadInputStream::NextBuffer(Buffer** buffer) {
+  while (true) {
+    FillWindow();
+    if (buffers_.empty()) {
+      *buffer = nullptr;
+      return Status::OK();
+    }
+    Buffer* front = buffers_.front().get();
+    front->Wait();
+    // Short reads are reported as OUT_OF_RANGE, along with the data that was
+    // read.
+    if (!front->status.ok() && !errors::IsOutOfRange(front->status)) {
+      return front->status;
+    }
+    if (front->data.size() < front->capacity) {
+      end_of_file_ = true;
+    }
+    if (consumed_ < front->data.size()) {
+      *buffer = front;
+      return Status::OK();
+    }
+    if (end_of_file_) {
+      *buffer = nullptr;
+      return Status::OK();
+    }
+    buffers_.pop_front();
+    consumed_ = 0;
+  }
+}
+
+Status ReadAheadInputStream::ReadNBytes(int64 bytes_to_read, tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->reserve(bytes_to_read);
+  while (result->size() < static_cast<size_t>(bytes_to_read)) {
+    Buffer* buffer;
+    TF_RETURN_IF_ERROR(NextBuffer(&buffer));
+    if (buffer == nullptr) {
+      return errors::OutOfRange("reached end of file");
+    }
+    const size_t bytes_to_copy = std::min<size_t>(
+        buffer->data.size() - consumed_, bytes_to_read - result->size());
+    result->append(buffer->data.data() + consumed_, bytes_to_copy);
+    consumed_ += bytes_to_copy;
+    pos_ += bytes_to_copy;
+  }
+  return Status::OK();
+}
+
+Status ReadAheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  // Skip over the data which has already been requested.
+  while (bytes_to_skip > 0 && !buffers_.empty()) {
+    Buffer* buffer = buffers_.front().get();
+    buffer->Wait();
+    if (!buffer->status.ok() && !errors::IsOutOfRange(buffer->status)) {
+      return buffer->status;
+    }
+    const size_t bytes_available = buffer->data.size() - consumed_;
+    if (bytes_available == 0) {
+      if (buffer->data.size() < buffer->capacity) {
+        end_of_file_ = true;
+        return errors::OutOfRange("reached end of file");
+      }
+      buffers_.pop_front();
+      consumed_ = 0;
+      continue;
+    }
+    const int64 bytes_to_drop = std::min<int64>(bytes_available, bytes_to_skip);
+    consumed_ += bytes_to_drop;
+    pos_ += bytes_to_drop;
+    bytes_to_skip -= bytes_to_drop;
+  }
+  if (bytes_to_skip == 0) {
+    return Status::OK();
+  }
+  // Skip the rest without reading it, and restart the window from there.
+  DiscardBuffers();
+  RandomAccessInputStream input_stream(file_);
+  TF_RETURN_IF_ERROR(input_stream.Seek(pos_));
+  Status s = input_stream.SkipNBytes(bytes_to_skip);
+  pos_ = input_stream.Tell();
+  next_read_offset_ = pos_;
+  return s;
+}
+
+int64 ReadAheadInputStream::Tell() const { return pos_; }
+
+Status ReadAheadInputStream::Reset() {
+  DiscardBuffers();
+  pos_ = 0;
+  next_read_offset_ = 0;
+  return Status::OK();
+}
+
+void ReadAheadInputStream::DiscardBuffers() {
+  for (const auto& buffer : buffers_) {
+    buffer->Wait();
+  }
+  buffers_.clear();
+  consumed_ = 0;
+  end_of_file_ = false;
+}
+
+}  // namespace io
+}  // namespace tensorflow
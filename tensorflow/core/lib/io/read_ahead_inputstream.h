@@ -0,0 +1,87 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a RandomAccessFile sequentially, keeping up to `num_buffers` reads of
+// `buffer_bytes` each in flight on a shared background thread pool. This hides
+// the latency of the underlying reads from the caller, which only waits when
+// it consumes data faster than the file system returns it.
+//
+// Backward seeks (through Reset() + SkipNBytes()) and skips past the read-ahead
+// window discard the buffered data. A single instance of ReadAheadInputStream
+// is NOT safe for concurrent use by multiple threads.
+class ReadAheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  ReadAheadInputStream(RandomAccessFile* file, size_t buffer_bytes,
+                       int num_buffers);
+
+  // Waits for the outstanding reads to finish.
+  ~ReadAheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Buffer;
+
+  // Issues reads until `num_buffers_` are in flight or the end of the file has
+  // been seen.
+  void FillWindow();
+  // Waits for the oldest buffer, and drops it if it has been fully consumed.
+  // Sets `*buffer` to the oldest buffer with unconsumed data, or to nullptr at
+  // the end of the file.
+  Status NextBuffer(Buffer** buffer);
+  // Waits for the outstanding reads, and drops all buffered data.
+  void DiscardBuffers();
+
+  RandomAccessFile* const file_;  // Not owned.
+  const size_t buffer_bytes_;
+  const int num_buffers_;
+  // Buffers in file order. The first one holds the data at `pos_`.
+  std::deque<std::shared_ptr<Buffer>> buffers_;
+  // Number of bytes of the first buffer already returned to the caller.
+  size_t consumed_ = 0;
+  // Position of the caller in the file.
+  int64 pos_ = 0;
+  // File offset of the next read to issue.
+  int64 next_read_offset_ = 0;
+  // Whether a read has come back short, so that no more reads are needed.
+  bool end_of_file_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadAheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READ_AHEAD_INPUTSTREAM_H_
@@ -0,0 +1,199 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+static std::vector<int> BufferSizes() {
+  return {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 65536};
+}
+
+static std::vector<int> NumBuffers() { return {1, 2, 8}; }
+
+string WriteTestFile(const string& contents) {
+  Env* env = Env::Default();
+  string fname;
+  CHECK(env->LocalTempFilename(&fname));
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  return fname;
+}
+
+TEST(ReadAheadInputStream, ReadNBytes) {
+  Env* env = Env::Default();
+  string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      ReadAheadInputStream in(file.get(), buf_size, num_buffers);
+      tstring read;
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "3456");
+      EXPECT_EQ(7, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "789");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+TEST(ReadAheadInputStream, EmptyFile) {
+  Env* env = Env::Default();
+  string fname = WriteTestFile("");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  ReadAheadInputStream in(file.get(), 4, 2);
+  tstring read;
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  EXPECT_EQ(read, "");
+  EXPECT_EQ(0, in.Tell());
+}
+
+TEST(ReadAheadInputStream, SkipNBytes) {
+  Env* env = Env::Default();
+  string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      ReadAheadInputStream in(file.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.SkipNBytes(1));
+      EXPECT_EQ(1, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "12");
+      TF_ASSERT_OK(in.SkipNBytes(4));
+      EXPECT_EQ(7, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "78");
+      EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(5)));
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+    }
+  }
+}
+
+TEST(ReadAheadInputStream, Reset) {
+  Env* env = Env::Default();
+  string fname = WriteTestFile("0123456789");
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    for (auto num_buffers : NumBuffers()) {
+      ReadAheadInputStream in(file.get(), buf_size, num_buffers);
+      tstring read;
+      TF_ASSERT_OK(in.ReadNBytes(6, &read));
+      EXPECT_EQ(read, "012345");
+      TF_ASSERT_OK(in.Reset());
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.SkipNBytes(2));
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "234");
+    }
+  }
+}
+
+TEST(ReadAheadInputStream, MatchesBufferedInputStream) {
+  Env* env = Env::Default();
+  string contents;
+  for (int i = 0; i < 10000; ++i) {
+    contents.append(1, static_cast<char>('a' + i % 26));
+  }
+  string fname = WriteTestFile(contents);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  BufferedInputStream expected(file.get(), 1000);
+  ReadAheadInputStream in(file.get(), 1000, 4);
+  for (int64 bytes_to_read = 1; bytes_to_read < 200; ++bytes_to_read) {
+    tstring expected_read;
+    tstring read;
+    Status expected_status = expected.ReadNBytes(bytes_to_read, &expected_read);
+    Status status = in.ReadNBytes(bytes_to_read, &read);
+    EXPECT_EQ(expected_status.code(), status.code());
+    EXPECT_EQ(expected_read, read);
+    EXPECT_EQ(expected.Tell(), in.Tell());
+  }
+}
+
+// Reads a file in records of `record_size` bytes, either through a
+// BufferedInputStream (if `num_buffers` is 0) or with `num_buffers` reads in
+// flight.
+void BM_ReadAhead(const int iters, const int record_size,
+                  const int num_buffers) {
+  testing::StopTiming();
+  constexpr int64 kFileSize = 64 << 20;
+  constexpr int64 kBufferSize = 256 << 10;
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, string(kFileSize, 'x')));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * kFileSize);
+  testing::UseRealTime();
+  tstring result;
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    std::unique_ptr<InputStreamInterface> in;
+    if (num_buffers == 0) {
+      in = absl::make_unique<BufferedInputStream>(file.get(), kBufferSize);
+    } else {
+      in = absl::make_unique<ReadAheadInputStream>(file.get(), kBufferSize,
+                                                   num_buffers);
+    }
+    for (int64 offset = 0; offset < kFileSize; offset += record_size) {
+      TF_ASSERT_OK(in->ReadNBytes(record_size, &result));
+    }
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(env->DeleteFile(fname));
+}
+BENCHMARK(BM_ReadAhead)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 2)
+    ->ArgPair(1024, 8)
+    ->ArgPair(64 * 1024, 0)
+    ->ArgPair(64 * 1024, 2)
+    ->ArgPair(64 * 1024, 8);
+
+}  // anonymous namespace
+}  // namespace io
+}  // namespace tensorflow
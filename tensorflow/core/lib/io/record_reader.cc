@@ -17,20 +17,49 @@ limitations under the License.
 
 #include <limits.h>
 
+#include <cstdlib>
+
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/read_ahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numbers.h"
 
 namespace tensorflow {
 namespace io {
 
+namespace {
+// Size of each read when read-ahead is used without buffer_size.
+constexpr int64 kDefaultReadAheadBufferSize = 256 << 10;
+
+// Returns the number of reads to keep in flight by default, from the
+// TF_RECORD_READ_AHEAD_BUFFERS environment variable.
+int64 ReadAheadBuffersFromEnv() {
+  static const int64 read_ahead_buffers = []() -> int64 {
+    const char* value = std::getenv("TF_RECORD_READ_AHEAD_BUFFERS");
+    if (value == nullptr) {
+      return 0;
+    }
+    int64 parsed;
+    if (!strings::safe_strto64(value, &parsed) || parsed < 0) {
+      LOG(ERROR) << "Invalid TF_RECORD_READ_AHEAD_BUFFERS: " << value
+                 << ". Read-ahead will not be used.";
+      return 0;
+    }
+    return parsed;
+  }();
+  return read_ahead_buffers;
+}
+}  // namespace
+
 RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
     const string& compression_type) {
   RecordReaderOptions options;
+  options.read_ahead_buffers = ReadAheadBuffersFromEnv();
 
 #if defined(IS_SLIM_BUILD)
   if (compression_type != compression::kNone) {
@@ -59,7 +88,13 @@ RecordReader::RecordReader(RandomAccessFile* file,
     : options_(options),
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.read_ahead_buffers > 0) {
+    input_stream_.reset(new ReadAheadInputStream(
+        file,
+        options.buffer_size > 0 ? options.buffer_size
+                                : kDefaultReadAheadBufferSize,
+        options.read_ahead_buffers));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
@@ -47,6 +47,14 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If read_ahead_buffers is non-zero, then up to this many reads of
+  // buffer_size bytes (or 256KiB if buffer_size is zero) are issued ahead of
+  // the records being read, on a background thread pool. Like buffering, this
+  // is meant for sequential reads. The options returned by
+  // CreateRecordReaderOptions() take it from the TF_RECORD_READ_AHEAD_BUFFERS
+  // environment variable.
+  int64 read_ahead_buffers = 0;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -229,6 +229,38 @@ TEST(RecordReaderWriterTest, TestSkipOutOfRange) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadAhead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_read_ahead_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get(), io::RecordWriterOptions());
+    for (int i = 0; i < 100; ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(strings::StrCat("record_", i)));
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  for (auto buf_size : BufferSizes()) {
+    std::unique_ptr<RandomAccessFile> read_file;
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options;
+    options.buffer_size = buf_size;
+    options.read_ahead_buffers = 4;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    tstring record;
+    int num_skipped;
+    TF_CHECK_OK(reader.SkipRecords(10, &num_skipped));
+    for (int i = 10; i < 100; ++i) {
+      TF_CHECK_OK(reader.ReadRecord(&record));
+      EXPECT_EQ(strings::StrCat("record_", i), record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&record)));
+  }
+}
+
 TEST(RecordReaderWriterTest, TestSnappy) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_snappy_test";
@@ -137,6 +137,7 @@ REGISTER_OP("CompressElement")
     .Input("components: input_types")
     .Output("compressed: variant")
     .Attr("input_types: list(type) >= 1")
+    .Attr("codec: {'none', 'snappy', 'zlib', 'auto'} = 'snappy'")
     .SetShapeFn(shape_inference::ScalarShape);
 
 REGISTER_OP("UncompressElement")
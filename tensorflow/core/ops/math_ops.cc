@@ -965,11 +965,16 @@ names specified as strings (e.g. "Relu"). They are performed in order, where the
 (first) input to each op is the output of the preceding op. The first input and
 the output of each fused_op must be of type T.
 
-Currently supported fused_op combinations are: ["BiasAdd"] and ["BiasAdd",A],
-where A is one of {"Elu","Relu","Relu6"}.
+Currently supported fused_op combinations are: ["BiasAdd"], ["BiasAdd",A],
+["BiasAdd","GeluApproximate"], ["BiasAdd","Add"] and ["BiasAdd","Add",A], where
+A is one of {"Elu","Relu","Relu6"}.
 
 * The first input to BiasAdd is the Conv2D result, and the additional BiasAdd
 input is specified by `args`.
+* The second input to "Add" is the last of `args`, and must have the shape of
+the output.
+* "GeluApproximate" is the tanh approximation of Gelu:
+0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))).
 * If there is an op A specified, the output of the BiasAdd is the input to op A,
 and op A produces the _FusedConv2D output. Otherwise, the BiasAdd produces the
 _FusedConv2D output.
@@ -978,6 +983,38 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("inputs: N * T")
+    .Output("y: T")
+    .Attr("N: int >= 1")
+    .Attr("T: {float, double}")
+    .Attr("fused_ops: list(string) >= 1")
+    .Attr("operands: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle out = c->input(0);
+      for (int i = 1; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
+            c, out, c->input(i), /*incompatible_shape_error=*/true, &out));
+      }
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Evaluates a graph of elementwise ops in a single pass over its inputs.
+
+The fused ops are evaluated in order. Values 0 to N-1 are the `inputs`, and the
+k-th op of `fused_ops` (e.g. "Mul") computes value N+k from the values listed,
+in order, by the next 1 or 2 entries of `operands`, depending on the arity of
+the op. The last value is the output.
+
+Inputs are broadcast against the output, which has the broadcast shape of all
+the inputs. Every input must have the shape of the output, or of a suffix of
+the output shape, up to leading dimensions of size 1.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
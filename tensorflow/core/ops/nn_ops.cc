@@ -414,10 +414,13 @@ names specified as strings (e.g. "Relu"). They are performed in order, where the
 the output of each fused_op must be of type T.
 
 Currently supported fused_op combinations are: [X] and [X,A], where X is one of
-{"BiasAdd","FusedBatchNorm"} and A is one of {"Elu","Relu","Relu6"}.
+{"BiasAdd","FusedBatchNorm"} and A is one of {"Elu","Relu","Relu6"}, and
+["BiasAdd","GeluApproximate"], ["BiasAdd","Add"] and ["BiasAdd","Add",A].
 
 * The first input to op X is the Conv2D result, and the additional input(s) to X
 are specified by `args`.
+* The second input to "Add" is the last of `args`, and must have the shape of
+the output.
 * If there is an op A specified, the output of op X is the input to op A, and op
 A produces the _FusedConv2D output. Otherwise, op X produces the _FusedConv2D
 output.
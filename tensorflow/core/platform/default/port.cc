@@ -39,6 +39,7 @@ limitations under the License.
 #include <unistd.h>
 #ifdef TF_USE_SNAPPY
 #include "snappy.h"
+#include "tensorflow/core/platform/snappy_iovec_source.h"
 #endif
 #if (defined(__APPLE__) && defined(__MACH__)) || defined(__FreeBSD__) || \
     defined(__HAIKU__)
@@ -323,6 +324,19 @@ bool Snappy_Compress(const char* input, size_t length, string* output) {
 #endif
 }
 
+bool Snappy_CompressFromIOVec(const struct iovec* iov,
+                              size_t uncompressed_length, string* output) {
+#ifdef TF_USE_SNAPPY
+  output->resize(snappy::MaxCompressedLength(uncompressed_length));
+  IOVecSource source(iov, uncompressed_length);
+  snappy::UncheckedByteArraySink sink(&(*output)[0]);
+  output->resize(snappy::Compress(&source, &sink));
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool Snappy_GetUncompressedLength(const char* input, size_t length,
                                   size_t* result) {
 #ifdef TF_USE_SNAPPY
@@ -34,6 +34,10 @@ namespace port {
 
 // Snappy compression/decompression support
 bool Snappy_Compress(const char* input, size_t length, string* output);
+// Compresses the concatenation of `iov`, which holds `uncompressed_length`
+// bytes in total, without first copying it into a contiguous buffer.
+bool Snappy_CompressFromIOVec(const struct iovec* iov,
+                              size_t uncompressed_length, string* output);
 
 bool Snappy_GetUncompressedLength(const char* input, size_t length,
                                   size_t* result);
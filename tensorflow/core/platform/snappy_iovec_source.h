@@ -0,0 +1,75 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_SNAPPY_IOVEC_SOURCE_H_
+#define TENSORFLOW_CORE_PLATFORM_SNAPPY_IOVEC_SOURCE_H_
+
+// Shared by the platform implementations of Snappy_CompressFromIOVec. Only
+// include this header when building with TF_USE_SNAPPY.
+
+#include <algorithm>
+#include <cstddef>
+
+#include "snappy-sinksource.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace tensorflow {
+namespace port {
+
+// A snappy::Source reading the concatenation of an array of iovecs.
+class IOVecSource : public snappy::Source {
+ public:
+  IOVecSource(const struct iovec* iov, size_t length)
+      : iov_(iov), remaining_(length) {}
+
+  size_t Available() const override { return remaining_; }
+
+  const char* Peek(size_t* len) override {
+    if (remaining_ == 0) {
+      *len = 0;
+      return nullptr;
+    }
+    while (offset_ == iov_->iov_len) {
+      ++iov_;
+      offset_ = 0;
+    }
+    *len = std::min(iov_->iov_len - offset_, remaining_);
+    return static_cast<const char*>(iov_->iov_base) + offset_;
+  }
+
+  void Skip(size_t n) override {
+    remaining_ -= n;
+    while (n > 0) {
+      const size_t left_in_iov = iov_->iov_len - offset_;
+      if (n < left_in_iov) {
+        offset_ += n;
+        return;
+      }
+      n -= left_in_iov;
+      ++iov_;
+      offset_ = 0;
+    }
+  }
+
+ private:
+  const struct iovec* iov_;
+  size_t offset_ = 0;
+  size_t remaining_;
+};
+
+}  // namespace port
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_SNAPPY_IOVEC_SOURCE_H_
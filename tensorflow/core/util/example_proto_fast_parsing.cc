@@ -166,6 +166,81 @@ class Feature {
     return true;
   }
 
+  // Counts the values of a float list without decoding them. The count is
+  // only trustworthy if ParseFloatList() succeeds later on.
+  bool GetNumElementsInFloatList(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      constexpr int32 kNumFloatBytes = 4;
+      uint8 peek_tag = PeekTag(&stream);
+      if (peek_tag == kDelimitedTag(1)) {  // packed
+        if (!stream.ExpectTag(kDelimitedTag(1))) return false;
+        uint32 packed_length;
+        if (!stream.ReadVarint32(&packed_length)) return false;
+        *num_elements = packed_length / kNumFloatBytes;
+      } else if (peek_tag == kFixed32Tag(1)) {  // non-packed
+        *num_elements = stream.BytesUntilLimit() / (1 + kNumFloatBytes);
+      } else {
+        return false;
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
+  // Counts the values of an int64 list without decoding them. The count is
+  // only trustworthy if ParseInt64List() succeeds later on.
+  bool GetNumElementsInInt64List(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      uint8 peek_tag = PeekTag(&stream);
+      if (peek_tag == kDelimitedTag(1)) {  // packed
+        if (!stream.ExpectTag(kDelimitedTag(1))) return false;
+        uint32 packed_length;
+        if (!stream.ReadVarint32(&packed_length)) return false;
+        const int position = stream.CurrentPosition();
+        if (packed_length > serialized_.size() - position) return false;
+        // Every varint ends with the only one of its bytes whose high bit is
+        // clear, so counting those bytes counts the values. This loop has no
+        // dependencies between iterations, and is vectorized by the compiler.
+        const uint8* packed =
+            reinterpret_cast<const uint8*>(serialized_.data()) + position;
+        int count = 0;
+        for (uint32 i = 0; i < packed_length; ++i) {
+          count += packed[i] < 0x80;
+        }
+        // A truncated last value would otherwise go uncounted.
+        if (packed_length > 0 && packed[packed_length - 1] >= 0x80) {
+          return false;
+        }
+        *num_elements = count;
+      } else if (peek_tag == kVarintTag(1)) {  // non-packed
+        while (!stream.ExpectAtEnd()) {
+          if (!stream.ExpectTag(kVarintTag(1))) return false;
+          protobuf_uint64 n;
+          if (!stream.ReadVarint64(&n)) return false;
+          ++*num_elements;
+        }
+      } else {
+        return false;
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
   // Helper methods
   tstring* construct_at_end(LimitedArraySlice<tstring>* bytes_list) {
     if (bytes_list->EndDistance() <= 0) {
@@ -539,6 +614,22 @@ struct SparseBuffer {
   std::vector<size_t> example_end_indices;
 };
 
+// The values of a sparse or ragged feature in one example. These are only
+// counted while examples are parsed, and decoded straight into the output
+// tensor once the outputs have been sized.
+struct ValuesToParse {
+  // Index of the feature in config.sparse or config.ragged.
+  size_t d;
+  Type type;
+  size_t example_index;
+  StringPiece feature_name;
+  // Position of the values in the output of their minibatch.
+  size_t offset;
+  size_t num_values;
+  // Positioned after the data type tag.
+  parsed::Feature feature;
+};
+
 struct SeededHasher {
   uint64 operator()(StringPiece s) const {
     return Hash64(s.data(), s.size(), seed);
@@ -576,10 +667,12 @@ Status FastParseSerializedExample(
     std::vector<SparseBuffer>* output_varlen_dense,
     std::vector<SparseBuffer>* output_sparse,
     std::vector<SparseBuffer>* output_ragged,
+    std::vector<ValuesToParse>* output_values_to_parse,
     PerExampleFeatureStats* output_stats) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
   DCHECK(output_ragged != nullptr);
+  DCHECK(output_values_to_parse != nullptr);
   parsed::Example parsed_example;
   if (!ParseExample(serialized_example, &parsed_example)) {
     return errors::InvalidArgument("Could not parse example input, value: '",
@@ -800,7 +893,8 @@ Status FastParseSerializedExample(
       }
       last_example[d] = example_index;
 
-      // Handle sparse features.
+      // Handle sparse features. Only their number of values is needed for
+      // now.
       SparseBuffer& out = is_ragged ? (*output_ragged)[d] : (*output_sparse)[d];
       DataType feature_dtype =
           is_ragged ? config.ragged[d].dtype : config.sparse[d].dtype;
@@ -811,37 +905,33 @@ Status FastParseSerializedExample(
                             ", Actual type: ", DataTypeString(example_dtype)));
       }
 
-      switch (feature_dtype) {
-        case DT_INT64: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseInt64List(&out.int64_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.int64_list.size());
-          break;
-        }
-        case DT_FLOAT: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseFloatList(&out.float_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.float_list.size());
-          break;
+      const size_t offset =
+          out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
+      int num_values = 0;
+      if (example_dtype != DT_INVALID) {
+        bool ok = false;
+        switch (feature_dtype) {
+          case DT_INT64:
+            ok = feature.GetNumElementsInInt64List(&num_values);
+            break;
+          case DT_FLOAT:
+            ok = feature.GetNumElementsInFloatList(&num_values);
+            break;
+          case DT_STRING:
+            ok = feature.GetNumElementsInBytesList(&num_values);
+            break;
+          default:
+            LOG(FATAL) << "Should not happen.";
         }
-        case DT_STRING: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseBytesList(&out.bytes_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.bytes_list.size());
-          break;
+        if (!ok) return parse_error();
+        if (num_values > 0) {
+          output_values_to_parse->push_back(
+              {d, is_ragged ? Type::Ragged : Type::Sparse, example_index,
+               feature_name, offset, static_cast<size_t>(num_values),
+               feature});
         }
-        default:
-          LOG(FATAL) << "Should not happen.";
       }
+      out.example_end_indices.push_back(offset + num_values);
 
       if (output_stats) {
         // Use `out.example_end_indices` to determine the feature-value count
@@ -1086,26 +1176,30 @@ void CountSparseFeatures(
   }
 }
 
-void CopySparseBufferToTensor(DataType dtype, size_t offset, SparseBuffer* src,
-                              Tensor* dst) {
+// Decodes `values->num_values` values into `dst`, starting at `offset`.
+// Returns false if the values can't be parsed, or if their number differs from
+// the one counted before.
+bool ParseValuesToTensor(DataType dtype, size_t offset, ValuesToParse* values,
+                         Tensor* dst) {
   switch (dtype) {
     case DT_INT64: {
-      std::copy(src->int64_list.begin(), src->int64_list.end(),
-                dst->flat<int64>().data() + offset);
-      break;
+      LimitedArraySlice<int64> slice(dst->flat<int64>().data() + offset,
+                                     values->num_values);
+      return values->feature.ParseInt64List(&slice) && slice.EndDistance() == 0;
     }
     case DT_FLOAT: {
-      std::copy(src->float_list.begin(), src->float_list.end(),
-                dst->flat<float>().data() + offset);
-      break;
+      LimitedArraySlice<float> slice(dst->flat<float>().data() + offset,
+                                     values->num_values);
+      return values->feature.ParseFloatList(&slice) && slice.EndDistance() == 0;
     }
     case DT_STRING: {
-      std::move(src->bytes_list.begin(), src->bytes_list.end(),
-                dst->flat<tstring>().data() + offset);
-      break;
+      LimitedArraySlice<tstring> slice(dst->flat<tstring>().data() + offset,
+                                       values->num_values);
+      return values->feature.ParseBytesList(&slice) && slice.EndDistance() == 0;
     }
     default:
       ReportUnexpectedDataType(dtype);
+      return false;
   }
 }
 
@@ -1204,10 +1298,12 @@ Status FastParseExample(const Config& config,
   //   in small batches.
   //   Maybe accept outside parameter #num_minibatches?
 
-  // Do minibatches in parallel.
+  // Do minibatches in parallel. Sparse and ragged values are only counted in
+  // this pass, so that they can be decoded straight into the outputs below.
   std::vector<std::vector<SparseBuffer>> sparse_buffers(num_minibatches);
   std::vector<std::vector<SparseBuffer>> varlen_dense_buffers(num_minibatches);
   std::vector<std::vector<SparseBuffer>> ragged_buffers(num_minibatches);
+  std::vector<std::vector<ValuesToParse>> values_to_parse(num_minibatches);
   std::vector<Status> status_of_minibatch(num_minibatches);
   auto ProcessMiniBatch = [&](size_t minibatch) {
     sparse_buffers[minibatch].resize(config.sparse.size());
@@ -1225,7 +1321,7 @@ Status FastParseExample(const Config& config,
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
           config_index, hasher, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch],
-          &ragged_buffers[minibatch], stats);
+          &ragged_buffers[minibatch], &values_to_parse[minibatch], stats);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
@@ -1247,9 +1343,11 @@ Status FastParseExample(const Config& config,
     result->dense_values.push_back(std::move(fixed_dense_values[d]));
   }
 
-  // Merge SparseBuffers from all minibatches for every config.sparse.
-  auto MergeSparseMinibatches = [&](size_t d) {
-    // Loop over minibatches
+  // Size the sparse and ragged outputs, and find where the values of each
+  // minibatch start in them.
+  std::vector<std::vector<size_t>> sparse_minibatch_offsets(
+      config.sparse.size());
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
     size_t total_num_features = 0;
     size_t max_num_features = 0;
     CountSparseFeatures(sparse_buffers, d, &total_num_features,
@@ -1259,18 +1357,82 @@ Status FastParseExample(const Config& config,
     indices_shape.AddDim(total_num_features);
     indices_shape.AddDim(2);
     result->sparse_indices.emplace_back(DT_INT64, indices_shape);
-    Tensor* indices = &result->sparse_indices.back();
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
     result->sparse_values.emplace_back(config.sparse[d].dtype, values_shape);
-    Tensor* values = &result->sparse_values.back();
 
     result->sparse_shapes.emplace_back(DT_INT64, TensorShape({2}));
     auto shapes_shape_t = result->sparse_shapes.back().vec<int64>();
     shapes_shape_t(0) = serialized.size();
     shapes_shape_t(1) = max_num_features;
 
+    size_t offset = 0;
+    for (size_t i = 0; i < num_minibatches; ++i) {
+      sparse_minibatch_offsets[d].push_back(offset);
+      offset += sparse_buffers[i][d].example_end_indices.back();
+    }
+  }
+  std::vector<std::vector<size_t>> ragged_minibatch_offsets(
+      config.ragged.size());
+  for (size_t d = 0; d < config.ragged.size(); ++d) {
+    size_t total_num_features = 0;
+    size_t max_num_features = 0;
+    CountSparseFeatures(ragged_buffers, d, &total_num_features,
+                        &max_num_features);
+
+    TensorShape row_splits_shape;
+    row_splits_shape.AddDim(serialized.size() + 1);
+    result->ragged_splits.emplace_back(config.ragged[d].splits_dtype,
+                                       row_splits_shape);
+
+    TensorShape values_shape;
+    values_shape.AddDim(total_num_features);
+    result->ragged_values.emplace_back(config.ragged[d].dtype, values_shape);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < num_minibatches; ++i) {
+      ragged_minibatch_offsets[d].push_back(offset);
+      if (!ragged_buffers[i][d].example_end_indices.empty()) {
+        offset += ragged_buffers[i][d].example_end_indices.back();
+      }
+    }
+  }
+
+  // Decode the sparse and ragged values into the outputs.
+  auto ParseMiniBatchValues = [&](size_t minibatch) {
+    for (ValuesToParse& values : values_to_parse[minibatch]) {
+      const bool is_ragged = values.type == Type::Ragged;
+      const size_t offset =
+          values.offset +
+          (is_ragged ? ragged_minibatch_offsets : sparse_minibatch_offsets)
+              [values.d][minibatch];
+      const DataType dtype = is_ragged ? config.ragged[values.d].dtype
+                                       : config.sparse[values.d].dtype;
+      Tensor* dst = is_ragged ? &result->ragged_values[values.d]
+                              : &result->sparse_values[values.d];
+      if (!ParseValuesToTensor(dtype, offset, &values, dst)) {
+        status_of_minibatch[minibatch] = errors::InvalidArgument(
+            "Name: ",
+            (!example_names.empty() ? example_names[values.example_index]
+                                    : "<unknown>"),
+            ", Key: ", values.feature_name,
+            ", Index: ", values.example_index,
+            ".  Can't parse serialized Example.");
+        return;
+      }
+    }
+  };
+
+  ParallelFor(ParseMiniBatchValues, num_minibatches, thread_pool);
+
+  for (Status& status : status_of_minibatch) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  // Fill in the indices of the sparse values of every config.sparse.
+  auto MergeSparseMinibatches = [&](size_t d) {
+    Tensor* indices = &result->sparse_indices[d];
     size_t offset = 0;
     for (size_t i = 0; i < sparse_buffers.size(); ++i) {
       SparseBuffer& buffer = sparse_buffers[i][d];
@@ -1295,36 +1457,19 @@ Status FastParseExample(const Config& config,
         }
       }
 
-      CopySparseBufferToTensor(config.sparse[d].dtype, offset, &buffer, values);
       offset += delta;
     }
   };
 
-  // Merge SparseBuffers from all minibatches for every config.ragged.
+  // Fill in the row splits of every config.ragged.
   auto MergeRaggedMinibatches = [&](size_t d) {
-    // Loop over minibatches
-    size_t total_num_features = 0;
-    size_t max_num_features = 0;
-    CountSparseFeatures(ragged_buffers, d, &total_num_features,
-                        &max_num_features);
-
-    TensorShape row_splits_shape;
-    row_splits_shape.AddDim(serialized.size() + 1);
-    result->ragged_splits.emplace_back(config.ragged[d].splits_dtype,
-                                       row_splits_shape);
-    Tensor* row_splits = &result->ragged_splits.back();
+    Tensor* row_splits = &result->ragged_splits[d];
     if (config.ragged[d].splits_dtype == DT_INT64) {
       row_splits->flat<int64>()(0) = 0;
     } else {
       row_splits->flat<int32>()(0) = 0;
     }
 
-    TensorShape values_shape;
-    values_shape.AddDim(total_num_features);
-    result->ragged_values.emplace_back(config.ragged[d].dtype, values_shape);
-    Tensor* values = &result->ragged_values.back();
-
-    size_t values_offset = 0;
     size_t splits_offset = 0;
     for (size_t i = 0; i < ragged_buffers.size(); ++i) {
       SparseBuffer& buffer = ragged_buffers[i][d];
@@ -1346,9 +1491,6 @@ Status FastParseExample(const Config& config,
         }
       }
 
-      CopySparseBufferToTensor(config.ragged[d].dtype, values_offset, &buffer,
-                               values);
-      values_offset += buffer.example_end_indices.back();
       splits_offset += buffer.example_end_indices.size();
     }
   };
@@ -413,6 +413,87 @@ TEST(FastParse, FuzzTest) {
   }
 }
 
+TEST(TestFastParseExample, SparseAndRaggedValues) {
+  // Enough examples to be split into several minibatches.
+  const int kNumExamples = 40;
+  std::vector<tstring> serialized;
+  int num_values = 0;
+  for (int i = 0; i < kNumExamples; ++i) {
+    num_values += i % 3;
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    // Every third example has no values. Negative values take ten bytes as
+    // varints.
+    for (int j = 0; j < i % 3; ++j) {
+      features["int64"].mutable_int64_list()->add_value(j % 2 ? -i : i << 20);
+      features["float"].mutable_float_list()->add_value(i + 0.5f * j);
+      features["bytes"].mutable_bytes_list()->add_value(
+          strings::StrCat(i, "_", j));
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  AddSparseFeature("int64", DT_INT64, &config);
+  AddSparseFeature("float", DT_FLOAT, &config);
+  AddSparseFeature("bytes", DT_STRING, &config);
+  config.ragged.push_back({"int64", DT_INT64, DT_INT64});
+  config.ragged.push_back({"bytes", DT_STRING, DT_INT32});
+
+  Result result;
+  TF_ASSERT_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+  ASSERT_EQ(3, result.sparse_values.size());
+  ASSERT_EQ(2, result.ragged_values.size());
+
+  auto int64_indices = result.sparse_indices[0].matrix<int64>();
+  auto int64_values = result.sparse_values[0].vec<int64>();
+  auto float_values = result.sparse_values[1].vec<float>();
+  auto bytes_values = result.sparse_values[2].vec<tstring>();
+  ASSERT_EQ(num_values, int64_values.size());
+  ASSERT_EQ(num_values, float_values.size());
+  ASSERT_EQ(num_values, bytes_values.size());
+  EXPECT_EQ(kNumExamples, result.sparse_shapes[0].vec<int64>()(0));
+  EXPECT_EQ(2, result.sparse_shapes[0].vec<int64>()(1));
+
+  auto int64_splits = result.ragged_splits[0].vec<int64>();
+  auto bytes_splits = result.ragged_splits[1].vec<int32>();
+  ASSERT_EQ(kNumExamples + 1, int64_splits.size());
+  EXPECT_EQ(0, int64_splits(0));
+
+  int n = 0;
+  for (int i = 0; i < kNumExamples; ++i) {
+    for (int j = 0; j < i % 3; ++j) {
+      EXPECT_EQ(i, int64_indices(n, 0));
+      EXPECT_EQ(j, int64_indices(n, 1));
+      EXPECT_EQ(j % 2 ? -i : i << 20, int64_values(n));
+      EXPECT_EQ(i + 0.5f * j, float_values(n));
+      EXPECT_EQ(strings::StrCat(i, "_", j), bytes_values(n));
+      EXPECT_EQ(int64_values(n), result.ragged_values[0].vec<int64>()(n));
+      EXPECT_EQ(bytes_values(n), result.ragged_values[1].vec<tstring>()(n));
+      ++n;
+    }
+    EXPECT_EQ(n, int64_splits(i + 1));
+    EXPECT_EQ(n, bytes_splits(i + 1));
+  }
+}
+
+TEST(TestFastParseExample, TruncatedSparseValues) {
+  Example example;
+  (*example.mutable_features()->mutable_feature())["int64"]
+      .mutable_int64_list()
+      ->add_value(-1);
+  string truncated = Serialize(example);
+  // Set the continuation bit of the last byte of the varint.
+  truncated.back() |= 0x80;
+  std::vector<tstring> serialized = {truncated};
+
+  FastParseExampleConfig config;
+  AddSparseFeature("int64", DT_INT64, &config);
+  Result result;
+  Status status = FastParseExample(config, serialized, {}, nullptr, &result);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
 TEST(TestFastParseExample, Empty) {
   Result result;
   FastParseExampleConfig config;
@@ -19,8 +19,10 @@ limitations under the License.
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <numeric>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -33,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -403,6 +406,17 @@ Status PadAlignment(FileOutputBuffer* out, int alignment, int64* size) {
   return status;
 }
 
+// Returns the smallest positive multiple of both "a" and "b".
+int64 LeastCommonMultiple(int64 a, int64 b) {
+  int64 x = a, y = b;
+  while (y != 0) {
+    const int64 r = x % y;
+    x = y;
+    y = r;
+  }
+  return a / x * b;
+}
+
 }  // namespace
 
 BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
@@ -445,6 +459,17 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
     return status_;
   }
 
+  // Tensors that BundleReader can alias with Options::use_mmap start at an
+  // offset suitable for a tensor buffer.
+  if (options_.align_for_mmap && DataTypeCanUseMemcpy(val.dtype()) &&
+      val.NumElements() > 0) {
+    status_ = PadAlignment(
+        out_.get(),
+        LeastCommonMultiple(options_.data_alignment, EIGEN_MAX_ALIGN_BYTES),
+        &size_);
+    if (!status_.ok()) return status_;
+  }
+
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
@@ -739,11 +764,244 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
   return status;
 }
 
+// Writing tensor bundles in parallel.
+
+ParallelBundleWriter::ParallelBundleWriter(Env* env, StringPiece prefix,
+                                           int num_shards,
+                                           const BundleWriter::Options& options)
+    : env_(env), options_(options), prefix_(prefix), num_shards_(num_shards) {
+  if (num_shards_ <= 1) {
+    serial_writer_.reset(new BundleWriter(env_, prefix_, options_));
+    status_ = serial_writer_->status();
+  }
+}
+
+Status ParallelBundleWriter::Add(StringPiece key, const Tensor& val) {
+  if (!status_.ok()) return status_;
+  if (serial_writer_) {
+    status_ = serial_writer_->Add(key, val);
+    return status_;
+  }
+  CHECK_NE(key, kHeaderEntryKey);
+  if (!pending_keys_.emplace(key).second) {
+    status_ = errors::InvalidArgument("Adding duplicate key: ", key);
+    return status_;
+  }
+  pending_.push_back({string(key), /*is_slice=*/false, TensorShape(),
+                      TensorSlice(), val});
+  return Status::OK();
+}
+
+Status ParallelBundleWriter::AddSlice(StringPiece full_tensor_key,
+                                      const TensorShape& full_tensor_shape,
+                                      const TensorSlice& slice_spec,
+                                      const Tensor& slice_tensor) {
+  if (!status_.ok()) return status_;
+  if (serial_writer_) {
+    status_ = serial_writer_->AddSlice(full_tensor_key, full_tensor_shape,
+                                       slice_spec, slice_tensor);
+    return status_;
+  }
+  if (IsFullSlice(slice_spec, full_tensor_shape)) {
+    return Add(full_tensor_key, slice_tensor);
+  }
+  CHECK_NE(full_tensor_key, kHeaderEntryKey);
+  const string full_tensor_key_string(full_tensor_key);
+  if (!pending_keys_
+           .insert(checkpoint::EncodeTensorNameSlice(full_tensor_key_string,
+                                                     slice_spec))
+           .second) {
+    status_ = errors::InvalidArgument("Adding duplicate slice ",
+                                      slice_spec.DebugString(), " of ",
+                                      full_tensor_key);
+    return status_;
+  }
+  pending_.push_back({full_tensor_key_string, /*is_slice=*/true,
+                      full_tensor_shape, slice_spec, slice_tensor});
+  return Status::OK();
+}
+
+Status ParallelBundleWriter::WriteShard(const string& prefix,
+                                        const std::vector<int>& indices) {
+  BundleWriter writer(env_, prefix, options_);
+  for (int i : indices) {
+    const PendingTensor& t = pending_[i];
+    if (t.is_slice) {
+      TF_RETURN_IF_ERROR(
+          writer.AddSlice(t.key, t.full_tensor_shape, t.slice_spec, t.val));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(t.key, t.val));
+    }
+  }
+  return writer.Finish();
+}
+
+Status ParallelBundleWriter::CheckShardSlices(
+    const std::vector<std::vector<int>>& shard_indices) const {
+  using checkpoint::RegisterTensorSlice;
+  using checkpoint::TensorSliceSet;
+  using SliceSets = std::unordered_map<string, TensorSliceSet*>;
+  auto delete_slice_sets = [](SliceSets* slice_sets) {
+    for (auto& p : *slice_sets) delete p.second;
+    slice_sets->clear();
+  };
+
+  SliceSets merged;
+  Status status;
+  for (int shard = 0; shard < shard_indices.size() && status.ok(); ++shard) {
+    const string tag = strings::StrCat(shard);
+    SliceSets shard_slices;
+    for (int i : shard_indices[shard]) {
+      const PendingTensor& t = pending_[i];
+      if (!t.is_slice) continue;
+      status = RegisterTensorSlice(t.key, t.full_tensor_shape, t.val.dtype(),
+                                   tag, t.slice_spec, &shard_slices);
+      if (!status.ok()) break;
+    }
+    // Same checks as when a reader assembles the slices of all shards.
+    for (const auto& p : shard_slices) {
+      if (!status.ok()) break;
+      for (const auto& slice : p.second->Slices()) {
+        status = RegisterTensorSlice(p.first, p.second->shape(),
+                                     p.second->type(), slice.second.tag,
+                                     slice.second.slice, &merged);
+        if (!status.ok()) break;
+      }
+    }
+    delete_slice_sets(&shard_slices);
+  }
+  delete_slice_sets(&merged);
+  return status;
+}
+
+Status ParallelBundleWriter::Finish() {
+  if (serial_writer_) {
+    status_.Update(serial_writer_->Finish());
+    serial_writer_ = nullptr;
+  }
+  if (!status_.ok()) return status_;
+  if (pending_.empty()) {
+    // Nothing was added; still produce a valid, empty bundle.
+    BundleWriter writer(env_, prefix_, options_);
+    status_ = writer.Finish();
+    if (!status_.ok()) return status_;
+    status_ = errors::Internal("ParallelBundleWriter is closed");
+    return Status::OK();
+  }
+
+  // Every shard must receive at least one tensor: MergeBundles() sums the
+  // shard counts of its inputs but only renames data files that are
+  // referenced by some entry.
+  const int num_shards =
+      std::min<int64>(num_shards_, static_cast<int64>(pending_.size()));
+
+  // Assigns the largest tensors first, each to the least loaded shard.
+  std::vector<int> order(pending_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return pending_[a].val.TotalBytes() > pending_[b].val.TotalBytes();
+  });
+  std::vector<std::vector<int>> shard_indices(num_shards);
+  std::vector<int64> shard_bytes(num_shards, 0);
+  for (int i : order) {
+    const int shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shard_indices[shard].push_back(i);
+    shard_bytes[shard] += pending_[i].val.TotalBytes();
+  }
+
+  status_ = CheckShardSlices(shard_indices);
+  if (!status_.ok()) return status_;
+
+  // The shards are written next to the final bundle, so that MergeBundles()
+  // only needs to rename their data files.
+  const string shard_prefix_base =
+      strings::StrCat(prefix_, ".tempstate", random::New64(), "_shard");
+  std::vector<tstring> shard_prefixes(num_shards);
+  std::vector<Status> shard_statuses(num_shards);
+  {
+    thread::ThreadPool pool(env_, "save_bundle_shards", num_shards);
+    for (int i = 0; i < num_shards; ++i) {
+      shard_prefixes[i] = strings::StrCat(shard_prefix_base, i);
+      pool.Schedule([this, i, &shard_prefixes, &shard_indices,
+                     &shard_statuses]() {
+        shard_statuses[i] = WriteShard(shard_prefixes[i], shard_indices[i]);
+      });
+    }
+  }
+  for (const Status& s : shard_statuses) {
+    status_.Update(s);
+  }
+  if (status_.ok()) {
+    status_ = MergeBundles(env_, shard_prefixes, prefix_);
+  }
+  if (!status_.ok()) {
+    // Cleanup: best effort based and ignores errors.
+    for (const tstring& shard_prefix : shard_prefixes) {
+      env_->DeleteFile(DataFilename(shard_prefix, 0, 1)).IgnoreError();
+      env_->DeleteFile(MetaFilename(shard_prefix)).IgnoreError();
+    }
+    return status_;
+  }
+  pending_.clear();
+  pending_keys_.clear();
+  status_ = errors::Internal("ParallelBundleWriter is closed");
+  return Status::OK();
+}
+
+// A memory-mapped data file of a bundle.  Reference counted so that tensors
+// aliasing the mapping keep it alive after the BundleReader is destroyed.
+class MappedBundleFile : public core::RefCounted {
+ public:
+  explicit MappedBundleFile(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const {
+    return static_cast<const char*>(region_->data());
+  }
+  uint64 length() const { return region_->length(); }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+namespace {
+
+// A TensorBuffer viewing part of a MappedBundleFile.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(MappedBundleFile* file, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), file_(file), size_(size) {
+    file_->Ref();
+  }
+  ~MappedTensorBuffer() override { file_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mmap");
+  }
+
+  // The mapping is read-only, so the buffer must never be forwarded to an op
+  // that would update it in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  MappedBundleFile* const file_;
+  const size_t size_;
+};
+
+}  // namespace
+
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       index_cache_(nullptr),
@@ -812,10 +1070,14 @@ BundleReader::~BundleReader() {
   for (auto& temp : data_) {
     delete temp.second;
   }
+  for (auto& temp : mapped_data_) {
+    if (temp.second != nullptr) temp.second->Unref();
+  }
   for (auto& temp : tensor_slices_) {
     delete temp.second;
   }
   data_.clear();
+  mapped_data_.clear();
   tensor_slices_.clear();
 }
 
@@ -840,7 +1102,92 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry,
+                                    Tensor* val, bool* aliased) {
+  *aliased = false;
+  if (!DataTypeCanUseMemcpy(entry.dtype()) || need_to_swap_bytes_ ||
+      entry.size() == 0) {
+    return Status::OK();
+  }
+
+  // Map the data file if it has not been mapped.
+  auto it = mapped_data_.find(entry.shard_id());
+  if (it == mapped_data_.end()) {
+    const string filename =
+        DataFilename(prefix_, entry.shard_id(), num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    Status s = env_->NewReadOnlyMemoryRegionFromFile(filename, &region);
+    MappedBundleFile* mapped_file = nullptr;
+    if (s.ok()) {
+      mapped_file = new MappedBundleFile(std::move(region));
+    } else if (errors::IsUnimplemented(s)) {
+      VLOG(1) << "Cannot memory-map " << filename << ", falling back to "
+              << "copying its tensors: " << s;
+    } else {
+      return s;
+    }
+    it = mapped_data_.emplace(entry.shard_id(), mapped_file).first;
+  }
+  MappedBundleFile* mapped_file = it->second;
+  if (mapped_file == nullptr) return Status::OK();
+
+  if (entry.offset() < 0 ||
+      entry.offset() + entry.size() > mapped_file->length()) {
+    return errors::OutOfRange("Bundle entry of ", entry.size(),
+                              " bytes at offset ", entry.offset(),
+                              " is past the end of shard ", entry.shard_id(),
+                              " of ", prefix_);
+  }
+  const char* data = mapped_file->data() + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    return Status::OK();
+  }
+
+  const TensorShape stored_shape(entry.shape());
+  if (entry.size() !=
+      stored_shape.num_elements() * DataTypeSize(entry.dtype())) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ",
+                            stored_shape.num_elements() *
+                                DataTypeSize(entry.dtype()));
+  }
+  // The mapped tensor replaces the tensor preallocated by the caller, if any,
+  // which must have the dtype and shape of the entry.
+  if (val->NumElements() != 0 &&
+      (val->dtype() != entry.dtype() || val->shape() != stored_shape)) {
+    return errors::InvalidArgument(
+        "Bundle entry for key ", key(), " has dtype ",
+        DataTypeString(entry.dtype()), " and shape ",
+        stored_shape.DebugString(),
+        ", but the tensor to restore into has dtype ",
+        DataTypeString(val->dtype()), " and shape ",
+        val->shape().DebugString());
+  }
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+
+  MappedTensorBuffer* buf =
+      new MappedTensorBuffer(mapped_file, data, entry.size());
+  *val = Tensor(entry.dtype(), stored_shape, buf);
+  buf->Unref();
+  *aliased = true;
+  return Status::OK();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
+  if (options_.use_mmap) {
+    bool aliased;
+    TF_RETURN_IF_ERROR(GetMappedValue(entry, val, &aliased));
+    if (aliased) return Status::OK();
+  }
+
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
   if (val->NumElements() == 0) {
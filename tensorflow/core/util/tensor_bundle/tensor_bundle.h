@@ -64,6 +64,8 @@ limitations under the License.
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -84,6 +86,7 @@ limitations under the License.
 namespace tensorflow {
 
 class FileOutputBuffer;
+class MappedBundleFile;
 
 // Versioning of the tensor bundle format.
 // Follows the same rules as 3p/tf/core/public/version.h.
@@ -112,6 +115,12 @@ class BundleWriter {
     // Alignment, in bytes, for tensor data.
     // Must be >= 1. The default size of 1 densely packs tensors.
     int data_alignment{1};
+    // If true, the data of tensors that BundleReader can alias with
+    // BundleReader::Options::use_mmap (non-empty tensors of POD dtypes) also
+    // starts at a multiple of EIGEN_MAX_ALIGN_BYTES, so that it can be
+    // aliased.  Costs at most EIGEN_MAX_ALIGN_BYTES - 1 bytes of padding per
+    // tensor.
+    bool align_for_mmap{true};
   };
   BundleWriter(Env* env, StringPiece prefix,
                const Options& options = Options());
@@ -160,6 +169,72 @@ class BundleWriter {
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
 };
 
+// Builds a bundle whose tensors are spread over up to "num_shards" data files
+// that are written, and checksummed, concurrently.
+//
+// Add() and AddSlice() only record the tensors.  Finish() balances them over
+// the shards by size, writes each shard with its own BundleWriter on a
+// separate thread, and combines the shards with MergeBundles().  With
+// "num_shards" <= 1 this is a plain BundleWriter.
+//
+// The tensors passed to Add() and AddSlice() must not be modified until
+// Finish() returns.
+//
+// All threads accessing the same ParallelBundleWriter must synchronize.
+class ParallelBundleWriter {
+ public:
+  ParallelBundleWriter(Env* env, StringPiece prefix, int num_shards,
+                       const BundleWriter::Options& options =
+                           BundleWriter::Options());
+
+  // Same as BundleWriter::Add().
+  Status Add(StringPiece key, const Tensor& val);
+
+  // Same as BundleWriter::AddSlice().
+  Status AddSlice(StringPiece full_tensor_key,
+                  const TensorShape& full_tensor_shape,
+                  const TensorSlice& slice_spec, const Tensor& slice_tensor);
+
+  // Writes out all shards and merges them under "prefix".  Fails without
+  // writing anything if the slices of a full tensor overlap.
+  Status Finish() TF_MUST_USE_RESULT;
+
+  Status status() const { return status_; }
+
+ private:
+  // A tensor or slice recorded by Add() or AddSlice().
+  struct PendingTensor {
+    string key;
+    bool is_slice;
+    TensorShape full_tensor_shape;
+    TensorSlice slice_spec;
+    Tensor val;
+  };
+
+  // Writes "pending_[indices]" as a single-shard bundle at "prefix".
+  Status WriteShard(const string& prefix, const std::vector<int>& indices);
+
+  // Merges the slices of each shard into a slice set per full tensor, and
+  // returns an error if slices of a tensor overlap or disagree on its shape or
+  // dtype.  Checked before any shard is written.
+  Status CheckShardSlices(
+      const std::vector<std::vector<int>>& shard_indices) const;
+
+  Env* const env_;  // Not owned.
+  const BundleWriter::Options options_;
+  const string prefix_;
+  const int num_shards_;
+  // Set iff num_shards_ <= 1, in which case all calls are forwarded to it.
+  std::unique_ptr<BundleWriter> serial_writer_;
+  std::vector<PendingTensor> pending_;
+  // Keys of the tensors and slices in pending_, used to reject duplicates
+  // before any data is written.
+  std::unordered_set<string> pending_keys_;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ParallelBundleWriter);
+};
+
 // Merges a set of bundles (given their prefixes) into a single bundle with the
 // given "merged_prefix".  The merged metadata is guaranteed to be consistent.
 //
@@ -182,7 +257,23 @@ Status MergeBundles(Env* env, gtl::ArraySlice<tstring> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, the data files are memory-mapped, and Lookup() returns tensors
+    // of POD dtypes as read-only views of the mapping instead of copying them
+    // into a fresh buffer.  Entries whose data does not start at a multiple
+    // of EIGEN_MAX_ALIGN_BYTES in the data file (as in bundles written
+    // without BundleWriter::Options::align_for_mmap), bundles of the other
+    // endianness, and file systems that do not support memory mapping fall
+    // back to copying.
+    //
+    // The data files must not be modified or truncated while tensors aliasing
+    // them are alive: reading a mapped page past the new end of a truncated
+    // file raises SIGBUS, which is not caught.
+    bool use_mmap{false};
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -215,6 +306,11 @@ class BundleReader {
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
   //
+  // With Options::use_mmap, "val" may instead be replaced by a tensor that
+  // aliases the mapped data file.  Such tensors stay valid after the reader
+  // is destroyed, but their buffer is read-only and is never forwarded to ops
+  // that update their input in place.
+  //
   // Validates the stored crc32c checksum against the restored bytes.
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
@@ -263,6 +359,8 @@ class BundleReader {
 
   string DebugString();
 
+  const Options& options() const { return options_; }
+
  private:
   // Seeks for "key" and reads the metadata proto.
   // On non-OK return, clears "entry" for the caller.
@@ -275,6 +373,13 @@ class BundleReader {
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Points "val" at the bytes described by "entry" in the mapped data file,
+  // if the entry can be aliased.  Sets "*aliased" to false, leaving "val"
+  // untouched, if the caller has to fall back to copying.
+  // REQUIRES: options_.use_mmap
+  Status GetMappedValue(const BundleEntryProto& entry, Tensor* val,
+                        bool* aliased) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -285,6 +390,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  const Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -293,6 +399,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // With Options::use_mmap, the mapped data files.  Each holds one reference,
+  // and every tensor aliasing a file holds another.  A null value marks a
+  // shard that could not be mapped.
+  std::unordered_map<int32, MappedBundleFile*> mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
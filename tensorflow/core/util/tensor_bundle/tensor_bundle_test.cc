@@ -18,6 +18,7 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -635,6 +636,125 @@ TEST(TensorBundleTest, PartitionedVariables) {
   }
 }
 
+TEST(TensorBundleTest, ParallelWriter) {
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel"), 3);
+    TF_ASSERT_OK(writer.status());
+    TF_EXPECT_OK(writer.Add("foo_003", Constant_2x3<float>(3)));
+    TF_EXPECT_OK(writer.Add("foo_000", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("foo_002", Constant_2x3<float>(2)));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    EXPECT_TRUE(errors::IsInvalidArgument(
+        writer.Add("foo_000", Constant_2x3<float>(0))));
+  }
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel"), 3);
+    TF_EXPECT_OK(writer.Add("foo_003", Constant_2x3<float>(3)));
+    TF_EXPECT_OK(writer.Add("foo_000", Constant_2x3<float>(0)));
+    TF_EXPECT_OK(writer.Add("foo_002", Constant_2x3<float>(2)));
+    TF_EXPECT_OK(writer.Add("foo_001", Constant_2x3<float>(1)));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(
+        Env::Default()->FileExists(DataFilename(Prefix("parallel"), i, 3)));
+  }
+  BundleReader reader(Env::Default(), Prefix("parallel"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(AllTensorKeys(&reader),
+            std::vector<string>(
+                {"foo_000", "foo_001", "foo_002", "foo_003", "strings"}));
+  Expect<float>(&reader, "foo_000", Constant_2x3<float>(0));
+  Expect<float>(&reader, "foo_001", Constant_2x3<float>(1));
+  Expect<float>(&reader, "foo_002", Constant_2x3<float>(2));
+  Expect<float>(&reader, "foo_003", Constant_2x3<float>(3));
+  Expect<tstring>(&reader, "strings",
+                  test::AsTensor<tstring>({"hello", "world"}));
+}
+
+TEST(TensorBundleTest, ParallelWriterMoreShardsThanTensors) {
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel_few"), 8);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<int32>(1)));
+    TF_EXPECT_OK(writer.Add("bar", Constant_2x3<int32>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("parallel_few"));
+  TF_ASSERT_OK(reader.status());
+  Expect<int32>(&reader, "foo", Constant_2x3<int32>(1));
+  Expect<int32>(&reader, "bar", Constant_2x3<int32>(2));
+}
+
+TEST(TensorBundleTest, ParallelWriterPartitionedVariables) {
+  const TensorShape kFullShape({5, 10});
+  TensorSlice slice1 = TensorSlice::ParseOrDie("-:0,1");
+  TensorSlice slice2 = TensorSlice::ParseOrDie("-:1,9");
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel_slices"), 2);
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape, slice1,
+                                 Constant<float>(0., TensorShape({5, 1}))));
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape, slice2,
+                                 Constant<float>(1., TensorShape({5, 9}))));
+    EXPECT_TRUE(errors::IsInvalidArgument(writer.AddSlice(
+        "foo", kFullShape, slice2, Constant<float>(1., TensorShape({5, 9})))));
+  }
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel_slices"), 2);
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape, slice1,
+                                 Constant<float>(0., TensorShape({5, 1}))));
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape, slice2,
+                                 Constant<float>(1., TensorShape({5, 9}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("parallel_slices"));
+  TF_ASSERT_OK(reader.status());
+  Tensor expected_val(DT_FLOAT, kFullShape);
+  test::FillFn<float>(&expected_val, [](int offset) -> float {
+    return offset % 10 == 0 ? 0 : 1;
+  });
+  Tensor val(DT_FLOAT, kFullShape);
+  TF_ASSERT_OK(reader.Lookup("foo", &val));
+  test::ExpectTensorEqual<float>(val, expected_val);
+}
+
+TEST(TensorBundleTest, ParallelWriterOverlappingSlices) {
+  const TensorShape kFullShape({5, 10});
+  {
+    // The two slices are balanced over the two shards, and only overlap once
+    // the slices of the shards are merged.
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel_overlap"), 2);
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape,
+                                 TensorSlice::ParseOrDie("-:0,6"),
+                                 Constant<float>(0., TensorShape({5, 6}))));
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape,
+                                 TensorSlice::ParseOrDie("-:4,6"),
+                                 Constant<float>(1., TensorShape({5, 6}))));
+    Status s = writer.Finish();
+    EXPECT_FALSE(s.ok());
+    EXPECT_TRUE(absl::StrContains(s.error_message(), "Overlapping slices"))
+        << s;
+  }
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      MetaFilename(Prefix("parallel_overlap")))));
+  {
+    ParallelBundleWriter writer(Env::Default(), Prefix("parallel_overlap"), 2);
+    TF_ASSERT_OK(writer.AddSlice("foo", kFullShape,
+                                 TensorSlice::ParseOrDie("-:0,5"),
+                                 Constant<float>(0., TensorShape({5, 5}))));
+    TF_ASSERT_OK(writer.AddSlice("foo", TensorShape({5, 12}),
+                                 TensorSlice::ParseOrDie("-:5,5"),
+                                 Constant<float>(1., TensorShape({5, 5}))));
+    Status s = writer.Finish();
+    EXPECT_FALSE(s.ok());
+    EXPECT_TRUE(absl::StrContains(s.error_message(), "Incompatible tensor"))
+        << s;
+  }
+}
+
 TEST(TensorBundleTest, EquivalentSliceTest) {
   const TensorShape kFullShape({5, 10});
   const Tensor kExpected(Constant<float>(1., kFullShape));
@@ -969,6 +1089,173 @@ TEST(TensorBundleTest, Checksum) {
   }
 }
 
+// Returns true iff "t" is a view of a memory-mapped data file.
+bool IsMapped(const Tensor& t) {
+  TensorDescription description;
+  t.FillDescription(&description);
+  return description.allocation_description().allocator_name() == "mmap";
+}
+
+TEST(TensorBundleTest, MmapAlignedTensorsAreAliased) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_aligned"), opts);
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(1.5)));
+    TF_EXPECT_OK(writer.Add("ints", Constant_2x3<int64>(7)));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor floats, ints, strings;
+  {
+    BundleReader::Options opts;
+    opts.use_mmap = true;
+    BundleReader reader(Env::Default(), Prefix("mmap_aligned"), opts);
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.Lookup("floats", &floats));
+    TF_ASSERT_OK(reader.Lookup("ints", &ints));
+    TF_ASSERT_OK(reader.Lookup("strings", &strings));
+  }
+  // The mapped tensors outlive the reader.
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(1.5));
+  test::ExpectTensorEqual<int64>(ints, Constant_2x3<int64>(7));
+  test::ExpectTensorEqual<tstring>(strings,
+                                   test::AsTensor<tstring>({"hello", "world"}));
+  EXPECT_TRUE(IsMapped(floats));
+  EXPECT_TRUE(IsMapped(ints));
+  // Strings are not stored in their in-memory layout, so they are copied.
+  EXPECT_FALSE(IsMapped(strings));
+}
+
+TEST(TensorBundleTest, MmapChecksPreallocatedTensors) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_preallocated"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(4.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_preallocated"), opts);
+  TF_ASSERT_OK(reader.status());
+
+  Tensor val(DT_FLOAT, TensorShape({2, 3}));
+  TF_ASSERT_OK(reader.Lookup("foo", &val));
+  test::ExpectTensorEqual<float>(val, Constant_2x3<float>(4.5));
+  EXPECT_TRUE(IsMapped(val));
+
+  // The same number of bytes, but a different shape or dtype.
+  Tensor transposed(DT_FLOAT, TensorShape({3, 2}));
+  EXPECT_TRUE(errors::IsInvalidArgument(reader.Lookup("foo", &transposed)));
+  EXPECT_EQ(transposed.shape(), TensorShape({3, 2}));
+  Tensor ints(DT_INT32, TensorShape({2, 3}));
+  EXPECT_TRUE(errors::IsInvalidArgument(reader.Lookup("foo", &ints)));
+  EXPECT_EQ(ints.dtype(), DT_INT32);
+}
+
+TEST(TensorBundleTest, MmapDefaultWriterTensorsAreAliased) {
+  {
+    // As written by SaveV2.
+    BundleWriter writer(Env::Default(), Prefix("mmap_default"));
+    TF_EXPECT_OK(writer.Add("small", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(
+        writer.Add("strings", test::AsTensor<tstring>({"hello", "world"})));
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(2.5)));
+    TF_EXPECT_OK(writer.Add("ints", Constant(int64{7}, TensorShape({3}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_default"), opts);
+  TF_ASSERT_OK(reader.status());
+  for (const char* key : {"small", "floats", "ints"}) {
+    BundleEntryProto entry;
+    TF_ASSERT_OK(reader.GetBundleEntryProto(key, &entry));
+    EXPECT_EQ(0, entry.offset() % EIGEN_MAX_ALIGN_BYTES) << key;
+  }
+  Tensor small, floats, ints;
+  TF_ASSERT_OK(reader.Lookup("small", &small));
+  TF_ASSERT_OK(reader.Lookup("floats", &floats));
+  TF_ASSERT_OK(reader.Lookup("ints", &ints));
+  test::ExpectTensorEqual<bool>(small, Constant(true, TensorShape({1})));
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(2.5));
+  test::ExpectTensorEqual<int64>(ints, Constant(int64{7}, TensorShape({3})));
+  EXPECT_TRUE(IsMapped(small));
+  EXPECT_TRUE(IsMapped(floats));
+  EXPECT_TRUE(IsMapped(ints));
+  Expect<tstring>(&reader, "strings",
+                  test::AsTensor<tstring>({"hello", "world"}));
+}
+
+TEST(TensorBundleTest, MmapMisalignedTensorsAreCopied) {
+  {
+    BundleWriter::Options opts;
+    opts.align_for_mmap = false;
+    BundleWriter writer(Env::Default(), Prefix("mmap_misaligned"), opts);
+    // Densely packed after a one-byte tensor, so "big" starts at offset 1.
+    TF_EXPECT_OK(writer.Add("small", Constant(true, TensorShape({1}))));
+    TF_EXPECT_OK(writer.Add("big", Constant_2x3<float>(2.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_misaligned"), opts);
+  TF_ASSERT_OK(reader.status());
+  Tensor big;
+  TF_ASSERT_OK(reader.Lookup("big", &big));
+  test::ExpectTensorEqual<float>(big, Constant_2x3<float>(2.5));
+  EXPECT_FALSE(IsMapped(big));
+  // Preallocated outputs are filled in as without memory mapping.
+  Expect<float>(&reader, "big", Constant_2x3<float>(2.5));
+  Expect<bool>(&reader, "small", Constant(true, TensorShape({1})));
+}
+
+TEST(TensorBundleTest, MmapOtherEndiannessIsCopied) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_endianness"), opts);
+    TF_EXPECT_OK(writer.Add("foo", ByteSwap(Constant_2x3<int32>(3))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  TF_ASSERT_OK(FlipEndiannessBit(Prefix("mmap_endianness")));
+
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_endianness"), opts);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("foo", &val));
+  test::ExpectTensorEqual<int32>(val, Constant_2x3<int32>(3));
+  EXPECT_FALSE(IsMapped(val));
+}
+
+TEST(TensorBundleTest, MmapChecksum) {
+  {
+    BundleWriter::Options opts;
+    opts.data_alignment = EIGEN_MAX_ALIGN_BYTES;
+    BundleWriter writer(Env::Default(), Prefix("mmap_checksum"), opts);
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(1)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string datafile = DataFilename(Prefix("mmap_checksum"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), datafile, &data));
+  data[0] = ~data[0];
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), datafile, data));
+
+  BundleReader::Options opts;
+  opts.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_checksum"), opts);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  Status status = reader.Lookup("foo", &val);
+  EXPECT_TRUE(errors::IsDataLoss(status));
+  EXPECT_TRUE(absl::StrContains(status.ToString(), "Checksum does not match"));
+}
+
 TEST(TensorBundleTest, TruncatedTensorContents) {
   Env* env = Env::Default();
   BundleWriter writer(env, Prefix("end"));
@@ -1143,4 +1430,38 @@ BM_BundleAlignment(4096, 512);
 BM_BundleAlignment(4096, 4096);
 BM_BundleAlignment(4096, 1048576);
 
+static void BM_BundleWriter(int iters, int num_shards) {
+  testing::StopTiming();
+  constexpr int kNumTensors = 16;
+  constexpr int64 kTensorElements = 4 << 20;  // 16MB of floats.
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < kNumTensors; ++i) {
+    tensors.push_back(Constant(static_cast<float>(i),
+                               TensorShape({kTensorElements})));
+  }
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumTensors *
+                          kTensorElements * sizeof(float));
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    // num_shards == 0 measures BundleWriter itself.
+    if (num_shards == 0) {
+      BundleWriter writer(Env::Default(), Prefix("bm_writer"));
+      for (int j = 0; j < kNumTensors; ++j) {
+        TF_CHECK_OK(writer.Add(strings::StrCat("tensor_", j), tensors[j]));
+      }
+      TF_CHECK_OK(writer.Finish());
+    } else {
+      ParallelBundleWriter writer(Env::Default(), Prefix("bm_writer"),
+                                  num_shards);
+      for (int j = 0; j < kNumTensors; ++j) {
+        TF_CHECK_OK(writer.Add(strings::StrCat("tensor_", j), tensors[j]));
+      }
+      TF_CHECK_OK(writer.Finish());
+    }
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_BundleWriter)->Arg(0)->Arg(2)->Arg(4)->Arg(8);
+
 }  // namespace tensorflow
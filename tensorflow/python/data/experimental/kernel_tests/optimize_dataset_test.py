@@ -515,5 +515,15 @@ class OptimizeDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     self.assertEqual(cpu_budget, 1000)
     self.assertEqual(ram_budget, 999999999)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testAutotuningBudgetAware(self):
+    options = dataset_ops.Options()
+    options.experimental_optimization.autotune_buffers = True
+    options.experimental_optimization.autotune_budget_aware = True
+
+    _, algorithm, _, _ = options._autotune_settings()
+    self.assertEqual(algorithm,
+                     optimization_options._AutotuneAlgorithm.BOTTLENECK)
+
 if __name__ == "__main__":
   test.main()
@@ -21,11 +21,16 @@ from tensorflow.python.data.util import structure
 from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
 
 
-def compress(element):
+def compress(element, codec=None):
   """Compress a dataset element.
 
   Args:
     element: A nested structure of types supported by Tensorflow.
+    codec: (Optional.) The codec to compress with: "none", "snappy", "zlib", or
+      "auto", which compresses with snappy unless that saves less than an
+      eighth of the element's size, in which case the element is stored
+      uncompressed. Defaults to snappy, without setting the `codec` attr of the
+      op, so that binaries which predate the attr can run it.
 
   Returns:
     A variant tensor representing the compressed element. This variant can be
@@ -33,7 +38,9 @@ def compress(element):
   """
   element_spec = structure.type_spec_from_value(element)
   tensor_list = structure.to_tensor_list(element_spec, element)
-  return ged_ops.compress_element(tensor_list)
+  if codec is None:
+    return ged_ops.compress_element(tensor_list)
+  return ged_ops.compress_element(tensor_list, codec=codec)
 
 
 def uncompress(element, output_spec):
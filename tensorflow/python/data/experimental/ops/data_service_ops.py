@@ -22,6 +22,7 @@ import functools
 import six
 
 from tensorflow.python import tf2
+from tensorflow.python.compat import compat
 from tensorflow.python.data.experimental.ops import compression_ops
 from tensorflow.python.data.experimental.ops.distribute_options import AutoShardPolicy
 from tensorflow.python.data.experimental.ops.distribute_options import ExternalStatePolicy
@@ -529,10 +530,14 @@ def register_dataset(service, dataset):
     external_state_policy = ExternalStatePolicy.WARN
 
   # Compress the dataset elements to reduce the amount of data that needs to
-  # be sent over the network.
-  dataset = dataset.map(
-      lambda *x: compression_ops.compress(x),
-      num_parallel_calls=dataset_ops.AUTOTUNE)
+  # be sent over the network. Elements which don't compress well, such as
+  # encoded images, are sent uncompressed once the dispatcher and workers can
+  # read them.
+  if compat.forward_compatible(2020, 11, 18):
+    compress_fn = lambda *x: compression_ops.compress(x, codec="auto")
+  else:
+    compress_fn = lambda *x: compression_ops.compress(x)
+  dataset = dataset.map(compress_fn, num_parallel_calls=dataset_ops.AUTOTUNE)
   dataset = dataset.prefetch(dataset_ops.AUTOTUNE)
   # Apply options so that the dataset executed in the tf.data service will
   # be optimized and support autotuning.
@@ -30,6 +30,7 @@ class _AutotuneAlgorithm(enum.Enum):
   """Controls what algorithm is used in the autotune implementation."""
   HILL_CLIMB = 0
   GRADIENT_DESCENT = 1
+  BOTTLENECK = 2
 
 
 @tf_export("data.experimental.MapVectorizationOptions")
@@ -100,6 +101,16 @@ class OptimizationOptions(options.OptionsBase):
       "Whether to automatically tune performance knobs. If None, defaults to "
       "True.")
 
+  autotune_budget_aware = options.create_option(
+      name="autotune_budget_aware",
+      ty=bool,
+      docstring=
+      "When autotuning is enabled (through `autotune`), determines whether to "
+      "tune with an algorithm that gives the CPU and RAM budgets to the "
+      "performance knobs that reduce the latency the most per unit of "
+      "resource used. Overrides the algorithm chosen by `autotune_buffers`. If "
+      "None, defaults to False.")
+
   autotune_buffers = options.create_option(
       name="autotune_buffers",
       ty=bool,
@@ -236,6 +247,8 @@ class OptimizationOptions(options.OptionsBase):
     # Set these options if they are explicitly set by the user.
     if self.autotune is False:  # pylint: disable=g-bool-id-comparison
       autotune = False
+    if self.autotune_budget_aware:
+      algorithm = _AutotuneAlgorithm.BOTTLENECK
     if self.autotune_cpu_budget is not None:
       cpu_budget = self.autotune_cpu_budget
     if self.autotune_ram_budget is not None: